@@ -0,0 +1,309 @@
+#include <restbed>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "BenchSession.h"
+#include "Benchmark.h"
+#include "CommentController.hpp"
+#include "Fixtures.h"
+#include "IssueController.hpp"
+#include "QueryCache.h"
+#include "UserController.hpp"
+#include "Utilities.h"
+#include "VoteController.hpp"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * Builds a request like the ones restbed hands to the controllers
+ */
+std::shared_ptr<restbed::Request> MakeRequest(const std::string& method,
+                                              const std::string& path,
+                                              const std::string& body = "") {
+  auto request = std::make_shared<restbed::Request>();
+  request->set_method(method);
+  request->set_path(path);
+  if (!body.empty()) {
+    request->set_header("Content-Length", std::to_string(body.length()));
+    request->set_body(body);
+  }
+  return request;
+}
+
+/**
+ * Stops the benchmarks if a request wasn't answered as expected, since the
+ * time of an error response says nothing about the request path
+ */
+void Check(const BenchSession& session, int expected, const char* name) {
+  if (session.Status() == expected) return;
+  std::cerr << name << " answered " << session.Status() << " instead of "
+            << expected << ": " << session.Body() << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+/**
+ * Sends the same request to a controller handler on every iteration
+ */
+template <typename Handler>
+void Serve(Bench::State& state, const char* name,
+           const std::shared_ptr<restbed::Request>& request, int expected,
+           Handler handle) {
+  while (state.KeepRunning()) {
+    auto session = std::make_shared<BenchSession>(request);
+    handle(session);
+    Check(*session, expected, name);
+  }
+}
+
+std::string MiddleIssue(std::size_t size) {
+  return Fixtures::Id("issues", size, size / 2);
+}
+
+std::string UserId(std::size_t size) { return Fixtures::Id("users", size, 1); }
+
+// IssueController
+
+void IssueControllerGetById(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeIssueService(state.Size()));
+  auto request = MakeRequest("GET", "/issues/" + MiddleIssue(state.Size()));
+  Serve(state, "GET /issues/:id", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("IssueController/GetById", IssueControllerGetById, SIZE_MAX);
+
+void IssueControllerGetNotModified(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  auto service = Fixtures::MakeIssueService(state.Size());
+  controller.SetEntityService(service);
+  // Lists are answered without reading the collection. A single issue is
+  // read first, to make sure it still exists
+  auto request = MakeRequest("GET", "/issues");
+  request->set_header("If-None-Match",
+                      ResponseUtilities::BuildETag(service->Generation()));
+  Serve(state, "GET /issues (If-None-Match)", request,
+        restbed::NOT_MODIFIED,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("IssueController/GetNotModified", IssueControllerGetNotModified,
+                SIZE_MAX);
+
+void IssueControllerGetQuery(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeIssueService(state.Size()));
+  auto request = MakeRequest("GET", "/issues");
+  request->set_query_parameter("reporter", UserId(state.Size()));
+  Serve(state, "GET /issues?reporter=", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("IssueController/GetQuery", IssueControllerGetQuery, SIZE_MAX);
+
+void IssueControllerGetQueryCached(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeIssueService(state.Size()));
+  controller.SetQueryCache(std::make_shared<QueryCache>("issues"));
+  auto request = MakeRequest("GET", "/issues");
+  request->set_query_parameter("reporter", UserId(state.Size()));
+  // The first request fills the cache, and is not timed
+  controller.Get(std::make_shared<BenchSession>(request));
+  Serve(state, "GET /issues?reporter= (cached)", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("IssueController/GetQueryCached", IssueControllerGetQueryCached,
+                SIZE_MAX);
+
+void IssueControllerCreate(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeIssueService(state.Size()));
+  std::string user = UserId(state.Size());
+  auto request = MakeRequest("POST", "/issues",
+                             json({{"title", "A new issue"},
+                                   {"status", "New"},
+                                   {"createdBy", user},
+                                   {"reporter", user}})
+                                 .dump());
+  Serve(state, "POST /issues", request, restbed::CREATED,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Create(session);
+        });
+}
+BENCHMARK_SIZED("IssueController/Create", IssueControllerCreate, SIZE_MAX);
+
+void IssueControllerUpdate(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeIssueService(state.Size()));
+  std::string id = MiddleIssue(state.Size());
+  std::string user = UserId(state.Size());
+  auto request = MakeRequest("PUT", "/issues/" + id,
+                             json({{"id", id},
+                                   {"title", "An edited issue"},
+                                   {"status", "Assigned"},
+                                   {"createdBy", user},
+                                   {"reporter", user},
+                                   {"assignedTo", user},
+                                   {"updatedBy", user}})
+                                 .dump());
+  Serve(state, "PUT /issues/:id", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Update(session);
+        });
+}
+BENCHMARK_SIZED("IssueController/Update", IssueControllerUpdate, SIZE_MAX);
+
+void IssueControllerPatch(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeIssueService(state.Size()));
+  auto request = MakeRequest("PATCH", "/issues/" + MiddleIssue(state.Size()),
+                             json({{"status", "Fixed"}}).dump());
+  Serve(state, "PATCH /issues/:id", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Patch(session);
+        });
+}
+BENCHMARK_SIZED("IssueController/Patch", IssueControllerPatch, SIZE_MAX);
+
+void IssueControllerDelete(Bench::State& state) {
+  IssueController<BenchSession> controller;
+  auto service = Fixtures::MakeIssueService(state.Size());
+  controller.SetEntityService(service);
+  std::string user = UserId(state.Size());
+  std::string body = json({{"title", "An issue to delete"},
+                           {"status", "New"},
+                           {"createdBy", user},
+                           {"reporter", user}})
+                         .dump();
+  while (state.KeepRunning()) {
+    // Put an issue back for every one deleted, so the dataset keeps its size
+    state.PauseTiming();
+    auto session = std::make_shared<BenchSession>(
+        MakeRequest("DELETE", "/issues/" + service->Create(body).id));
+    state.ResumeTiming();
+
+    controller.Delete(session);
+    Check(*session, restbed::OK, "DELETE /issues/:id");
+  }
+}
+BENCHMARK_SIZED("IssueController/Delete", IssueControllerDelete, SIZE_MAX);
+
+// CommentController
+
+void CommentControllerGetForIssue(Bench::State& state) {
+  CommentController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeCommentService(state.Size()));
+  auto request = MakeRequest(
+      "GET", "/issues/" + MiddleIssue(state.Size()) + "/comments");
+  Serve(state, "GET /issues/:id/comments", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("CommentController/GetForIssue", CommentControllerGetForIssue,
+                SIZE_MAX);
+
+void CommentControllerCreate(Bench::State& state) {
+  CommentController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeCommentService(state.Size()));
+  auto request = MakeRequest("POST", "/comments",
+                             json({{"issueId", MiddleIssue(state.Size())},
+                                   {"body", "A new comment"},
+                                   {"createdBy", UserId(state.Size())}})
+                                 .dump());
+  Serve(state, "POST /comments", request, restbed::CREATED,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Create(session);
+        });
+}
+BENCHMARK_SIZED("CommentController/Create", CommentControllerCreate, SIZE_MAX);
+
+// VoteController
+
+void VoteControllerGetById(Bench::State& state) {
+  VoteController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeVoteService(state.Size()));
+  auto request = MakeRequest(
+      "GET", "/votes/" + Fixtures::Id("votes", state.Size(), state.Size() / 2));
+  Serve(state, "GET /votes/:id", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("VoteController/GetById", VoteControllerGetById, SIZE_MAX);
+
+void VoteControllerToggle(Bench::State& state) {
+  VoteController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeVoteService(state.Size()));
+  std::string issueId = MiddleIssue(state.Size());
+  auto request = MakeRequest("POST", "/issues/" + issueId + "/votes",
+                             json({{"issueId", issueId},
+                                   {"createdBy", UserId(state.Size())}})
+                                 .dump());
+  // Voting again removes the vote, so the requests alternate between the two
+  bool voted = false;
+  while (state.KeepRunning()) {
+    auto session = std::make_shared<BenchSession>(request);
+    controller.Create(session);
+    Check(*session, voted ? restbed::OK : restbed::CREATED,
+          "POST /issues/:id/votes");
+    voted = !voted;
+  }
+}
+BENCHMARK_SIZED("VoteController/Toggle", VoteControllerToggle, SIZE_MAX);
+
+// UserController
+
+void UserControllerGetById(Bench::State& state) {
+  UserController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeUserService(state.Size()));
+  auto request = MakeRequest("GET", "/users/" + UserId(state.Size()));
+  Serve(state, "GET /users/:id", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("UserController/GetById", UserControllerGetById, SIZE_MAX);
+
+void UserControllerGetQuery(Bench::State& state) {
+  UserController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeUserService(state.Size()));
+  auto request = MakeRequest("GET", "/users");
+  request->set_query_parameter("role", "Tester");
+  Serve(state, "GET /users?role=", request, restbed::OK,
+        [&](const std::shared_ptr<BenchSession>& session) {
+          controller.Get(session);
+        });
+}
+BENCHMARK_SIZED("UserController/GetQuery", UserControllerGetQuery, SIZE_MAX);
+
+void UserControllerCreate(Bench::State& state) {
+  UserController<BenchSession> controller;
+  controller.SetEntityService(Fixtures::MakeUserService(state.Size()));
+  int created = 0;
+  while (state.KeepRunning()) {
+    // Names have to be unique
+    state.PauseTiming();
+    auto session = std::make_shared<BenchSession>(MakeRequest(
+        "POST", "/users",
+        json({{"name", "New user " + std::to_string(created++)},
+              {"role", "Developer"}})
+            .dump()));
+    state.ResumeTiming();
+
+    controller.Create(session);
+    Check(*session, restbed::CREATED, "POST /users");
+  }
+}
+BENCHMARK_SIZED("UserController/Create", UserControllerCreate, SIZE_MAX);
+}  // namespace
@@ -0,0 +1,99 @@
+#include <string>
+
+#include "Benchmark.h"
+#include "Comment.h"
+#include "Issue.h"
+#include "User.h"
+#include "Vote.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+const char* const CreatedAt = "Thu Dec 10 06:49:49 2020";
+
+json UserJson() {
+  return {{"id", "u1"}, {"name", "User 1"}, {"role", "Developer"}};
+}
+
+json IssueJson() {
+  return {{"id", "i1"},
+          {"title", "Issue 1"},
+          {"status", "Assigned"},
+          {"createdAt", CreatedAt},
+          {"createdBy", "u1"},
+          {"reporter", "u1"},
+          {"assignedTo", "u2"},
+          {"updatedAt", CreatedAt},
+          {"updatedBy", "u2"},
+          {"comments", {"c1", "c2", "c3"}},
+          {"votes", {"v1", "v2"}},
+          {"version", 3}};
+}
+
+json CommentJson() {
+  return {{"id", "c1"},
+          {"issueId", "i1"},
+          {"body", "Whenever I open the browser, I can't do anything else"},
+          {"createdAt", CreatedAt},
+          {"createdBy", "u1"},
+          {"updatedAt", ""},
+          {"updatedBy", ""},
+          {"version", 1}};
+}
+
+json VoteJson() {
+  return {{"id", "v1"},
+          {"issueId", "i1"},
+          {"createdAt", CreatedAt},
+          {"createdBy", "u1"},
+          {"updatedAt", ""},
+          {"updatedBy", ""},
+          {"version", 1}};
+}
+
+/**
+ * Measures converting an entity from JSON
+ */
+template <typename T>
+void FromJson(Bench::State& state, const json& data) {
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(data.get<T>());
+  }
+}
+
+/**
+ * Measures converting an entity to JSON
+ */
+template <typename T>
+void ToJson(Bench::State& state, const json& data) {
+  T entity = data.get<T>();
+  while (state.KeepRunning()) {
+    json serialized = entity;
+    Bench::DoNotOptimize(serialized);
+  }
+}
+
+BENCHMARK_UNSIZED("User/to_json",
+                  [](Bench::State& state) { ToJson<User>(state, UserJson()); });
+BENCHMARK_UNSIZED("User/from_json", [](Bench::State& state) {
+  FromJson<User>(state, UserJson());
+});
+BENCHMARK_UNSIZED("Issue/to_json", [](Bench::State& state) {
+  ToJson<Issue>(state, IssueJson());
+});
+BENCHMARK_UNSIZED("Issue/from_json", [](Bench::State& state) {
+  FromJson<Issue>(state, IssueJson());
+});
+BENCHMARK_UNSIZED("Comment/to_json", [](Bench::State& state) {
+  ToJson<Comment>(state, CommentJson());
+});
+BENCHMARK_UNSIZED("Comment/from_json", [](Bench::State& state) {
+  FromJson<Comment>(state, CommentJson());
+});
+BENCHMARK_UNSIZED("Vote/to_json",
+                  [](Bench::State& state) { ToJson<Vote>(state, VoteJson()); });
+BENCHMARK_UNSIZED("Vote/from_json", [](Bench::State& state) {
+  FromJson<Vote>(state, VoteJson());
+});
+}  // namespace
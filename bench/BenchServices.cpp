@@ -0,0 +1,340 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Fixtures.h"
+#include "IssueTable.h"
+#include "TimeIndex.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * The id of the entity in the middle of a collection, so lookups aren't helped
+ * by being at either end of it
+ */
+std::string MiddleId(const std::string& collection, std::size_t size) {
+  std::size_t count =
+      collection == "users" ? Fixtures::UserCount(size) : size;
+  return Fixtures::Id(collection, size, count / 2);
+}
+
+/**
+ * The id of a user in a dataset, for creating entities with
+ */
+std::string UserId(std::size_t size) { return Fixtures::Id("users", size, 1); }
+
+void EntityServiceFilter(Bench::State& state) {
+  auto service = Fixtures::MakeUserService(state.Size());
+  json issues = json::parse(Fixtures::Collection("issues", state.Size()));
+  StringMap query = {{"status", "Fixed"}};
+  while (state.KeepRunning()) {
+    // The view is lazy, so the matches are counted to run the filter
+    Bench::DoNotOptimize(service->Filter(issues, query).size());
+  }
+}
+BENCHMARK_SIZED("EntityService/Filter", EntityServiceFilter, SIZE_MAX);
+
+void IssueTableSelect(Bench::State& state) {
+  IssueTable table(json::parse(Fixtures::Collection("issues", state.Size())));
+  StringMap query = {{"status", "Fixed"}};
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(table.Select(query).Count());
+  }
+}
+BENCHMARK_SIZED("IssueTable/Select", IssueTableSelect, SIZE_MAX);
+
+void IssueTableCount(Bench::State& state) {
+  IssueTable table(json::parse(Fixtures::Collection("issues", state.Size())));
+  StringMap query = {{"status", "New"}, {"status", "Assigned"}};
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(table.Count(query));
+  }
+}
+BENCHMARK_SIZED("IssueTable/Count", IssueTableCount, SIZE_MAX);
+
+void TimeIndexRecentlyUpdated(Bench::State& state) {
+  IssueTable table(json::parse(Fixtures::Collection("issues", state.Size())));
+  StringMap filters;
+  ListOptions options =
+      ListOptions::Parse({{"sort", "-updatedAt"}, {"limit", "10"}}, &filters);
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(table.Times().Select(nullptr, options));
+  }
+}
+BENCHMARK_SIZED("TimeIndex/RecentlyUpdated", TimeIndexRecentlyUpdated,
+                SIZE_MAX);
+
+void TimeIndexRecentlyUpdatedNew(Bench::State& state) {
+  IssueTable table(json::parse(Fixtures::Collection("issues", state.Size())));
+  StringMap filters;
+  ListOptions options = ListOptions::Parse(
+      {{"status", "New"}, {"sort", "-updatedAt"}, {"limit", "10"}}, &filters);
+  while (state.KeepRunning()) {
+    std::vector<std::size_t> rows = table.Select(filters).Rows();
+    Bench::DoNotOptimize(table.Times().Select(&rows, options));
+  }
+}
+BENCHMARK_SIZED("TimeIndex/RecentlyUpdatedNew", TimeIndexRecentlyUpdatedNew,
+                SIZE_MAX);
+
+// UserService
+
+void UserServiceGet(Bench::State& state) {
+  auto service = Fixtures::MakeUserService(state.Size());
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(StringMap{{"role", "Tester"}}));
+  }
+}
+BENCHMARK_SIZED("UserService/Get", UserServiceGet, SIZE_MAX);
+
+void UserServiceGetById(Bench::State& state) {
+  auto service = Fixtures::MakeUserService(state.Size());
+  std::string id = MiddleId("users", state.Size());
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(id));
+  }
+}
+BENCHMARK_SIZED("UserService/GetById", UserServiceGetById, SIZE_MAX);
+
+void UserServiceCreate(Bench::State& state) {
+  auto service = Fixtures::MakeUserService(state.Size());
+  int created = 0;
+  while (state.KeepRunning()) {
+    // Names have to be unique
+    json user = {{"name", "New user " + std::to_string(created++)},
+                 {"role", "Developer"}};
+    Bench::DoNotOptimize(service->Create(user.dump()));
+  }
+}
+BENCHMARK_SIZED("UserService/Create", UserServiceCreate, SIZE_MAX);
+
+void UserServiceUpdate(Bench::State& state) {
+  auto service = Fixtures::MakeUserService(state.Size());
+  std::string id = MiddleId("users", state.Size());
+  std::string body =
+      json({{"id", id}, {"name", "Renamed " + id}, {"role", "Manager"}})
+          .dump();
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Update(body));
+  }
+}
+BENCHMARK_SIZED("UserService/Update", UserServiceUpdate, SIZE_MAX);
+
+void UserServiceDelete(Bench::State& state) {
+  auto service = Fixtures::MakeUserService(state.Size());
+  int created = 0;
+  while (state.KeepRunning()) {
+    // Put a user back for every one deleted, so the dataset keeps its size
+    state.PauseTiming();
+    json user = {{"name", "Deleted user " + std::to_string(created++)},
+                 {"role", "Developer"}};
+    std::string id = service->Create(user.dump()).id;
+    state.ResumeTiming();
+
+    Bench::DoNotOptimize(service->Delete(id));
+  }
+}
+BENCHMARK_SIZED("UserService/Delete", UserServiceDelete, SIZE_MAX);
+
+// CommentService
+
+void CommentServiceGet(Bench::State& state) {
+  auto service = Fixtures::MakeCommentService(state.Size());
+  StringMap query = {{"issueId", MiddleId("issues", state.Size())}};
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(query));
+  }
+}
+BENCHMARK_SIZED("CommentService/Get", CommentServiceGet, SIZE_MAX);
+
+void CommentServiceGetById(Bench::State& state) {
+  auto service = Fixtures::MakeCommentService(state.Size());
+  std::string id = MiddleId("comments", state.Size());
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(id));
+  }
+}
+BENCHMARK_SIZED("CommentService/GetById", CommentServiceGetById, SIZE_MAX);
+
+void CommentServiceCreate(Bench::State& state) {
+  auto service = Fixtures::MakeCommentService(state.Size());
+  std::string body = json({{"issueId", MiddleId("issues", state.Size())},
+                           {"body", "A new comment"},
+                           {"createdBy", UserId(state.Size())}})
+                         .dump();
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Create(body));
+  }
+}
+BENCHMARK_SIZED("CommentService/Create", CommentServiceCreate, SIZE_MAX);
+
+void CommentServiceUpdate(Bench::State& state) {
+  auto service = Fixtures::MakeCommentService(state.Size());
+  std::string id = MiddleId("comments", state.Size());
+  std::string body = json({{"id", id},
+                           {"issueId", MiddleId("issues", state.Size())},
+                           {"body", "An edited comment"},
+                           {"createdBy", UserId(state.Size())},
+                           {"updatedBy", UserId(state.Size())}})
+                         .dump();
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Update(body));
+  }
+}
+BENCHMARK_SIZED("CommentService/Update", CommentServiceUpdate, SIZE_MAX);
+
+void CommentServiceDelete(Bench::State& state) {
+  auto service = Fixtures::MakeCommentService(state.Size());
+  std::string body = json({{"issueId", MiddleId("issues", state.Size())},
+                           {"body", "A comment to delete"},
+                           {"createdBy", UserId(state.Size())}})
+                         .dump();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::string id = service->Create(body).id;
+    state.ResumeTiming();
+
+    Bench::DoNotOptimize(service->Delete(id));
+  }
+}
+BENCHMARK_SIZED("CommentService/Delete", CommentServiceDelete, SIZE_MAX);
+
+// VoteService
+
+void VoteServiceGet(Bench::State& state) {
+  auto service = Fixtures::MakeVoteService(state.Size());
+  StringMap query = {{"issueId", MiddleId("issues", state.Size())}};
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(query));
+  }
+}
+BENCHMARK_SIZED("VoteService/Get", VoteServiceGet, SIZE_MAX);
+
+void VoteServiceGetById(Bench::State& state) {
+  auto service = Fixtures::MakeVoteService(state.Size());
+  std::string id = MiddleId("votes", state.Size());
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(id));
+  }
+}
+BENCHMARK_SIZED("VoteService/GetById", VoteServiceGetById, SIZE_MAX);
+
+void VoteServiceCreate(Bench::State& state) {
+  auto service = Fixtures::MakeVoteService(state.Size());
+  std::string body =
+      json({{"issueId", MiddleId("issues", state.Size())}, {"createdBy", UserId(state.Size())}})
+          .dump();
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Create(body));
+  }
+}
+BENCHMARK_SIZED("VoteService/Create", VoteServiceCreate, SIZE_MAX);
+
+void VoteServiceDelete(Bench::State& state) {
+  auto service = Fixtures::MakeVoteService(state.Size());
+  std::string body =
+      json({{"issueId", MiddleId("issues", state.Size())}, {"createdBy", UserId(state.Size())}})
+          .dump();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::string id = service->Create(body).id;
+    state.ResumeTiming();
+
+    Bench::DoNotOptimize(service->Delete(id));
+  }
+}
+BENCHMARK_SIZED("VoteService/Delete", VoteServiceDelete, SIZE_MAX);
+
+// IssueService
+
+void IssueServiceGetRecentlyUpdated(Bench::State& state) {
+  auto service = Fixtures::MakeIssueService(state.Size());
+  StringMap query = {{"sort", "-updatedAt"}, {"limit", "10"}};
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(query));
+  }
+}
+BENCHMARK_SIZED("IssueService/GetRecentlyUpdated",
+                IssueServiceGetRecentlyUpdated, SIZE_MAX);
+
+void IssueServiceGet(Bench::State& state) {
+  auto service = Fixtures::MakeIssueService(state.Size());
+  // Users report about ten issues each on average, whatever the size
+  StringMap query = {{"reporter", UserId(state.Size())}};
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(query));
+  }
+}
+BENCHMARK_SIZED("IssueService/Get", IssueServiceGet, SIZE_MAX);
+
+void IssueServiceGetAll(Bench::State& state) {
+  auto service = Fixtures::MakeIssueService(state.Size());
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(StringMap{}));
+  }
+}
+// Listing every issue looks up the users, comments and votes of each one, so
+// it is quadratic in the size of the dataset
+BENCHMARK_SIZED("IssueService/GetAll", IssueServiceGetAll, 1000);
+
+void IssueServiceGetById(Bench::State& state) {
+  auto service = Fixtures::MakeIssueService(state.Size());
+  std::string id = MiddleId("issues", state.Size());
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Get(id));
+  }
+}
+BENCHMARK_SIZED("IssueService/GetById", IssueServiceGetById, SIZE_MAX);
+
+void IssueServiceCreate(Bench::State& state) {
+  auto service = Fixtures::MakeIssueService(state.Size());
+  std::string body = json({{"title", "A new issue"},
+                           {"status", "New"},
+                           {"createdBy", UserId(state.Size())},
+                           {"reporter", UserId(state.Size())},
+                           {"assignedTo", UserId(state.Size())}})
+                         .dump();
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Create(body));
+  }
+}
+BENCHMARK_SIZED("IssueService/Create", IssueServiceCreate, SIZE_MAX);
+
+void IssueServiceUpdate(Bench::State& state) {
+  auto service = Fixtures::MakeIssueService(state.Size());
+  std::string id = MiddleId("issues", state.Size());
+  std::string body = json({{"id", id},
+                           {"title", "An edited issue"},
+                           {"status", "Assigned"},
+                           {"createdBy", UserId(state.Size())},
+                           {"reporter", UserId(state.Size())},
+                           {"assignedTo", UserId(state.Size())},
+                           {"updatedBy", UserId(state.Size())}})
+                         .dump();
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(service->Update(body));
+  }
+}
+BENCHMARK_SIZED("IssueService/Update", IssueServiceUpdate, SIZE_MAX);
+
+void IssueServiceDelete(Bench::State& state) {
+  auto service = Fixtures::MakeIssueService(state.Size());
+  std::string body = json({{"title", "An issue to delete"},
+                           {"status", "New"},
+                           {"createdBy", UserId(state.Size())},
+                           {"reporter", UserId(state.Size())}})
+                         .dump();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::string id = service->Create(body).id;
+    state.ResumeTiming();
+
+    Bench::DoNotOptimize(service->Delete(id));
+  }
+}
+BENCHMARK_SIZED("IssueService/Delete", IssueServiceDelete, SIZE_MAX);
+}  // namespace
@@ -0,0 +1,74 @@
+#ifndef BENCH_SESSION_H
+#define BENCH_SESSION_H
+
+#include <restbed>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * @class BenchSession
+ * @brief An in-memory session for driving the controllers without a network
+ *
+ * It has the same interface as the MockSession the controller tests use, so
+ * the controllers can be instantiated with it, but it simply hands the request
+ * body to fetch and keeps what is passed to yield or close. gmock's call
+ * matching would otherwise be measured along with the controllers
+ */
+class BenchSession : public std::enable_shared_from_this<BenchSession> {
+ public:
+  /**
+   * Constructor
+   * @param request the request the session is for
+   */
+  explicit BenchSession(const std::shared_ptr<restbed::Request>& request)
+      : _request(request) {}
+  ~BenchSession() {}
+
+  const std::shared_ptr<restbed::Request> get_request() { return _request; }
+
+  std::string get_path_parameter(std::string name) {
+    return _request->get_path_parameter(name);
+  }
+
+  void yield(const int status, const std::string& body,
+             const std::multimap<std::string, std::string>& /*headers*/) {
+    _status = status;
+    _body = body;
+  }
+
+  void close(const int status, const std::string& body,
+             const std::multimap<std::string, std::string>& headers) {
+    yield(status, body, headers);
+  }
+
+  void fetch(const std::size_t length,
+             const std::function<void(const std::shared_ptr<BenchSession>&,
+                                      const restbed::Bytes&)>& callback) {
+    const restbed::Bytes& body = _request->get_body();
+    callback(shared_from_this(),
+             restbed::Bytes(body.begin(),
+                            body.begin() + std::min(length, body.size())));
+  }
+
+  /**
+   * @return the status the controller responded with
+   */
+  int Status() const { return _status; }
+
+  /**
+   * @return the body the controller responded with
+   */
+  const std::string& Body() const { return _body; }
+
+ private:
+  std::shared_ptr<restbed::Request> _request;
+  int _status = 0;
+  std::string _body;
+};
+
+#endif  // BENCH_SESSION_H
@@ -0,0 +1,34 @@
+#include <ctime>
+#include <string>
+
+#include "Benchmark.h"
+#include "Utilities.h"
+
+namespace {
+const char* const CreatedAt = "Thu Dec 10 06:49:49 2020";
+
+BENCHMARK_UNSIZED("TimeUtilities/ConvertStringToTime", [](Bench::State& state) {
+  std::string time = CreatedAt;
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(TimeUtilities::ConvertStringToTime(time));
+  }
+});
+BENCHMARK_UNSIZED("TimeUtilities/ConvertTimeToString", [](Bench::State& state) {
+  struct tm time = TimeUtilities::ConvertStringToTime(CreatedAt);
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(TimeUtilities::ConvertTimeToString(time));
+  }
+});
+BENCHMARK_UNSIZED("TimeUtilities/DateComparator", [](Bench::State& state) {
+  struct tm earlier = TimeUtilities::ConvertStringToTime(CreatedAt);
+  struct tm later = TimeUtilities::CurrentTimeUTC();
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(TimeUtilities::DateComparator(earlier, later));
+  }
+});
+BENCHMARK_UNSIZED("TimeUtilities/CurrentTimeUTC", [](Bench::State& state) {
+  while (state.KeepRunning()) {
+    Bench::DoNotOptimize(TimeUtilities::CurrentTimeUTC());
+  }
+});
+}  // namespace
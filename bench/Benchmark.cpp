@@ -0,0 +1,213 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocationBytes{0};
+
+void* Allocate(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocationBytes.fetch_add(size, std::memory_order_relaxed);
+  void* memory = std::malloc(size > 0 ? size : 1);
+  if (memory == nullptr) throw std::bad_alloc();
+  return memory;
+}
+}  // namespace
+
+// Every allocation in the program goes through these, so the benchmarks can
+// report how much they allocate
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return Allocate(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return Allocate(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+namespace Bench {
+Allocations CurrentAllocations() {
+  Allocations allocations;
+  allocations.count = allocationCount.load(std::memory_order_relaxed);
+  allocations.bytes = allocationBytes.load(std::memory_order_relaxed);
+  return allocations;
+}
+
+bool State::KeepRunning() {
+  if (!_started) {
+    _started = true;
+    ResumeTiming();
+  }
+  if (_completed < _iterations) {
+    _completed++;
+    return true;
+  }
+  PauseTiming();
+  return false;
+}
+
+void State::PauseTiming() {
+  if (!_running) return;
+  _elapsed += std::chrono::steady_clock::now() - _start;
+  Allocations now = CurrentAllocations();
+  _allocated.count += now.count - _startAllocations.count;
+  _allocated.bytes += now.bytes - _startAllocations.bytes;
+  _running = false;
+}
+
+void State::ResumeTiming() {
+  if (_running) return;
+  _startAllocations = CurrentAllocations();
+  _start = std::chrono::steady_clock::now();
+  _running = true;
+}
+
+std::vector<Benchmark>& Registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+bool Register(const Benchmark& benchmark) {
+  Registry().push_back(benchmark);
+  return true;
+}
+}  // namespace Bench
+
+namespace {
+/**
+ * Runs a benchmark with more and more iterations, until it runs for at least
+ * the minimum time
+ */
+Bench::State Measure(const Bench::Benchmark& benchmark, std::size_t size,
+                     double minSeconds) {
+  auto minTime = std::chrono::duration<double>(minSeconds);
+  uint64_t iterations = 1;
+  while (true) {
+    Bench::State state(size, iterations);
+    benchmark.function(state);
+
+    auto elapsed = std::chrono::duration<double>(state.Elapsed());
+    if (elapsed >= minTime || iterations >= 1000000000) {
+      return state;
+    }
+
+    // Aim a little past the minimum time, but don't grow too quickly from a
+    // run that was too short to time well
+    double scale = elapsed.count() > 0
+                       ? minTime.count() / elapsed.count() * 1.4
+                       : 100.0;
+    iterations = std::max<uint64_t>(
+        iterations + 1,
+        static_cast<uint64_t>(iterations * std::min(scale, 100.0)));
+  }
+}
+
+/**
+ * Parses a comma separated list of sizes (i.e. 1000,10000)
+ */
+std::vector<std::size_t> ParseSizes(const std::string& text) {
+  std::vector<std::size_t> sizes;
+  std::stringstream stream(text);
+  std::string size;
+  while (std::getline(stream, size, ',')) {
+    if (!size.empty()) sizes.push_back(std::stoul(size));
+  }
+  return sizes;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options("benchProgram",
+                           "Micro-benchmarks for the hotTicket services");
+  // clang-format off
+  options.add_options()
+    ("s,sizes", "Comma separated dataset sizes to run against",
+                cxxopts::value<std::string>()->default_value("1000,10000"))
+    ("f,filter", "Only run benchmarks whose name contains this text",
+                 cxxopts::value<std::string>()->default_value(""))
+    ("t,min-time", "Least time to run each benchmark for, in seconds",
+                   cxxopts::value<double>()->default_value("0.2"))
+    ("format", "Output format: json (one object per line) or csv",
+               cxxopts::value<std::string>()->default_value("json"))
+    ("h,help", "Print help text");
+  // clang-format on
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  std::vector<std::size_t> sizes = ParseSizes(result["sizes"].as<std::string>());
+  std::string filter = result["filter"].as<std::string>();
+  double minTime = result["min-time"].as<double>();
+  bool csv = result["format"].as<std::string>() == "csv";
+
+  if (csv) {
+    std::cout << "name,size,iterations,ns_per_op,allocs_per_op,bytes_per_op"
+              << std::endl;
+  }
+
+  for (auto& benchmark : Bench::Registry()) {
+    if (benchmark.name.find(filter) == std::string::npos) continue;
+
+    std::vector<std::size_t> benchmarkSizes = {0};
+    if (benchmark.sized) benchmarkSizes = sizes;
+
+    for (auto size : benchmarkSizes) {
+      if (size > benchmark.maxSize) continue;
+
+      Bench::State state = Measure(benchmark, size, minTime);
+      double iterations = static_cast<double>(state.Iterations());
+      double nsPerOp = state.Elapsed().count() / iterations;
+      double allocsPerOp = state.Allocated().count / iterations;
+      double bytesPerOp = state.Allocated().bytes / iterations;
+
+      if (csv) {
+        std::cout << benchmark.name << "," << size << ","
+                  << state.Iterations() << "," << std::fixed
+                  << std::setprecision(1) << nsPerOp << "," << allocsPerOp
+                  << "," << bytesPerOp << std::endl;
+      } else {
+        json line = {{"name", benchmark.name},
+                     {"size", size},
+                     {"iterations", state.Iterations()},
+                     {"ns_per_op", nsPerOp},
+                     {"allocs_per_op", allocsPerOp},
+                     {"bytes_per_op", bytesPerOp}};
+        std::cout << line.dump() << std::endl;
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace Bench
+ * @brief A small, self-contained micro-benchmark harness
+ *
+ * Benchmarks are functions that set up what they need and then repeat the
+ * operation being measured while State::KeepRunning returns true. Only the
+ * time and allocations inside that loop are counted
+ * \verbatim
+ * void UserServiceGet(Bench::State& state) {
+ *   auto service = Fixtures::MakeUserService(state.Size());
+ *   while (state.KeepRunning()) {
+ *     service->Get("u0");
+ *   }
+ * }
+ * BENCHMARK(UserServiceGet);
+ * \endverbatim
+ */
+namespace Bench {
+/**
+ * Counts of the memory allocated since the program started
+ */
+struct Allocations {
+  /**
+   * The number of allocations
+   */
+  uint64_t count = 0;
+
+  /**
+   * The number of bytes allocated
+   */
+  uint64_t bytes = 0;
+};
+
+/**
+ * @return the allocations made so far, by every thread
+ */
+Allocations CurrentAllocations();
+
+/**
+ * @class State
+ * @brief Runs the measured loop of a benchmark, and keeps its measurements
+ */
+class State {
+ public:
+  /**
+   * Constructor
+   * @param size the number of records in the dataset
+   * @param iterations how many times to run the operation
+   */
+  State(std::size_t size, uint64_t iterations)
+      : _size(size), _iterations(iterations) {}
+
+  /**
+   * Starts the timer the first time it is called
+   * @return whether the operation should be run again
+   */
+  bool KeepRunning();
+
+  /**
+   * Stops counting time and allocations, for work that isn't part of the
+   * operation (i.e. putting back a deleted record)
+   */
+  void PauseTiming();
+
+  /**
+   * Starts counting time and allocations again
+   */
+  void ResumeTiming();
+
+  /**
+   * @return the number of records in the dataset
+   */
+  std::size_t Size() const { return _size; }
+
+  /**
+   * @return how many times the operation is run
+   */
+  uint64_t Iterations() const { return _iterations; }
+
+  /**
+   * @return the time spent running the operation
+   */
+  std::chrono::nanoseconds Elapsed() const { return _elapsed; }
+
+  /**
+   * @return the allocations made while running the operation
+   */
+  Allocations Allocated() const { return _allocated; }
+
+ private:
+  std::size_t _size;
+  uint64_t _iterations;
+  uint64_t _completed = 0;
+  bool _started = false;
+  bool _running = false;
+  std::chrono::steady_clock::time_point _start;
+  std::chrono::nanoseconds _elapsed{0};
+  Allocations _startAllocations;
+  Allocations _allocated;
+};
+
+/**
+ * A registered benchmark
+ */
+struct Benchmark {
+  /**
+   * The name of the benchmark (i.e. UserService/Get)
+   */
+  std::string name;
+
+  /**
+   * The benchmark itself
+   */
+  std::function<void(State&)> function;
+
+  /**
+   * Whether the benchmark runs against a dataset. Benchmarks that don't are
+   * run once, with a size of 0
+   */
+  bool sized = true;
+
+  /**
+   * The largest dataset the benchmark is run against. Operations that are
+   * quadratic in the size of the dataset would take hours at the largest
+   * sizes, so they can be capped
+   */
+  std::size_t maxSize = SIZE_MAX;
+};
+
+/**
+ * @return every registered benchmark, in the order they were registered
+ */
+std::vector<Benchmark>& Registry();
+
+/**
+ * Registers a benchmark
+ * @param benchmark the benchmark
+ * @return true, so registration can happen in a static initializer
+ */
+bool Register(const Benchmark& benchmark);
+
+/**
+ * Prevents the compiler from optimizing away a value that isn't used
+ * @param value the value
+ */
+template <typename T>
+void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+}  // namespace Bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+/**
+ * Registers a benchmark run against each dataset size
+ */
+#define BENCHMARK_SIZED(name, function, maxSize)            \
+  static bool BENCH_CONCAT(_registered_, __LINE__) =        \
+      Bench::Register({name, function, true, maxSize})
+
+/**
+ * Registers a benchmark that doesn't use a dataset
+ */
+#define BENCHMARK_UNSIZED(name, function)                   \
+  static bool BENCH_CONCAT(_registered_, __LINE__) =        \
+      Bench::Register({name, function, false, SIZE_MAX})
+
+#endif  // BENCHMARK_H
@@ -0,0 +1,94 @@
+#include "Fixtures.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DatasetGenerator.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * A dataset, serialized the way the services store it, along with the ids of
+ * each collection in order
+ */
+struct Generated {
+  std::map<std::string, std::string> collections;
+  std::map<std::string, std::vector<std::string>> ids;
+};
+
+const Generated& Generate(std::size_t size) {
+  static std::map<std::size_t, Generated> generated;
+  auto itGenerated = generated.find(size);
+  if (itGenerated != generated.end()) return itGenerated->second;
+
+  DatasetOptions options;
+  options.users = Fixtures::UserCount(size);
+  options.issues = size;
+  options.comments = size;
+  options.votes = size;
+  Dataset dataset = DatasetGenerator(options).Generate();
+
+  Generated& result = generated[size];
+  const std::pair<const char*, json*> collections[] = {
+      {"users", &dataset.users},
+      {"issues", &dataset.issues},
+      {"comments", &dataset.comments},
+      {"votes", &dataset.votes}};
+  for (auto& collection : collections) {
+    std::vector<std::string>& ids = result.ids[collection.first];
+    for (auto& entity : *collection.second) ids.push_back(entity["id"]);
+    result.collections[collection.first] = collection.second->dump();
+  }
+  return result;
+}
+
+std::shared_ptr<IStreamableFileHandler> Handler(const std::string& collection,
+                                                std::size_t size) {
+  return std::make_shared<MemoryFileHandler>(
+      Fixtures::Collection(collection, size));
+}
+}  // namespace
+
+namespace Fixtures {
+std::size_t UserCount(std::size_t size) {
+  return std::max<std::size_t>(10, size / 10);
+}
+
+const std::string& Collection(const std::string& collection,
+                              std::size_t size) {
+  return Generate(size).collections.at(collection);
+}
+
+const std::string& Id(const std::string& collection, std::size_t size,
+                      std::size_t index) {
+  return Generate(size).ids.at(collection).at(index);
+}
+
+std::shared_ptr<UserService> MakeUserService(std::size_t size) {
+  return std::make_shared<UserService>(Handler("users", size));
+}
+
+std::shared_ptr<CommentService> MakeCommentService(std::size_t size) {
+  return std::make_shared<CommentService>(Handler("comments", size),
+                                          MakeUserService(size));
+}
+
+std::shared_ptr<VoteService> MakeVoteService(std::size_t size) {
+  return std::make_shared<VoteService>(Handler("votes", size),
+                                       MakeUserService(size));
+}
+
+std::shared_ptr<IssueService> MakeIssueService(std::size_t size) {
+  auto userService = MakeUserService(size);
+  return std::make_shared<IssueService>(
+      Handler("issues", size), userService,
+      std::make_shared<CommentService>(Handler("comments", size), userService),
+      std::make_shared<VoteService>(Handler("votes", size), userService));
+}
+}  // namespace Fixtures
@@ -0,0 +1,100 @@
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "CommentService.h"
+#include "IStreamableFileHandler.h"
+#include "IssueService.h"
+#include "UserService.h"
+#include "VoteService.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @class MemoryFileHandler
+ * @brief Keeps a collection as serialized JSON in memory instead of on disk
+ *
+ * Reads and writes still parse and serialize the whole collection, like
+ * FileHandler does, so the benchmarks measure the services without the disk
+ */
+class MemoryFileHandler : public IStreamableFileHandler {
+ public:
+  /**
+   * Constructor
+   * @param data the serialized collection
+   */
+  explicit MemoryFileHandler(const std::string& data) : _data(data) {}
+  virtual ~MemoryFileHandler() {}
+
+  json read() override { return json::parse(_data); }
+
+  void write(const json& updatedJson) override { _data = updatedJson.dump(); }
+
+ private:
+  std::string _data;
+};
+
+/**
+ * @namespace Fixtures
+ * @brief Builds services loaded with generated datasets for the benchmarks
+ *
+ * A dataset of size n is made by the DatasetGenerator, with n issues, n
+ * comments and n votes spread over n / 10 users (at least 10). The same size
+ * always gives the same dataset
+ */
+namespace Fixtures {
+/**
+ * @param size the size of the dataset
+ * @return the number of users in the dataset
+ */
+std::size_t UserCount(std::size_t size);
+
+/**
+ * Gets a serialized collection of a dataset. Collections are generated once
+ * per size and reused
+ * @param collection users, issues, comments or votes
+ * @param size the size of the dataset
+ * @return the collection, serialized as a JSON array
+ */
+const std::string& Collection(const std::string& collection, std::size_t size);
+
+/**
+ * Gets the id of an entity in a dataset
+ * @param collection users, issues, comments or votes
+ * @param size the size of the dataset
+ * @param index the position of the entity in its collection
+ * @return the id of the entity
+ */
+const std::string& Id(const std::string& collection, std::size_t size,
+                      std::size_t index);
+
+/**
+ * @param size the size of the dataset
+ * @return a UserService loaded with the users of the dataset
+ */
+std::shared_ptr<UserService> MakeUserService(std::size_t size);
+
+/**
+ * @param size the size of the dataset
+ * @return a CommentService loaded with the comments of the dataset
+ */
+std::shared_ptr<CommentService> MakeCommentService(std::size_t size);
+
+/**
+ * @param size the size of the dataset
+ * @return a VoteService loaded with the votes of the dataset
+ */
+std::shared_ptr<VoteService> MakeVoteService(std::size_t size);
+
+/**
+ * @param size the size of the dataset
+ * @return an IssueService loaded with the whole dataset
+ */
+std::shared_ptr<IssueService> MakeIssueService(std::size_t size);
+}  // namespace Fixtures
+
+#endif  // FIXTURES_H
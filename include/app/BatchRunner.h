@@ -0,0 +1,148 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <restbed>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "User.h"
+#include "Utilities.h"
+
+/**
+ * @class BatchRunner
+ * @brief Runs a script of commands against the server without any prompts,
+ * so the client can be used from scripts and automation
+ *
+ * Each line of a script is one command. Blank lines and lines starting with #
+ * are skipped
+ * \verbatim
+ * create <collection> <json>       (i.e. create issues {"title": "..."})
+ * update <collection> <id> <json>
+ * patch <collection> <id> <json>
+ * delete <collection> <id>
+ * comment <issueId> <text>
+ * vote <issueId>                   (casts or removes your vote)
+ * \endverbatim
+ * Commands are sent without waiting for the ones before them to finish, up to
+ * a limit, except that commands on the same entity are always sent in order
+ */
+class BatchRunner {
+ public:
+  /**
+   * A command from a script, ready to be sent
+   */
+  struct Command {
+    /**
+     * The line of the script the command is on
+     */
+    int line = 0;
+
+    /**
+     * The HTTP method (i.e. POST)
+     */
+    std::string method;
+
+    /**
+     * The endpoint (i.e. /issues/abc123defg)
+     */
+    std::string endpoint;
+
+    /**
+     * The request body, if any
+     */
+    std::string body;
+
+    /**
+     * The entity the command changes. Commands with the same target are sent
+     * in order, and commands without one (creates) can be sent at any time
+     */
+    std::string target;
+  };
+
+  /**
+   * The most commands in flight at once when no limit is given
+   */
+  static constexpr std::size_t DefaultJobs =
+      RequestUtilities::ConnectionPool::DefaultConnections;
+
+  /**
+   * Constructor
+   * @param serverUri the URI of the server
+   * @param user the User the commands are run as, used as the author of
+   * comments, votes and new entities
+   * @param jobs the most commands to have in flight at once
+   */
+  BatchRunner(const std::string& serverUri, const User& user,
+              std::size_t jobs = DefaultJobs)
+      : _serverUri(serverUri), _user(user), _jobs(jobs > 0 ? jobs : 1) {}
+  virtual ~BatchRunner() {}
+
+  /**
+   * Runs every command in a script, reporting the commands that fail and how
+   * long the script took
+   * @param script the script to run
+   * @param out where to write the report
+   * @return whether every command succeeded
+   */
+  bool Run(std::istream& script, std::ostream& out);
+
+  /**
+   * Parses one line of a script
+   * @param text the text of the line
+   * @param line the line number, for error messages
+   * @return the command
+   * @throw BadRequestError if the line isn't a valid command
+   */
+  Command Parse(const std::string& text, int line);
+
+ protected:
+  /**
+   * A command that has been sent, and the response that will arrive for it
+   */
+  struct InFlight {
+    Command command;
+    std::future<std::shared_ptr<restbed::Response>> response;
+  };
+
+  /**
+   * Waits for the oldest command in flight to finish, and reports it if it
+   * failed
+   * @param out where to write the report
+   * @return whether the command succeeded
+   */
+  bool Finish(std::ostream& out);
+
+  /**
+   * Builds the request for a command
+   * @param command the command
+   * @return the request
+   */
+  std::shared_ptr<restbed::Request> BuildRequest(const Command& command);
+
+  /**
+   * The URI of the server
+   */
+  std::string _serverUri;
+
+  /**
+   * The User the commands are run as
+   */
+  User _user;
+
+  /**
+   * The most commands to have in flight at once
+   */
+  std::size_t _jobs;
+
+  /**
+   * The commands that have been sent, oldest first
+   */
+  std::deque<InFlight> _inFlight;
+};
+
+#endif  // BATCH_RUNNER_H
@@ -1,11 +1,19 @@
 #ifndef CLIENT_APP_MANAGER_H
 #define CLIENT_APP_MANAGER_H
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "AppManager.h"
+#include "Comment.h"
+#include "Issue.h"
+#include "LocalCache.h"
 #include "User.h"
+#include "Utilities.h"
 
 /**
  * @class ClientAppManager
@@ -23,16 +31,90 @@ class ClientAppManager {
   static bool Init(int argc, char* argv[]);
 
   /**
-   * Runs the client app
+   * Runs the client app, either through the menus or by running a script
    */
   static void Run();
 
+  /**
+   * Runs the script given on the command line with a BatchRunner, without
+   * any prompts
+   * @returns whether every command in the script succeeded
+   */
+  static bool RunScript();
+
   static User CurrentUser();
 
   static void SetUser(const User& user);
 
   static std::string ServerURI();
 
+  /**
+   * Applies the changes made on the server since the last sync to the local
+   * cache. If the server can't be reached, the client browses the cache
+   * offline until it can be reached again
+   */
+  static void Sync();
+
+  /**
+   * @returns whether the server couldn't be reached the last time the client
+   * tried
+   */
+  static bool Offline();
+
+  /**
+   * Switches to browsing the local cache, for when the server can't be reached
+   * at startup
+   * @returns whether there is a cache to browse
+   */
+  static bool StartOffline();
+
+  /**
+   * Gets the Issues that match a query from the local cache, fetching all of
+   * the Issues the first time they are needed
+   * @param query the values to match, by field. Issues match if each field has
+   * one of the values given for it
+   * @returns the matching Issues
+   */
+  static std::vector<Issue> GetIssues(const StringMap& query);
+
+  /**
+   * Gets the Comments on an Issue from the local cache, fetching them the
+   * first time they are needed
+   * @param issueId the id of the Issue
+   * @returns the Comments, oldest first
+   */
+  static std::multiset<Comment> GetComments(const std::string& issueId);
+
+  /**
+   * Gets the Users that match a query from the local cache, fetching all of
+   * the Users the first time they are needed
+   * @param query the values to match, by field (i.e. name)
+   * @returns the matching Users
+   */
+  static std::vector<User> FindUsers(const StringMap& query = {});
+
+  /**
+   * Gets a User from the local cache, or from the server if it isn't cached
+   * @param id the id of the User
+   * @returns the User, or a User named "Unknown user" if they couldn't be found
+   */
+  static User GetUser(const std::string& id);
+
+  /**
+   * Gets several Users at once. Users that aren't cached yet are fetched from
+   * the server concurrently
+   * @param ids the ids of the Users. Empty ids are ignored
+   * @returns the Users, by id
+   */
+  static std::map<EntityId, User> GetUsers(const std::set<EntityId>& ids);
+
+  /**
+   * Removes a User from the cache, so they are fetched again the next time
+   * they are needed. Should be called after a User is changed
+   * @param id the id of the User
+   */
+  static void ForgetUser(const std::string& id);
+
  private:
   /**
    * The configuration properties for the client app
@@ -43,6 +125,55 @@ class ClientAppManager {
    * The currently logged in user
    */
   static User _user;
+
+  /**
+   * Fetches a request in full into the local cache, unless it already has
+   * been or the client is offline
+   * @param collection the collection the request returns
+   * @param endpoint the endpoint to fetch (i.e. /issues)
+   */
+  static void Fetch(const std::string& collection, const std::string& endpoint);
+
+  /**
+   * Saves the local cache to disk, if it is kept between sessions
+   */
+  static void SaveCache();
+
+  /**
+   * The Issues, Comments and Users fetched from the server
+   */
+  static std::shared_ptr<LocalCache> _cache;
+
+  /**
+   * Whether the local cache is saved between sessions
+   */
+  static bool _persistCache;
+
+  /**
+   * Whether the server couldn't be reached the last time the client tried
+   */
+  static bool _offline;
+
+  /**
+   * Makes sure only one sync runs at a time
+   */
+  static std::mutex _syncMutex;
+
+  /**
+   * The script to run instead of the menus, or - for stdin. Empty when the
+   * client is used interactively
+   */
+  static std::string _script;
+
+  /**
+   * The name of the User the script is run as
+   */
+  static std::string _scriptUser;
+
+  /**
+   * The most script commands to send at once
+   */
+  static int _jobs;
 };
 
 #endif  // CLIENT_APP_MANAGER_H
@@ -0,0 +1,242 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <restbed>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "Utilities.h"
+
+/**
+ * @class LoadGenerator
+ * @brief Drives the REST API with a mix of operations and reports the
+ * throughput and latency percentiles of each one, to check the server's
+ * capacity
+ *
+ * Each worker acts as one user, picking operations at random in proportion to
+ * the mix:
+ * \verbatim
+ * list     GET /issues?status=<status>
+ * get      GET /issues/<id>
+ * create   POST /issues
+ * comment  POST /comments
+ * vote     POST /issues/<id>/votes, which casts or removes the user's vote
+ * \endverbatim
+ * With a target rate, requests are scheduled at fixed intervals whether or
+ * not earlier ones have finished (open loop), and latency is measured from
+ * when a request was scheduled rather than when it was sent. A slow server
+ * then shows up as higher latency instead of fewer requests, which avoids
+ * coordinated omission. Without a rate, every worker sends its next request
+ * as soon as the last one finishes (closed loop)
+ */
+class LoadGenerator {
+ public:
+  /**
+   * The operations a workload is made of
+   */
+  enum Operation { List, Get, Create, Comment, Vote, OperationCount };
+
+  /**
+   * The names of the operations, in the order of Operation
+   */
+  static const char* const OperationNames[OperationCount];
+
+  /**
+   * The settings of a load test
+   */
+  struct Options {
+    /**
+     * The URI of the server (i.e. http://localhost:8080)
+     */
+    std::string serverUri;
+
+    /**
+     * The weight of each operation, in the order of Operation
+     */
+    std::vector<unsigned> mix;
+
+    /**
+     * The requests per second to send, or 0 to send them as fast as the
+     * workers can
+     */
+    double rate = 0;
+
+    /**
+     * The number of workers sending requests at once
+     */
+    std::size_t concurrency = 16;
+
+    /**
+     * How long to send requests for, in seconds
+     */
+    double duration = 30;
+
+    /**
+     * The seed for picking operations and entities
+     */
+    uint64_t seed = 1;
+  };
+
+  /**
+   * Parses a workload mix, either the name of a profile (read-heavy, mixed or
+   * write-heavy) or weights for each operation (i.e.
+   * list=40,get=40,create=10,comment=5,vote=5). Operations left out of the
+   * weights are never run
+   * @param mix the profile name or weights
+   * @return the weight of each operation, in the order of Operation
+   * @throw BadRequestError if the mix isn't a profile or valid weights
+   */
+  static std::vector<unsigned> ParseMix(const std::string& mix);
+
+  /**
+   * Constructor
+   * @param options the settings of the load test
+   */
+  explicit LoadGenerator(const Options& options);
+  virtual ~LoadGenerator() {}
+
+  /**
+   * Fetches the users and issues the operations are run against
+   * @throw NotFoundError if the server has no users
+   */
+  void Prepare();
+
+  /**
+   * Sends requests for the duration of the test, then waits for the requests
+   * in flight to finish
+   */
+  void Run();
+
+  /**
+   * Writes the throughput and latency of each operation
+   * @param out where to write the report
+   * @param asJson whether to write the report as JSON instead of a table
+   */
+  void Report(std::ostream& out, bool asJson) const;
+
+  /**
+   * @return the number of requests that failed
+   */
+  uint64_t Errors() const;
+
+ private:
+  /**
+   * The results of one operation
+   */
+  struct Results {
+    /**
+     * Latencies, in microseconds
+     */
+    LatencyHistogram latency;
+
+    /**
+     * The number of requests that failed
+     */
+    uint64_t errors = 0;
+  };
+
+  /**
+   * The state of one worker
+   */
+  struct Worker {
+    /**
+     * The user the worker acts as
+     */
+    std::string userId;
+
+    /**
+     * Picks the operations and entities
+     */
+    std::mt19937_64 random;
+
+    /**
+     * The results of each operation, in the order of Operation
+     */
+    std::vector<Results> results;
+  };
+
+  /**
+   * Sends requests until the test is over
+   * @param worker the worker sending them
+   */
+  void Work(Worker* worker);
+
+  /**
+   * Sends the request for one operation
+   * @param operation the operation
+   * @param worker the worker sending it
+   * @return whether the request succeeded
+   */
+  bool Perform(Operation operation, Worker* worker);
+
+  /**
+   * Sends a request
+   * @param method the HTTP method
+   * @param endpoint the endpoint (i.e. /issues)
+   * @param body the request body, if any
+   * @return the response
+   */
+  std::shared_ptr<restbed::Response> Send(const std::string& method,
+                                          const std::string& endpoint,
+                                          const std::string& body = "");
+
+  /**
+   * Picks an issue at random
+   * @param worker the worker picking it
+   * @return the id of the issue, or an empty string if there are none
+   */
+  std::string RandomIssue(Worker* worker);
+
+  /**
+   * The settings of the load test
+   */
+  Options _options;
+
+  /**
+   * The ids of the users on the server
+   */
+  std::vector<std::string> _userIds;
+
+  /**
+   * The ids of the issues on the server, including the ones created during
+   * the test
+   */
+  std::vector<std::string> _issueIds;
+
+  /**
+   * Guards _issueIds
+   */
+  std::mutex _issuesMutex;
+
+  /**
+   * The index of the next request to schedule, for open loop tests
+   */
+  std::atomic<uint64_t> _next{0};
+
+  /**
+   * When the test started
+   */
+  std::chrono::steady_clock::time_point _start;
+
+  /**
+   * How long the test took, including the requests in flight at the end
+   */
+  std::chrono::duration<double> _elapsed{0};
+
+  /**
+   * The combined results of each operation, in the order of Operation
+   */
+  std::vector<Results> _results;
+};
+
+#endif  // LOAD_GENERATOR_H
@@ -9,6 +9,7 @@
 struct ServerConfig {
   bool debug = false;  // No logging enabled by default
   int port = 8080;     // Default port
+  int queryCacheMB = 64;  // Megabytes of list responses cached per collection
 };
 
 /**
@@ -0,0 +1,294 @@
+#ifndef CHANGE_CONTROLLER_H
+#define CHANGE_CONTROLLER_H
+
+#include <restbed>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ChangeLog.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using nlohmann::json;
+using std::placeholders::_1;
+
+/**
+ * @class ChangeController
+ * @brief Serves the ChangeLog from /changes, so clients can sync the changes
+ * made since they last looked instead of fetching whole collections
+ *
+ * Requests can wait for the next change (long polling), and clients that
+ * accept text/event-stream are sent the changes as
+ * [server-sent events](https://html.spec.whatwg.org/multipage/server-sent-events.html).
+ * An event stream holds one batch of changes per connection, and browsers
+ * reconnect for the next one. A waiting request holds a worker of the
+ * restbed::Service, so only a few requests may wait at once
+ * @tparam Session the type for the Session used in the methods. Defaults to
+ * restbed::Session, which is replaced with a mock in testing
+ */
+template <class Session = restbed::Session>
+class ChangeController {
+ public:
+  /**
+   * The most changes sent in one response
+   */
+  static constexpr std::size_t MaxChanges = 500;
+
+  /**
+   * The longest a request can wait for a change, in seconds
+   */
+  static constexpr int MaxWait = 30;
+
+  /**
+   * The most requests that wait for a change at once, unless another limit
+   * is set
+   */
+  static constexpr std::size_t DefaultMaxWaiters = 2;
+
+  /**
+   * Default constructor. Sets the endpoint to "/changes" and leaves the
+   * resource uninitialized
+   */
+  ChangeController()
+      : _endpoint("/changes"), _changeLog(std::make_shared<ChangeLog>()) {}
+
+  /**
+   * Constructor. Sets the endpoint to "/changes" and the ChangeLog, and
+   * initializes the resource
+   * @param changeLog the ChangeLog shared by the services
+   */
+  explicit ChangeController(const std::shared_ptr<ChangeLog>& changeLog)
+      : _endpoint("/changes"), _changeLog(changeLog) {
+    this->resource->set_path(this->_endpoint);
+    this->resource->set_method_handler(
+        "GET", std::bind(&ChangeController::Get, this, _1));
+  }
+  virtual ~ChangeController() {}
+
+  /**
+   * Gets the changes after a sequence number via a GET request to
+   * /changes?since=<sequence>&wait=<seconds>. The sequence can also be sent in
+   * a Last-Event-ID header, which is how browsers resume an event stream, and
+   * since=latest skips the changes that have already been made. If
+   * there are no changes yet, the request waits up to the given number of
+   * seconds for one. The response is a JSON object of the form
+   * \verbatim
+   * {
+   *   "changes": the changes after since, oldest first,
+   *   "next": the sequence to send as since in the next request,
+   *   "latest": the sequence of the latest change,
+   *   "epoch": the epoch of the ChangeLog the sequences belong to
+   * }
+   * \endverbatim
+   * or one event per change if the request accepts text/event-stream. Clients
+   * that have fallen behind the ChangeLog are answered with 410 Gone, and
+   * should fetch the collections again. Requests that would wait while too
+   * many others already are answered with 503 Service Unavailable, and a
+   * Retry-After header
+   * @param session restbed::Session object passed by the restbed::Service
+   */
+  virtual void Get(const std::shared_ptr<Session>& session) {
+    auto request = session->get_request();
+
+    int statusCode;
+    std::string responseBody;
+    StringMap headers;
+    bool stream = false;
+
+    try {
+      if (request == nullptr) {
+        throw BadRequestError("No request found");
+      }
+      stream = request->get_header("Accept").find("text/event-stream") !=
+               std::string::npos;
+
+      std::string sinceParam = request->get_query_parameter("since");
+      uint64_t since =
+          sinceParam == "latest"
+              ? _changeLog->Latest()
+              : ParseNumber(sinceParam, "since",
+                            ParseNumber(request->get_header("Last-Event-ID"),
+                                        "Last-Event-ID", 0));
+      uint64_t wait =
+          std::min(ParseNumber(request->get_query_parameter("wait"), "wait", 0),
+                   static_cast<uint64_t>(MaxWait));
+
+      std::vector<Change> changes = _changeLog->Since(since, MaxChanges);
+      if (changes.empty() && wait > 0) {
+        WaitSlot slot(this);
+        if (!slot.taken) {
+          throw ServiceUnavailableError(
+              "Too many requests are waiting for changes");
+        }
+        if (_changeLog->WaitForChanges(since, std::chrono::seconds(wait))) {
+          changes = _changeLog->Since(since, MaxChanges);
+        }
+      }
+      uint64_t next = changes.empty() ? since : changes.back().sequence;
+
+      if (stream) {
+        responseBody = BuildEvents(changes);
+        headers.insert({"Content-Type", "text/event-stream"});
+        headers.insert({"Cache-Control", "no-cache"});
+      } else {
+        json response = {{"changes", changes},
+                         {"next", next},
+                         {"latest", _changeLog->Latest()},
+                         {"epoch", _changeLog->Epoch()}};
+        responseBody = response.dump();
+      }
+      statusCode = restbed::OK;
+    } catch (const BadRequestError& e) {
+      statusCode = restbed::BAD_REQUEST;
+      responseBody = ResponseUtilities::GenerateErrorResponse("Invalid request",
+                                                              statusCode, e);
+    } catch (const ServiceUnavailableError& e) {
+      // The client should wait for changes again in a moment
+      statusCode = restbed::SERVICE_UNAVAILABLE;
+      responseBody = ResponseUtilities::GenerateErrorResponse(
+          "Too busy", statusCode, e);
+      headers.insert({"Retry-After", "1"});
+    } catch (const GoneError& e) {
+      // The client needs to fetch the collections again
+      statusCode = restbed::GONE;
+      responseBody = ResponseUtilities::GenerateErrorResponse(
+          "Changes no longer available", statusCode, e);
+    } catch (const std::exception& e) {
+      statusCode = restbed::INTERNAL_SERVER_ERROR;
+      responseBody = ResponseUtilities::GenerateErrorResponse(
+          "Something went wrong while processing your request", statusCode, e);
+    }
+
+    // Create the response headers
+    // An event stream ends with its connection, which EventSource opens again
+    // for the next batch
+    headers.insert({CONTENT_LENGTH(responseBody)});
+    ResponseUtilities::Respond(session, statusCode, responseBody,
+                               ResponseUtilities::BuildResponseHeader(headers),
+                               !stream);
+  }
+
+  /**
+   * The restbed::Resource for the ChangeLog
+   */
+  std::shared_ptr<restbed::Resource> resource =
+      std::make_shared<restbed::Resource>();
+
+  /**
+   * @return the endpoint for the ChangeController
+   */
+  std::string GetEndpoint() { return _endpoint; }
+
+  /**
+   * @param changeLog the ChangeLog for the ChangeController to serve
+   */
+  void SetChangeLog(const std::shared_ptr<ChangeLog>& changeLog) {
+    _changeLog = changeLog;
+  }
+
+  /**
+   * Limits the requests that wait for a change at once. It should be below
+   * the worker limit of the restbed::Service, so the rest of the API is
+   * always served
+   * @param maxWaiters the most requests that may wait
+   */
+  void SetMaxWaiters(std::size_t maxWaiters) { _maxWaiters = maxWaiters; }
+
+  /**
+   * @return the number of requests waiting for a change
+   */
+  std::size_t Waiting() const { return _waiters; }
+
+ protected:
+  /**
+   * @class WaitSlot
+   * @brief One of the places for requests waiting for a change, held for as
+   * long as the request waits, if one was free
+   */
+  class WaitSlot {
+   public:
+    explicit WaitSlot(ChangeController* controller)
+        : _waiters(controller->_waiters) {
+      taken = _waiters.fetch_add(1) < controller->_maxWaiters;
+      if (!taken) _waiters--;
+    }
+
+    ~WaitSlot() {
+      if (taken) _waiters--;
+    }
+
+    WaitSlot(const WaitSlot&) = delete;
+    WaitSlot& operator=(const WaitSlot&) = delete;
+
+    bool taken;
+
+   private:
+    std::atomic<std::size_t>& _waiters;
+  };
+
+  /**
+   * Parses a sequence number or number of seconds sent by the client
+   * @param value the value sent by the client, or an empty string
+   * @param name the name of the value, for the error message
+   * @param defaultValue the number to use if no value was sent
+   * @return the number
+   * @throw BadRequestError if the value is not a whole number
+   */
+  uint64_t ParseNumber(const std::string& value, const std::string& name,
+                       uint64_t defaultValue) {
+    if (value.empty()) return defaultValue;
+    if (value.find_first_not_of("0123456789") != std::string::npos ||
+        value.size() > 19) {
+      throw BadRequestError(std::string("The " + name +
+                                        " must be a whole number, not " + value)
+                                .c_str());
+    }
+    return std::stoull(value);
+  }
+
+  /**
+   * Builds an event stream with one event per change. The connection is closed
+   * after the events are sent, and browsers reconnect after the retry delay
+   * with the id of the last event in a Last-Event-ID header
+   * @param changes the changes to send
+   * @return the text of the event stream
+   */
+  std::string BuildEvents(const std::vector<Change>& changes) {
+    std::string events = "retry: 1000\n\n";
+    for (auto& change : changes) {
+      json data = change;
+      events += "id: " + std::to_string(change.sequence) + "\n";
+      events += "event: change\n";
+      events += "data: " + data.dump() + "\n\n";
+    }
+    return events;
+  }
+
+  /**
+   * The REST endpoint for the ChangeLog
+   */
+  std::string _endpoint;
+
+  /**
+   * The ChangeLog shared by the services
+   */
+  std::shared_ptr<ChangeLog> _changeLog;
+
+  /**
+   * The most requests that may wait for a change at once
+   */
+  std::size_t _maxWaiters = DefaultMaxWaiters;
+
+  /**
+   * The number of requests waiting for a change
+   */
+  std::atomic<std::size_t> _waiters{0};
+};
+
+#endif  // CHANGE_CONTROLLER_H
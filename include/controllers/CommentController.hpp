@@ -22,8 +22,7 @@ template <class Session = restbed::Session>
 class CommentController : public EntityController<Comment, Session> {
  public:
   CommentController()
-      : EntityController<Comment, Session>(
-            "/comments", std::make_shared<CommentService>()) {}
+      : EntityController<Comment, Session>("/comments", nullptr) {}
   explicit CommentController(
       const std::shared_ptr<CommentService>& commentService)
       : EntityController<Comment, Session>("/comments", commentService) {
@@ -42,12 +41,20 @@ class CommentController : public EntityController<Comment, Session> {
     // Set method handler for PUT requests
     this->resource->set_method_handler(
         "PUT", std::bind(&CommentController::Update, this, _1));
+    // Set method handler for PATCH requests
+    this->resource->set_method_handler(
+        "PATCH", std::bind(&CommentController::Patch, this, _1));
     // Set method handler for DELETE requests
     this->resource->set_method_handler(
         "DELETE", std::bind(&CommentController::Delete, this, _1));
     // Set method handler for POST requests
     this->resource->set_method_handler(
         "POST", std::bind(&CommentController::Create, this, _1));
+
+    // Bulk operations are served from /comments/_bulk
+    this->bulkResource->set_path(this->_endpoint + "/_bulk");
+    this->bulkResource->set_method_handler(
+        "POST", std::bind(&CommentController::Bulk, this, _1));
   }
   virtual ~CommentController() {}
 };
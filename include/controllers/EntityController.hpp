@@ -3,12 +3,16 @@
 
 #include <restbed>
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "AllocationStats.h"
 #include "EntityService.hpp"
+#include "QueryCache.h"
+#include "RequestCoalescer.h"
 #include "Utilities.h"
 #include "nlohmann/json.hpp"
 
@@ -22,6 +26,14 @@ using nlohmann::json;
  * @tparam Entity the Entity the controller is interacting with
  * @tparam Session the type for the Session used in the methods. Defaults to
  * restbed::Session, which is replaced with a mock in testing
+ *
+ * In instrumented builds, the allocations of each request are reported to
+ * AllocationStats, split into the service call, serializing the response and
+ * closing the session
+ *
+ * A controller can be given a QueryCache, which list requests are answered
+ * from when it has the response, and a RequestCoalescer, which shares a
+ * response among the identical requests waiting for it
  */
 template <class Entity, class Session = restbed::Session>
 class EntityController {
@@ -41,12 +53,20 @@ class EntityController {
   /**
    * General method for processing GET requests to the resource. Will call the
    * appropriate EntityService method based on the restbed::Request path
-   * parameters
+   * parameters. Responses carry an ETag built from the generation of the
+   * EntityService (and the version, for a single Entity), and list requests
+   * whose If-None-Match header matches it are answered with 304 Not Modified
+   * without reading the Entities. A request for one Entity is only answered
+   * with 304 once the Entity is found. Identical requests made at the same
+   * generation share one response when the controller has a RequestCoalescer
    * @param session restbed::Session object passed by the restbed::Service
    */
   virtual void Get(const std::shared_ptr<Session>& session) {
+    AllocationStats::Request accounting(this->_endpoint, "GET");
     auto request = session->get_request();
     std::string id;
+    std::string etag;
+    uint64_t generation = 0;
 
     int statusCode;
     std::string responseBody;
@@ -55,28 +75,119 @@ class EntityController {
       id = Utilities::GetEntityIdFromRequestPath(request->get_path(),
                                                  this->_endpoint);
       try {
-        if (id.empty()) {
+        // The tag is built before the Entities are read, so a write during
+        // the request can only make the tag older than the response. The
+        // version of the cache is read with it for the same reason: a list
+        // cached under it can only be dropped too soon, never kept too long
+        generation = this->_entityService->Generation();
+        etag = ResponseUtilities::BuildETag(generation);
+        uint64_t cacheVersion =
+            this->_queryCache ? this->_queryCache->Version() : 0;
+
+        if (id.empty() &&
+            ResponseUtilities::ETagMatches(
+                request->get_header("If-None-Match"), etag)) {
+          // The client already has the current representation
+          statusCode = restbed::NOT_MODIFIED;
+        } else if (id.empty()) {
           // Get the query parameters provided in the request
-          const StringMap queryParams = request->get_query_parameters();
+          StringMap queryParams = request->get_query_parameters();
+
+          // Entities nested under an issue (i.e. /issues/:issueId/comments)
+          // only include the ones for that issue
+          std::string issueId = Utilities::GetEntityIdFromRequestPath(
+              request->get_path(), "/issues");
+          if (this->_endpoint != "/issues" && !issueId.empty()) {
+            queryParams.insert({"issueId", issueId});
+          }
+
+          std::shared_ptr<const std::string> cached;
+          if (this->_queryCache) cached = this->_queryCache->Get(queryParams);
+
+          if (cached) {
+            // The service isn't called, and nothing is serialized
+            AllocationStats::Phase phase("cache");
+            responseBody = *cached;
+          } else {
+            responseBody = Coalesce(id, queryParams, generation, [&]() {
+              // Get all Entities from the service that match the query
+              std::vector<Entity> entities;
+              {
+                AllocationStats::Phase phase("service");
+                entities = this->_entityService->Get(queryParams);
+              }
 
-          // Get all Entities from the service that match the query
-          std::vector<Entity> entities = this->_entityService->Get(queryParams);
-          json response = entities;
+              AllocationStats::Phase phase("serialize");
+              json response = entities;
 
-          responseBody = response.dump();
-        } else {
-          // Get the Entity from the service
-          Entity entity = this->_entityService->Get(id);
+              auto body = std::make_shared<const RequestCoalescer::Response>(
+                  response.dump());
+              if (this->_queryCache) {
+                this->_queryCache->Put(queryParams, body->body, response,
+                                       cacheVersion);
+              }
+              return body;
+            })->body;
+          }
 
-          json response = entity;
-          responseBody = response.dump();
+          statusCode = restbed::OK;
+        } else {
+          // The Entity is read first, so one that doesn't exist is never
+          // reported as not modified. It is only serialized for a client that
+          // doesn't already have its version
+          std::string ifNoneMatch = request->get_header("If-None-Match");
+          auto read = [&]() -> RequestCoalescer::Body {
+            // Get the Entity from the service
+            Entity entity;
+            {
+              AllocationStats::Phase phase("service");
+              entity = this->_entityService->Get(id);
+            }
+            if (ResponseUtilities::ETagMatches(
+                    ifNoneMatch, ResponseUtilities::BuildEntityETag(
+                                     entity.version, generation))) {
+              return std::make_shared<const RequestCoalescer::Response>(
+                  "", entity.version);
+            }
+
+            AllocationStats::Phase phase("serialize");
+            json response = entity;
+            return std::make_shared<const RequestCoalescer::Response>(
+                response.dump(), entity.version);
+          };
+          RequestCoalescer::Body body =
+              Coalesce(id, StringMap(), generation, read);
+
+          // The tag of an Entity holds its version, so it can be sent back in
+          // an If-Match header to update the Entity
+          etag = ResponseUtilities::BuildEntityETag(body->version, generation);
+          bool notModified = ResponseUtilities::ETagMatches(ifNoneMatch, etag);
+          if (!notModified && body->body.empty()) {
+            // The response was shared by a request that had the Entity
+            // already, so it has no body
+            body = read();
+            etag =
+                ResponseUtilities::BuildEntityETag(body->version, generation);
+            notModified = ResponseUtilities::ETagMatches(ifNoneMatch, etag);
+          }
+
+          if (notModified) {
+            statusCode = restbed::NOT_MODIFIED;
+          } else {
+            responseBody = body->body;
+            statusCode = restbed::OK;
+          }
         }
-
-        statusCode = restbed::OK;
       } catch (const NotFoundError& e) {
         // Occues if the Entity could not be retrieved
         statusCode = restbed::NOT_FOUND;
 
+        responseBody = ResponseUtilities::GenerateErrorResponse(
+            "Invalid request", statusCode, e);
+      } catch (const BadRequestError& e) {
+        // The query was bad (i.e. an invalid sort or limit)
+        statusCode = restbed::BAD_REQUEST;
+
         responseBody = ResponseUtilities::GenerateErrorResponse(
             "Invalid request", statusCode, e);
       } catch (const std::exception& e) {
@@ -96,12 +207,19 @@ class EntityController {
     }
 
     // Build response headers
-    StringMap contentLengthHeader = {CONTENT_LENGTH(responseBody)};
-    StringMap headers =
-        ResponseUtilities::BuildResponseHeader(contentLengthHeader);
-
-    // Close session with response
-    session->close(statusCode, responseBody, headers);
+    StringMap responseHeaders = {CONTENT_LENGTH(responseBody)};
+    if (statusCode == restbed::OK || statusCode == restbed::NOT_MODIFIED) {
+      responseHeaders.insert({"ETag", etag});
+    }
+    StringMap headers = ResponseUtilities::BuildResponseHeader(responseHeaders);
+
+    // Respond, keeping the connection open for the next request
+    AllocationStats::Phase phase("respond");
+    // A body sent with the request is never fetched
+    bool keepAlive =
+        request == nullptr || request->get_header("Content-Length", 0) == 0;
+    ResponseUtilities::Respond(session, statusCode, responseBody, headers,
+                               keepAlive);
   }
 
   /**
@@ -110,6 +228,7 @@ class EntityController {
    * @param session restbed::Session object passed by the restbed::Service
    */
   virtual void Create(const std::shared_ptr<Session>& session) {
+    AllocationStats::Request accounting(this->_endpoint, "POST");
     auto request = session->get_request();
 
     std::string responseBody;
@@ -132,8 +251,13 @@ class EntityController {
                                const restbed::Bytes& body) {
               try {
                 requestBody = restbed::String::to_string(body);
-                Entity entity = this->_entityService->Create(requestBody);
+                Entity entity;
+                {
+                  AllocationStats::Phase phase("service");
+                  entity = this->_entityService->Create(requestBody);
+                }
 
+                AllocationStats::Phase phase("serialize");
                 json response = entity;
                 responseBody = response.dump();
 
@@ -168,16 +292,21 @@ class EntityController {
     StringMap headers =
         ResponseUtilities::BuildResponseHeader(contentLengthHeader);
 
-    // Close the session with the response
-    session->close(statusCode, responseBody, headers);
+    // Respond, keeping the connection open for the next request
+    AllocationStats::Phase phase("respond");
+    ResponseUtilities::Respond(session, statusCode, responseBody, headers);
   }
 
   /**
    * Allows the update of an Entity via a PUT request to /<endpoint>/:id, where
-   * id refers to the id of the Entity in request body
+   * id refers to the id of the Entity in request body. The version of the
+   * Entity the client last saw can be sent in an If-Match header (or as the
+   * version of the Entity in the body), in which case the update fails with
+   * 412 Precondition Failed if the Entity has changed since
    * @param session restbed::Session object passed by the restbed::Service
    */
   virtual void Update(const std::shared_ptr<Session>& session) {
+    AllocationStats::Request accounting(this->_endpoint, "PUT");
     auto request = session->get_request();
 
     std::string responseBody;
@@ -200,7 +329,17 @@ class EntityController {
                                const restbed::Bytes& body) {
               try {
                 requestBody = restbed::String::to_string(body);
-                Entity entity = this->_entityService->Update(requestBody);
+                if (request->has_header("If-Match")) {
+                  requestBody = WithExpectedVersion(
+                      requestBody, request->get_header("If-Match"));
+                }
+                Entity entity;
+                {
+                  AllocationStats::Phase phase("service");
+                  entity = this->_entityService->Update(requestBody);
+                }
+
+                AllocationStats::Phase phase("serialize");
                 json response = entity;
 
                 responseBody = response.dump();
@@ -210,6 +349,18 @@ class EntityController {
                 // Can't find the Entity to be updated
                 statusCode = restbed::NOT_FOUND;
 
+                responseBody = ResponseUtilities::GenerateErrorResponse(
+                    "Invalid request", statusCode, e);
+              } catch (const PreconditionFailedError& e) {
+                // The Entity was changed by someone else
+                statusCode = restbed::PRECONDITION_FAILED;
+
+                responseBody = ResponseUtilities::GenerateErrorResponse(
+                    "Conflicting update", statusCode, e);
+              } catch (const BadRequestError& e) {
+                // The body or the If-Match header could not be processed
+                statusCode = restbed::BAD_REQUEST;
+
                 responseBody = ResponseUtilities::GenerateErrorResponse(
                     "Invalid request", statusCode, e);
               } catch (const std::exception& e) {
@@ -235,14 +386,123 @@ class EntityController {
     StringMap headers =
         ResponseUtilities::BuildResponseHeader(contentLengthHeader);
 
-    session->close(statusCode, responseBody, headers);
+    AllocationStats::Phase phase("respond");
+    ResponseUtilities::Respond(session, statusCode, responseBody, headers);
+  }
+
+  /**
+   * Allows a partial update of an Entity via a PATCH request to
+   * /<endpoint>/:id, where the request body is a [JSON merge
+   * patch](https://tools.ietf.org/html/rfc7396) of the fields to change. Like
+   * PUT requests, the version of the Entity can be sent in an If-Match header
+   * @param session restbed::Session object passed by the restbed::Service
+   */
+  virtual void Patch(const std::shared_ptr<Session>& session) {
+    AllocationStats::Request accounting(this->_endpoint, "PATCH");
+    auto request = session->get_request();
+
+    std::string id;
+    std::string responseBody;
+    int statusCode;
+
+    if (request != nullptr) {
+      id = Utilities::GetEntityIdFromRequestPath(request->get_path(),
+                                                 this->_endpoint);
+    }
+
+    int contentLength =
+        request != nullptr ? request->get_header("Content-Length", 0) : 0;
+
+    if (id.empty() || contentLength == 0) {
+      BadRequestError e = BadRequestError("No id or request body found");
+      statusCode = restbed::BAD_REQUEST;
+
+      responseBody = ResponseUtilities::GenerateErrorResponse(
+          "Invalid Request", statusCode, e);
+    } else {
+      // Get the content from the session and process the request
+      session->fetch(
+          contentLength, [&](const std::shared_ptr<Session>& /*session*/,
+                             const restbed::Bytes& body) {
+            try {
+              std::string requestBody = restbed::String::to_string(body);
+              if (request->has_header("If-Match")) {
+                requestBody = WithExpectedVersion(
+                    requestBody, request->get_header("If-Match"));
+              }
+              Entity entity;
+              {
+                AllocationStats::Phase phase("service");
+                entity = this->_entityService->Patch(id, requestBody);
+              }
+
+              AllocationStats::Phase phase("serialize");
+              json response = entity;
+
+              responseBody = response.dump();
+
+              statusCode = restbed::OK;
+            } catch (const NotFoundError& e) {
+              // Can't find the Entity to be patched
+              statusCode = restbed::NOT_FOUND;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Invalid request", statusCode, e);
+            } catch (const PreconditionFailedError& e) {
+              // The Entity was changed by someone else
+              statusCode = restbed::PRECONDITION_FAILED;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Conflicting update", statusCode, e);
+            } catch (const BadRequestError& e) {
+              // The patch changes a field it isn't allowed to, or is invalid
+              statusCode = restbed::BAD_REQUEST;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Invalid request", statusCode, e);
+            } catch (const AlreadyExistsError& e) {
+              // The patch clashes with another Entity (i.e. a User's name)
+              statusCode = restbed::CONFLICT;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Invalid request", statusCode, e);
+            } catch (const NotImplementedError& e) {
+              // The Entity can't be patched
+              statusCode = restbed::METHOD_NOT_ALLOWED;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Invalid request", statusCode, e);
+            } catch (const std::exception& e) {
+              // Something went wrong, likely processing the file
+              statusCode = restbed::INTERNAL_SERVER_ERROR;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Something went wrong while processing your request",
+                  statusCode, e);
+            }
+          });
+    }
+
+    // Create the response headers
+    StringMap contentLengthHeader = {CONTENT_LENGTH(responseBody)};
+    StringMap headers =
+        ResponseUtilities::BuildResponseHeader(contentLengthHeader);
+
+    AllocationStats::Phase phase("respond");
+    // The body isn't fetched without an id
+    ResponseUtilities::Respond(session, statusCode, responseBody, headers,
+                               !id.empty() || contentLength == 0);
   }
 
   /**
    * Allows the deletion of an Entity via a DELETE request to /<endpoint>/:id,
-   * where id refers to the id of the Entity to be deleted
+   * where id refers to the id of the Entity to be deleted. If the request has
+   * an If-Match header with a version, the Entity is only deleted if it is
+   * still at that version, otherwise the response is 412 Precondition Failed
+   * @param session restbed::Session object passed by the restbed::Service
    */
   virtual void Delete(const std::shared_ptr<Session>& session) {
+    AllocationStats::Request accounting(this->_endpoint, "DELETE");
     auto request = session->get_request();
 
     std::string id;
@@ -261,13 +521,33 @@ class EntityController {
       statusCode = restbed::BAD_REQUEST;
     } else {
       try {
-        bool deleted = this->_entityService->Delete(id);
+        AllocationStats::Phase phase("service");
+        bool deleted;
+        if (request->has_header("If-Match")) {
+          int version =
+              Utilities::ParseVersionTag(request->get_header("If-Match"));
+          deleted = this->_entityService->Delete(id, version);
+        } else {
+          deleted = this->_entityService->Delete(id);
+        }
 
         statusCode = restbed::OK;
       } catch (const NotFoundError& e) {
         // Couldn't find the Entity
         statusCode = restbed::NOT_FOUND;
 
+        responseBody = ResponseUtilities::GenerateErrorResponse(
+            "Invalid request", statusCode, e);
+      } catch (const PreconditionFailedError& e) {
+        // The Entity was changed by someone else
+        statusCode = restbed::PRECONDITION_FAILED;
+
+        responseBody = ResponseUtilities::GenerateErrorResponse(
+            "Conflicting delete", statusCode, e);
+      } catch (const BadRequestError& e) {
+        // The If-Match header could not be processed
+        statusCode = restbed::BAD_REQUEST;
+
         responseBody = ResponseUtilities::GenerateErrorResponse(
             "Invalid request", statusCode, e);
       } catch (const std::exception& e) {
@@ -285,7 +565,99 @@ class EntityController {
     StringMap headers =
         ResponseUtilities::BuildResponseHeader(contentLengthHeader);
 
-    session->close(statusCode, responseBody, headers);
+    AllocationStats::Phase phase("respond");
+    // A body sent with the request is never fetched
+    bool keepAlive =
+        request == nullptr || request->get_header("Content-Length", 0) == 0;
+    ResponseUtilities::Respond(session, statusCode, responseBody, headers,
+                               keepAlive);
+  }
+
+  /**
+   * Applies a batch of operations to the Entities via a POST request to
+   * /<endpoint>/_bulk. The request body is a JSON array of operations, or one
+   * operation per line, as described by EntityService::Bulk. The operations
+   * are saved with a single write, and the response is an array with the
+   * result of each operation
+   * \verbatim
+   * [
+   *   {
+   *     "op": the operation,
+   *     "id": the id of the Entity,
+   *     "status": the HTTP Status Code for the operation,
+   *     "entity": the Entity after the operation (if it succeeded),
+   *     "error": the error for the operation (if it failed)
+   *   }
+   * ]
+   * \endverbatim
+   * @param session restbed::Session object passed by the restbed::Service
+   */
+  virtual void Bulk(const std::shared_ptr<Session>& session) {
+    AllocationStats::Request accounting(this->_endpoint + "/_bulk", "POST");
+    auto request = session->get_request();
+
+    std::string responseBody;
+    int statusCode;
+
+    int contentLength =
+        request != nullptr ? request->get_header("Content-Length", 0) : 0;
+
+    if (contentLength == 0) {
+      BadRequestError e = BadRequestError("No request body found");
+      statusCode = restbed::BAD_REQUEST;
+
+      responseBody = ResponseUtilities::GenerateErrorResponse(
+          "Invalid Request", statusCode, e);
+    } else {
+      // Get the content from the session and process the request
+      session->fetch(
+          contentLength, [&](const std::shared_ptr<Session>& /*session*/,
+                             const restbed::Bytes& body) {
+            try {
+              json operations = Utilities::ParseBulkBody(
+                  restbed::String::to_string(body));
+              if (!operations.is_array()) {
+                throw BadRequestError("Bulk requests must be a JSON array");
+              }
+
+              std::vector<BulkResult<Entity>> results;
+              {
+                AllocationStats::Phase phase("service");
+                results = this->_entityService->Bulk(operations);
+              }
+
+              AllocationStats::Phase phase("serialize");
+              json response = json::array();
+              for (auto& result : results) {
+                response.push_back(BulkResultToJson(result));
+              }
+              responseBody = response.dump();
+
+              statusCode = restbed::OK;
+            } catch (const BadRequestError& e) {
+              // The body could not be parsed
+              statusCode = restbed::BAD_REQUEST;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Invalid request", statusCode, e);
+            } catch (const std::exception& e) {
+              // Something went wrong, likely processing the file
+              statusCode = restbed::INTERNAL_SERVER_ERROR;
+
+              responseBody = ResponseUtilities::GenerateErrorResponse(
+                  "Something went wrong while processing your request",
+                  statusCode, e);
+            }
+          });
+    }
+
+    // Create the response headers
+    StringMap contentLengthHeader = {CONTENT_LENGTH(responseBody)};
+    StringMap headers =
+        ResponseUtilities::BuildResponseHeader(contentLengthHeader);
+
+    AllocationStats::Phase phase("respond");
+    ResponseUtilities::Respond(session, statusCode, responseBody, headers);
   }
 
   /**
@@ -294,6 +666,13 @@ class EntityController {
   std::shared_ptr<restbed::Resource> resource =
       std::make_shared<restbed::Resource>();
 
+  /**
+   * The restbed::Resource for bulk operations on the Entity, at
+   * /<endpoint>/_bulk
+   */
+  std::shared_ptr<restbed::Resource> bulkResource =
+      std::make_shared<restbed::Resource>();
+
   /**
    * @return the endpoint for the EntityController
    */
@@ -308,13 +687,132 @@ class EntityController {
     _entityService = entityService;
   }
 
+  /**
+   * Answers list requests from a cache. The cache must be given every change
+   * to the collections it depends on (see QueryCache)
+   * @param queryCache the cache, or nullptr for none
+   */
+  void SetQueryCache(const std::shared_ptr<QueryCache>& queryCache) {
+    _queryCache = queryCache;
+  }
+
+  /**
+   * Shares the responses of identical GET requests made at the same time
+   * @param coalescer the coalescer, or nullptr to compute every response
+   */
+  void SetCoalescer(const std::shared_ptr<RequestCoalescer>& coalescer) {
+    _coalescer = coalescer;
+  }
+
  protected:
+  /**
+   * Computes the response to a GET request, or waits for an identical request
+   * computing it
+   * @param id the id of the Entity requested, or empty for a list
+   * @param query the query parameters of a list request
+   * @param generation the generation of the EntityService when the request
+   * arrived
+   * @param compute computes the response
+   * @return the response
+   */
+  RequestCoalescer::Body Coalesce(
+      const std::string& id, const StringMap& query, uint64_t generation,
+      const std::function<RequestCoalescer::Body()>& compute) {
+    if (!_coalescer) return compute();
+    std::string path = id.empty() ? _endpoint : _endpoint + "/" + id;
+    return _coalescer->Do(
+        RequestCoalescer::Key(path, QueryCache::Key(query), generation),
+        compute);
+  }
+
+  /**
+   * Converts the result of a bulk operation to the JSON sent to the client,
+   * with the HTTP Status Code the operation would have had on its own
+   * @param result the result of the bulk operation
+   * @return the JSON for the result
+   */
+  json BulkResultToJson(const BulkResult<Entity>& result) {
+    json item = {{"op", result.op}, {"id", result.id}};
+
+    if (!result.error) {
+      item["status"] = result.op == "create" ? restbed::CREATED : restbed::OK;
+      if (result.op != "delete") item["entity"] = result.entity;
+      return item;
+    }
+
+    int statusCode;
+    std::string title = "Invalid request";
+    std::string detail;
+    try {
+      std::rethrow_exception(result.error);
+    } catch (const NotFoundError& e) {
+      statusCode = restbed::NOT_FOUND;
+      detail = e.what();
+    } catch (const PreconditionFailedError& e) {
+      statusCode = restbed::PRECONDITION_FAILED;
+      title = "Conflicting update";
+      detail = e.what();
+    } catch (const BadRequestError& e) {
+      statusCode = restbed::BAD_REQUEST;
+      detail = e.what();
+    } catch (const AlreadyExistsError& e) {
+      statusCode = restbed::CONFLICT;
+      detail = e.what();
+    } catch (const NotImplementedError& e) {
+      statusCode = restbed::METHOD_NOT_ALLOWED;
+      detail = e.what();
+    } catch (const std::exception& e) {
+      statusCode = restbed::INTERNAL_SERVER_ERROR;
+      title = "Something went wrong while processing your request";
+      detail = e.what();
+    }
+
+    item["status"] = statusCode;
+    item["error"] = ServerErrorResponse(title, detail, statusCode);
+    return item;
+  }
+
+  /**
+   * Sets the version in an update request body to the version in an If-Match
+   * header, so the EntityService only makes the update if the Entity is still
+   * at that version
+   * @param body the body of the update request
+   * @param ifMatch the value of the If-Match header
+   * @return the body with the expected version
+   * @throw BadRequestError if the body or the header can't be processed
+   */
+  std::string WithExpectedVersion(const std::string& body,
+                                  const std::string& ifMatch) {
+    int version = Utilities::ParseVersionTag(ifMatch);
+    if (version == EntityService<Entity>::AnyVersion) return body;
+
+    json entity;
+    try {
+      entity = json::parse(body);
+    } catch (const std::exception& e) {
+      throw BadRequestError(
+          std::string("Unable to process the request body: " + body).c_str());
+    }
+    entity["version"] = version;
+    return entity.dump();
+  }
+
   /**
    * The EntityService corresponding to the Entity class. Handles interacting
    * with Entity objects in persistent storage
    */
   std::shared_ptr<EntityService<Entity>> _entityService;
 
+  /**
+   * The responses of recent list requests, or nullptr
+   */
+  std::shared_ptr<QueryCache> _queryCache;
+
+  /**
+   * The GET requests being answered, or nullptr
+   */
+  std::shared_ptr<RequestCoalescer> _coalescer;
+
   /**
    * The REST endpoint for the Entity
    */
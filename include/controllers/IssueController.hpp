@@ -35,12 +35,20 @@ class IssueController : public EntityController<Issue, Session> {
     // Set method handler for PUT requests
     this->resource->set_method_handler(
         "PUT", std::bind(&IssueController::Update, this, _1));
+    // Set method handler for PATCH requests
+    this->resource->set_method_handler(
+        "PATCH", std::bind(&IssueController::Patch, this, _1));
     // Set method handler for DELETE requests
     this->resource->set_method_handler(
         "DELETE", std::bind(&IssueController::Delete, this, _1));
     // Set method handler for POST requests
     this->resource->set_method_handler(
         "POST", std::bind(&IssueController::Create, this, _1));
+
+    // Bulk operations are served from /issues/_bulk
+    this->bulkResource->set_path(this->_endpoint + "/_bulk");
+    this->bulkResource->set_method_handler(
+        "POST", std::bind(&IssueController::Bulk, this, _1));
   }
 
   virtual ~IssueController() {}
@@ -46,12 +46,20 @@ class UserController : public EntityController<User, Session> {
     // Set method handler for PUT requests
     this->resource->set_method_handler(
         "PUT", std::bind(&UserController::Update, this, _1));
+    // Set method handler for PATCH requests
+    this->resource->set_method_handler(
+        "PATCH", std::bind(&UserController::Patch, this, _1));
     // Set method handler for DELETE requests
     this->resource->set_method_handler(
         "DELETE", std::bind(&UserController::Delete, this, _1));
     // Set method handler for POST requests
     this->resource->set_method_handler(
         "POST", std::bind(&UserController::Create, this, _1));
+
+    // Bulk operations are served from /users/_bulk
+    this->bulkResource->set_path(this->_endpoint + "/_bulk");
+    this->bulkResource->set_method_handler(
+        "POST", std::bind(&UserController::Bulk, this, _1));
   }
   virtual ~UserController() {}
 };
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 
+#include "AllocationStats.h"
 #include "EntityController.hpp"
 #include "Utilities.h"
 #include "VoteService.h"
@@ -31,7 +32,9 @@ class VoteController : public EntityController<Vote, Session> {
    */
   VoteController()
       : EntityController<Vote, Session>("/votes",
-                                        std::make_shared<VoteService>()) {}
+                                        std::make_shared<VoteService>()) {
+    _voteService = std::static_pointer_cast<VoteService>(this->_entityService);
+  }
 
   /**
    * Constructor. Sets the endpoint to "/votes" and the VoteService, and
@@ -39,7 +42,8 @@ class VoteController : public EntityController<Vote, Session> {
    * @param voteService the VoteService used by the controller
    */
   explicit VoteController(const std::shared_ptr<VoteService>& voteService)
-      : EntityController<Vote, Session>("/votes", voteService) {
+      : EntityController<Vote, Session>("/votes", voteService),
+        _voteService(voteService) {
     // Initialize the resource paths to /votes and /issue/:issueId/votes
     std::string issuePath = "/issues/{issueId:[a-z0-9]*}/";
     std::string idPath = "/{id:[a-z0-9]*}";
@@ -55,21 +59,40 @@ class VoteController : public EntityController<Vote, Session> {
     // Set the method handler for POST requests
     this->resource->set_method_handler(
         "POST", std::bind(&VoteController::Create, this, _1));
+
+    // Bulk operations are served from /votes/_bulk
+    this->bulkResource->set_path(this->_endpoint + "/_bulk");
+    this->bulkResource->set_method_handler(
+        "POST", std::bind(&VoteController::Bulk, this, _1));
   }
   virtual ~VoteController() {}
 
+  /**
+   * Votes are toggled by the VoteService, so the controller keeps it as one
+   * @param entityService pointer to the new VoteService
+   */
+  void SetEntityService(
+      const std::shared_ptr<EntityService<Vote>>& entityService) override {
+    EntityController<Vote, Session>::SetEntityService(entityService);
+    _voteService = std::dynamic_pointer_cast<VoteService>(entityService);
+  }
+
   /**
    * Overloaded Create method, which handles creating and deleting Votes. If a
-   * Vote exists for the corresponding User and Issue, we will call
-   * VoteService::Delete to remove it. Else, we will call VoteService::Create to
-   * create one
+   * Vote exists for the corresponding User and Issue, it is removed. Else, one
+   * is cast. VoteService::Toggle does both in one step, so concurrent requests
+   * never cast a vote twice. The response holds the vote and the number of
+   * votes the issue has after it, with a status of CREATED if it was cast or
+   * OK if it was removed
    * @param session the restbed::Session containing the request
    */
   void Create(const std::shared_ptr<Session>& session) override {
+    AllocationStats::Request accounting(this->_endpoint, "POST");
     auto request = session->get_request();
 
     std::string responseBody;
     int statusCode;
+    bool keepAlive = true;
 
     if (request == nullptr) {
       statusCode = restbed::BAD_REQUEST;
@@ -93,6 +116,8 @@ class VoteController : public EntityController<Vote, Session> {
         statusCode = restbed::BAD_REQUEST;
         responseBody = ResponseUtilities::GenerateErrorResponse(
             "Invalid Request", statusCode, e);
+        // The body isn't fetched, so the connection can't be reused
+        keepAlive = contentLength == 0;
       } else {
         if (contentLength == 0) {
           BadRequestError e = BadRequestError("No request body found");
@@ -108,28 +133,25 @@ class VoteController : public EntityController<Vote, Session> {
                   std::string requestBody = restbed::String::to_string(body);
                   json requestJson = json::parse(requestBody);
                   std::string userId = requestJson.value("createdBy", "");
-
-                  // Create the query for existing votes
-                  StringMap queryParams = {{"issueId", issueId},
-                                           {"createdBy", userId}};
-                  std::vector<Vote> existingVotes =
-                      this->_entityService->Get(queryParams);
-
-                  // If there are no votes by that user for the issue, we create
-                  // one Else, we delete the one that exists
-                  if (existingVotes.empty()) {
-                    Vote vote = this->_entityService->Create(requestBody);
-                    json response = vote;
-                    responseBody = response.dump();
-                    statusCode = restbed::CREATED;
-                  } else {
-                    bool deleted =
-                        this->_entityService->Delete(existingVotes.front().id);
-                    statusCode = restbed::NO_CONTENT;
+                  // Votes posted to /votes name their issue in the body
+                  if (issueId.empty()) {
+                    issueId = requestJson.value("issueId", "");
                   }
+
+                  AllocationStats::Phase phase("service");
+                  VoteService::Toggled toggled =
+                      _voteService->Toggle(issueId, userId);
+
+                  AllocationStats::Phase serialize("serialize");
+                  json response = {{"voted", toggled.cast},
+                                   {"count", toggled.count},
+                                   {"vote", toggled.vote}};
+                  responseBody = response.dump();
+                  statusCode =
+                      toggled.cast ? restbed::CREATED : restbed::OK;
                 } catch (const NotFoundError& e) {
-                  // The service couldn't find the user trying to vote on the
-                  // issue
+                  // The service couldn't find the issue, or the user trying
+                  // to vote on it
                   statusCode = restbed::NOT_FOUND;
                   responseBody = ResponseUtilities::GenerateErrorResponse(
                       "Not found", statusCode, e);
@@ -157,7 +179,9 @@ class VoteController : public EntityController<Vote, Session> {
         ResponseUtilities::BuildResponseHeader(contentLengthHeader);
 
     // Close the session with the response
-    session->close(statusCode, responseBody, headers);
+    AllocationStats::Phase phase("respond");
+    ResponseUtilities::Respond(session, statusCode, responseBody, headers,
+                               keepAlive);
   }
 
   /**
@@ -170,6 +194,12 @@ class VoteController : public EntityController<Vote, Session> {
    * is not needed, so it is overloaded to do nothing
    */
   void Delete(const std::shared_ptr<Session>& session) override {}
+
+ private:
+  /**
+   * The VoteService votes are toggled by. The same service as _entityService
+   */
+  std::shared_ptr<VoteService> _voteService;
 };
 
 #endif  // VOTE_CONTROLLER_H
@@ -31,6 +31,7 @@ class Comment : public MutableEntity {
     updatedAt = entity.updatedAt;
     updatedBy = entity.updatedBy;
     id = entity.id;
+    version = entity.version;
     return *this;
   }
 
@@ -46,7 +47,7 @@ class Comment : public MutableEntity {
   /**
    * the id of the Issue
    */
-  std::string issueId;
+  EntityId issueId;
 
   /**
    * the contents of the comment
@@ -77,7 +78,7 @@ inline void to_json(json& j, const Comment& comment) {
 inline void from_json(const json& j, Comment& comment) {
   auto entity = j.get<MutableEntity>();
   comment = entity;
-  comment.issueId = j.at("issueId").get<std::string>();
+  comment.issueId = j.at("issueId").get<EntityId>();
   comment.body = j.value("body", "");
 }
 
@@ -2,6 +2,8 @@
 #define ENTITY_H
 
 #include <string>
+
+#include "EntityId.h"
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
@@ -27,7 +29,15 @@ class Entity {
   /**
    * ID which can uniquely identify any Entity object
    */
-  std::string id = "";
+  EntityId id;
+
+  /**
+   * Version of the Entity in persistent storage. Starts at 1 when the Entity
+   * is created and increases by one every time it is updated. A version of 0
+   * means the Entity has not been versioned (i.e. it was never saved, or it
+   * predates versioning)
+   */
+  int version = 0;
 };
 
 #endif  // ENTITY_H
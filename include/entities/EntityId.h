@@ -0,0 +1,210 @@
+#ifndef ENTITY_ID_H
+#define ENTITY_ID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @class EntityId
+ * @brief The id of an Entity, as a single 64-bit value
+ *
+ * Ids made by the services are lowercase alphanumeric strings, which are
+ * packed into the value, one base-37 digit per character. Any other string
+ * (a longer id, or one with other characters, as in hand written data) is
+ * interned instead, and the value is its index in a table shared by the
+ * program. Either way two ids are equal exactly when their strings are, so
+ * comparing and hashing ids never touches the strings.
+ *
+ * Interned ids are counted, and a string is dropped from the table once the
+ * last id holding it is gone, so ids read from requests never outlive them.
+ * Code that keeps a Value() instead of the id must keep the id too.
+ *
+ * Packed ids sort like their strings, and before every interned id
+ */
+class EntityId {
+ public:
+  /**
+   * The longest string that can be packed into the value
+   */
+  static const std::size_t MaxPackedLength = 12;
+
+  /**
+   * Constructor. Makes an empty id
+   */
+  EntityId() {}
+
+  /**
+   * Constructor
+   * @param id the string form of the id
+   */
+  EntityId(const std::string& id);  // NOLINT
+
+  /**
+   * Constructor
+   * @param id the string form of the id
+   */
+  EntityId(const char* id);  // NOLINT
+
+  EntityId(const EntityId& other) : _value(other._value) {
+    if (!IsPacked()) Retain(_value);
+  }
+
+  EntityId(EntityId&& other) noexcept : _value(other._value) {
+    other._value = 0;
+  }
+
+  EntityId& operator=(const EntityId& other) {
+    if (!other.IsPacked()) Retain(other._value);
+    if (!IsPacked()) Release(_value);
+    _value = other._value;
+    return *this;
+  }
+
+  EntityId& operator=(EntityId&& other) noexcept {
+    std::swap(_value, other._value);
+    return *this;
+  }
+
+  ~EntityId() {
+    if (!IsPacked()) Release(_value);
+  }
+
+  /**
+   * Finds the id of a string without interning it, so strings from requests
+   * (i.e. query parameters) can be compared with ids without growing the
+   * table of interned ids
+   * @param id the string form of the id
+   * @param result set to the id, if there is one
+   * @return whether the string is the id of something: either it can be
+   * packed, or it has been interned already
+   */
+  static bool Lookup(const std::string& id, EntityId* result);
+
+  /**
+   * @return the number of strings interned by ids that still exist
+   */
+  static std::size_t InternedCount();
+
+  /**
+   * @return whether the id is empty, as it is for an Entity not stored yet
+   */
+  bool empty() const { return _value == 0; }
+
+  /**
+   * @return the string form of the id
+   */
+  std::string str() const;
+
+  /**
+   * @return the string form of the id
+   */
+  operator std::string() const { return str(); }  // NOLINT
+
+  /**
+   * @return the value the id is compared and hashed by
+   */
+  uint64_t Value() const { return _value; }
+
+  /**
+   * @return whether the string of the id is packed into its value, rather
+   * than interned
+   */
+  bool IsPacked() const { return (_value & InternedFlag) == 0; }
+
+  friend bool operator==(const EntityId& lhs, const EntityId& rhs) {
+    return lhs._value == rhs._value;
+  }
+
+  friend bool operator!=(const EntityId& lhs, const EntityId& rhs) {
+    return lhs._value != rhs._value;
+  }
+
+  friend bool operator<(const EntityId& lhs, const EntityId& rhs) {
+    return lhs._value < rhs._value;
+  }
+
+ private:
+  /**
+   * Set in the value of interned ids. Packed values never reach it, since
+   * 37^12 < 2^63
+   */
+  static const uint64_t InternedFlag = uint64_t(1) << 63;
+
+  /**
+   * Makes the value of an id
+   * @param id the characters of the id
+   * @param length the number of characters
+   * @return the packed value, if the id can be packed, or else the interned
+   * one
+   */
+  static uint64_t Encode(const char* id, std::size_t length);
+
+  /**
+   * Packs an id into a value
+   * @param id the characters of the id
+   * @param length the number of characters
+   * @param value set to the packed value
+   * @return whether the id could be packed
+   */
+  static bool Pack(const char* id, std::size_t length, uint64_t* value);
+
+  /**
+   * Counts another id holding an interned value
+   * @param value the interned value
+   */
+  static void Retain(uint64_t value);
+
+  /**
+   * Counts an id holding an interned value being gone, and drops its string
+   * if it was the last one
+   * @param value the interned value
+   */
+  static void Release(uint64_t value);
+
+  uint64_t _value = 0;
+};
+
+inline std::string operator+(const std::string& lhs, const EntityId& rhs) {
+  return lhs + rhs.str();
+}
+
+inline std::string operator+(const char* lhs, const EntityId& rhs) {
+  return lhs + rhs.str();
+}
+
+inline std::string operator+(const EntityId& lhs, const std::string& rhs) {
+  return lhs.str() + rhs;
+}
+
+inline std::string operator+(const EntityId& lhs, const char* rhs) {
+  return lhs.str() + rhs;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const EntityId& id) {
+  return out << id.str();
+}
+
+inline void to_json(json& j, const EntityId& id) { j = id.str(); }
+
+inline void from_json(const json& j, EntityId& id) {
+  id = j.is_null() ? EntityId() : EntityId(j.get_ref<const std::string&>());
+}
+
+namespace std {
+template <>
+struct hash<EntityId> {
+  std::size_t operator()(const EntityId& id) const {
+    return std::hash<uint64_t>()(id.Value());
+  }
+};
+}  // namespace std
+
+#endif  // ENTITY_ID_H
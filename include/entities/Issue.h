@@ -8,7 +8,7 @@
 
 #include "Comment.h"
 #include "MutableEntity.h"
-#include "User.h"
+#include "UserRef.h"
 #include "Vote.h"
 
 /**
@@ -32,6 +32,7 @@ class Issue : public MutableEntity {
     updatedAt = entity.updatedAt;
     updatedBy = entity.updatedBy;
     id = entity.id;
+    version = entity.version;
     return *this;
   }
 
@@ -48,12 +49,12 @@ class Issue : public MutableEntity {
   /**
    * the User who is assigned the Issue
    */
-  User assignedTo;
+  UserRef assignedTo;
 
   /**
    * the User reporting the Issue
    */
-  User reporter;
+  UserRef reporter;
 
   /**
    * the comments associated with the Issue
@@ -101,8 +102,6 @@ inline void to_json(json& j, const Issue& issue) {
  * @param issue the Issue the result will be stored in
  */
 inline void from_json(const json& j, Issue& issue) {
-  User reporter;
-  User assignedTo;
   std::multiset<Comment> comments;
   std::vector<Vote> votes;
   auto entity = j.get<MutableEntity>();
@@ -110,8 +109,8 @@ inline void from_json(const json& j, Issue& issue) {
   issue.title = j.value("title", "");
   issue.status = j.value("status", "");
 
-  issue.reporter = reporter;
-  issue.assignedTo = assignedTo;
+  issue.reporter = UserRef();
+  issue.assignedTo = UserRef();
   issue.assignedTo.id = j.value("assignedTo", "");
   issue.reporter.id = j.value("reporter", "");
 
@@ -6,7 +6,7 @@
 #include <string>
 
 #include "Entity.h"
-#include "User.h"
+#include "UserRef.h"
 #include "Utilities.h"
 #include "nlohmann/json.hpp"
 
@@ -21,7 +21,8 @@ class MutableEntity : public Entity {
   /**
    * Constructor. Creates an entity with the current time in UTC
    */
-  MutableEntity(time_t time = time(0)) : createdAt(*gmtime(&time)) {}
+  MutableEntity(time_t created = time(0))
+      : createdAt(TimeUtilities::ToUTC(created)) {}
 
   /**
    * Destructor
@@ -36,7 +37,7 @@ class MutableEntity : public Entity {
   /**
    * The User who created the Entity
    */
-  User createdBy;
+  UserRef createdBy;
 
   /**
    * Time the Entity was last updated at. Default value is the "null time"
@@ -47,7 +48,7 @@ class MutableEntity : public Entity {
   /**
    * The User who last updated the Entity
    */
-  User updatedBy;
+  UserRef updatedBy;
 };
 
 /**
@@ -65,23 +66,26 @@ inline void to_json(json& j, const MutableEntity& entity) {
     j["updatedAt"] = "";
     j["updatedBy"] = "";
   }
+  // Unversioned entities are serialized without a version
+  if (entity.version > 0) {
+    j["version"] = entity.version;
+  }
 }
 
 /**
  * Deserializes a MutableEntity from a nlohmann::json object
  */
 inline void from_json(const json& j, MutableEntity& entity) {
-  User createdBy;
-  User updatedBy;
   entity.id = j.value("id", entity.id);
-  entity.createdBy = createdBy;
+  entity.version = j.value("version", entity.version);
   // We can really only append the User id
+  entity.createdBy = UserRef();
   entity.createdBy.id = j.value("createdBy", "");
   auto createdAt = j.value("createdAt", "");
   if (createdAt != "") {
     entity.createdAt = TimeUtilities::ConvertStringToTime(createdAt);
   }
-  entity.updatedBy = updatedBy;
+  entity.updatedBy = UserRef();
   entity.updatedBy.id = j.value("updatedBy", "");
   auto updatedAt = j.value("updatedAt", "");
   if (updatedAt != "") {
@@ -45,6 +45,10 @@ class User : public Entity {
  */
 inline void to_json(json& j, const User& user) {
   j = json{{"name", user.name}, {"id", user.id}, {"role", user.role}};
+  // Unversioned users are serialized without a version
+  if (user.version > 0) {
+    j["version"] = user.version;
+  }
 }
 
 /**
@@ -58,6 +62,7 @@ inline void from_json(const json& j, User& user) {
   user.name = j.value("name", user.name);
   user.id = j.value("id", user.id);
   user.role = j.value("role", user.role);
+  user.version = j.value("version", user.version);
 }
 
 #endif  // USER_H
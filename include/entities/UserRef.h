@@ -0,0 +1,79 @@
+#ifndef USER_REF_H
+#define USER_REF_H
+
+#include <memory>
+#include <string>
+
+#include "EntityId.h"
+#include "User.h"
+
+/**
+ * @class UserRef
+ * @brief A reference from an entity to a User, such as the User who created
+ * it
+ *
+ * The reference always has the id of the User. Once the User has been
+ * resolved by a service it also shares an immutable copy of them, which every
+ * other reference to the same User resolved at the same time shares too
+ */
+class UserRef {
+ public:
+  /**
+   * Constructor. Makes a reference to no User
+   */
+  UserRef() {}
+
+  /**
+   * Constructor. Resolves the reference to a copy of the User
+   * @param user the User
+   */
+  UserRef(const User& user)  // NOLINT
+      : id(user.id), _user(std::make_shared<const User>(user)) {}
+
+  /**
+   * Constructor. Resolves the reference to a shared User
+   * @param user the User, or nullptr for no User
+   */
+  UserRef(std::shared_ptr<const User> user)  // NOLINT
+      : id(user ? user->id : EntityId()), _user(std::move(user)) {}
+
+  /**
+   * @return whether the reference has been resolved to the User with its id.
+   * Changing the id of a resolved reference unresolves it
+   */
+  bool Resolved() const { return _user && _user->id == id; }
+
+  /**
+   * @return the User, or nullptr if the reference isn't resolved
+   */
+  std::shared_ptr<const User> Get() const {
+    return Resolved() ? _user : nullptr;
+  }
+
+  /**
+   * @return the name of the User, or an empty string if the reference isn't
+   * resolved
+   */
+  const std::string& Name() const { return Resolved() ? _user->name : Empty(); }
+
+  /**
+   * @return the role of the User, or an empty string if the reference isn't
+   * resolved
+   */
+  const std::string& Role() const { return Resolved() ? _user->role : Empty(); }
+
+  /**
+   * The id of the User
+   */
+  EntityId id;
+
+ private:
+  static const std::string& Empty() {
+    static const std::string empty;
+    return empty;
+  }
+
+  std::shared_ptr<const User> _user;
+};
+
+#endif  // USER_REF_H
@@ -30,13 +30,14 @@ class Vote : public MutableEntity {
     updatedAt = entity.updatedAt;
     updatedBy = entity.updatedBy;
     id = entity.id;
+    version = entity.version;
     return *this;
   }
 
   /**
    * the id of the Issue
    */
-  std::string issueId;
+  EntityId issueId;
 };
 
 /**
@@ -61,7 +62,7 @@ inline void to_json(json& j, const Vote& vote) {
 inline void from_json(const json& j, Vote& vote) {
   auto entity = j.get<MutableEntity>();
   vote = entity;
-  vote.issueId = j.at("issueId").get<std::string>();
+  vote.issueId = j.at("issueId").get<EntityId>();
 }
 
 #endif
@@ -0,0 +1,184 @@
+#ifndef CHANGELOG_H
+#define CHANGELOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @struct Change
+ * A mutation made to one of the collections, as recorded in the ChangeLog
+ */
+struct Change {
+  /**
+   * The sequence number of the change. Sequence numbers are shared by all of
+   * the collections, and increase by one with every change
+   */
+  uint64_t sequence = 0;
+
+  /**
+   * The collection that was changed (i.e. issues)
+   */
+  std::string collection;
+
+  /**
+   * The operation that was applied (create, update, patch or delete)
+   */
+  std::string op;
+
+  /**
+   * The id of the Entity that was changed
+   */
+  std::string id;
+
+  /**
+   * The Entity after the change, or null if it was deleted
+   */
+  json entity;
+
+  /**
+   * The time the change was recorded, in UTC
+   */
+  std::string at;
+};
+
+/**
+ * Serializes a Change to JSON, of the form
+ * \verbatim
+ * {
+ *   "sequence": the sequence number of the change,
+ *   "collection": the collection that was changed,
+ *   "op": the operation that was applied,
+ *   "id": the id of the Entity,
+ *   "entity": the Entity after the change (null for deletes),
+ *   "at": the time of the change
+ * }
+ * \endverbatim
+ * @param j the json object to write the Change to
+ * @param change the Change to serialize
+ */
+void to_json(json& j, const Change& change);
+
+/**
+ * @class ChangeLog
+ * @brief A bounded, in-memory log of the changes made by the services
+ *
+ * Every change saved by a service is given the next sequence number and
+ * appended to the log. Only the most recent changes are kept, so a client that
+ * has fallen too far behind has to fetch the collections again
+ */
+class ChangeLog {
+ public:
+  /**
+   * The number of changes kept when no capacity is given
+   */
+  static constexpr std::size_t DefaultCapacity = 10000;
+
+  /**
+   * Constructor
+   * @param capacity the most changes to keep in memory
+   */
+  explicit ChangeLog(std::size_t capacity = DefaultCapacity);
+  virtual ~ChangeLog() {}
+
+  /**
+   * Records a change, and wakes anyone waiting for changes
+   * @param collection the collection that was changed
+   * @param op the operation that was applied
+   * @param id the id of the Entity that was changed
+   * @param entity the Entity after the change, or null if it was deleted
+   * @return the sequence number of the change
+   */
+  uint64_t Append(const std::string& collection, const std::string& op,
+                  const std::string& id, const json& entity);
+
+  /**
+   * Gets the changes made after a sequence number, oldest first
+   * @param since the sequence number of the last change the caller has seen,
+   * or 0 for all of the changes
+   * @param limit the most changes to return
+   * @return the changes after since
+   * @throw GoneError if changes after since have already been dropped from
+   * the log
+   */
+  std::vector<Change> Since(uint64_t since, std::size_t limit);
+
+  /**
+   * Blocks until there is a change after a sequence number, or the timeout
+   * passes
+   * @param since the sequence number of the last change the caller has seen
+   * @param timeout how long to wait for a change
+   * @return true if there is a change after since
+   */
+  bool WaitForChanges(uint64_t since, std::chrono::milliseconds timeout);
+
+  /**
+   * @return the sequence number of the latest change, or 0 if nothing has
+   * changed
+   */
+  uint64_t Latest();
+
+  /**
+   * Calls a function with every change appended from now on, in order. It is
+   * called while the change is appended, before the service that made the
+   * change returns, so it must be quick and must not use the ChangeLog
+   * @param subscriber the function to call with each change
+   */
+  void Subscribe(std::function<void(const Change&)> subscriber);
+
+  /**
+   * Sequence numbers start again from 1 whenever the server restarts, so each
+   * ChangeLog is given an epoch. Clients that see a different epoch than the
+   * one they synced with have to fetch the collections again
+   * @return the epoch of the ChangeLog
+   */
+  std::string Epoch() const { return _epoch; }
+
+ protected:
+  /**
+   * The most changes to keep in memory
+   */
+  std::size_t _capacity;
+
+  /**
+   * Identifies this ChangeLog, so clients can tell that the server restarted
+   */
+  std::string _epoch;
+
+  /**
+   * The sequence number of the latest change
+   */
+  uint64_t _latest = 0;
+
+  /**
+   * The most recent changes, oldest first
+   */
+  std::deque<Change> _changes;
+
+  /**
+   * The functions called with every change
+   */
+  std::vector<std::function<void(const Change&)>> _subscribers;
+
+  /**
+   * Guards the changes, the latest sequence number and the subscribers
+   */
+  std::mutex _mutex;
+
+  /**
+   * Notified whenever a change is appended
+   */
+  std::condition_variable _appended;
+};
+
+#endif  // CHANGELOG_H
@@ -44,7 +44,7 @@ class CommentService : public EntityService<Comment> {
    * @return a vector of Users
    */
   virtual std::vector<Comment> Get(
-      const std::multimap<std::string, std::string> queryParams = {});
+      const std::multimap<std::string, std::string>& queryParams = {});
 
   /**
    * Get a Comment by its id
@@ -52,14 +52,19 @@ class CommentService : public EntityService<Comment> {
    * @return the Comment with that id
    * @throw NotFoundError if no Comment is found with that id
    */
-  virtual Comment Get(const std::string id);
+  virtual Comment Get(const std::string& id);
 
   /**
    * Creates a Comment and saves it to the JSON file
    * @param body the information of the Comment to create
    * @throw BadRequestError if the body is invalid
    */
-  virtual Comment Create(std::string body);
+  virtual Comment Create(const std::string& body);
+
+  /**
+   * Creating a Comment in a Transaction (i.e. the description of an issue)
+   */
+  using EntityService<Comment>::Create;
 
   /**
    * Updates a Comment and saves it to the JSON file
@@ -67,16 +72,66 @@ class CommentService : public EntityService<Comment> {
    * @throw BadRequestError if the body is invalid
    * @throw NotFoundError if the Comment could not be found
    */
-  virtual Comment Update(std::string body);
+  virtual Comment Update(const std::string& body);
+
+  /**
+   * Applies a JSON merge patch to a Comment and saves it to the JSON file. Only
+   * the fields in the patch are validated
+   * @param id the id of the Comment to patch
+   * @param body the merge patch
+   * @throw BadRequestError if the patch is invalid
+   * @throw NotFoundError if the Comment could not be found
+   * @throw PreconditionFailedError if the Comment is not at the version in the
+   * patch
+   */
+  virtual Comment Patch(const std::string& id, const std::string& body);
 
   /**
    * Deletes a Comment and saves the changes to our JSON file
    * @param id the id of the Comment to delete
    * @throw NotFoundError if the Comment could not be found
    */
-  virtual bool Delete(std::string id);
+  virtual bool Delete(const std::string& id);
+
+  /**
+   * Deletes a Comment if it is still at the expected version
+   * @param id the id of the Comment to delete
+   * @param expectedVersion the version the caller last saw, or AnyVersion
+   * @throw NotFoundError if the Comment could not be found
+   * @throw PreconditionFailedError if the Comment is at a different version
+   */
+  virtual bool Delete(const std::string& id, int expectedVersion);
+
+  /**
+   * Comments are built from users, so the generation includes the generation
+   * of the UserService
+   * @return the current generation of the comments
+   */
+  virtual uint64_t Generation();
 
  protected:
+  /**
+   * Creates a Comment in the collection, without saving it
+   */
+  Comment ApplyCreate(json& collection, json body) override;
+
+  /**
+   * Updates a Comment in the collection, without saving it
+   */
+  Comment ApplyUpdate(json& collection, json body) override;
+
+  /**
+   * Applies a merge patch to a Comment in the collection, without saving it
+   */
+  Comment ApplyPatch(json& collection, const std::string& id,
+                     json patch) override;
+
+  /**
+   * Deletes a Comment from the collection, without saving it
+   */
+  void ApplyDelete(json& collection, const std::string& id,
+                   int expectedVersion) override;
+
   /**
    * Internal UserService, for handling User data for the Comments
    */
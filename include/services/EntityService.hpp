@@ -2,23 +2,224 @@
 #define ENTITYSERVICE_H
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "ChangeLog.h"
+#include "Exceptions.h"
 #include "FileHandler.h"
 #include "IStreamableFileHandler.h"
+#include "TimeIndex.h"
+#include "Transaction.h"
+
+/**
+ * @struct BulkResult
+ * The outcome of one operation of a bulk request
+ * @tparam T Entity class the operation was applied to
+ */
+template <typename T>
+struct BulkResult {
+  /**
+   * The operation that was applied (create, update, patch or delete)
+   */
+  std::string op;
+
+  /**
+   * The id of the Entity the operation was applied to
+   */
+  std::string id;
+
+  /**
+   * The Entity after the operation. Left empty for deletes and failures
+   */
+  T entity;
+
+  /**
+   * The error the operation failed with, or nullptr if it succeeded
+   */
+  std::exception_ptr error;
+};
+
+/**
+ * @class FilterView
+ * The items of a json array that have every field of a query, found as they
+ * are iterated over rather than copied out of the array. The view refers to
+ * the array, so it must not outlive it, or be used after the array changes
+ */
+class FilterView {
+ public:
+  /**
+   * The fields and values an item must have
+   */
+  typedef std::multimap<std::string, std::string> Query;
+
+  /**
+   * @class iterator
+   * Forward iterator over the matching items
+   */
+  class iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef json value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const json* pointer;
+    typedef const json& reference;
+
+    iterator(json::const_iterator current, json::const_iterator end,
+             const Query* query)
+        : _current(current), _end(end), _query(query) {
+      SkipMismatches();
+    }
+
+    reference operator*() const { return *_current; }
+    pointer operator->() const { return &*_current; }
+
+    iterator& operator++() {
+      ++_current;
+      SkipMismatches();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const iterator& other) const {
+      return _current == other._current;
+    }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+
+   private:
+    void SkipMismatches() {
+      while (_current != _end && !FilterView::Matches(*_current, *_query)) {
+        ++_current;
+      }
+    }
+
+    json::const_iterator _current;
+    json::const_iterator _end;
+    const Query* _query;
+  };
+
+  /**
+   * Constructor for a query owned by the caller, which must outlive the view
+   * @param data the json array to filter
+   * @param query the fields and values to filter by
+   */
+  FilterView(const json& data, const Query& query)
+      : _data(&data), _query(&query) {}
+
+  /**
+   * Constructor for a query the view keeps, i.e. one built for the call
+   * @param data the json array to filter
+   * @param query the fields and values to filter by
+   */
+  FilterView(const json& data, Query&& query)
+      : _data(&data), _ownedQuery(std::move(query)) {}
+
+  FilterView(const FilterView& other)
+      : _data(other._data),
+        _query(other._query),
+        _ownedQuery(other._ownedQuery) {}
+
+  FilterView(FilterView&& other)
+      : _data(other._data),
+        _query(other._query),
+        _ownedQuery(std::move(other._ownedQuery)) {}
+
+  FilterView& operator=(const FilterView&) = delete;
+
+  iterator begin() const {
+    return iterator(_data->cbegin(), _data->cend(), &GetQuery());
+  }
+  iterator end() const {
+    return iterator(_data->cend(), _data->cend(), &GetQuery());
+  }
+
+  /**
+   * @return whether no item matches. Stops at the first one that does
+   */
+  bool empty() const { return begin() == end(); }
+
+  /**
+   * @return the number of matching items
+   */
+  std::size_t size() const { return std::distance(begin(), end()); }
+
+  /**
+   * @return the first matching item. The view must not be empty
+   */
+  const json& front() const { return *begin(); }
+
+  /**
+   * @param item a json item
+   * @param query the fields and values to filter by. A field given several
+   * times matches any of its values
+   * @return whether the item has every field of the query, with one of its
+   * values
+   */
+  static bool Matches(const json& item, const Query& query) {
+    for (auto first = query.begin(); first != query.end();
+         first = query.upper_bound(first->first)) {
+      // Only strings can equal a query value. Comparing the strings directly
+      // avoids converting the value to json for every item
+      auto field = item.find(first->first);
+      if (field == item.end() || !field->is_string()) return false;
+
+      const std::string& value = field->get_ref<const std::string&>();
+      auto last = query.upper_bound(first->first);
+      if (std::none_of(first, last, [&value](const Query::value_type& param) {
+            return param.second == value;
+          })) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  const Query& GetQuery() const {
+    return _query != nullptr ? *_query : _ownedQuery;
+  }
+
+  const json* _data;
+
+  /**
+   * The caller's query, or nullptr if the view keeps its own
+   */
+  const Query* _query = nullptr;
+
+  Query _ownedQuery;
+};
 
 /**
  * @class EntityService
  * This class provides a template interface for handling Entity data stored in
  * JSON files in persistent storage
  * @tparam T Entity class the service is handling
+ *
+ * Changes to several collections that must be saved together are made in a
+ * Transaction, which the service joins when its collection is first changed
  */
 template <typename T>
-class EntityService {
+class EntityService : public Transactional {
  public:
+  /**
+   * Expected version that matches any version of a stored Entity
+   */
+  static constexpr int AnyVersion = -1;
+
   /**
    * Constructor for building an EntityService from an existing
    * IStreamableFileHandler
@@ -49,35 +250,128 @@ class EntityService {
    * @return a vector of entities of type T
    */
   virtual std::vector<T> Get(
-      const std::multimap<std::string, std::string> queryParams = {}) = 0;
+      const std::multimap<std::string, std::string>& queryParams = {}) = 0;
 
   /**
    * Gets an Entity
    * @param id the Entity's ID that we want to retrieve from our JSON file
    * @return the entity of type T
    */
-  virtual T Get(const std::string id) = 0;
+  virtual T Get(const std::string& id) = 0;
 
   /**
    * Creates a Entity and saves it to the JSON file
    * @param body the information of the Entity to create
    * @return the successfully created Entity of type T
    */
-  virtual T Create(std::string body) = 0;
+  virtual T Create(const std::string& body) = 0;
 
   /**
-   * Updates an Entity and saves that updated Entity to our JSON File
+   * Updates an Entity and saves that updated Entity to our JSON File. If the
+   * body has a version, the update is only made if the stored Entity is still
+   * at that version
    * @param body the information of the Entity to update
    * @return the successfully updated Entity of type T
+   * @throw PreconditionFailedError if the Entity has been changed since the
+   * version in the body
+   */
+  virtual T Update(const std::string& body) = 0;
+
+  /**
+   * Applies a [JSON merge patch](https://tools.ietf.org/html/rfc7396) to an
+   * Entity and saves it to our JSON file. Only the fields in the patch are
+   * validated, and the rest of the stored Entity is left as it is. If the patch
+   * has a version, it is only applied if the Entity is still at that version
+   * @param id the id of the Entity to patch
+   * @param body the merge patch to apply to the Entity
+   * @return the successfully patched Entity of type T
+   * @throw NotImplementedError if the Entity cannot be patched
    */
-  virtual T Update(std::string body) = 0;
+  virtual T Patch(const std::string& /*id*/, const std::string& /*body*/) {
+    throw NotImplementedError("This kind of Entity cannot be patched");
+  }
 
   /**
    * Deletes an Entity and saves the changes to our JSON file
    * @param id the id of the Entity to delete
    * @returns whether or not the Entity was successfully deleted
    */
-  virtual bool Delete(std::string id) = 0;
+  virtual bool Delete(const std::string& id) = 0;
+
+  /**
+   * Deletes an Entity if the stored Entity is still at the expected version
+   * @param id the id of the Entity to delete
+   * @param expectedVersion the version of the Entity the caller last saw, or
+   * AnyVersion to delete the Entity regardless of its version
+   * @returns whether or not the Entity was successfully deleted
+   * @throw PreconditionFailedError if the Entity is at a different version
+   */
+  virtual bool Delete(const std::string& id, int expectedVersion) = 0;
+
+  /**
+   * Applies a batch of operations to the collection while holding the lock,
+   * and saves the results with a single write. Each operation is a JSON object
+   * of the form
+   * \verbatim
+   * {
+   *   "op": create, update, patch or delete,
+   *   "id": the id of the Entity (not needed for create or update),
+   *   "version": the version the Entity is expected to be at (optional),
+   *   "body": the Entity, or the merge patch (not needed for delete)
+   * }
+   * \endverbatim
+   * Operations are applied in order, and an operation that fails leaves the
+   * collection as it was, so the others are still applied
+   * @param operations a JSON array of operations
+   * @return the result of each operation, in the same order
+   */
+  virtual std::vector<BulkResult<T>> Bulk(const json& operations) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    json collection = _fileHandler->read();
+    bool changed = false;
+    std::vector<BulkResult<T>> results =
+        ApplyBulk(collection, operations, &changed);
+
+    if (changed) {
+      Save(collection);
+    }
+    return results;
+  }
+
+  /**
+   * Creates an Entity as part of a Transaction, which saves it when it is
+   * committed
+   * @param transaction the Transaction, which the collection joins
+   * @param body the information of the Entity to create
+   * @return the created Entity
+   * @throw BadRequestError if the body is invalid
+   */
+  virtual T Create(Transaction* transaction, json body) {
+    return ApplyCreate(transaction->Collection(this), std::move(body));
+  }
+
+  /**
+   * Deletes every Entity matching a query as part of a Transaction, which
+   * saves the collection when it is committed
+   * @param transaction the Transaction, which the collection joins
+   * @param query the fields and values of the Entities to delete
+   * @return the number of Entities deleted
+   */
+  virtual std::size_t DeleteMatching(
+      Transaction* transaction,
+      const std::multimap<std::string, std::string>& query) {
+    json& collection = transaction->Collection(this);
+    std::size_t deleted = 0;
+    auto kept = std::remove_if(
+        collection.begin(), collection.end(), [&](const json& item) {
+          if (!FilterView::Matches(item, query)) return false;
+          Record("delete", item.value("id", ""));
+          deleted++;
+          return true;
+        });
+    collection.erase(kept, collection.end());
+    return deleted;
+  }
 
   /**
    * @return the file handler for the service
@@ -86,31 +380,69 @@ class EntityService {
     return _fileHandler;
   }
 
+  /**
+   * The generation of the collection increases every time the service writes
+   * to persistent storage. Services whose Entities are built from other
+   * services (i.e. an Issue and its comments and votes) include the
+   * generations of those services, so any change that could alter a response
+   * produces a new generation. This lets callers detect changes without
+   * reading the JSON file
+   * @return the current generation of the collection
+   */
+  virtual uint64_t Generation() { return _generation; }
+
+  /**
+   * Records every change the service saves in a ChangeLog
+   * @param changeLog the ChangeLog shared by the services
+   * @param collection the name of the collection in the ChangeLog (i.e.
+   * issues)
+   */
+  void SetChangeLog(const std::shared_ptr<ChangeLog>& changeLog,
+                    const std::string& collection) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _changeLog = changeLog;
+    _collection = collection;
+  }
+
   /**
    * Filters our json data file to find a specific value. The json data should
-   * be an array.
+   * be an array. Nothing is copied: the matches are found as the view is
+   * iterated over
    * @param data the json file data we are trying to search
    * @param searchParameters a key value pair where the key is the field and the
-   * value is the value we want to filter from our json file.
-   * @return the filtered json data
+   * value is the value we want to filter from our json file. Must outlive the
+   * view
+   * @return a view of the matching items of data
    */
-  json Filter(json data,
-              std::multimap<std::string, std::string> searchParameters) {
-    json filtered;
-    std::copy_if(data.begin(), data.end(), std::back_inserter(filtered),
-                 [&](const json& item) {
-                   bool found = true;
-                   for (auto& param : searchParameters) {
-                     found = found && item.contains(param.first) &&
-                             item[param.first] == param.second;
-                   }
-
-                   return found;
-                 });
+  FilterView Filter(
+      const json& data,
+      const std::multimap<std::string, std::string>& searchParameters) const {
+    return FilterView(data, searchParameters);
+  }
 
-    return filtered;
+  /**
+   * Filters our json data file with a query built for the call (i.e.
+   * Filter(collection, {{"id", id}})), which the view keeps
+   * @param data the json file data we are trying to search
+   * @param searchParameters the fields and values to filter by
+   * @return a view of the matching items of data
+   */
+  FilterView Filter(
+      const json& data,
+      std::multimap<std::string, std::string>&& searchParameters) const {
+    return FilterView(data, std::move(searchParameters));
   }
 
+  /**
+   * The view would refer to a temporary that is gone by the time it is used
+   */
+  FilterView Filter(json&& data,
+                    const std::multimap<std::string, std::string>&
+                        searchParameters) const = delete;
+  FilterView Filter(json&& data,
+                    std::multimap<std::string, std::string>&&
+                        searchParameters) const = delete;
+
   /**
    * Generates unique ID of 10 lowercase characters and numbers for an Entity
    * object
@@ -131,6 +463,344 @@ class EntityService {
   }
 
  protected:
+  /**
+   * Reads the collection from persistent storage while holding _mutex, so it
+   * is never read part way through a write
+   * @return the json data for the collection
+   */
+  json Load() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _fileHandler->read();
+  }
+
+  /**
+   * A collection as it was read, with a TimeIndex of it
+   */
+  struct IndexedCollection {
+    explicit IndexedCollection(json data)
+        : items(std::move(data)), times(items) {}
+
+    json items;
+    TimeIndex times;
+  };
+
+  /**
+   * Gets the collection with a TimeIndex, reading it and building the index
+   * again only if the collection has been saved since. Only this service
+   * writes the collection, so changes made to the file by anything else
+   * aren't seen until then
+   * @return the collection and its index
+   */
+  std::shared_ptr<const IndexedCollection> LoadIndexed() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t generation = _generation;
+    if (!_indexed || _indexedGeneration != generation) {
+      _indexed =
+          std::make_shared<const IndexedCollection>(_fileHandler->read());
+      _indexedGeneration = generation;
+    }
+    return _indexed;
+  }
+
+  /**
+   * Finds the items of the collection matching a list query. Queries with
+   * ListOptions (a time range, sort or limit) are answered from the TimeIndex
+   * of the collection, and the others by filtering the collection as it is
+   * read
+   * @param queryParams the fields and values to filter by, and the ListOptions
+   * @param visit called with the json of each item to list, in order
+   * @throw BadRequestError if the ListOptions are invalid
+   */
+  template <typename Visit>
+  void ForEachMatch(const std::multimap<std::string, std::string>& queryParams,
+                    Visit visit) {
+    if (!ListOptions::Requested(queryParams)) {
+      json collection = Load();
+      for (const json& item : Filter(collection, queryParams)) visit(item);
+      return;
+    }
+
+    std::multimap<std::string, std::string> filters;
+    ListOptions options = ListOptions::Parse(queryParams, &filters);
+    std::shared_ptr<const IndexedCollection> indexed = LoadIndexed();
+    const json& items = indexed->items;
+
+    std::vector<std::size_t> matches;
+    if (!filters.empty()) {
+      for (std::size_t row = 0; row < indexed->times.size(); row++) {
+        if (FilterView::Matches(items[row], filters)) matches.push_back(row);
+      }
+    }
+    for (std::size_t row : indexed->times.Select(
+             filters.empty() ? nullptr : &matches, options)) {
+      visit(items[row]);
+    }
+  }
+
+  /**
+   * Applies the operations of a bulk request to the collection, without
+   * saving it (see Bulk)
+   * @param collection the json data of the collection
+   * @param operations a JSON array of operations
+   * @param changed set to true if any operation was applied
+   * @return the result of each operation, in the same order
+   */
+  std::vector<BulkResult<T>> ApplyBulk(json& collection,
+                                       const json& operations, bool* changed) {
+    std::vector<BulkResult<T>> results;
+    for (auto& operation : operations) {
+      BulkResult<T> result;
+      try {
+        if (!operation.is_object()) {
+          throw BadRequestError("Bulk operations must be JSON objects");
+        }
+        result.op = StringField(operation, "op");
+        result.id = StringField(operation, "id");
+        json body = operation.value("body", json::object());
+        if (operation.contains("version") && body.is_object()) {
+          body["version"] = operation["version"];
+        }
+
+        if (result.op == "create") {
+          result.entity = ApplyCreate(collection, body);
+        } else if (result.op == "update") {
+          if (!result.id.empty() && body.is_object()) body["id"] = result.id;
+          result.entity = ApplyUpdate(collection, body);
+        } else if (result.op == "patch") {
+          result.entity = ApplyPatch(collection, result.id, body);
+        } else if (result.op == "delete") {
+          ApplyDelete(collection, result.id, ExpectedVersion(operation));
+        } else {
+          throw BadRequestError(
+              std::string("Unknown bulk operation: " + result.op).c_str());
+        }
+
+        if (result.op != "delete") result.id = result.entity.id;
+        *changed = true;
+      } catch (const std::exception& e) {
+        result.error = std::current_exception();
+      }
+      results.push_back(result);
+    }
+    return results;
+  }
+
+  /**
+   * Creates an Entity in the collection, without saving it
+   * @param collection the json data of the collection
+   * @param body the information of the Entity to create
+   * @return the created Entity
+   */
+  virtual T ApplyCreate(json& /*collection*/, json /*body*/) {
+    throw NotImplementedError("This kind of Entity cannot be created");
+  }
+
+  /**
+   * Updates an Entity in the collection, without saving it
+   * @param collection the json data of the collection
+   * @param body the information of the Entity to update
+   * @return the updated Entity
+   */
+  virtual T ApplyUpdate(json& /*collection*/, json /*body*/) {
+    throw NotImplementedError("This kind of Entity cannot be updated");
+  }
+
+  /**
+   * Applies a merge patch to an Entity in the collection, without saving it
+   * @param collection the json data of the collection
+   * @param id the id of the Entity to patch
+   * @param patch the merge patch
+   * @return the patched Entity
+   */
+  virtual T ApplyPatch(json& /*collection*/, const std::string& /*id*/,
+                       json /*patch*/) {
+    throw NotImplementedError("This kind of Entity cannot be patched");
+  }
+
+  /**
+   * Deletes an Entity from the collection, without saving it
+   * @param collection the json data of the collection
+   * @param id the id of the Entity to delete
+   * @param expectedVersion the version the caller last saw, or AnyVersion
+   */
+  virtual void ApplyDelete(json& /*collection*/, const std::string& /*id*/,
+                           int /*expectedVersion*/) {
+    throw NotImplementedError("This kind of Entity cannot be deleted");
+  }
+
+  /**
+   * Parses the body of a PATCH request
+   * @param body the merge patch
+   * @return the parsed merge patch
+   * @throw BadRequestError if the patch isn't a JSON object
+   */
+  json ParsePatch(const std::string& body) {
+    try {
+      return json::parse(body);
+    } catch (const std::exception& e) {
+      throw BadRequestError(
+          std::string("An error occurred parsing the following patch: " + body)
+              .c_str());
+    }
+  }
+
+  /**
+   * Checks that a merge patch only changes fields that can be patched, and
+   * removes the id of the Entity from it. Any other field, read only or not a
+   * field of the Entity at all, is rejected, so a patched Entity is stored
+   * with the same fields as an updated one
+   * @param id the id of the Entity being patched
+   * @param patch the merge patch
+   * @param patchableFields the fields of the Entity that can be patched. The
+   * version can always be given
+   * @throw BadRequestError if the patch isn't a JSON object, or it changes the
+   * id or any field that isn't patchable
+   */
+  void CheckPatch(const std::string& id, json& patch,
+                  const std::vector<std::string>& patchableFields) {
+    if (!patch.is_object()) {
+      throw BadRequestError(
+          std::string("A patch must be a JSON object, not " + patch.dump())
+              .c_str());
+    }
+
+    // The id can be repeated in the patch, but not changed
+    auto itId = patch.find("id");
+    if (itId != patch.end()) {
+      if (*itId != id) {
+        throw BadRequestError(
+            std::string("The id of " + id + " cannot be changed").c_str());
+      }
+      patch.erase(itId);
+    }
+
+    for (auto& field : patch.items()) {
+      if (field.key() != "version" &&
+          std::find(patchableFields.begin(), patchableFields.end(),
+                    field.key()) == patchableFields.end()) {
+        throw BadRequestError(
+            std::string("The " + field.key() + " field cannot be patched")
+                .c_str());
+      }
+    }
+  }
+
+  /**
+   * Reads an optional string field of a request
+   * @param body the json body of the request
+   * @param field the name of the field
+   * @return the value of the field, or an empty string if there isn't one
+   * @throw BadRequestError if the field is not a string
+   */
+  std::string StringField(const json& body, const std::string& field) {
+    auto it = body.find(field);
+    if (it == body.end() || it->is_null()) return "";
+    if (!it->is_string()) {
+      throw BadRequestError(
+          std::string("The " + field + " field must be a string").c_str());
+    }
+    return it->get<std::string>();
+  }
+
+  /**
+   * Finds an Entity in the collection
+   * @param collection the json data of the collection
+   * @param id the id of the Entity
+   * @return an iterator to the Entity, or the end of the collection
+   */
+  json::iterator FindById(json& collection, const std::string& id) {
+    return std::find_if(collection.begin(), collection.end(),
+                        [&](const json& item) { return item["id"] == id; });
+  }
+
+  /**
+   * Reads the version a request expects an Entity to be at
+   * @param body the json body of the request
+   * @return the version in the body, or AnyVersion if there isn't one
+   * @throw BadRequestError if the version is not a number
+   */
+  int ExpectedVersion(const json& body) {
+    auto it = body.find("version");
+    if (it == body.end()) return AnyVersion;
+    if (!it->is_number_integer()) {
+      throw BadRequestError(
+          std::string("The version must be a whole number, not " + it->dump())
+              .c_str());
+    }
+    return it->get<int>();
+  }
+
+  /**
+   * Checks that a stored Entity is at the version a request expects. Callers
+   * should hold _mutex, so the Entity cannot change between the check and the
+   * write
+   * @param stored the json of the Entity in persistent storage
+   * @param expectedVersion the version the request expects, or AnyVersion
+   * @throw PreconditionFailedError if the versions are different
+   */
+  void CheckVersion(const json& stored, int expectedVersion) {
+    int version = stored.value("version", 0);
+    if (expectedVersion != AnyVersion && expectedVersion != version) {
+      throw PreconditionFailedError(
+          std::string("The Entity with id " + stored["id"].get<std::string>() +
+                      " is at version " + std::to_string(version) +
+                      ", not version " + std::to_string(expectedVersion))
+              .c_str());
+    }
+  }
+
+  /**
+   * Writes the updated collection to persistent storage and advances the
+   * generation of the collection. Callers should hold _mutex from the read
+   * the updated collection was built from until the write is done
+   * @param data the updated json data for the collection
+   */
+  void Save(const json& data) {
+    // Changes that fail to save are never published
+    std::vector<Change> pending;
+    pending.swap(_pending);
+
+    _fileHandler->write(data);
+    ++_generation;
+
+    if (_changeLog) {
+      for (auto& change : pending) {
+        _changeLog->Append(_collection, change.op, change.id, change.entity);
+      }
+    }
+  }
+
+  /**
+   * Records a change made to the collection, to be added to the ChangeLog once
+   * the collection is saved, and to the commit record of a Transaction.
+   * Callers should hold _mutex
+   * @param op the operation that was applied (create, update, patch or delete)
+   * @param id the id of the Entity that was changed
+   * @param entity the Entity after the change, or null if it was deleted
+   */
+  void Record(const std::string& op, const std::string& id,
+              const json& entity = nullptr) {
+    Change change;
+    change.op = op;
+    change.id = id;
+    change.entity = entity;
+    _pending.push_back(change);
+  }
+
+  const std::string& CollectionName() const override { return _collection; }
+
+  std::mutex& CollectionMutex() override { return _mutex; }
+
+  json ReadCollection() override { return _fileHandler->read(); }
+
+  void SaveCollection(const json& data) override { Save(data); }
+
+  const std::vector<Change>& PendingChanges() const override {
+    return _pending;
+  }
+
+  void DiscardChanges() override { _pending.clear(); }
+
   /**
    * The File Handler
    */
@@ -145,6 +815,44 @@ class EntityService {
   * Input file stream containing the JSON data corresponding to the service
   */
   std::ifstream is;
+
+  /**
+   * Number of writes made to the collection by this service
+   */
+  std::atomic<uint64_t> _generation{0};
+
+  /**
+   * The ChangeLog that saved changes are recorded in, if there is one
+   */
+  std::shared_ptr<ChangeLog> _changeLog;
+
+  /**
+   * The name of the collection in the ChangeLog and in commit records
+   */
+  std::string _collection;
+
+  /**
+   * Changes recorded since the collection was last saved
+   */
+  std::vector<Change> _pending;
+
+  /**
+   * The collection as it was last read for a query with ListOptions, or
+   * nullptr. Guarded by _mutex
+   */
+  std::shared_ptr<const IndexedCollection> _indexed;
+
+  /**
+   * The generation of the collection when _indexed was read
+   */
+  uint64_t _indexedGeneration = 0;
+
+  /**
+   * Guards the JSON file while it is read and written. It is only held for
+   * the read-check-write of the file, never for a whole request; concurrent
+   * writers to the same Entity are told apart by the version checks
+   */
+  std::mutex _mutex;
 };
 
 #endif  // ENTITYSERVICE_H
@@ -1,6 +1,7 @@
 #ifndef IssueSERVICE_H
 #define IssueSERVICE_H
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -12,6 +13,7 @@
 #include "FileHandler.h"
 #include "IStreamableFileHandler.h"
 #include "Issue.h"
+#include "IssueTable.h"
 #include "UserService.h"
 #include "VoteService.h"
 
@@ -58,7 +60,7 @@ class IssueService : public EntityService<Issue> {
    * @return a vector of Users
    */
   virtual std::vector<Issue> Get(
-      const std::multimap<std::string, std::string> queryParams = {});
+      const std::multimap<std::string, std::string>& queryParams = {});
 
   /**
    * Get a Issue by its id
@@ -66,33 +68,174 @@ class IssueService : public EntityService<Issue> {
    * @return the Issue with that id
    * @throw NotFoundError if no Issue is found with that id
    */
-  virtual Issue Get(const std::string id);
+  virtual Issue Get(const std::string& id);
 
   /**
-   * Creates a Issue and saves it to the JSON file
+   * Creates a Issue and saves it to the JSON file. The comment made from its
+   * description is saved in the same Transaction
    * @param body the information of the Issue to create
    * @throw BadRequestError if the body is invalid
    */
-  virtual Issue Create(std::string body);
+  virtual Issue Create(const std::string& body);
 
   /**
    * Not implemented for the Issue model, since there is no concept of updating
    * a Issue
    * @throw NotImplementedError alerting the caller that this method isn't valid
    */
-  virtual Issue Update(std::string body);
+  virtual Issue Update(const std::string& body);
 
   /**
-   * Deletes a Issue and saves the changes to our JSON file
+   * Applies a JSON merge patch to an Issue and saves it to the JSON file. Only
+   * the fields in the patch are validated
+   * @param id the id of the Issue to patch
+   * @param body the merge patch
+   * @throw BadRequestError if the patch is invalid
+   * @throw NotFoundError if the Issue could not be found
+   * @throw PreconditionFailedError if the Issue is not at the version in the
+   * patch
+   */
+  virtual Issue Patch(const std::string& id, const std::string& body);
+
+  /**
+   * Deletes a Issue, with its comments and votes, and saves the changes to
+   * our JSON files
    * @param id the id of the Issue to delete
    * @throw NotFoundError if the Issue
    */
-  virtual bool Delete(std::string id);
+  virtual bool Delete(const std::string& id);
+
+  /**
+   * Deletes a Issue if it is still at the expected version
+   * @param id the id of the Issue to delete
+   * @param expectedVersion the version the caller last saw, or AnyVersion
+   * @throw NotFoundError if the Issue could not be found
+   * @throw PreconditionFailedError if the Issue is at a different version
+   */
+  virtual bool Delete(const std::string& id, int expectedVersion);
+
+  /**
+   * Applies a batch of operations to the issues in one Transaction, so the
+   * comments and votes created or deleted with them are saved together
+   * @param operations a JSON array of operations
+   * @return the result of each operation, in the same order
+   */
+  std::vector<BulkResult<Issue>> Bulk(const json& operations) override;
+
+  /**
+   * Writes the commit records of the Transactions that change more than one
+   * collection to a Journal
+   * @param journal the journal, or nullptr to save the collections without one
+   */
+  void SetJournal(const std::shared_ptr<Journal>& journal);
+
+  /**
+   * Runs a change while the issues are locked, once the issue it is for is
+   * known to exist, so the issue can't be deleted until the change is done.
+   * VoteService::Toggle casts votes through it
+   * @param issueId the id of the issue
+   * @param apply the change
+   * @throw NotFoundError if no issue has the id
+   */
+  virtual void WhileIssueExists(const std::string& issueId,
+                                const std::function<void()>& apply);
+
+  /**
+   * Issues are built from users, comments, and votes, so the generation
+   * includes the generations of those services
+   * @return the current generation of the issues
+   */
+  virtual uint64_t Generation();
 
  protected:
+  /**
+   * Creates a Issue in the collection, without saving it
+   */
+  Issue ApplyCreate(json& collection, json body) override;
+
+  /**
+   * Updates a Issue in the collection, without saving it
+   */
+  Issue ApplyUpdate(json& collection, json body) override;
+
+  /**
+   * Applies a merge patch to a Issue in the collection, without saving it
+   */
+  Issue ApplyPatch(json& collection, const std::string& id,
+                   json patch) override;
+
+  /**
+   * Deletes a Issue from the collection, without saving it
+   */
+  void ApplyDelete(json& collection, const std::string& id,
+                   int expectedVersion) override;
+
+  /**
+   * Applies a change to the issues in a Transaction, and commits it. The
+   * Transaction is held in _transaction while the change is applied
+   * @param apply applies the change to the json data of the issues
+   * @return what apply returns
+   */
+  template <typename Result, typename Apply>
+  Result Transact(Apply apply);
+
+  /**
+   * Gets the Entities that belong to an issue (i.e. its comments), from the
+   * Transaction if it holds their collection
+   * @param service the service of the Entities
+   * @param issueId the id of the issue
+   * @return the Entities of the issue
+   */
+  template <typename Related>
+  std::vector<Related> RelatedTo(EntityService<Related>* service,
+                                 const std::string& issueId);
+
+  /**
+   * Gets the issues as a table, reading them again only if they have been
+   * saved since they were last read. Only this service writes the issues, so
+   * changes made to the file by anything else aren't seen until then
+   * @return the issues
+   */
+  std::shared_ptr<const IssueTable> LoadTable();
+
+  /**
+   * Gets the issues as a table, as LoadTable does. Callers should hold _mutex
+   * @return the issues
+   */
+  std::shared_ptr<const IssueTable> ReadTable();
+
+  /**
+   * Builds an Issue with its users, votes and comments
+   * @param stored the json of the issue
+   * @param users resolves the users of the issue
+   * @return the Issue
+   */
+  Issue Hydrate(const json& stored, UserResolver* users);
+
   std::shared_ptr<UserService> _userService;
   std::shared_ptr<CommentService> _commentService;
   std::shared_ptr<VoteService> _voteService;
+
+  /**
+   * The journal of the Transactions, or nullptr
+   */
+  std::shared_ptr<Journal> _journal;
+
+  /**
+   * The Transaction the issues are being changed in, or nullptr. Guarded by
+   * _mutex, which the Transaction holds
+   */
+  Transaction* _transaction = nullptr;
+
+  /**
+   * The issues as they were last read, or nullptr. Guarded by _mutex
+   */
+  std::shared_ptr<const IssueTable> _table;
+
+  /**
+   * The generation of the issues when _table was read
+   */
+  uint64_t _tableGeneration = 0;
 };
 
 #endif  // IssueSERVICE_H
@@ -0,0 +1,202 @@
+#ifndef ISSUE_TABLE_H
+#define ISSUE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CompressedBitmap.h"
+#include "EntityId.h"
+#include "TimeIndex.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @class IssueTable
+ * @brief A column oriented copy of the fields issues are usually listed by,
+ * so a list query compares integers in tight loops instead of looking up
+ * and comparing strings in the json of every issue
+ *
+ * Each row is the issue at the same position of the json array the table was
+ * built from, which the table keeps. The id and createdBy are held as columns
+ * of EntityId values. status, assignedTo and reporter have few distinct
+ * values, so each of their values has a CompressedBitmap of the rows with
+ * it instead, and queries on them are answered by joining and intersecting
+ * bitmaps. createdAt and updatedAt are kept in a TimeIndex. A field that is
+ * missing, or isn't a string, is in no bitmap and is held as a value no
+ * query can match, just as FilterView never matches it
+ */
+class IssueTable {
+ public:
+  /**
+   * The fields and values an issue must have
+   */
+  typedef std::multimap<std::string, std::string> Query;
+
+  /**
+   * @class Selection
+   * @brief The rows matching a query, one bit per row
+   */
+  class Selection {
+   public:
+    /**
+     * Constructor
+     * @param rows the number of rows of the table
+     * @param selected whether every row starts selected, or none
+     */
+    explicit Selection(std::size_t rows, bool selected = true);
+
+    /**
+     * @return the number of rows selected
+     */
+    std::size_t Count() const;
+
+    /**
+     * @return the selected rows, in order
+     */
+    std::vector<std::size_t> Rows() const;
+
+    /**
+     * Deselects every row
+     */
+    void Clear();
+
+    /**
+     * Deselects the rows the other selection doesn't have
+     * @param other a selection of the same table
+     */
+    void And(const Selection& other);
+
+    /**
+     * One bit per row, 64 rows to a word
+     */
+    std::vector<uint64_t> words;
+  };
+
+  /**
+   * Constructor. Builds the columns and indexes
+   * @param issues the json array of the issues
+   */
+  explicit IssueTable(json issues);
+
+  /**
+   * @return the json array of the issues
+   */
+  const json& Issues() const { return _issues; }
+
+  /**
+   * @return the creation and update times of the issues
+   */
+  const TimeIndex& Times() const { return _times; }
+
+  /**
+   * @return the number of rows (issues)
+   */
+  std::size_t size() const { return _ids.size(); }
+
+  /**
+   * @param query the fields and values to filter by
+   * @return whether every field of the query has a column, so Select can
+   * answer it
+   */
+  static bool Covers(const Query& query);
+
+  /**
+   * Finds the rows matching a query, as FilterView would: a row must match
+   * every field of the query, and one of the values given for each field. The
+   * query must be covered by the columns
+   * @param query the fields and values to filter by
+   * @return the matching rows
+   */
+  Selection Select(const Query& query) const;
+
+  /**
+   * Counts the rows matching a query. A query of indexed fields only is
+   * counted from the bitmaps, without visiting the rows
+   * @param query the fields and values to filter by, covered by the columns
+   * @return the number of matching rows
+   */
+  std::size_t Count(const Query& query) const;
+
+ private:
+  /**
+   * Held for a field that is missing or isn't a string
+   */
+  static const uint64_t Missing = UINT64_MAX;
+
+  /**
+   * The rows of each value of an id field
+   */
+  typedef std::unordered_map<uint64_t, CompressedBitmap> IdIndex;
+
+  /**
+   * Interned ids are kept in _interned, so their values stay theirs for as
+   * long as the table holds them
+   * @param issue the json of an issue
+   * @param field the name of an id field
+   * @return the EntityId value of the field, or Missing
+   */
+  uint64_t IdColumnValue(const json& issue, const char* field);
+
+  /**
+   * @param field the name of a field
+   * @return the column of an id field, or nullptr if it isn't one
+   */
+  const std::vector<uint64_t>* IdColumn(const std::string& field) const;
+
+  /**
+   * @param field the name of a field
+   * @return whether the field has an index
+   */
+  static bool Indexed(const std::string& field);
+
+  /**
+   * @param field the name of an indexed field
+   * @param value a value of the field
+   * @return the rows with the value, or nullptr if there are none
+   */
+  const CompressedBitmap* IndexedRows(const std::string& field,
+                                      const std::string& value) const;
+
+  /**
+   * Finds the rows of an indexed field with any of the given values
+   * @param first the first field and value of the query for the field
+   * @param last past the last one
+   * @return the rows
+   */
+  CompressedBitmap IndexedRows(Query::const_iterator first,
+                               Query::const_iterator last) const;
+
+  /**
+   * Finds the rows matching the indexed fields of a query
+   * @param query the fields and values to filter by
+   * @param rows set to the matching rows
+   * @return whether the query has any indexed fields
+   */
+  bool IndexedRows(const Query& query, CompressedBitmap* rows) const;
+
+  json _issues;
+  TimeIndex _times;
+
+  std::vector<uint64_t> _ids;
+  std::vector<uint64_t> _createdBy;
+
+  /**
+   * The rows of each status
+   */
+  std::unordered_map<std::string, CompressedBitmap> _statusRows;
+
+  IdIndex _assignedToRows;
+  IdIndex _reporterRows;
+
+  /**
+   * The interned ids whose values are held by the columns and indexes
+   */
+  std::vector<EntityId> _interned;
+};
+
+#endif  // ISSUE_TABLE_H
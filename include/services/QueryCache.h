@@ -0,0 +1,175 @@
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChangeLog.h"
+#include "EntityId.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @class QueryCache
+ * @brief The serialized responses of recent list queries of one collection,
+ * so a query that is asked again is answered without reading, hydrating or
+ * serializing the Entities
+ *
+ * Queries are told apart by their parameters, in any order. The cache is
+ * bounded by the bytes it holds, and drops the least recently used responses
+ * to stay under it. Every change recorded in the ChangeLog is given to
+ * Invalidate, which drops only the responses the change could alter: the ones
+ * that include the changed Entity, and the ones whose query the Entity now
+ * matches
+ */
+class QueryCache {
+ public:
+  /**
+   * The most bytes held when no capacity is given
+   */
+  static constexpr std::size_t DefaultCapacity = 64 << 20;
+
+  /**
+   * The fields and values of a list query
+   */
+  typedef std::multimap<std::string, std::string> Query;
+
+  /**
+   * The use of the cache so far
+   */
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+  };
+
+  /**
+   * Constructor
+   * @param collection the collection the responses list (i.e. issues)
+   * @param capacity the most bytes to hold, counting the responses and what
+   * is kept to invalidate them
+   */
+  explicit QueryCache(const std::string& collection,
+                      std::size_t capacity = DefaultCapacity);
+
+  /**
+   * Makes the responses depend on another collection whose Entities refer to
+   * the listed ones (i.e. an issue lists the ids of its comments), so changes
+   * to those Entities drop the responses that list what they refer to
+   * @param collection the other collection (i.e. comments)
+   * @param field the field of its Entities holding the id of a listed Entity
+   * (i.e. issueId)
+   */
+  void Depend(const std::string& collection, const std::string& field);
+
+  /**
+   * @param query the parameters of a list query
+   * @return the response to the query, or nullptr if it isn't cached
+   */
+  std::shared_ptr<const std::string> Get(const Query& query);
+
+  /**
+   * The version of the cache increases with every change it is given. Taking
+   * it before reading the Entities lets Put tell whether they could have
+   * changed since
+   * @return the version of the cache
+   */
+  uint64_t Version();
+
+  /**
+   * Caches the response to a query, unless a change has been given to the
+   * cache since version, or the response is too big to hold
+   * @param query the parameters of the query
+   * @param body the serialized response
+   * @param response the response, a json array of Entities. The ids of the
+   * Entities, and the ids in their array fields (i.e. the comments of an
+   * issue), are what the response includes
+   * @param version the version of the cache before the Entities were read
+   */
+  void Put(const Query& query, const std::string& body, const json& response,
+           uint64_t version);
+
+  /**
+   * Drops the responses a change could alter
+   * @param change a change to any of the collections
+   */
+  void Invalidate(const Change& change);
+
+  /**
+   * @return the use of the cache so far
+   */
+  Stats GetStats();
+
+  /**
+   * @param query the parameters of a list query
+   * @return a key that is the same for any order of the parameters, and of
+   * the values of a repeated parameter
+   */
+  static std::string Key(const Query& query);
+
+ private:
+  struct Entry {
+    std::string key;
+
+    /**
+     * The fields of the query, without its ListOptions
+     */
+    Query filters;
+
+    std::shared_ptr<const std::string> body;
+
+    /**
+     * The ids the response includes, sorted
+     */
+    std::vector<EntityId> ids;
+
+    std::size_t bytes = 0;
+  };
+
+  /**
+   * @return whether a change leaves an Entity of the collection matching the
+   * query of an entry, so the Entity could now be in its response
+   */
+  bool Matches(const Entry& entry, const Change& change) const;
+
+  /**
+   * Drops an entry. Callers should hold _mutex
+   */
+  std::list<Entry>::iterator Erase(std::list<Entry>::iterator entry);
+
+  std::string _collection;
+  std::size_t _capacity;
+
+  /**
+   * The collections the responses depend on, and the field of their Entities
+   * that refers to the listed ones
+   */
+  std::map<std::string, std::string> _dependencies;
+
+  /**
+   * The entries, most recently used first, and by key
+   */
+  std::list<Entry> _entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+
+  std::size_t _bytes = 0;
+  uint64_t _version = 0;
+  uint64_t _hits = 0;
+  uint64_t _misses = 0;
+
+  /**
+   * Guards everything above
+   */
+  std::mutex _mutex;
+};
+
+#endif  // QUERY_CACHE_H
@@ -0,0 +1,105 @@
+#ifndef REQUEST_COALESCER_H
+#define REQUEST_COALESCER_H
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+/**
+ * @class RequestCoalescer
+ * @brief Shares the response to a GET request with the identical requests
+ * that arrive while it is being computed, so a burst of them reads and
+ * serializes the Entities once
+ *
+ * Requests are identical when they have the same key. The key includes the
+ * generation of the EntityService when the request arrived, so a request
+ * made after a write never waits for a response computed before it
+ */
+class RequestCoalescer {
+ public:
+  /**
+   * A serialized response, with the version of the Entity it holds
+   */
+  struct Response {
+    /**
+     * Constructor
+     * @param body the serialized response
+     * @param version the version of the Entity, or 0 for a list
+     */
+    explicit Response(std::string body, int version = 0)
+        : body(std::move(body)), version(version) {}
+
+    std::string body;
+    int version;
+  };
+
+  /**
+   * A response shared by the requests waiting for it
+   */
+  typedef std::shared_ptr<const Response> Body;
+
+  /**
+   * The requests so far
+   */
+  struct Stats {
+    /**
+     * Requests that computed their response
+     */
+    uint64_t computed = 0;
+
+    /**
+     * Requests that waited for the response of an identical one
+     */
+    uint64_t shared = 0;
+  };
+
+  /**
+   * Computes a response, or waits for the identical request computing it
+   * @param key the key of the request (see Key)
+   * @param compute computes the response
+   * @return the response
+   * @throw whatever compute throws, to every request waiting for it
+   */
+  Body Do(const std::string& key, const std::function<Body()>& compute);
+
+  /**
+   * @return the number of responses being computed
+   */
+  std::size_t InFlight();
+
+  /**
+   * @return the requests so far
+   */
+  Stats GetStats();
+
+  /**
+   * @param path the path of the request
+   * @param query the normalized query of the request (see QueryCache::Key)
+   * @param generation the generation of the EntityService when the request
+   * arrived
+   * @return the key of the request
+   */
+  static std::string Key(const std::string& path, const std::string& query,
+                         uint64_t generation);
+
+ private:
+  /**
+   * The responses being computed, by key
+   */
+  std::map<std::string, std::shared_future<Body>> _flights;
+
+  uint64_t _computed = 0;
+  uint64_t _shared = 0;
+
+  /**
+   * Guards everything above
+   */
+  std::mutex _mutex;
+};
+
+#endif  // REQUEST_COALESCER_H
@@ -0,0 +1,135 @@
+#ifndef TIME_INDEX_H
+#define TIME_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @struct ListOptions
+ * @brief The parameters of a list query that aren't fields to filter by
+ *
+ * \verbatim
+ * createdAfter=<time>  only the Entities created after the time
+ * updatedSince=<time>  only the Entities updated at or after the time
+ * sort=<field>         createdAt or updatedAt for the oldest first, or
+ *                      -createdAt or -updatedAt for the newest first
+ * limit=<count>        at most count Entities
+ * \endverbatim
+ * Times are read by TimeUtilities::ParseSeconds, and compared to the second.
+ * Without a sort, the Entities are listed in the order they are stored
+ */
+struct ListOptions {
+  /**
+   * The time fields of a MutableEntity
+   */
+  enum Field { CreatedAt, UpdatedAt };
+
+  /**
+   * A time before every other, held for Entities that have never been updated
+   */
+  static const int64_t Never = INT64_MIN;
+
+  /**
+   * @param query the parameters of a list query
+   * @return whether the query has any of the parameters of ListOptions
+   */
+  static bool Requested(const std::multimap<std::string, std::string>& query);
+
+  /**
+   * Splits a list query into its ListOptions and the fields to filter by
+   * @param query the parameters of a list query
+   * @param filters set to the other parameters of the query
+   * @return the ListOptions of the query
+   * @throw BadRequestError if a parameter of ListOptions is invalid, or given
+   * more than once
+   */
+  static ListOptions Parse(const std::multimap<std::string, std::string>& query,
+                           std::multimap<std::string, std::string>* filters);
+
+  /**
+   * The earliest createdAt and updatedAt an Entity can have
+   */
+  int64_t minCreatedAt = Never;
+  int64_t minUpdatedAt = Never;
+
+  bool sorted = false;
+  Field sortField = CreatedAt;
+  bool descending = false;
+
+  std::size_t limit = SIZE_MAX;
+};
+
+/**
+ * @class TimeIndex
+ * @brief The createdAt and updatedAt of the Entities of a collection, in
+ * columns and in order, so a list query can ask for a range of times and the
+ * first few Entities in time order without sorting the whole collection
+ *
+ * Each row is the Entity at the same position of the json array the index was
+ * built from. The index doesn't keep the array, and is only valid for it
+ */
+class TimeIndex {
+ public:
+  /**
+   * Constructor. Builds the index
+   * @param collection the json array of the Entities
+   */
+  explicit TimeIndex(const json& collection);
+
+  /**
+   * @return the number of rows (Entities)
+   */
+  std::size_t size() const { return _createdAt.size(); }
+
+  /**
+   * Applies the range, order and limit of a query to the rows matching its
+   * fields. A query without fields is answered by walking the index from the
+   * start of its range, stopping at the limit; otherwise the first rows in
+   * order are found by a partial sort
+   * @param rows the rows matching the fields of the query, in increasing
+   * order, or nullptr if the query has no fields
+   * @param options the ListOptions of the query
+   * @return the rows to list, in order
+   */
+  std::vector<std::size_t> Select(const std::vector<std::size_t>* rows,
+                                  const ListOptions& options) const;
+
+  /**
+   * @param item the json of an Entity
+   * @param field the name of a time field
+   * @return the time of the field in seconds, or Never if it is missing or
+   * empty
+   */
+  static int64_t Key(const json& item, const char* field);
+
+ private:
+  const std::vector<int64_t>& Keys(ListOptions::Field field) const {
+    return field == ListOptions::CreatedAt ? _createdAt : _updatedAt;
+  }
+
+  /**
+   * @return whether a row is in the time range of a query
+   */
+  bool InRange(std::size_t row, const ListOptions& options) const {
+    return _createdAt[row] >= options.minCreatedAt &&
+           _updatedAt[row] >= options.minUpdatedAt;
+  }
+
+  std::vector<int64_t> _createdAt;
+  std::vector<int64_t> _updatedAt;
+
+  /**
+   * The rows ordered by time, and by row for the same time
+   */
+  std::vector<uint32_t> _byCreatedAt;
+  std::vector<uint32_t> _byUpdatedAt;
+};
+
+#endif  // TIME_INDEX_H
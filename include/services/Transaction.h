@@ -0,0 +1,217 @@
+#ifndef TRANSACTION_H
+#define TRANSACTION_H
+
+#include <cstddef>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ChangeLog.h"
+#include "IStreamableFileHandler.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+class Journal;
+class Transaction;
+
+/**
+ * @class Transactional
+ * @brief A collection that can be changed by a Transaction along with other
+ * collections. EntityService realizes it for every kind of Entity
+ */
+class Transactional {
+ public:
+  virtual ~Transactional() {}
+
+ protected:
+  friend class Journal;
+  friend class Transaction;
+
+  /**
+   * @return the name of the collection in commit records (i.e. issues)
+   */
+  virtual const std::string& CollectionName() const = 0;
+
+  /**
+   * @return the mutex guarding the collection in persistent storage
+   */
+  virtual std::mutex& CollectionMutex() = 0;
+
+  /**
+   * Reads the collection from persistent storage. Callers should hold
+   * CollectionMutex
+   * @return the json data of the collection
+   */
+  virtual json ReadCollection() = 0;
+
+  /**
+   * Writes the collection to persistent storage and publishes its pending
+   * changes. Callers should hold CollectionMutex
+   * @param data the json data of the collection
+   */
+  virtual void SaveCollection(const json& data) = 0;
+
+  /**
+   * @return the changes made to the collection since it was last saved.
+   * Callers should hold CollectionMutex
+   */
+  virtual const std::vector<Change>& PendingChanges() const = 0;
+
+  /**
+   * Forgets the changes made since the collection was last saved. Callers
+   * should hold CollectionMutex
+   */
+  virtual void DiscardChanges() = 0;
+};
+
+/**
+ * @class Journal
+ * @brief Where a Transaction writes its commit record: every change it makes,
+ * to every collection, in one write. The record is kept until all of the
+ * collections are saved, so a server stopped part way through a commit
+ * finishes it by recovering the journal when it starts again
+ *
+ * The journal holds the json null when no commit is in progress
+ */
+class Journal {
+ public:
+  /**
+   * Constructor. Specifies the file handler to be used
+   * @param fileHandler the file handler of the journal
+   */
+  explicit Journal(std::shared_ptr<IStreamableFileHandler> fileHandler);
+
+  /**
+   * Constructor. Uses a FileHandler for the file, which is created if it
+   * doesn't exist
+   * @param fileName the name of the journal file (i.e. journal.json)
+   */
+  explicit Journal(const std::string& fileName);
+
+  /**
+   * Writes a commit record, replacing any there was
+   * @param record the commit record
+   */
+  void Write(const json& record);
+
+  /**
+   * Marks the commit in progress as finished
+   */
+  void Clear();
+
+  /**
+   * @return the record of the commit in progress, or null if there isn't one.
+   * A journal that can't be read was torn while its record was written, so
+   * nothing was saved from that commit, and there isn't one either
+   */
+  json Read();
+
+  /**
+   * Finishes the commit in progress, if there is one, by applying its changes
+   * to the collections again. Changes are applied by id, so those that were
+   * saved before the commit stopped are applied without harm
+   * @param collections the collections the commit could have changed
+   * @return the number of changes applied
+   * @throw InternalServerError if the commit changed a collection that isn't
+   * one of them
+   */
+  std::size_t Recover(const std::vector<Transactional*>& collections);
+
+  /**
+   * Applies a change of a commit record to a collection
+   * @param collection the json data of the collection
+   * @param change the change, with the op, id and entity of a Change
+   */
+  static void Redo(json& collection, const json& change);
+
+ private:
+  /**
+   * The streams of the journal file, if the journal has one. Declared before
+   * _fileHandler, which refers to them
+   */
+  std::ofstream _os;
+  std::ifstream _is;
+
+  std::shared_ptr<IStreamableFileHandler> _fileHandler;
+
+  /**
+   * Guards the journal file. Transactions over different collections can
+   * commit at the same time
+   */
+  std::mutex _mutex;
+};
+
+/**
+ * @class Transaction
+ * @brief Changes to several collections that are saved together or not at all
+ *
+ * A collection joins the transaction when it is first asked for, which locks
+ * it until the transaction ends. Collections are always joined in the same
+ * order (issues, then comments, then votes), so transactions never wait for
+ * each other in a cycle. Changes are made to the json of each collection by
+ * the EntityService, as they are for a single collection, and Commit saves
+ * them. A transaction that ends without a commit discards its changes
+ */
+class Transaction {
+ public:
+  /**
+   * Constructor
+   * @param journal the journal commit records are written to, or nullptr to
+   * save the collections without one
+   */
+  explicit Transaction(std::shared_ptr<Journal> journal);
+
+  /**
+   * Destructor. Discards the changes if the transaction wasn't committed, and
+   * unlocks the collections
+   */
+  ~Transaction();
+
+  Transaction(const Transaction&) = delete;
+  Transaction& operator=(const Transaction&) = delete;
+
+  /**
+   * Gets the json data of a collection, locking and reading it the first time
+   * it is asked for
+   * @param collection the collection
+   * @return the json data of the collection, to be changed in place
+   */
+  json& Collection(Transactional* collection);
+
+  /**
+   * @param collection a collection
+   * @return whether the collection has joined the transaction
+   */
+  bool Holds(const Transactional* collection) const;
+
+  /**
+   * Saves every collection that was changed. When more than one was, the
+   * changes are written to the journal first, in a single commit record
+   * @throw InternalServerError if a collection could not be saved. The
+   * commit is finished when the journal is recovered
+   */
+  void Commit();
+
+ private:
+  struct Participant {
+    Transactional* collection;
+    std::unique_lock<std::mutex> lock;
+    json data;
+  };
+
+  std::shared_ptr<Journal> _journal;
+
+  /**
+   * The collections, in the order they joined. A list, so their data stays
+   * where it is as others join
+   */
+  std::list<Participant> _participants;
+
+  bool _committed = false;
+};
+
+#endif  // TRANSACTION_H
@@ -4,11 +4,14 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include "EntityId.h"
 #include "EntityService.hpp"
 #include "FileHandler.h"
 #include "IStreamableFileHandler.h"
 #include "User.h"
+#include "UserRef.h"
 
 
 /**
@@ -43,31 +46,115 @@ class UserService : public EntityService<User> {
    * @return a vector of Users
    **/
   std::vector<User> Get(
-      const std::multimap<std::string, std::string> queryParams = {});
+      const std::multimap<std::string, std::string>& queryParams = {});
 
   /**
    * Gets a User
    * @param id the User's ID that we want to retrieve from our JSON file
    **/
-  User Get(const std::string id);
+  User Get(const std::string& id);
 
   /**
    * Creates a User and saves that User to our JSON File
    * @param body the information of the User to create
    **/
-  User Create(std::string body);
+  User Create(const std::string& body);
 
   /**
    * Updates a User and saves that updated User to our JSON File
    * @param body the information of the User to update
    **/
-  User Update(std::string body);
+  User Update(const std::string& body);
+
+  /**
+   * Applies a JSON merge patch to a User and saves it to the JSON file. Only
+   * the fields in the patch are validated
+   * @param id the id of the User to patch
+   * @param body the merge patch
+   * @throw BadRequestError if the patch is invalid
+   * @throw NotFoundError if the User could not be found
+   * @throw PreconditionFailedError if the User is not at the version in the
+   * patch
+   * @throw AlreadyExistsError if another User already has the new name
+   **/
+  User Patch(const std::string& id, const std::string& body);
 
   /**
    * Deletes a User and saves the changes to our JSON file
    * @param id the id of the User to delete
    **/
-  bool Delete(std::string id);
+  bool Delete(const std::string& id);
+
+  /**
+   * Deletes a User if it is still at the expected version
+   * @param id the id of the User to delete
+   * @param expectedVersion the version the caller last saw, or AnyVersion
+   **/
+  bool Delete(const std::string& id, int expectedVersion);
+
+ protected:
+  /**
+   * Creates a User in the collection, without saving it
+   **/
+  User ApplyCreate(json& collection, json body) override;
+
+  /**
+   * Updates a User in the collection, without saving it
+   **/
+  User ApplyUpdate(json& collection, json body) override;
+
+  /**
+   * Applies a merge patch to a User in the collection, without saving it
+   **/
+  User ApplyPatch(json& collection, const std::string& id,
+                  json patch) override;
+
+  /**
+   * Deletes a User from the collection, without saving it
+   **/
+  void ApplyDelete(json& collection, const std::string& id,
+                   int expectedVersion) override;
+};
+
+/**
+ * @class UserResolver
+ * @brief Resolves the UserRefs of the entities a service is building. Each
+ * User is fetched once, and shared by every reference to them, so the users
+ * of a list of entities take memory per User rather than per reference
+ */
+class UserResolver {
+ public:
+  /**
+   * Constructor
+   * @param userService the service to fetch Users from. Must outlive the
+   * resolver
+   */
+  explicit UserResolver(UserService& userService) : _userService(userService) {}
+
+  /**
+   * Resolves a reference to a User
+   * @param id the id of the User. An empty id resolves to no User
+   * @return the reference
+   * @throw NotFoundError if there is no User with the id
+   */
+  UserRef Resolve(const EntityId& id) {
+    if (id.empty()) return UserRef();
+
+    auto found = _users.find(id);
+    if (found != _users.end()) return found->second;
+
+    UserRef user(std::make_shared<const User>(_userService.Get(id)));
+    _users.emplace(id, user);
+    return user;
+  }
+
+ private:
+  UserService& _userService;
+
+  /**
+   * The Users resolved so far, by id
+   */
+  std::unordered_map<EntityId, UserRef> _users;
 };
 
 #endif  // USERSERVICE_H
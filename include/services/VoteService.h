@@ -1,9 +1,11 @@
 #ifndef VOTESERVICE_H
 #define VOTESERVICE_H
 
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "EntityService.hpp"
@@ -13,12 +15,24 @@
 #include "UserService.h"
 #include "Vote.h"
 
+class IssueService;
+
 /**
  * @class VoteService
  * @brief Realization of EntityService for votes
  */
 class VoteService : public EntityService<Vote> {
  public:
+  /**
+   * The outcome of a toggle: the vote that was cast or removed, and how many
+   * votes the issue has after it
+   */
+  struct Toggled {
+    Vote vote;
+    bool cast = false;
+    std::size_t count = 0;
+  };
+
   /**
    * Constructor. Uses the default EntityService constructor to read data from
    * "votes.json"
@@ -46,7 +60,7 @@ class VoteService : public EntityService<Vote> {
    * @return a vector of Users
    */
   virtual std::vector<Vote> Get(
-      const std::multimap<std::string, std::string> queryParams = {});
+      const std::multimap<std::string, std::string>& queryParams = {});
 
   /**
    * Get a vote by its id
@@ -54,34 +68,159 @@ class VoteService : public EntityService<Vote> {
    * @return the vote with that id
    * @throw NotFoundError if no Vote is found with that id
    */
-  virtual Vote Get(const std::string id);
+  virtual Vote Get(const std::string& id);
 
   /**
    * Creates a Vote and saves it to the JSON file
    * @param body the information of the Vote to create
    * @throw BadRequestError if the body is invalid
    */
-  virtual Vote Create(std::string body);
+  virtual Vote Create(const std::string& body);
 
   /**
    * Not implemented for the Vote model, since there is no concept of updating a
    * vote
    * @throw NotImplementedError alerting the caller that this method isn't valid
    */
-  virtual Vote Update(std::string body);
+  virtual Vote Update(const std::string& body);
 
   /**
    * Deletes a Vote and saves the changes to our JSON file
    * @param id the id of the Vote to delete
    * @throw NotFoundError if the Vote
    */
-  virtual bool Delete(std::string id);
+  virtual bool Delete(const std::string& id);
+
+  /**
+   * Deletes a Vote if it is still at the expected version
+   * @param id the id of the Vote to delete
+   * @param expectedVersion the version the caller last saw, or AnyVersion
+   * @throw NotFoundError if the Vote could not be found
+   * @throw PreconditionFailedError if the Vote is at a different version
+   */
+  virtual bool Delete(const std::string& id, int expectedVersion);
+
+  /**
+   * Casts a user's vote for an issue, or removes it if the user has already
+   * voted. The check and the change are made under one lock, so concurrent
+   * toggles by the same user never cast two votes. Once SetIssueService is
+   * called, the issue must exist, and can't be deleted until the toggle is
+   * saved
+   * @param issueId the id of the issue
+   * @param userId the id of the user voting
+   * @return the vote that was cast or removed, and the new vote count
+   * @throw BadRequestError if either id is empty
+   * @throw NotFoundError if the user or the issue doesn't exist
+   */
+  virtual Toggled Toggle(const std::string& issueId,
+                         const std::string& userId);
+
+  /**
+   * @param issueId the id of an issue
+   * @return the number of votes for the issue
+   */
+  virtual std::size_t Count(const std::string& issueId);
+
+  /**
+   * Votes are built from users, so the generation includes the generation of
+   * the UserService
+   * @return the current generation of the votes
+   */
+  virtual uint64_t Generation();
+
+  /**
+   * Sets the IssueService that Toggle checks the issue of a vote with. The
+   * IssueService holds this service, so it is held weakly
+   * @param issueService the IssueService, or nullptr to not check issues
+   */
+  void SetIssueService(const std::shared_ptr<IssueService>& issueService);
 
  protected:
+  /**
+   * Creates a Vote in the collection, without saving it
+   */
+  Vote ApplyCreate(json& collection, json body) override;
+
+  /**
+   * Deletes a Vote from the collection, without saving it
+   */
+  void ApplyDelete(json& collection, const std::string& id,
+                   int expectedVersion) override;
+
   /**
    * Internal UserService, for handling User data for the Votes
    */
   std::shared_ptr<UserService> _userService;
+
+  /**
+   * The IssueService the issues of votes are checked with, if any
+   */
+  std::weak_ptr<IssueService> _issueService;
+
+ private:
+  /**
+   * The votes as they were last saved, indexed for toggling
+   */
+  struct Ballots {
+    json votes;
+
+    /**
+     * The slot of the vote for each issue and user. A vote's position in
+     * votes is its slot less the number of removed slots before it, so
+     * removing a vote keeps the others in order without renumbering them
+     */
+    std::unordered_map<std::string, std::size_t> slots;
+
+    /**
+     * The slots of the votes removed since the slots were numbered, sorted
+     */
+    std::vector<std::size_t> removed;
+
+    /**
+     * The number of votes for each issue
+     */
+    std::unordered_map<std::string, std::size_t> counts;
+
+    /**
+     * The generation of the collection the ballots were read at
+     */
+    uint64_t generation = 0;
+  };
+
+  /**
+   * The most removed slots kept before the slots are numbered again
+   */
+  static const std::size_t MaxRemovedSlots = 1024;
+
+  /**
+   * @return the key of a user's vote for an issue in Ballots::slots
+   */
+  static std::string BallotKey(const std::string& issueId,
+                               const std::string& userId);
+
+  /**
+   * Reads the ballots again if the collection was written since they were
+   * last read. Callers should hold _mutex
+   * @return the ballots
+   */
+  Ballots& LoadBallots();
+
+  /**
+   * Numbers the slots of the ballots again from their positions
+   * @param ballots the ballots
+   */
+  static void NumberSlots(Ballots* ballots);
+
+  /**
+   * Toggles a vote, as Toggle does, once the issue is known to exist
+   */
+  Toggled ApplyToggle(const std::string& issueId, const std::string& userId);
+
+  /**
+   * The ballots, or nullptr until a vote is toggled or counted. Guarded by
+   * _mutex
+   */
+  std::unique_ptr<Ballots> _ballots;
 };
 
 #endif  // VOTESERVICE_H
@@ -0,0 +1,219 @@
+#ifndef ALLOCATION_STATS_H
+#define ALLOCATION_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @namespace AllocationStats
+ * @brief Counts the heap allocations made while serving each request, by
+ * controller and by phase of the request
+ *
+ * The allocations are counted by a replacement of the global operator new,
+ * which is only compiled into instrumented builds of the server (make
+ * instrumented, which defines HOTTICKET_ALLOCATION_STATS). Other builds keep
+ * the standard operator new, and Request and Phase do nothing in them.
+ *
+ * Counts are kept per thread, and each request is served on one thread, so a
+ * Request only sees its own allocations. A Phase started during the Request
+ * takes the allocations made while it is alive, and phases can be nested, in
+ * which case the inner one takes them. Allocations outside of any phase are
+ * counted as "controller"
+ */
+namespace AllocationStats {
+/**
+ * A number of allocations and the bytes they asked for
+ */
+struct Counts {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+};
+
+/**
+ * @return whether allocations are being counted. They are in instrumented
+ * builds, unless SetEnabled turned them off
+ */
+bool Enabled();
+
+/**
+ * Turns the accounting of requests on or off
+ * @param enabled whether to account for requests
+ */
+void SetEnabled(bool enabled);
+
+/**
+ * Counts an allocation made on this thread. Called by the instrumented
+ * operator new
+ * @param bytes the size of the allocation
+ */
+void Count(std::size_t bytes);
+
+/**
+ * @return the allocations made on this thread so far
+ */
+Counts Current();
+
+/**
+ * @return the counts of the Request being served on this thread so far, as
+ * the value of an X-Allocations header (i.e. allocations=120; bytes=8192), or
+ * an empty string if no Request is being accounted for
+ */
+std::string Header();
+
+/**
+ * Builds a report of the requests served since the last Reset
+ * \verbatim
+ * {
+ *   "enabled": whether allocations are being counted,
+ *   "requests": {
+ *     "<method> <endpoint>": {
+ *       "requests": the number of requests,
+ *       "allocations": the allocations of all of them,
+ *       "bytes": the bytes of all of them,
+ *       "allocationsPerRequest": the mean allocations of a request,
+ *       "bytesPerRequest": the mean bytes of a request,
+ *       "phases": {
+ *         "<phase>": { "allocations": ..., "bytes": ... }
+ *       }
+ *     }
+ *   }
+ * }
+ * \endverbatim
+ * @return the report
+ */
+nlohmann::json Snapshot();
+
+/**
+ * Forgets the requests served so far
+ */
+void Reset();
+
+/**
+ * @class Request
+ * @brief Accounts for the allocations made on this thread while it is alive,
+ * as one request to a controller
+ */
+class Request {
+ public:
+  /**
+   * Constructor. Starts accounting, unless allocations aren't being counted
+   * or another Request is already being accounted for on this thread
+   * @param endpoint the endpoint of the controller (i.e. /issues)
+   * @param method the HTTP method of the request
+   */
+  Request(const std::string& endpoint, const char* method);
+
+  /**
+   * Destructor. Adds the allocations of the request to the report
+   */
+  ~Request();
+
+  Request(const Request&) = delete;
+  Request& operator=(const Request&) = delete;
+
+ private:
+  friend class Phase;
+  friend std::string Header();
+
+  /**
+   * The most phases a request can have, including controller. Allocations of
+   * phases past them are counted as controller
+   */
+  static const std::size_t MaxPhases = 12;
+
+  /**
+   * The allocations of one phase
+   */
+  struct PhaseCounts {
+    const char* name;
+    Counts counts;
+  };
+
+  /**
+   * Adds the allocations made since the last call to the current phase
+   */
+  void Flush();
+
+  /**
+   * Makes a phase the current one
+   * @param name the name of the phase
+   * @return the phase that was current before, to be restored later
+   */
+  const char* Enter(const char* name);
+
+  /**
+   * @return the allocations of every phase so far
+   */
+  Counts Total() const;
+
+  /**
+   * Whether this Request is accounting for the thread
+   */
+  bool _active = false;
+
+  /**
+   * The method and endpoint the request is reported under
+   */
+  std::string _key;
+
+  /**
+   * The allocations on the thread when the counts were last flushed
+   */
+  Counts _mark;
+
+  /**
+   * The phase allocations are currently counted in
+   */
+  const char* _phase = nullptr;
+
+  /**
+   * The allocations of each phase, in the order they started
+   */
+  PhaseCounts _phases[MaxPhases];
+
+  /**
+   * The number of phases in _phases
+   */
+  std::size_t _phaseCount = 0;
+};
+
+/**
+ * @class Phase
+ * @brief Counts the allocations made on this thread while it is alive in a
+ * phase of the current Request (i.e. service or serialize). Does nothing if
+ * there is no Request
+ */
+class Phase {
+ public:
+  /**
+   * Constructor
+   * @param name the name of the phase. Must outlive the Request, so it is
+   * normally a string literal
+   */
+  explicit Phase(const char* name);
+
+  /**
+   * Destructor. Counts later allocations in the phase that was current before
+   */
+  ~Phase();
+
+  Phase(const Phase&) = delete;
+  Phase& operator=(const Phase&) = delete;
+
+ private:
+  /**
+   * The Request the phase is part of, or nullptr
+   */
+  Request* _request;
+
+  /**
+   * The phase that was current before this one
+   */
+  const char* _previous = nullptr;
+};
+}  // namespace AllocationStats
+
+#endif  // ALLOCATION_STATS_H
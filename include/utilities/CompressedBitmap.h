@@ -0,0 +1,121 @@
+#ifndef COMPRESSED_BITMAP_H
+#define COMPRESSED_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class CompressedBitmap
+ * @brief A set of 32-bit values (i.e. the rows of a table), compressed the
+ * way Roaring bitmaps are
+ *
+ * The values are split into chunks of 65536 by their high 16 bits. A chunk
+ * with few values keeps their low 16 bits in a sorted array, and a chunk with
+ * more than 4096 keeps a 65536-bit bitmap instead, so no chunk takes more
+ * than 8KB. Sets are intersected and joined a chunk at a time, with the
+ * cheapest operation for the kinds of the two chunks
+ */
+class CompressedBitmap {
+ public:
+  /**
+   * Adds a value. Adding values in increasing order is the fastest
+   * @param value the value
+   */
+  void Add(uint32_t value);
+
+  /**
+   * @param value a value
+   * @return whether the value is in the set
+   */
+  bool Contains(uint32_t value) const;
+
+  /**
+   * @return the number of values in the set, without visiting them
+   */
+  std::size_t Cardinality() const;
+
+  /**
+   * @return whether the set is empty
+   */
+  bool empty() const { return _chunks.empty(); }
+
+  /**
+   * @return the values of the set, in increasing order
+   */
+  std::vector<uint32_t> Values() const;
+
+  /**
+   * Sets the bit of every value of the set in a plain bitmap
+   * @param words the plain bitmap, 64 values to a word. Values past its end
+   * are left out
+   */
+  void SetBits(std::vector<uint64_t>* words) const;
+
+  /**
+   * @return the values in both sets
+   */
+  static CompressedBitmap And(const CompressedBitmap& lhs,
+                              const CompressedBitmap& rhs);
+
+  /**
+   * @return the values in either set
+   */
+  static CompressedBitmap Or(const CompressedBitmap& lhs,
+                             const CompressedBitmap& rhs);
+
+ private:
+  /**
+   * The most values a chunk keeps in an array
+   */
+  static const std::size_t MaxArrayValues = 4096;
+
+  /**
+   * The number of words of the bitmap of a chunk
+   */
+  static const std::size_t ChunkWords = 1024;
+
+  /**
+   * The values whose high 16 bits are key
+   */
+  struct Chunk {
+    uint16_t key = 0;
+
+    /**
+     * The number of values of the chunk
+     */
+    uint32_t cardinality = 0;
+
+    /**
+     * The low 16 bits of the values, sorted, if the chunk is an array
+     */
+    std::vector<uint16_t> array;
+
+    /**
+     * One bit per value, if the chunk is a bitmap
+     */
+    std::vector<uint64_t> bits;
+
+    bool IsBitmap() const { return !bits.empty(); }
+  };
+
+  /**
+   * Turns an array chunk into a bitmap chunk
+   */
+  static void ToBitmap(Chunk* chunk);
+
+  /**
+   * Turns a bitmap chunk into an array chunk, if it is small enough to be one
+   */
+  static void Shrink(Chunk* chunk);
+
+  static Chunk AndChunks(const Chunk& lhs, const Chunk& rhs);
+  static Chunk OrChunks(const Chunk& lhs, const Chunk& rhs);
+
+  /**
+   * The chunks that have values, sorted by key
+   */
+  std::vector<Chunk> _chunks;
+};
+
+#endif  // COMPRESSED_BITMAP_H
@@ -0,0 +1,127 @@
+#ifndef DATASET_GENERATOR_H
+#define DATASET_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @struct DatasetOptions
+ * @brief The shape of a generated dataset
+ */
+struct DatasetOptions {
+  /**
+   * The number of users
+   */
+  std::size_t users = 100;
+
+  /**
+   * The number of issues
+   */
+  std::size_t issues = 1000;
+
+  /**
+   * The number of comments, spread over the issues
+   */
+  std::size_t comments = 5000;
+
+  /**
+   * The number of votes, spread over the issues
+   */
+  std::size_t votes = 10000;
+
+  /**
+   * The exponent of the Zipf distribution comments and votes are spread over
+   * the issues with. 0 spreads them evenly; the larger it is, the more of them
+   * go to a few popular issues
+   */
+  double skew = 1.1;
+
+  /**
+   * The fraction of users who are heavy reporters
+   */
+  double heavyReporters = 0.05;
+
+  /**
+   * The fraction of issues reported by the heavy reporters
+   */
+  double heavyShare = 0.5;
+
+  /**
+   * When the first issue can be created
+   */
+  time_t start = 1577836800;  // Wed Jan 1 00:00:00 2020 UTC
+
+  /**
+   * The number of days after start that entities are created over
+   */
+  int days = 365;
+
+  /**
+   * The seed for the random numbers. The same options always generate the
+   * same dataset
+   */
+  uint64_t seed = 42;
+};
+
+/**
+ * @struct Dataset
+ * @brief The collections of a generated dataset, in the form the server
+ * stores them
+ */
+struct Dataset {
+  json users = json::array();
+  json issues = json::array();
+  json comments = json::array();
+  json votes = json::array();
+};
+
+/**
+ * @class DatasetGenerator
+ * @brief Generates large, realistic datasets for benchmarks and load tests
+ *
+ * Issues are reported mostly by a small group of heavy reporters, and their
+ * comments and votes follow a Zipf distribution, so a few issues get most of
+ * the activity like they do in a real tracker. Every reference in the dataset
+ * (i.e. an issue's comments, or a vote's issueId) points at an entity that
+ * exists, and times always come after the issue they belong to
+ */
+class DatasetGenerator {
+ public:
+  /**
+   * Constructor
+   * @param options the shape of the dataset
+   */
+  explicit DatasetGenerator(const DatasetOptions& options)
+      : _options(options) {}
+  virtual ~DatasetGenerator() {}
+
+  /**
+   * Generates the dataset
+   * @return the users, issues, comments and votes
+   */
+  Dataset Generate() const;
+
+  /**
+   * Writes a dataset as users.json, issues.json, comments.json and votes.json,
+   * the files the server reads its collections from
+   * @param dataset the dataset to write
+   * @param directory the directory to write the files to. It is created if it
+   * doesn't exist
+   * @throw InternalServerError if a file couldn't be written
+   */
+  static void Write(const Dataset& dataset, const std::string& directory);
+
+ private:
+  /**
+   * The shape of the dataset
+   */
+  DatasetOptions _options;
+};
+
+#endif  // DATASET_GENERATOR_H
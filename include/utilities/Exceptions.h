@@ -59,6 +59,48 @@ class AlreadyExistsError : public std::runtime_error {
       : std::runtime_error(errMessage) {}
 };
 
+/**
+ * @class PreconditionFailedError
+ * @brief Implements an exception for errors when: an Entity has changed since
+ * the version the request was based on
+ */
+class PreconditionFailedError : public std::runtime_error {
+ public:
+  /**
+   * @param errMessage An error message.
+   */
+  explicit PreconditionFailedError(const char* errMessage)
+      : std::runtime_error(errMessage) {}
+};
+
+/**
+ * @class GoneError
+ * @brief Implements an exception for errors when: the data a request asks for
+ * is no longer kept by the server
+ */
+class GoneError : public std::runtime_error {
+ public:
+  /**
+   * @param errMessage An error message.
+   */
+  explicit GoneError(const char* errMessage)
+      : std::runtime_error(errMessage) {}
+};
+
+/**
+ * @class ServiceUnavailableError
+ * @brief Implements an exception for errors when: the server is too busy to
+ * serve the request now, and it should be retried later
+ */
+class ServiceUnavailableError : public std::runtime_error {
+ public:
+  /**
+   * @param errMessage An error message.
+   */
+  explicit ServiceUnavailableError(const char* errMessage)
+      : std::runtime_error(errMessage) {}
+};
+
 /**
  * @class NotImplementedError
  * @brief Alerts the caller that the method they're calling is not implemented
@@ -26,13 +26,17 @@ class FileHandler : public IStreamableFileHandler {
   virtual ~FileHandler() {}
 
   /**
-   * Writes the updated JSON object to our file
+   * Writes the updated JSON object to our file. The JSON is flushed to the
+   * disk and then replaces the file in one step, so the file holds either the
+   * old JSON or the new
    * @param updatedJson the updated JSON object
+   * @throw InternalServerError if the file could not be written
    */
-  virtual void write(json updatedJson);
+  virtual void write(const json& updatedJson);
 
   /**
-   * Reads the iostream and parsed the iostream into a JSON object
+   * Reads the iostream and parsed the iostream into a JSON object. The file
+   * is opened again for each read, so it is read as last written
    * @return a parsed nlohmann::json object from our iostream (sstream or
    * fstream)
    */
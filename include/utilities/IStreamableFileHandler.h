@@ -10,7 +10,7 @@ using json = nlohmann::json;
 class IStreamableFileHandler {
  public:
   virtual nlohmann::json read() = 0;
-  virtual void write(json updatedJson) = 0;
+  virtual void write(const json& updatedJson) = 0;
 };
 
 #endif
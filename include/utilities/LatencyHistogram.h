@@ -0,0 +1,101 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class LatencyHistogram
+ * @brief Records latencies in a fixed amount of memory and reports their
+ * percentiles, in the style of an HDR histogram
+ *
+ * Values are counted in buckets that are exact below 128 and then get wider
+ * with the value, so every bucket is within 1/64 (about 1.6%) of the values
+ * it holds. Any value up to 2^40 can be recorded, which is about 12 days in
+ * microseconds
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+  virtual ~LatencyHistogram() {}
+
+  /**
+   * Records a value
+   * @param value the value (i.e. a latency in microseconds)
+   */
+  void Record(uint64_t value);
+
+  /**
+   * Adds every value recorded in another histogram to this one
+   * @param other the histogram to add
+   */
+  void Merge(const LatencyHistogram& other);
+
+  /**
+   * @return the number of values recorded
+   */
+  uint64_t Count() const { return _count; }
+
+  /**
+   * @return the smallest value recorded, or 0 if there are none
+   */
+  uint64_t Min() const { return _count > 0 ? _min : 0; }
+
+  /**
+   * @return the largest value recorded, or 0 if there are none
+   */
+  uint64_t Max() const { return _max; }
+
+  /**
+   * @return the mean of the values recorded, or 0 if there are none
+   */
+  double Mean() const;
+
+  /**
+   * Gets the value at a percentile, i.e. Percentile(99) is the value 99% of
+   * the recorded values are at or below
+   * @param percentile the percentile, from 0 to 100
+   * @return the largest value that falls in the same bucket as the value at
+   * the percentile, or 0 if no values were recorded
+   */
+  uint64_t Percentile(double percentile) const;
+
+ private:
+  /**
+   * @return the bucket a value is counted in
+   */
+  static std::size_t BucketOf(uint64_t value);
+
+  /**
+   * @return the largest value counted in a bucket
+   */
+  static uint64_t HighestIn(std::size_t bucket);
+
+  /**
+   * The number of values in each bucket
+   */
+  std::vector<uint64_t> _buckets;
+
+  /**
+   * The number of values recorded
+   */
+  uint64_t _count = 0;
+
+  /**
+   * The sum of the values recorded, for the mean
+   */
+  double _sum = 0;
+
+  /**
+   * The smallest value recorded
+   */
+  uint64_t _min = UINT64_MAX;
+
+  /**
+   * The largest value recorded
+   */
+  uint64_t _max = 0;
+};
+
+#endif  // LATENCY_HISTOGRAM_H
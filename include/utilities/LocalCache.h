@@ -0,0 +1,206 @@
+#ifndef LOCAL_CACHE_H
+#define LOCAL_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @class LocalCache
+ * @brief An on-disk copy of the collections the client has fetched, kept up to
+ * date from the server's change feed
+ *
+ * Entities are stored by collection (i.e. issues) in the form the server sends
+ * them. The cache also remembers which requests it has already fetched in full,
+ * so each one is only downloaded once, and the sequence of the last change it
+ * applied, so only newer changes are fetched the next time it syncs
+ */
+class LocalCache {
+ public:
+  /**
+   * Constructor
+   * @param directory the directory the cache is saved in. It is created when
+   * the cache is first saved
+   */
+  explicit LocalCache(const std::string& directory) : _directory(directory) {}
+  virtual ~LocalCache() {}
+
+  /**
+   * Gets the default directory for the cache of a server, under the user's
+   * home directory
+   * @param serverUri the URI of the server (i.e. http://localhost:8080)
+   * @return the directory (i.e. ~/.hotTicket/localhost_8080)
+   */
+  static std::string DefaultDirectory(const std::string& serverUri);
+
+  /**
+   * Reads the cache from its directory. A missing or unreadable cache is
+   * treated as empty
+   */
+  void Load();
+
+  /**
+   * Writes the cache to its directory, if it has changed since it was last
+   * loaded or saved
+   * @throw InternalServerError if the cache couldn't be written
+   */
+  void Save();
+
+  /**
+   * Removes every entity, so the collections are fetched again
+   */
+  void Clear();
+
+  /**
+   * @param key the request that was fetched (i.e. /issues)
+   * @return whether the request has already been fetched in full
+   */
+  bool Fetched(const std::string& key);
+
+  /**
+   * Stores the entities returned by a request, and remembers that the request
+   * has been fetched
+   * @param collection the collection the entities belong to
+   * @param key the request that was fetched (i.e. /issues/:id/comments)
+   * @param entities a json array of the entities
+   */
+  void Fetch(const std::string& collection, const std::string& key,
+             const json& entities);
+
+  /**
+   * Adds or replaces an entity
+   * @param collection the collection the entity belongs to
+   * @param entity the entity, which must have an id
+   */
+  void Put(const std::string& collection, const json& entity);
+
+  /**
+   * Removes an entity, if it is cached
+   * @param collection the collection the entity belongs to
+   * @param id the id of the entity
+   */
+  void Remove(const std::string& collection, const std::string& id);
+
+  /**
+   * Finds an entity by id
+   * @param collection the collection the entity belongs to
+   * @param id the id of the entity
+   * @return the entity, or null if it isn't cached
+   */
+  json Find(const std::string& collection, const std::string& id);
+
+  /**
+   * Gets the cached entities that match a query, in the order they were
+   * cached. Entities match if each field in the query has one of the values
+   * given for it, so {{"status", "New"}, {"status", "Fixed"}} matches both new
+   * and fixed issues
+   * @param collection the collection to search
+   * @param query the values to match, by field
+   * @return the matching entities
+   */
+  std::vector<json> Get(const std::string& collection,
+                        const StringMap& query = {});
+
+  /**
+   * Applies a change from the server's change feed, and records its sequence
+   * @param change the change, as sent by GET /changes
+   */
+  void Apply(const json& change);
+
+  /**
+   * @return the sequence of the last change applied, or 0 if none have been
+   */
+  uint64_t Sequence();
+
+  /**
+   * @param sequence the sequence to continue syncing from
+   */
+  void SetSequence(uint64_t sequence);
+
+  /**
+   * @return the epoch of the server's change log the sequence belongs to, or
+   * an empty string if the cache has never synced
+   */
+  std::string Epoch();
+
+  /**
+   * @param epoch the epoch of the server's change log
+   */
+  void SetEpoch(const std::string& epoch);
+
+ protected:
+  /**
+   * The entities of one collection, with their positions by id
+   */
+  struct Collection {
+    json entities = json::array();
+    std::unordered_map<std::string, std::size_t> index;
+  };
+
+  /**
+   * Adds or replaces an entity while holding _mutex
+   */
+  void PutLocked(const std::string& collection, const json& entity);
+
+  /**
+   * Removes an entity while holding _mutex
+   */
+  void RemoveLocked(const std::string& collection, const std::string& id);
+
+  /**
+   * Adds or removes a comment or vote id on the cached issue it belongs to, so
+   * the issue's counts stay current without fetching it again
+   * @param collection comments or votes
+   * @param id the id of the comment or vote
+   * @param issueId the issue to add the id to, or an empty string to remove it
+   * from every issue
+   */
+  void LinkToIssue(const std::string& collection, const std::string& id,
+                   const std::string& issueId);
+
+  /**
+   * The directory the cache is saved in
+   */
+  std::string _directory;
+
+  /**
+   * The cached entities, by collection
+   */
+  std::map<std::string, Collection> _collections;
+
+  /**
+   * The requests that have been fetched in full
+   */
+  std::set<std::string> _fetched;
+
+  /**
+   * The sequence of the last change applied
+   */
+  uint64_t _sequence = 0;
+
+  /**
+   * The epoch of the server's change log
+   */
+  std::string _epoch;
+
+  /**
+   * Whether the cache has changed since it was loaded or saved
+   */
+  bool _dirty = false;
+
+  /**
+   * Guards the cache, which the client fills from several threads
+   */
+  std::mutex _mutex;
+};
+
+#endif  // LOCAL_CACHE_H
@@ -4,13 +4,18 @@
 #include <math.h>
 #include <restbed>
 
+#include <condition_variable>
+#include <cstdint>
 #include <ctime>
+#include <future>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "Exceptions.h"
 #include "ServerErrorResponse.h"
@@ -83,6 +88,25 @@ std::string GetEntityIdFromRequestPath(const std::string& path,
  * @returns the number of digits in i
  */
 int DigitCount(int i);
+
+/**
+ * Parses the version of an Entity from the value of an If-Match header. The
+ * version may be quoted like an entity tag (i.e. "3" or W/"3"), or be the
+ * ETag the Entity was sent with (see ResponseUtilities::BuildEntityETag)
+ * @param header the value of the If-Match header
+ * @return the version, or -1 if the header is empty or * (any version)
+ * @throw BadRequestError if the header does not hold a version
+ */
+int ParseVersionTag(const std::string& header);
+
+/**
+ * Parses the body of a bulk request, which is either a JSON array or
+ * [NDJSON](http://ndjson.org/) (one JSON value per line)
+ * @param body the body of the bulk request
+ * @return a JSON array of the values in the body
+ * @throw BadRequestError if the body can't be parsed
+ */
+json ParseBulkBody(const std::string& body);
 }  // namespace Utilities
 
 /**
@@ -114,6 +138,33 @@ std::string ConvertTimeToString(struct tm time);
  */
 bool DateComparator(struct tm tm1, struct tm tm2);
 
+/**
+ * Converts a time in UTC to the number of seconds since the Unix epoch. Unlike
+ * mktime, it doesn't depend on the local time zone or change the time
+ * @param time the time to convert
+ * @return the seconds since Jan 01 00:00:00 1970, negative before then
+ */
+int64_t ToSeconds(const struct tm& time);
+
+/**
+ * Reads a time in the format of our JSON file (Www Mmm dd hh:mm:ss yyyy), or
+ * an ISO 8601 date or UTC date and time (i.e. 2001-08-23 or
+ * 2001-08-23T14:55:02Z)
+ * @param stringTime the string formatted time to be read
+ * @param seconds set to the time, in seconds since the Unix epoch
+ * @return whether the string is a time in one of those formats
+ */
+bool ParseSeconds(const std::string& stringTime, int64_t* seconds);
+
+/**
+ * Converts a time to UTC. Unlike std::gmtime, it doesn't share a struct tm
+ * between callers, so requests served by different workers can call it at
+ * the same time
+ * @param time the number of seconds since the Unix epoch
+ * @returns a struct tm with the time in UTC
+ */
+struct tm ToUTC(time_t time);
+
 /**
  * @returns a struct tm with the current time in UTC
  */
@@ -133,11 +184,37 @@ struct tm NullTimeUTC();
  */
 namespace ResponseUtilities {
 /**
- * Method to build the response header to send back to the client
+ * Method to build the response header to send back to the client. In
+ * instrumented builds, the header includes the allocations made for the
+ * request so far as X-Allocations
  * @return a key-value pair of header parameters
  */
 StringMap BuildResponseHeader(const StringMap& parameters);
 
+/**
+ * Sends a response and leaves the connection open for the client's next
+ * request, so clients that keep their connections (see
+ * RequestUtilities::ConnectionPool) only connect once
+ * @param session the session of the request
+ * @param status the HTTP status code of the response
+ * @param body the body of the response
+ * @param headers the headers of the response
+ * @param keepAlive false to close the connection once the response is sent,
+ * with a Connection: close header. A request whose body wasn't fetched must
+ * close it, or the rest of the body would be read as the next request
+ */
+template <typename Session>
+void Respond(const std::shared_ptr<Session>& session, const int status,
+             const std::string& body, StringMap headers,
+             bool keepAlive = true) {
+  if (keepAlive) {
+    session->yield(status, body, headers);
+  } else {
+    headers.insert(CLOSE_CONNECTION);
+    session->close(status, body, headers);
+  }
+}
+
 /**
  * Creates a good error response (as described
  * [here](https://www.baeldung.com/rest-api-error-handling-best-practices))
@@ -173,6 +250,35 @@ json HandleResponse(std::shared_ptr<restbed::Response> response);
  * Creates default headers for the server response
  */
 StringMap BuildResponseHeaders(const std::string& body = "");
+
+/**
+ * Builds a weak entity tag from the generation of the collection a response
+ * was built from. The tag includes the time the server started, so tags handed
+ * out before a restart never match
+ * @param generation the generation of the collection
+ * @return the entity tag, i.e. W/"1606870940-12"
+ */
+std::string BuildETag(const uint64_t& generation);
+
+/**
+ * Builds a weak entity tag for a single Entity. It starts with the version of
+ * the Entity, so it can be sent back in an If-Match header, and includes the
+ * generation, since the Entities an Entity refers to can change without it
+ * @param version the version of the Entity
+ * @param generation the generation of the collection
+ * @return the entity tag, i.e. W/"3.1606870940-12"
+ */
+std::string BuildEntityETag(int version, const uint64_t& generation);
+
+/**
+ * Compares the value of an If-None-Match header to an entity tag, using the
+ * weak comparison described in [RFC
+ * 7232](https://tools.ietf.org/html/rfc7232#section-2.3.2)
+ * @param header the value of the If-None-Match header
+ * @param etag the current entity tag
+ * @return true if any of the entity tags in the header match
+ */
+bool ETagMatches(const std::string& header, const std::string& etag);
 }  // namespace ResponseUtilities
 
 /**
@@ -232,6 +338,99 @@ std::shared_ptr<restbed::Request> CreatePutRequest(const std::string& baseUri,
 std::shared_ptr<restbed::Request> CreateDeleteRequest(
     const std::string& baseUri, const std::string& endpoint);
 
+/**
+ * @class ConnectionPool
+ * @brief Sends requests to one server over a bounded set of reusable
+ * connections
+ *
+ * Each connection is a restbed::Request that keeps its socket between
+ * requests, so servers that keep connections alive are only connected to once
+ * per connection. Connections the server closes are reopened on their next use
+ */
+class ConnectionPool {
+ public:
+  /**
+   * The number of connections a pool opens when no limit is given
+   */
+  static constexpr std::size_t DefaultConnections = 4;
+
+  /**
+   * Constructor
+   * @param maxConnections the most connections to open to the server at once
+   */
+  explicit ConnectionPool(std::size_t maxConnections = DefaultConnections)
+      : _maxConnections(maxConnections > 0 ? maxConnections : 1) {}
+
+  /**
+   * Sends a request over one of the pooled connections, waiting for a free
+   * connection if they are all in use. The whole response body is read before
+   * the connection is handed to the next request
+   * @param request the request to send
+   * @return the response, with its body
+   */
+  std::shared_ptr<restbed::Response> Send(
+      const std::shared_ptr<restbed::Request>& request);
+
+ private:
+  /**
+   * Takes an idle connection, or opens a new one if the pool isn't full
+   */
+  std::shared_ptr<restbed::Request> Acquire();
+
+  /**
+   * Returns a connection to the pool
+   */
+  void Release(const std::shared_ptr<restbed::Request>& connection);
+
+  /**
+   * The most connections to open to the server at once
+   */
+  std::size_t _maxConnections;
+
+  /**
+   * The number of connections that have been opened
+   */
+  std::size_t _opened = 0;
+
+  /**
+   * Connections that aren't being used by a request
+   */
+  std::vector<std::shared_ptr<restbed::Request>> _idle;
+
+  /**
+   * Guards the idle connections
+   */
+  std::mutex _mutex;
+
+  /**
+   * Notified whenever a connection is returned to the pool
+   */
+  std::condition_variable _released;
+};
+
+/**
+ * Sends a request using the ConnectionPool for its server, which is shared by
+ * the whole client. Use this rather than restbed::Http::sync
+ * @param request the request to send
+ * @return the response, with its body
+ */
+std::shared_ptr<restbed::Response> Send(
+    const std::shared_ptr<restbed::Request>& request);
+
+/**
+ * Sets how many connections the pools opened after this call may use, for
+ * clients that send many requests at once
+ * @param maxConnections the most connections to open to each server
+ */
+void SetConnectionsPerServer(std::size_t maxConnections);
+
+/**
+ * Sends a request in the background, so independent requests can overlap
+ * @param request the request to send
+ * @return a future holding the response
+ */
+std::future<std::shared_ptr<restbed::Response>> SendAsync(
+    const std::shared_ptr<restbed::Request>& request);
 }  // namespace RequestUtilities
 
 #endif  // UTILITIES_HPP
@@ -0,0 +1,231 @@
+#include "BatchRunner.h"
+
+#include <restbed>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "Exceptions.h"
+#include "ServerErrorResponse.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * The collections commands can be run against
+ */
+const std::set<std::string> Collections = {"issues", "users", "comments",
+                                           "votes"};
+
+/**
+ * Throws a BadRequestError for a line of a script
+ */
+[[noreturn]] void InvalidLine(int line, const std::string& message) {
+  throw BadRequestError(
+      std::string("Line " + std::to_string(line) + ": " + message).c_str());
+}
+}  // namespace
+
+bool BatchRunner::Run(std::istream& script, std::ostream& out) {
+  int line = 0;
+  int sent = 0;
+  int succeeded = 0;
+  int failed = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  std::string text;
+  while (std::getline(script, text)) {
+    line++;
+    // Skip blank lines and comments
+    std::size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos || text[first] == '#') continue;
+
+    Command command;
+    try {
+      command = Parse(text, line);
+    } catch (const BadRequestError& e) {
+      out << e.what() << std::endl;
+      failed++;
+      continue;
+    }
+
+    // Wait for a free slot, and for any earlier command on the same entity
+    auto sameTarget = [&command](const InFlight& inFlight) {
+      return inFlight.command.target == command.target;
+    };
+    while (!_inFlight.empty() &&
+           (_inFlight.size() >= _jobs ||
+            (!command.target.empty() &&
+             std::any_of(_inFlight.begin(), _inFlight.end(), sameTarget)))) {
+      if (Finish(out)) {
+        succeeded++;
+      } else {
+        failed++;
+      }
+    }
+
+    _inFlight.push_back(
+        {command, RequestUtilities::SendAsync(BuildRequest(command))});
+    sent++;
+  }
+  while (!_inFlight.empty()) {
+    if (Finish(out)) {
+      succeeded++;
+    } else {
+      failed++;
+    }
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  double seconds = elapsed.count();
+  out << "Ran " << sent << " commands in " << std::fixed
+      << std::setprecision(3) << seconds << "s";
+  if (seconds > 0) {
+    out << " (" << std::setprecision(1) << sent / seconds << " commands/s)";
+  }
+  out << ": " << succeeded << " succeeded, " << failed << " failed"
+      << std::endl;
+
+  return failed == 0;
+}
+
+BatchRunner::Command BatchRunner::Parse(const std::string& text, int line) {
+  std::istringstream stream(text);
+  std::string verb;
+  stream >> verb;
+
+  Command command;
+  command.line = line;
+
+  if (verb == "create" || verb == "update" || verb == "patch" ||
+      verb == "delete") {
+    std::string collection;
+    stream >> collection;
+    if (Collections.count(collection) == 0) {
+      InvalidLine(line, "Unknown collection '" + collection + "'");
+    }
+
+    std::string id;
+    if (verb != "create") {
+      stream >> id;
+      if (id.empty()) InvalidLine(line, verb + " needs the id of an entity");
+    }
+
+    json body;
+    if (verb != "delete") {
+      std::string bodyText;
+      std::getline(stream >> std::ws, bodyText);
+      try {
+        body = json::parse(bodyText);
+      } catch (const std::exception& e) {
+        InvalidLine(line, verb + " needs a JSON object: " + e.what());
+      }
+      if (!body.is_object()) {
+        InvalidLine(line, verb + " needs a JSON object");
+      }
+    }
+
+    // Entities are created and changed by the user running the script,
+    // unless the script says otherwise
+    if (collection != "users" && !_user.id.empty()) {
+      if (verb == "create" && !body.contains("createdBy")) {
+        body["createdBy"] = _user.id;
+      }
+      if (verb == "create" && collection == "issues" &&
+          !body.contains("reporter")) {
+        body["reporter"] = _user.id;
+      }
+      if ((verb == "update" || verb == "patch") &&
+          !body.contains("updatedBy")) {
+        body["updatedBy"] = _user.id;
+      }
+    }
+
+    if (verb == "create") {
+      command.method = "POST";
+      command.endpoint = "/" + collection;
+    } else {
+      command.method = verb == "update"  ? "PUT"
+                       : verb == "patch" ? "PATCH"
+                                         : "DELETE";
+      command.endpoint = "/" + collection + "/" + id;
+      command.target = command.endpoint;
+      if (verb == "update") body["id"] = id;
+    }
+    if (!body.is_null()) command.body = body.dump();
+  } else if (verb == "comment" || verb == "vote") {
+    std::string issueId;
+    stream >> issueId;
+    if (issueId.empty()) InvalidLine(line, verb + " needs the id of an issue");
+    if (_user.id.empty()) {
+      InvalidLine(line, verb + " needs a user. Run the script with --user");
+    }
+
+    json body = {{"issueId", issueId}, {"createdBy", _user.id}};
+    command.method = "POST";
+    if (verb == "comment") {
+      std::string commentBody;
+      std::getline(stream >> std::ws, commentBody);
+      if (commentBody.empty()) InvalidLine(line, "comment needs some text");
+      body["body"] = commentBody;
+      command.endpoint = "/comments";
+    } else {
+      // Voting twice removes the vote, so votes are sent in order
+      command.endpoint = "/issues/" + issueId + "/votes";
+      command.target = command.endpoint;
+    }
+    command.body = body.dump();
+  } else {
+    InvalidLine(line, "Unknown command '" + verb + "'");
+  }
+
+  return command;
+}
+
+bool BatchRunner::Finish(std::ostream& out) {
+  InFlight inFlight = std::move(_inFlight.front());
+  _inFlight.pop_front();
+  const Command& command = inFlight.command;
+
+  try {
+    auto response = inFlight.response.get();
+    int statusCode = response->get_status_code();
+    if (statusCode >= 200 && statusCode < 400) return true;
+
+    std::string detail;
+    json responseJson = ResponseUtilities::HandleResponse(response);
+    if (responseJson.is_object()) {
+      detail = responseJson.value("detail", "");
+    }
+    out << "Line " << command.line << ": " << command.method << " "
+        << command.endpoint << " failed with " << statusCode;
+    if (!detail.empty()) out << ": " << detail;
+    out << std::endl;
+  } catch (const std::exception& e) {
+    out << "Line " << command.line << ": " << command.method << " "
+        << command.endpoint << " failed: " << e.what() << std::endl;
+  }
+  return false;
+}
+
+std::shared_ptr<restbed::Request> BatchRunner::BuildRequest(
+    const Command& command) {
+  auto request = RequestUtilities::CreateGenericRequest(
+      _serverUri, command.endpoint, command.method);
+  if (!command.body.empty()) {
+    request->set_header("Content-Length",
+                        std::to_string(command.body.length()));
+    request->set_body(command.body);
+  }
+  return request;
+}
@@ -2,15 +2,26 @@
 
 #include <restbed>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <vector>
 
+#include "BatchRunner.h"
 #include "ClientAppManager.h"
+#include "Comment.h"
 #include "CommentView.h"
+#include "Issue.h"
 #include "IssueView.h"
+#include "LocalCache.h"
 #include "MainView.h"
 #include "User.h"
 #include "UserView.h"
@@ -23,6 +34,14 @@
 // Kinda smelly, but 🤷🏻‍♂️
 std::string ClientAppManager::_serverUri = "";
 User ClientAppManager::_user = User{};
+std::shared_ptr<LocalCache> ClientAppManager::_cache =
+    std::make_shared<LocalCache>("");
+bool ClientAppManager::_persistCache = false;
+bool ClientAppManager::_offline = false;
+std::mutex ClientAppManager::_syncMutex;
+std::string ClientAppManager::_script = "";
+std::string ClientAppManager::_scriptUser = "";
+int ClientAppManager::_jobs = BatchRunner::DefaultJobs;
 
 bool ClientAppManager::Init(int argc, char* argv[]) {
   std::string serverUri;
@@ -40,8 +59,23 @@ bool ClientAppManager::Init(int argc, char* argv[]) {
     ("u,url", "Full URL to the server. If specified, --host and --port are "
               "ignored",
               cxxopts::value<std::string>())
+    ("cache-dir", "Directory for the local cache. Defaults to a directory "
+                  "for the server under ~/.hotTicket",
+              cxxopts::value<std::string>())
+    ("no-cache", "Don't keep a local cache between sessions")
+    ("user", "Name of the user to run a script as",
+              cxxopts::value<std::string>())
+    ("j,jobs", "Most script commands to send at once",
+              cxxopts::value<int>()->default_value(
+                  std::to_string(BatchRunner::DefaultJobs)))
+    ("command", "Use 'exec <script>' to run a script instead of the menus",
+              cxxopts::value<std::string>())
+    ("script", "The script to run, or - to read commands from stdin",
+              cxxopts::value<std::string>()->default_value("-"))
     ("h, help", "Print help text");
   // clang-format on
+  options.parse_positional({"command", "script"});
+  options.positional_help("[exec <script>]");
 
   // Parse the options
   auto result = options.parse(argc, argv);
@@ -67,6 +101,30 @@ bool ClientAppManager::Init(int argc, char* argv[]) {
     }
     ClientAppManager::_serverUri = serverUri;
 
+    // exec runs a script without any prompts
+    if (result.count("command")) {
+      if (result["command"].as<std::string>() != "exec") {
+        std::cout << "Unknown command '" << result["command"].as<std::string>()
+                  << "'. Did you mean exec?" << std::endl;
+        return false;
+      }
+      ClientAppManager::_script = result["script"].as<std::string>();
+      ClientAppManager::_jobs = std::max(1, result["jobs"].as<int>());
+      if (result.count("user")) {
+        ClientAppManager::_scriptUser = result["user"].as<std::string>();
+      }
+    }
+
+    // Pick up where the last session left off, unless caching is turned off
+    std::string cacheDirectory = result.count("cache-dir")
+                                     ? result["cache-dir"].as<std::string>()
+                                     : LocalCache::DefaultDirectory(serverUri);
+    ClientAppManager::_cache = std::make_shared<LocalCache>(cacheDirectory);
+    ClientAppManager::_persistCache = !result.count("no-cache");
+    if (ClientAppManager::_persistCache) {
+      ClientAppManager::_cache->Load();
+    }
+
     // If the input values were correct, then the server uri shouldn't be empty
     // We return the result that assertion to verify that the client
     // initialization worked correctly
@@ -78,6 +136,10 @@ bool ClientAppManager::Init(int argc, char* argv[]) {
 }
 
 void ClientAppManager::Run() {
+  if (!_script.empty()) {
+    exit(RunScript() ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
   MainView mainView;
   UserView userView;
   VoteView voteView;
@@ -100,25 +162,72 @@ void ClientAppManager::Run() {
   bool quit = false;
 
   while (!quit) {
-    switch (choice) {
-      case MainViewState::ManageIssues: {
-        IssueViewState issueViewChoice = issueView.MainMenu();
-        issueView.RunIssueView(issueViewChoice);
-      } break;
-
-      case MainViewState::ManageUsers: {
-        UserViewState userViewChoice = userView.MainMenu();
-        userView.RunUserView(userViewChoice);
-      } break;
-      default:
-        quit = true;
-        break;
+    try {
+      switch (choice) {
+        case MainViewState::ManageIssues: {
+          IssueViewState issueViewChoice = issueView.MainMenu();
+          issueView.RunIssueView(issueViewChoice);
+        } break;
+
+        case MainViewState::ManageUsers: {
+          UserViewState userViewChoice = userView.MainMenu();
+          userView.RunUserView(userViewChoice);
+        } break;
+        default:
+          quit = true;
+          break;
+      }
+    } catch (const std::exception& e) {
+      // Changes can't be sent while the server is unreachable, but the cache
+      // can still be browsed
+      std::cout << std::endl
+                << "Unable to reach the server: " << e.what() << std::endl;
     }
     if (!quit) choice = mainView.MainMenu();
   }
+  SaveCache();
   std::cout << "Goodbye!\n";
 }
 
+bool ClientAppManager::RunScript() {
+  // Send the commands over as many connections as there are jobs
+  RequestUtilities::SetConnectionsPerServer(_jobs);
+
+  User user;
+  if (!_scriptUser.empty()) {
+    auto request = RequestUtilities::CreateGetRequest(
+        ServerURI(), "/users?name=" + restbed::Uri::encode(_scriptUser));
+    try {
+      auto response = RequestUtilities::Send(request);
+      json responseJson = ResponseUtilities::HandleResponse(response);
+      if (response->get_status_code() == restbed::OK &&
+          !responseJson.empty()) {
+        user = responseJson[0];
+      }
+    } catch (const std::exception& e) {
+      std::cout << "Unable to reach the server: " << e.what() << std::endl;
+      return false;
+    }
+    if (user.id.empty()) {
+      std::cout << "Couldn't find a user named '" << _scriptUser << "'"
+                << std::endl;
+      return false;
+    }
+  }
+
+  BatchRunner runner(ServerURI(), user, _jobs);
+  if (_script == "-") {
+    return runner.Run(std::cin, std::cout);
+  }
+
+  std::ifstream script(_script);
+  if (!script) {
+    std::cout << "Unable to open the script '" << _script << "'" << std::endl;
+    return false;
+  }
+  return runner.Run(script, std::cout);
+}
+
 User ClientAppManager::CurrentUser() { return ClientAppManager::_user; }
 
 void ClientAppManager::SetUser(const User& user) {
@@ -128,3 +237,178 @@ void ClientAppManager::SetUser(const User& user) {
 std::string ClientAppManager::ServerURI() {
   return ClientAppManager::_serverUri;
 }
+
+User ClientAppManager::GetUser(const std::string& id) {
+  return ClientAppManager::GetUsers({id})[id];
+}
+
+std::map<EntityId, User> ClientAppManager::GetUsers(
+    const std::set<EntityId>& ids) {
+  std::map<EntityId, User> users;
+  std::vector<EntityId> missing;
+  for (auto& id : ids) {
+    if (id.empty()) continue;
+    json cached = _cache->Find("users", id);
+    if (!cached.is_null()) {
+      users[id] = cached.get<User>();
+    } else if (_offline) {
+      users[id].name = "Unknown user";
+    } else {
+      missing.push_back(id);
+    }
+  }
+
+  // Fetch the users we haven't seen yet at the same time, rather than waiting
+  // on each request in turn
+  std::vector<std::future<std::shared_ptr<restbed::Response>>> requests;
+  for (auto& id : missing) {
+    requests.push_back(RequestUtilities::SendAsync(
+        RequestUtilities::CreateGetRequest(ServerURI(), "/users/" + id)));
+  }
+
+  for (int i = 0; i < missing.size(); i++) {
+    User user;
+    try {
+      auto response = requests[i].get();
+      if (response->get_status_code() == restbed::OK) {
+        json responseJson = ResponseUtilities::HandleResponse(response);
+        user = responseJson.get<User>();
+      }
+    } catch (const std::exception& e) {
+      _offline = true;
+    }
+
+    // Only cache users that were found, so a failed request is retried
+    if (!user.id.empty()) {
+      _cache->Put("users", user);
+    } else {
+      user.name = "Unknown user";
+    }
+    users[missing[i]] = user;
+  }
+  return users;
+}
+
+void ClientAppManager::ForgetUser(const std::string& id) {
+  _cache->Remove("users", id);
+}
+
+void ClientAppManager::Sync() {
+  std::lock_guard<std::mutex> lock(_syncMutex);
+  try {
+    bool more = true;
+    while (more) {
+      // A new cache starts from the latest change, and fetches the
+      // collections as they are needed
+      bool fresh = _cache->Epoch().empty();
+      auto request =
+          RequestUtilities::CreateGetRequest(ServerURI(), "/changes");
+      request->set_query_parameter(
+          "since", fresh ? "latest" : std::to_string(_cache->Sequence()));
+
+      auto response = RequestUtilities::Send(request);
+      json responseJson = ResponseUtilities::HandleResponse(response);
+      int statusCode = response->get_status_code();
+
+      if (statusCode == restbed::GONE) {
+        // The changes we need are no longer kept, so start over
+        _cache->Clear();
+        continue;
+      } else if (statusCode != restbed::OK) {
+        // Without the changes the cache can't be kept up to date, so the
+        // collections are fetched again whenever they are needed
+        _cache->Clear();
+        break;
+      }
+
+      std::string epoch = responseJson.value("epoch", "");
+      uint64_t next = responseJson.value("next", static_cast<uint64_t>(0));
+      uint64_t latest = responseJson.value("latest", next);
+      if (fresh) {
+        _cache->SetEpoch(epoch);
+        _cache->SetSequence(next);
+        more = false;
+      } else if (epoch != _cache->Epoch()) {
+        // The server restarted, so our sequence means nothing to it
+        _cache->Clear();
+      } else {
+        for (auto& change : responseJson["changes"]) {
+          _cache->Apply(change);
+        }
+        _cache->SetSequence(next);
+        more = next < latest;
+      }
+    }
+    _offline = false;
+  } catch (const std::exception& e) {
+    _offline = true;
+  }
+  SaveCache();
+}
+
+bool ClientAppManager::Offline() { return _offline; }
+
+bool ClientAppManager::StartOffline() {
+  _offline = true;
+  return !_cache->Epoch().empty();
+}
+
+std::vector<Issue> ClientAppManager::GetIssues(const StringMap& query) {
+  Sync();
+  Fetch("issues", "/issues");
+
+  std::vector<Issue> issues;
+  for (auto& issue : _cache->Get("issues", query)) {
+    issues.push_back(issue.get<Issue>());
+  }
+  return issues;
+}
+
+std::multiset<Comment> ClientAppManager::GetComments(
+    const std::string& issueId) {
+  Sync();
+  Fetch("comments", "/issues/" + issueId + "/comments");
+
+  std::multiset<Comment> comments;
+  for (auto& comment : _cache->Get("comments", {{"issueId", issueId}})) {
+    comments.insert(comment.get<Comment>());
+  }
+  return comments;
+}
+
+std::vector<User> ClientAppManager::FindUsers(const StringMap& query) {
+  Sync();
+  Fetch("users", "/users");
+
+  std::vector<User> users;
+  for (auto& user : _cache->Get("users", query)) {
+    users.push_back(user.get<User>());
+  }
+  return users;
+}
+
+void ClientAppManager::Fetch(const std::string& collection,
+                             const std::string& endpoint) {
+  if (_offline || _cache->Fetched(endpoint)) return;
+
+  try {
+    auto request = RequestUtilities::CreateGetRequest(ServerURI(), endpoint);
+    auto response = RequestUtilities::Send(request);
+    json responseJson = ResponseUtilities::HandleResponse(response);
+    if (response->get_status_code() == restbed::OK) {
+      _cache->Fetch(collection, endpoint, responseJson);
+      SaveCache();
+    }
+  } catch (const std::exception& e) {
+    _offline = true;
+  }
+}
+
+void ClientAppManager::SaveCache() {
+  if (!_persistCache) return;
+  try {
+    _cache->Save();
+  } catch (const std::exception& e) {
+    // The cache only saves time, so the session carries on without it
+  }
+}
@@ -55,7 +55,7 @@ string CommentView::CreateCommentView() {
 
   auto request =
       RequestUtilities::CreatePostRequest(_serverUri, "/comments", comment);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json commentResponse = ResponseUtilities::HandleResponse(response);
 
@@ -78,7 +78,7 @@ string CommentView::UpdateCommentView() {
 
   auto request =
       RequestUtilities::CreateGetRequest(_serverUri, "/comments/" + id);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json commentResponse = ResponseUtilities::HandleResponse(response);
 
@@ -100,7 +100,7 @@ string CommentView::UpdateCommentView() {
     auto newRequest = RequestUtilities::CreatePutRequest(
         _serverUri, "/comments/" + commentResponse["id"].get<std::string>(),
         body);
-    auto newResponse = restbed::Http::sync(newRequest);
+    auto newResponse = RequestUtilities::Send(newRequest);
 
     json j = ResponseUtilities::HandleResponse(newResponse);
   } else if (response->get_status_code() == restbed::NOT_FOUND) {
@@ -112,7 +112,7 @@ string CommentView::UpdateCommentView() {
 
 void CommentView::GetCommentsView() {
   auto request = RequestUtilities::CreateGetRequest(_serverUri, "/comments");
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
   json comments = ResponseUtilities::HandleResponse(response);
 
   if (comments.empty()) {
@@ -137,7 +137,7 @@ string CommentView::GetCommentView() {
 
   auto request =
       RequestUtilities::CreateGetRequest(_serverUri, "/comments/" + id);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json commentResponse = ResponseUtilities::HandleResponse(response);
 
@@ -160,7 +160,7 @@ string CommentView::DeleteCommentView() {
 
   auto request =
       RequestUtilities::CreateDeleteRequest(_serverUri, "/comments/" + id);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json commentResponse = ResponseUtilities::HandleResponse(response);
   if (response->get_status_code() == restbed::OK) {
@@ -4,6 +4,7 @@
 #include <restbed>
 
 #include <algorithm>
+#include <future>
 #include <map>
 #include <set>
 #include <sstream>
@@ -28,47 +29,24 @@ using std::string;
 std::vector<string> IssueStatus = {"New", "Assigned", "Fixed", "Won't Fix",
                                    "Closed"};
 
-User GetUserById(const std::string& id) {
-  auto request = RequestUtilities::CreateGetRequest(
-      ClientAppManager::ServerURI(), "/users/" + id);
-  auto response = restbed::Http::sync(request);
-
-  User user;
-  if (response->get_status_code() == restbed::OK) {
-    json responseJson = ResponseUtilities::HandleResponse(response);
-    user = responseJson.get<User>();
-  } else {
-    user.name = "Unknown user";
-  }
-  return user;
+std::multiset<Comment> GetCommentsForIssue(const std::string& issueId) {
+  // The comments for the issue are only downloaded the first time
+  return ClientAppManager::GetComments(issueId);
 }
 
-Comment GetCommentById(const std::string& id) {
-  auto request = RequestUtilities::CreateGetRequest(
-      ClientAppManager::ServerURI(), "/comments/" + id);
-  auto response = restbed::Http::sync(request);
-
-  Comment comment;
-  if (response->get_status_code() == restbed::OK) {
-    json responseJson = ResponseUtilities::HandleResponse(response);
-    comment = responseJson.get<Comment>();
-    comment.createdBy = GetUserById(comment.createdBy.id);
-    if (!comment.updatedBy.id.empty()) {
-      comment.updatedBy = GetUserById(comment.updatedBy.id);
-    }
+std::string DisplayComments(const std::multiset<Comment>& comments) {
+  // Look up everyone who wrote a comment at once
+  std::set<EntityId> userIds;
+  for (auto& comment : comments) {
+    userIds.insert(comment.createdBy.id);
   }
-  return comment;
-}
+  std::map<EntityId, User> users = ClientAppManager::GetUsers(userIds);
 
-std::string DisplayComments(const std::multiset<Comment>& comments) {
   std::stringstream commentsStream;
-  int count = 0;
-  for (auto comment : comments) {
-    Comment temp = GetCommentById(comment.id);
-    User user = GetUserById(temp.createdBy.id);
-    commentsStream << "   \u2516" << temp.body << std::endl
-                   << "     By: " << user.name << " on "
-                   << TimeUtilities::ConvertTimeToString(temp.createdAt)
+  for (auto& comment : comments) {
+    commentsStream << "   \u2516" << comment.body << std::endl
+                   << "     By: " << users[comment.createdBy.id].name << " on "
+                   << TimeUtilities::ConvertTimeToString(comment.createdAt)
                    << std::endl;
   }
   return commentsStream.str();
@@ -76,9 +54,17 @@ std::string DisplayComments(const std::multiset<Comment>& comments) {
 
 std::string DisplayVotesForIssue(const Issue& issue) {
   std::stringstream votesStream;
+  if (issue.votes.empty()) return votesStream.str();
+
+  // Without the server we only know how many votes there are
+  if (ClientAppManager::Offline()) {
+    votesStream << "\u2516 " << issue.votes.size() << " votes";
+    return votesStream.str();
+  }
+
   auto request = RequestUtilities::CreateGetRequest(
       ClientAppManager::ServerURI(), "/issues/" + issue.id + "/votes");
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
   if (response->get_status_code() == restbed::OK) {
     json responseJson = ResponseUtilities::HandleResponse(response);
     std::vector<Vote> votes = responseJson;
@@ -210,34 +196,37 @@ void IssueView::RunIssueView(IssueViewState choice) {
 Issue IssueView::IssuesView(const StringMap& query) {
   std::cout << std::endl;
 
-  auto request = RequestUtilities::CreateGetRequest(_serverUri, "/issues");
-  request->set_query_parameters(query);
-
-  auto response = restbed::Http::sync(request);
-  json jsonResponse = ResponseUtilities::HandleResponse(response);
+  // Issues are listed from the local cache, which is brought up to date first
+  std::vector<Issue> issues = ClientAppManager::GetIssues(query);
+  if (ClientAppManager::Offline()) {
+    std::cout << "(Offline: showing the issues saved on this computer)\n";
+  }
 
   Issue selectedIssue;
-  if (response->get_status_code() != restbed::OK) {
-    std::cout << "Something went wrong: " << jsonResponse.dump() << std::endl;
+  if (issues.empty()) {
+    std::cout << "No issues to display" << std::endl;
   } else {
-    std::vector<Issue> issues = jsonResponse;
-    if (issues.empty()) {
-      std::cout << "No issues to display" << std::endl;
-    } else {
-      std::stringstream prompt;
-      prompt << "Available Issues:\n";
-      for (int i = 1; i <= issues.size(); i++) {
-        prompt << i << ": " << DisplayIssueBrief(issues[i - 1]) << "\n";
-      }
-      prompt << issues.size() + 1 << ": Go Back\n";
-      prompt << "Select an issue to view more details: ";
+    // Fetch the reporters of the issues together, so the list below is
+    // built from the cache
+    std::set<EntityId> reporterIds;
+    for (auto& issue : issues) {
+      reporterIds.insert(issue.reporter.id);
+    }
+    ClientAppManager::GetUsers(reporterIds);
 
-      int selection =
-          PromptUser(prompt, Validators::RangeValidator(1, issues.size() + 1));
+    std::stringstream prompt;
+    prompt << "Available Issues:\n";
+    for (int i = 1; i <= issues.size(); i++) {
+      prompt << i << ": " << DisplayIssueBrief(issues[i - 1]) << "\n";
+    }
+    prompt << issues.size() + 1 << ": Go Back\n";
+    prompt << "Select an issue to view more details: ";
 
-      if (selection >= 1 && selection <= issues.size()) {
-        selectedIssue = issues[selection - 1];
-      }
+    int selection =
+        PromptUser(prompt, Validators::RangeValidator(1, issues.size() + 1));
+
+    if (selection >= 1 && selection <= issues.size()) {
+      selectedIssue = issues[selection - 1];
     }
   }
   return selectedIssue;
@@ -299,7 +288,7 @@ void IssueView::CreateIssueView() {
 
   auto request =
       RequestUtilities::CreatePostRequest(_serverUri, "/issues", issue);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json issueResponse = ResponseUtilities::HandleResponse(response);
   if (response->get_status_code() == restbed::CREATED) {
@@ -357,7 +346,7 @@ Issue IssueView::UpdateIssueView(const Issue& issue) {
   request->set_body(body);
   request->set_header("Content-Length", std::to_string(body.length()));
 
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
   json issueResponse = ResponseUtilities::HandleResponse(response);
   if (response->get_status_code() == restbed::OK) {
     Issue updatedIssue = issueResponse.get<Issue>();
@@ -385,7 +374,7 @@ bool IssueView::DeleteIssueView(const Issue& issue) {
 
   auto request =
       RequestUtilities::CreateDeleteRequest(_serverUri, "/issues/" + issue.id);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
   if (response->get_status_code() < 400) {
     std::cout << std::endl << "Issue successfully delete" << std::endl;
     return true;
@@ -412,7 +401,7 @@ void IssueView::AddCommentView(const Issue& issue) {
                        {"issueId", issue.id}};
   auto request =
       RequestUtilities::CreatePostRequest(_serverUri, "/comments", comment);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
   std::cout << std::endl;
   if (response->get_status_code() == restbed::CREATED) {
     std::cout << std::endl << "Comment successfully created" << std::endl;
@@ -433,7 +422,7 @@ Issue IssueView::ChangeVoteView(const Issue& issue) {
   StringMap query = {{"createdBy", ClientAppManager::CurrentUser().id}};
   request->set_query_parameters(query);
 
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
   if (response->get_status_code() == restbed::OK) {
     json responseJson = ResponseUtilities::HandleResponse(response);
     auto votes = responseJson.get<std::vector<Vote>>();
@@ -454,12 +443,12 @@ Issue IssueView::ChangeVoteView(const Issue& issue) {
                         {"createdBy", ClientAppManager::CurrentUser().id}};
       request = RequestUtilities::CreatePostRequest(
           _serverUri, "/issues/" + issue.id + "/votes", vote);
-      response = restbed::Http::sync(request);
+      response = RequestUtilities::Send(request);
       bool updated = false;
       if (response->get_status_code() == restbed::CREATED) {
         std::cout << std::endl << "Your vote has been cast" << std::endl;
         updated = true;
-      } else if (response->get_status_code() == restbed::NO_CONTENT) {
+      } else if (response->get_status_code() == restbed::OK) {
         std::cout << std::endl << "Your vote has been removed" << std::endl;
         updated = true;
       } else {
@@ -471,7 +460,7 @@ Issue IssueView::ChangeVoteView(const Issue& issue) {
       if (updated) {
         request = RequestUtilities::CreateGetRequest(_serverUri,
                                                      "/issues/" + issue.id);
-        response = restbed::Http::sync(request);
+        response = RequestUtilities::Send(request);
         if (response->get_status_code() == restbed::OK) {
           json updatedIssueJson = ResponseUtilities::HandleResponse(response);
           Issue updatedIssue = updatedIssueJson.get<Issue>();
@@ -484,7 +473,7 @@ Issue IssueView::ChangeVoteView(const Issue& issue) {
 }
 
 std::string IssueView::DisplayIssueBrief(const Issue& issue) {
-  User reporter = GetUserById(issue.reporter.id);
+  User reporter = ClientAppManager::GetUser(issue.reporter.id);
   std::stringstream issueStream;
   issueStream << "Title: " << issue.title.substr(0, 50);
   if (issue.title.size() > 50) issueStream << "...";
@@ -497,35 +486,42 @@ std::string IssueView::DisplayIssueBrief(const Issue& issue) {
 }
 
 void IssueView::DisplayIssue(const Issue& issue) {
+  // The votes, comments and users are independent, so fetch them all at once
+  auto votes = std::async(std::launch::async, DisplayVotesForIssue, issue);
+  auto comments = std::async(std::launch::async, [&issue]() {
+    if (issue.comments.empty()) return std::string();
+    return DisplayComments(GetCommentsForIssue(issue.id));
+  });
+  std::map<EntityId, User> users = ClientAppManager::GetUsers(
+      {issue.reporter.id, issue.assignedTo.id, issue.updatedBy.id});
+
   std::cout << std::endl << "Issue details\n";
 
   // Display the title
   std::cout << "Title: " << issue.title << std::endl;
 
   // Display the reporter and timestamp
-  User reporter = GetUserById(issue.reporter.id);
-  std::cout << "\u2516 Reported by: " << reporter.name << " on "
+  std::cout << "\u2516 Reported by: " << users[issue.reporter.id].name << " on "
             << TimeUtilities::ConvertTimeToString(issue.createdAt) << std::endl;
 
   if (!issue.assignedTo.id.empty()) {
-    User assignedTo = GetUserById(issue.assignedTo.id);
-    std::cout << "\u2516 Assigned to: " << assignedTo.name << std::endl;
+    std::cout << "\u2516 Assigned to: " << users[issue.assignedTo.id].name
+              << std::endl;
   }
 
   // If updated, display updated information
   if (!issue.updatedBy.id.empty()) {
-    User updater = GetUserById(issue.updatedBy.id);
-    std::cout << "\u2516 Updated by: " << updater.name << " on "
-              << TimeUtilities::ConvertTimeToString(issue.updatedAt)
+    std::cout << "\u2516 Updated by: " << users[issue.updatedBy.id].name
+              << " on " << TimeUtilities::ConvertTimeToString(issue.updatedAt)
               << std::endl;
   }
 
   if (issue.votes.size() > 0) {
-    std::cout << DisplayVotesForIssue(issue) << std::endl;
+    std::cout << votes.get() << std::endl;
   }
 
   if (issue.comments.size() > 0) {
     std::cout << "\u2516 Comments:" << std::endl;
-    std::cout << DisplayComments(issue.comments);
+    std::cout << comments.get();
   }
 }
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -23,9 +24,22 @@ bool MainView::WelcomeMessage() {
   std::cout << "Connecting the to server at '" << _serverUri << "'...\n";
 
   // Make a synchronous GET request to the server
-  auto response = restbed::Http::sync(request);
-  if (response->get_status_code() == restbed::OK) {
+  std::shared_ptr<restbed::Response> response;
+  try {
+    response = RequestUtilities::Send(request);
+  } catch (const std::exception& e) {
+    response = nullptr;
+  }
+
+  if (response != nullptr && response->get_status_code() == restbed::OK) {
     std::cout << "Connection successful!\n\n";
+    // Catch up on the changes made since the last session
+    ClientAppManager::Sync();
+    return true;
+  } else if (ClientAppManager::StartOffline()) {
+    std::cout << "Unable to reach the server at '" << _serverUri
+              << "'. Browsing the issues saved on this computer instead. "
+                 "Changes can't be saved until the server is back\n\n";
     return true;
   } else {
     std::cout << "Connection unsuccesful. Please verify that the server is "
@@ -41,12 +55,23 @@ User MainView::Login() {
       1, 256, "Name must be between 1 and 256 characters.");
   string input = PromptUser(prompt, validator);
 
+  // Offline, we can only log in as a user we've seen before
+  if (ClientAppManager::Offline()) {
+    std::vector<User> users = ClientAppManager::FindUsers({{"name", input}});
+    if (users.empty()) {
+      std::cout << "You can't log in as a new user while offline" << std::endl;
+      return User{};
+    }
+    std::cout << "Welcome back, " << users.front().name << std::endl;
+    return users.front();
+  }
+
   // Create request to get the user from the server
   auto request = RequestUtilities::CreateGetRequest(
       _serverUri, string("/users?name=" + restbed::Uri::encode(input)));
 
   // Send the request and get the response
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   // Parse the reseponse
   json responseJson = ResponseUtilities::HandleResponse(response);
@@ -64,7 +89,7 @@ User MainView::Login() {
     request =
         RequestUtilities::CreatePostRequest(_serverUri, "/users", userMap);
     // Send the request and get the response
-    response = restbed::Http::sync(request);
+    response = RequestUtilities::Send(request);
     // Parse the response
     responseJson = ResponseUtilities::HandleResponse(response);
     if (response->get_status_code() == restbed::CREATED) {
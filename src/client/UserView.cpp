@@ -64,7 +64,7 @@ void UserView::CreateUserView() {
 
   auto request =
       RequestUtilities::CreatePostRequest(_serverUri, "/users", user);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   std::cout << std::endl;
   if (response->get_status_code() == restbed::CREATED) {
@@ -78,16 +78,12 @@ void UserView::CreateUserView() {
 
 User UserView::SelectUserView() {
   std::cout << std::endl;
-  auto request = RequestUtilities::CreateGetRequest(_serverUri, "/users");
-  auto response = restbed::Http::sync(request);
-  json usersJson = ResponseUtilities::HandleResponse(response);
+  std::vector<User> users = ClientAppManager::FindUsers();
   int selection;
   std::cout << std::endl;
-  if (usersJson.empty()) {
+  if (users.empty()) {
     std::cout << "No users to select\n\n";
   } else {
-    std::vector<User> users = usersJson;
-
     std::stringstream prompt;
     prompt << "All available users: " << std::endl;
     // Display the list of users
@@ -150,9 +146,10 @@ void UserView::UpdateUserView(const User& user) {
   auto request =
       RequestUtilities::CreatePutRequest(_serverUri, "/users/" + user.id, body);
 
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   if (response->get_status_code() == restbed::OK) {
+    ClientAppManager::ForgetUser(user.id);
     std::cout << "\nUser updated successfully!\n";
   } else {
     json jsonResponse = ResponseUtilities::HandleResponse(response);
@@ -165,10 +162,11 @@ void UserView::DeleteUserView(const User& user) {
   std::cout << std::endl;
   auto request =
       RequestUtilities::CreateDeleteRequest(_serverUri, "/users/" + user.id);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json jsonResponse = ResponseUtilities::HandleResponse(response);
   if (response->get_status_code() == restbed::OK) {
+    ClientAppManager::ForgetUser(user.id);
     std::cout << "User successfully deleted!\n";
   } else {
     std::cout << "\nAn error occurred with your request:\n"
@@ -185,25 +183,13 @@ std::string UserView::GetUserIdFromName(const std::string& prompt) {
   string userName;
   userName = PromptUser(prompt, Validators::StringLengthValidator(1, 256));
 
-  const StringMap queryUserParam = {{"name", userName}};
-
-  // get the User where the name is equal to the inputted name
-  auto userRequest = RequestUtilities::CreateGetRequest(
-      ClientAppManager::ServerURI(), "/users");
-  userRequest->set_query_parameters(queryUserParam);
-
-  auto userResponse = restbed::Http::sync(userRequest);
-
-  // If we couldn't find the user, return nothing
-  if (userResponse->get_status_code() == restbed::NOT_FOUND) {
-    return "";
-  }
-
-  json matchedUsers = ResponseUtilities::HandleResponse(userResponse);
+  // Get the User where the name is equal to the inputted name
+  std::vector<User> matchedUsers =
+      ClientAppManager::FindUsers({{"name", userName}});
 
   string userId;
   if (!matchedUsers.empty()) {
-    userId = matchedUsers[0]["id"];
+    userId = matchedUsers[0].id;
   }
 
   return userId;
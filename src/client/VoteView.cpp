@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 
+#include "ClientAppManager.h"
 #include "Vote.h"
 #include "Utilities.h"
 #include "nlohmann/json.hpp"
@@ -46,20 +47,27 @@ string VoteView::CreateVoteView() {
 
   issueId = PromptUser(issuePrompt, Validators::IdValidator());
 
-  StringMap vote = {{"issueId", issueId}};
+  StringMap vote = {{"issueId", issueId},
+                    {"createdBy", ClientAppManager::CurrentUser().id}};
 
   auto request =
       RequestUtilities::CreatePostRequest(_serverUri, "/votes", vote);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json voteResponse = ResponseUtilities::HandleResponse(response);
 
+  // Voting again on an issue removes the vote
   if (response->get_status_code() == restbed::CREATED) {
     std::cout << "Newly created vote: \n";
-    for (auto& it : voteResponse.items()) {
+    for (auto& it : voteResponse["vote"].items()) {
       std::cout << it.key() << ": " << it.value() << ", ";
     }
-    std::cout << "\n\n";
+    std::cout << "\n";
+  } else if (response->get_status_code() == restbed::OK) {
+    std::cout << "Your vote has been removed\n";
+  }
+  if (voteResponse.contains("count")) {
+    std::cout << "The issue has " << voteResponse["count"] << " votes\n\n";
   }
 
   return issueId;
@@ -68,7 +76,7 @@ string VoteView::CreateVoteView() {
 
 void VoteView::GetVotesView() {
   auto request = RequestUtilities::CreateGetRequest(_serverUri, "/votes");
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
   json votes = ResponseUtilities::HandleResponse(response);
 
   if (votes.empty()) {
@@ -92,7 +100,7 @@ string VoteView::GetVoteView() {
   id = PromptUser(idPrompt, Validators::IdValidator());
 
   auto request = RequestUtilities::CreateGetRequest(_serverUri, "/votes/" + id);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json voteResponse = ResponseUtilities::HandleResponse(response);
 
@@ -115,7 +123,7 @@ string VoteView::DeleteVoteView() {
 
   auto request =
       RequestUtilities::CreateDeleteRequest(_serverUri, "/votes/" + id);
-  auto response = restbed::Http::sync(request);
+  auto response = RequestUtilities::Send(request);
 
   json voteResponse = ResponseUtilities::HandleResponse(response);
   if (response->get_status_code() == restbed::OK) {
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "DatasetGenerator.h"
+#include "cxxopts.hpp"
+
+int main(int argc, char* argv[]) {
+  DatasetOptions defaults;
+  cxxopts::Options options(
+      "hotTicket-datagen",
+      "Generates users.json, issues.json, comments.json and votes.json for "
+      "benchmarks and load tests");
+  // clang-format off
+  options.add_options()
+    ("o,output", "Directory to write the files to",
+                 cxxopts::value<std::string>()->default_value("."))
+    ("users", "Number of users",
+              cxxopts::value<std::size_t>()->default_value(
+                  std::to_string(defaults.users)))
+    ("issues", "Number of issues",
+               cxxopts::value<std::size_t>()->default_value(
+                   std::to_string(defaults.issues)))
+    ("comments", "Number of comments",
+                 cxxopts::value<std::size_t>()->default_value(
+                     std::to_string(defaults.comments)))
+    ("votes", "Number of votes",
+              cxxopts::value<std::size_t>()->default_value(
+                  std::to_string(defaults.votes)))
+    ("skew", "Zipf exponent for comments and votes per issue (0 is even)",
+             cxxopts::value<double>()->default_value("1.1"))
+    ("heavy-reporters", "Fraction of users who are heavy reporters",
+                        cxxopts::value<double>()->default_value("0.05"))
+    ("heavy-share", "Fraction of issues the heavy reporters report",
+                    cxxopts::value<double>()->default_value("0.5"))
+    ("days", "Number of days the entities are created over",
+             cxxopts::value<int>()->default_value(
+                 std::to_string(defaults.days)))
+    ("seed", "Seed for the random numbers",
+             cxxopts::value<uint64_t>()->default_value(
+                 std::to_string(defaults.seed)))
+    ("h,help", "Print help text");
+  // clang-format on
+
+  try {
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+      std::cout << options.help() << std::endl;
+      return EXIT_SUCCESS;
+    }
+
+    DatasetOptions datasetOptions;
+    datasetOptions.users = result["users"].as<std::size_t>();
+    datasetOptions.issues = result["issues"].as<std::size_t>();
+    datasetOptions.comments = result["comments"].as<std::size_t>();
+    datasetOptions.votes = result["votes"].as<std::size_t>();
+    datasetOptions.skew = result["skew"].as<double>();
+    datasetOptions.heavyReporters = result["heavy-reporters"].as<double>();
+    datasetOptions.heavyShare = result["heavy-share"].as<double>();
+    datasetOptions.days = result["days"].as<int>();
+    datasetOptions.seed = result["seed"].as<uint64_t>();
+    std::string output = result["output"].as<std::string>();
+
+    if (datasetOptions.users == 0 && datasetOptions.issues > 0) {
+      std::cout << "Issues need at least one user to report them" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DatasetGenerator generator(datasetOptions);
+    Dataset dataset = generator.Generate();
+    DatasetGenerator::Write(dataset, output);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::cout << "Wrote " << dataset.users.size() << " users, "
+              << dataset.issues.size() << " issues, "
+              << dataset.comments.size() << " comments and "
+              << dataset.votes.size() << " votes to '" << output << "' in "
+              << elapsed.count() << "s" << std::endl;
+  } catch (const std::exception& e) {
+    std::cout << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
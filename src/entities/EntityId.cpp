@@ -0,0 +1,163 @@
+#include "EntityId.h"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+const uint64_t Base = 37;
+
+constexpr uint64_t Power(std::size_t exponent) {
+  return exponent == 0 ? 1 : Base * Power(exponent - 1);
+}
+
+/**
+ * The weight of each position of a packed id, so the first character is the
+ * most significant digit. Constant initialized, so ids can be made by other
+ * static initializers
+ */
+const uint64_t Powers[EntityId::MaxPackedLength] = {
+    Power(11), Power(10), Power(9), Power(8), Power(7), Power(6),
+    Power(5),  Power(4),  Power(3), Power(2), Power(1), Power(0)};
+
+/**
+ * @return the digit of a character in a packed id, or 0 if it can't be
+ * packed. Digits sort like the characters they stand for
+ */
+uint64_t Digit(char c) {
+  if (c >= '0' && c <= '9') return c - '0' + 1;
+  if (c >= 'a' && c <= 'z') return c - 'a' + 11;
+  return 0;
+}
+
+char Character(uint64_t digit) {
+  return digit <= 10 ? static_cast<char>('0' + digit - 1)
+                     : static_cast<char>('a' + digit - 11);
+}
+
+/**
+ * The strings of the interned ids, by index and by string, with the number of
+ * ids holding each one. The indexes of dropped strings are reused. Interned
+ * ids are only expected for the odd id that wasn't made by the services, so
+ * one mutex guards the whole table
+ */
+struct InternTable {
+  struct Entry {
+    std::string string;
+    std::size_t references = 0;
+  };
+
+  std::mutex mutex;
+  std::vector<Entry> entries;
+  std::vector<uint64_t> unused;
+  std::unordered_map<std::string, uint64_t> indexes;
+};
+
+InternTable& Interned() {
+  // Never destroyed, so ids in other static objects can outlive it
+  static InternTable* table = new InternTable();
+  return *table;
+}
+}  // namespace
+
+EntityId::EntityId(const std::string& id)
+    : _value(Encode(id.data(), id.length())) {}
+
+EntityId::EntityId(const char* id) : _value(Encode(id, std::strlen(id))) {}
+
+bool EntityId::Lookup(const std::string& id, EntityId* result) {
+  EntityId found;
+  if (!Pack(id.data(), id.length(), &found._value)) {
+    InternTable& table = Interned();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto index = table.indexes.find(id);
+    if (index == table.indexes.end()) return false;
+    table.entries[index->second].references++;
+    found._value = index->second | InternedFlag;
+  }
+  *result = std::move(found);
+  return true;
+}
+
+std::size_t EntityId::InternedCount() {
+  InternTable& table = Interned();
+  std::lock_guard<std::mutex> lock(table.mutex);
+  return table.indexes.size();
+}
+
+void EntityId::Retain(uint64_t value) {
+  InternTable& table = Interned();
+  std::lock_guard<std::mutex> lock(table.mutex);
+  table.entries[value & ~InternedFlag].references++;
+}
+
+void EntityId::Release(uint64_t value) {
+  InternTable& table = Interned();
+  uint64_t index = value & ~InternedFlag;
+  std::lock_guard<std::mutex> lock(table.mutex);
+  InternTable::Entry& entry = table.entries[index];
+  if (--entry.references > 0) return;
+
+  table.indexes.erase(entry.string);
+  std::string().swap(entry.string);
+  table.unused.push_back(index);
+}
+
+bool EntityId::Pack(const char* id, std::size_t length, uint64_t* value) {
+  if (length > MaxPackedLength) return false;
+
+  uint64_t packed = 0;
+  for (std::size_t i = 0; i < length; i++) {
+    uint64_t digit = Digit(id[i]);
+    if (digit == 0) return false;
+    packed += digit * Powers[i];
+  }
+  *value = packed;
+  return true;
+}
+
+uint64_t EntityId::Encode(const char* id, std::size_t length) {
+  uint64_t value;
+  if (Pack(id, length, &value)) return value;
+
+  InternTable& table = Interned();
+  std::string key(id, length);
+  std::lock_guard<std::mutex> lock(table.mutex);
+  auto found = table.indexes.find(key);
+  if (found != table.indexes.end()) {
+    table.entries[found->second].references++;
+    return found->second | InternedFlag;
+  }
+
+  uint64_t index;
+  if (table.unused.empty()) {
+    index = table.entries.size();
+    table.entries.emplace_back();
+  } else {
+    index = table.unused.back();
+    table.unused.pop_back();
+  }
+  table.entries[index].string = key;
+  table.entries[index].references = 1;
+  table.indexes.emplace(std::move(key), index);
+  return index | InternedFlag;
+}
+
+std::string EntityId::str() const {
+  if (!IsPacked()) {
+    InternTable& table = Interned();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.entries[_value & ~InternedFlag].string;
+  }
+
+  std::string result;
+  result.reserve(MaxPackedLength);
+  for (std::size_t i = 0; i < MaxPackedLength; i++) {
+    uint64_t digit = _value / Powers[i] % Base;
+    if (digit == 0) break;
+    result += Character(digit);
+  }
+  return result;
+}
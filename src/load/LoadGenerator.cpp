@@ -0,0 +1,326 @@
+#include "LoadGenerator.h"
+
+#include <restbed>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Exceptions.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * The weights of the named workload profiles, in the order of Operation
+ */
+const std::map<std::string, std::vector<unsigned>> Profiles = {
+    {"read-heavy", {45, 45, 2, 4, 4}},
+    {"mixed", {30, 40, 10, 10, 10}},
+    {"write-heavy", {10, 20, 30, 20, 20}}};
+
+/**
+ * The statuses issues are listed by. Won't Fix is left out so the query
+ * doesn't need escaping
+ */
+const char* const ListStatuses[] = {"New", "Assigned", "Fixed", "Closed"};
+
+/**
+ * The percentiles reported for each operation
+ */
+const double Percentiles[] = {50, 90, 99, 99.9};
+
+/**
+ * Formats microseconds as milliseconds
+ */
+std::string Milliseconds(double micros) {
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(2) << micros / 1000.0;
+  return stream.str();
+}
+}  // namespace
+
+const char* const LoadGenerator::OperationNames[OperationCount] = {
+    "list", "get", "create", "comment", "vote"};
+
+std::vector<unsigned> LoadGenerator::ParseMix(const std::string& mix) {
+  auto profile = Profiles.find(mix);
+  if (profile != Profiles.end()) return profile->second;
+
+  std::vector<unsigned> weights(OperationCount, 0);
+  std::stringstream stream(mix);
+  std::string weight;
+  while (std::getline(stream, weight, ',')) {
+    std::size_t equals = weight.find('=');
+    std::string name = weight.substr(0, equals);
+    auto operation =
+        std::find(OperationNames, OperationNames + OperationCount, name);
+    if (equals == std::string::npos ||
+        operation == OperationNames + OperationCount) {
+      throw BadRequestError(
+          std::string("'" + mix +
+                      "' is not a profile (read-heavy, mixed or write-heavy) "
+                      "or weights like list=40,get=40,create=10,comment=5,"
+                      "vote=5")
+              .c_str());
+    }
+    try {
+      weights[operation - OperationNames] =
+          std::stoul(weight.substr(equals + 1));
+    } catch (const std::exception&) {
+      throw BadRequestError(
+          std::string("The weight of " + name + " must be a whole number")
+              .c_str());
+    }
+  }
+
+  if (std::all_of(weights.begin(), weights.end(),
+                  [](unsigned w) { return w == 0; })) {
+    throw BadRequestError("At least one operation needs a weight");
+  }
+  return weights;
+}
+
+LoadGenerator::LoadGenerator(const Options& options)
+    : _options(options), _results(OperationCount) {
+  if (_options.concurrency == 0) _options.concurrency = 1;
+  if (_options.mix.size() != OperationCount) {
+    _options.mix = Profiles.at("mixed");
+  }
+}
+
+void LoadGenerator::Prepare() {
+  json users = ResponseUtilities::HandleResponse(Send("GET", "/users"));
+  for (auto& user : users) _userIds.push_back(user.value("id", ""));
+  if (_userIds.empty()) {
+    throw NotFoundError(
+        "The server has no users to run the load test as. Generate a dataset "
+        "with hotTicket-datagen first");
+  }
+
+  json issues = ResponseUtilities::HandleResponse(Send("GET", "/issues"));
+  for (auto& issue : issues) _issueIds.push_back(issue.value("id", ""));
+}
+
+void LoadGenerator::Run() {
+  // Each worker gets enough connections that none waits on another
+  RequestUtilities::SetConnectionsPerServer(_options.concurrency);
+
+  std::vector<Worker> workers(_options.concurrency);
+  for (std::size_t i = 0; i < workers.size(); i++) {
+    workers[i].userId = _userIds[i % _userIds.size()];
+    workers[i].random.seed(_options.seed + i);
+    workers[i].results.resize(OperationCount);
+  }
+
+  _next = 0;
+  _start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto& worker : workers) {
+    threads.emplace_back([this, &worker]() { Work(&worker); });
+  }
+  for (auto& thread : threads) thread.join();
+  _elapsed = std::chrono::steady_clock::now() - _start;
+
+  for (auto& worker : workers) {
+    for (int i = 0; i < OperationCount; i++) {
+      _results[i].latency.Merge(worker.results[i].latency);
+      _results[i].errors += worker.results[i].errors;
+    }
+  }
+}
+
+void LoadGenerator::Work(Worker* worker) {
+  using Clock = std::chrono::steady_clock;
+  auto end = _start + std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(_options.duration));
+  auto interval =
+      _options.rate > 0
+          ? std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / _options.rate))
+          : Clock::duration::zero();
+
+  unsigned total = 0;
+  for (auto weight : _options.mix) total += weight;
+
+  while (true) {
+    // With a rate, requests are due at fixed times whether or not the server
+    // has kept up, and their latency counts from then
+    Clock::time_point scheduled = Clock::now();
+    if (_options.rate > 0) {
+      scheduled = _start + interval * static_cast<int64_t>(_next++);
+      if (scheduled >= end) break;
+      std::this_thread::sleep_until(scheduled);
+    } else if (scheduled >= end) {
+      break;
+    }
+
+    // Pick an operation in proportion to its weight
+    unsigned pick = static_cast<unsigned>(worker->random() % total);
+    int operation = 0;
+    while (pick >= _options.mix[operation]) pick -= _options.mix[operation++];
+
+    bool succeeded = false;
+    try {
+      succeeded = Perform(static_cast<Operation>(operation), worker);
+    } catch (const std::exception&) {
+      succeeded = false;
+    }
+
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - scheduled);
+    Results& results = worker->results[operation];
+    results.latency.Record(static_cast<uint64_t>(latency.count()));
+    if (!succeeded) results.errors++;
+  }
+}
+
+bool LoadGenerator::Perform(Operation operation, Worker* worker) {
+  std::string issueId = RandomIssue(worker);
+  // Everything but list and create needs an issue to work with
+  if (issueId.empty() && operation != List) operation = Create;
+
+  std::shared_ptr<restbed::Response> response;
+  switch (operation) {
+    case List: {
+      std::string status = ListStatuses[worker->random() % 4];
+      response = Send("GET", "/issues?status=" + status);
+      break;
+    }
+    case Get:
+      response = Send("GET", "/issues/" + issueId);
+      break;
+    case Create: {
+      json issue = {{"title", "Load test issue"},
+                    {"status", "New"},
+                    {"createdBy", worker->userId},
+                    {"reporter", worker->userId}};
+      response = Send("POST", "/issues", issue.dump());
+      json created = ResponseUtilities::HandleResponse(response);
+      if (created.is_object() && created.contains("id")) {
+        std::lock_guard<std::mutex> lock(_issuesMutex);
+        _issueIds.push_back(created["id"]);
+      }
+      break;
+    }
+    case Comment: {
+      json comment = {{"issueId", issueId},
+                      {"body", "Load test comment"},
+                      {"createdBy", worker->userId}};
+      response = Send("POST", "/comments", comment.dump());
+      break;
+    }
+    case Vote:
+    default: {
+      // The server casts the vote, or removes it if the user already voted
+      json body = {{"issueId", issueId}, {"createdBy", worker->userId}};
+      response = Send("POST", "/issues/" + issueId + "/votes", body.dump());
+      break;
+    }
+  }
+
+  int statusCode = response->get_status_code();
+  return statusCode >= 200 && statusCode < 400;
+}
+
+std::shared_ptr<restbed::Response> LoadGenerator::Send(
+    const std::string& method, const std::string& endpoint,
+    const std::string& body) {
+  auto request = RequestUtilities::CreateGenericRequest(_options.serverUri,
+                                                        endpoint, method);
+  if (!body.empty()) {
+    request->set_header("Content-Length", std::to_string(body.length()));
+    request->set_body(body);
+  }
+  return RequestUtilities::Send(request);
+}
+
+std::string LoadGenerator::RandomIssue(Worker* worker) {
+  std::lock_guard<std::mutex> lock(_issuesMutex);
+  if (_issueIds.empty()) return "";
+  return _issueIds[worker->random() % _issueIds.size()];
+}
+
+uint64_t LoadGenerator::Errors() const {
+  uint64_t errors = 0;
+  for (auto& results : _results) errors += results.errors;
+  return errors;
+}
+
+void LoadGenerator::Report(std::ostream& out, bool asJson) const {
+  double seconds = _elapsed.count();
+  LatencyHistogram all;
+  for (auto& results : _results) all.Merge(results.latency);
+
+  // Operations that never ran are left out, but the total is always reported
+  std::vector<std::pair<std::string, const Results*>> rows;
+  for (int i = 0; i < OperationCount; i++) {
+    if (_results[i].latency.Count() > 0) {
+      rows.push_back({OperationNames[i], &_results[i]});
+    }
+  }
+  Results total;
+  total.latency = all;
+  total.errors = Errors();
+  rows.push_back({"all", &total});
+
+  if (asJson) {
+    json report = {{"duration", seconds},
+                   {"concurrency", _options.concurrency},
+                   {"targetRate", _options.rate},
+                   {"operations", json::object()}};
+    for (auto& row : rows) {
+      const LatencyHistogram& latency = row.second->latency;
+      json operation = {
+          {"count", latency.Count()},
+          {"errors", row.second->errors},
+          {"throughput", seconds > 0 ? latency.Count() / seconds : 0},
+          {"meanMicros", latency.Mean()},
+          {"maxMicros", latency.Max()}};
+      for (double percentile : Percentiles) {
+        std::stringstream name;
+        name << "p" << percentile << "Micros";
+        operation[name.str()] = latency.Percentile(percentile);
+      }
+      report["operations"][row.first] = operation;
+    }
+    out << report.dump() << std::endl;
+    return;
+  }
+
+  out << "Sent " << all.Count() << " requests in " << std::fixed
+      << std::setprecision(1) << seconds << "s with " << _options.concurrency
+      << " workers";
+  if (seconds > 0) out << " (" << all.Count() / seconds << " requests/s";
+  if (_options.rate > 0) out << ", target " << _options.rate << " requests/s";
+  if (seconds > 0) out << ")";
+  out << ": " << Errors() << " failed" << std::endl << std::endl;
+
+  out << std::left << std::setw(9) << "operation" << std::right
+      << std::setw(9) << "count" << std::setw(8) << "errors" << std::setw(10)
+      << "req/s" << std::setw(9) << "mean" << std::setw(9) << "p50"
+      << std::setw(9) << "p90" << std::setw(9) << "p99" << std::setw(9)
+      << "p99.9" << std::setw(9) << "max" << "  (ms)" << std::endl;
+  for (auto& row : rows) {
+    const LatencyHistogram& latency = row.second->latency;
+    out << std::left << std::setw(9) << row.first << std::right
+        << std::setw(9) << latency.Count() << std::setw(8) << row.second->errors
+        << std::setw(10) << std::setprecision(1)
+        << (seconds > 0 ? latency.Count() / seconds : 0) << std::setw(9)
+        << Milliseconds(latency.Mean());
+    for (double percentile : Percentiles) {
+      out << std::setw(9) << Milliseconds(latency.Percentile(percentile));
+    }
+    out << std::setw(9) << Milliseconds(latency.Max()) << std::endl;
+  }
+}
@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "LoadGenerator.h"
+#include "cxxopts.hpp"
+
+int main(int argc, char* argv[]) {
+  cxxopts::Options options(
+      "hotTicket-load",
+      "Drives a hotTicket server with a mix of requests and reports the "
+      "throughput and latency of each kind");
+  // clang-format off
+  options.add_options()
+    ("u,url", "URI of the server",
+              cxxopts::value<std::string>()->default_value(
+                  "http://localhost:8080"))
+    ("m,mix", "Workload profile (read-heavy, mixed, write-heavy) or weights, "
+              "i.e. list=40,get=40,create=10,comment=5,vote=5",
+              cxxopts::value<std::string>()->default_value("mixed"))
+    ("r,rate", "Requests per second to schedule (open loop). 0 sends them as "
+               "fast as the workers can (closed loop)",
+               cxxopts::value<double>()->default_value("0"))
+    ("c,concurrency", "Number of workers sending requests at once",
+                      cxxopts::value<std::size_t>()->default_value("16"))
+    ("d,duration", "Seconds to send requests for",
+                   cxxopts::value<double>()->default_value("30"))
+    ("seed", "Seed for picking operations and entities",
+             cxxopts::value<uint64_t>()->default_value("1"))
+    ("json", "Write the report as JSON",
+             cxxopts::value<bool>()->default_value("false"))
+    ("h,help", "Print help text");
+  // clang-format on
+
+  try {
+    auto result = options.parse(argc, argv);
+    if (result.count("help")) {
+      std::cout << options.help() << std::endl;
+      return EXIT_SUCCESS;
+    }
+
+    LoadGenerator::Options loadOptions;
+    loadOptions.serverUri = result["url"].as<std::string>();
+    loadOptions.mix = LoadGenerator::ParseMix(result["mix"].as<std::string>());
+    loadOptions.rate = result["rate"].as<double>();
+    loadOptions.concurrency = result["concurrency"].as<std::size_t>();
+    loadOptions.duration = result["duration"].as<double>();
+    loadOptions.seed = result["seed"].as<uint64_t>();
+
+    LoadGenerator generator(loadOptions);
+    generator.Prepare();
+    generator.Run();
+    generator.Report(std::cout, result["json"].as<bool>());
+    return generator.Errors() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  } catch (const std::exception& e) {
+    std::cout << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
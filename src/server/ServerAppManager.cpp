@@ -2,19 +2,28 @@
 
 #include <restbed>
 
+#include <signal.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
 
+#include "AllocationStats.h"
+#include "ChangeController.hpp"
+#include "ChangeLog.h"
 #include "CommentController.hpp"
 #include "CommentService.h"
 #include "IssueController.hpp"
 #include "IssueService.h"
 #include "Logger.hpp"
+#include "QueryCache.h"
+#include "RequestCoalescer.h"
+#include "Transaction.h"
 #include "UserController.hpp"
 #include "UserService.h"
 #include "Utilities.h"
@@ -37,6 +46,9 @@ bool ServerAppManager::Init(int argc, char* argv[]) {
                 cxxopts::value<bool>()->default_value("false"))
     ("p,port", "Port to run the server on",
                cxxopts::value<int>()->default_value("8080"))
+    ("query-cache-mb", "Megabytes of list responses to cache for each "
+                       "collection, or 0 to not cache them",
+               cxxopts::value<int>()->default_value("64"))
     ("h, help", "Print help text");
   // clang-format om
 
@@ -53,6 +65,7 @@ bool ServerAppManager::Init(int argc, char* argv[]) {
   try {
     config.debug = result["debug"].as<bool>();
     config.port = result["port"].as<int>();
+    config.queryCacheMB = result["query-cache-mb"].as<int>();
     this->_config = config;
     return true;
   } catch (const std::exception& e) {
@@ -70,12 +83,64 @@ void ServerAppManager::Run() {
       std::make_shared<CommentService>(userService);
   std::shared_ptr<IssueService> issueService =
       std::make_shared<IssueService>(userService, commentService, voteService);
+  // Votes are only cast for issues that exist
+  voteService->SetIssueService(issueService);
+
+  // Every change the services save is recorded in one ChangeLog
+  auto changeLog = std::make_shared<ChangeLog>();
+  userService->SetChangeLog(changeLog, "users");
+  voteService->SetChangeLog(changeLog, "votes");
+  commentService->SetChangeLog(changeLog, "comments");
+  issueService->SetChangeLog(changeLog, "issues");
+
+  // Changes to more than one collection are saved through a journal. A
+  // commit the server stopped part way through is finished before starting
+  auto journal = std::make_shared<Journal>("journal.json");
+  std::size_t recovered = journal->Recover(
+      {issueService.get(), commentService.get(), voteService.get(),
+       userService.get()});
+  if (recovered > 0) {
+    std::cout << "Finished an interrupted commit of " << recovered
+              << " changes" << std::endl;
+  }
+  issueService->SetJournal(journal);
 
   // Create the controllers
   UserController<restbed::Session> userController(userService);
   VoteController<restbed::Session> voteController(voteService);
   CommentController<restbed::Session> commentController(commentService);
   IssueController<restbed::Session> issueController(issueService);
+  ChangeController<restbed::Session> changeController(changeLog);
+
+  // Identical GET requests made at the same time share one response. Keys
+  // include the endpoint, so the controllers share the coalescer
+  auto coalescer = std::make_shared<RequestCoalescer>();
+  userController.SetCoalescer(coalescer);
+  voteController.SetCoalescer(coalescer);
+  commentController.SetCoalescer(coalescer);
+  issueController.SetCoalescer(coalescer);
+
+  // List responses are cached, and the changes recorded in the ChangeLog drop
+  // the ones they alter. Issues list the ids of their comments and votes
+  if (_config.queryCacheMB > 0) {
+    std::size_t capacity =
+        static_cast<std::size_t>(_config.queryCacheMB) << 20;
+    auto userCache = std::make_shared<QueryCache>("users", capacity);
+    auto voteCache = std::make_shared<QueryCache>("votes", capacity);
+    auto commentCache = std::make_shared<QueryCache>("comments", capacity);
+    auto issueCache = std::make_shared<QueryCache>("issues", capacity);
+    issueCache->Depend("comments", "issueId");
+    issueCache->Depend("votes", "issueId");
+
+    for (auto& cache : {userCache, voteCache, commentCache, issueCache}) {
+      changeLog->Subscribe(
+          [cache](const Change& change) { cache->Invalidate(change); });
+    }
+    userController.SetQueryCache(userCache);
+    voteController.SetQueryCache(voteCache);
+    commentController.SetQueryCache(commentCache);
+    issueController.SetQueryCache(issueCache);
+  }
 
   // Get the resources from the controllers
   auto usersResource = userController.resource;
@@ -88,7 +153,24 @@ void ServerAppManager::Run() {
       std::make_shared<restbed::Resource>();
   alive->set_path("/alive");
   alive->set_method_handler("GET", [&](const Session& session) {
-    session->close(restbed::OK, "", ResponseUtilities::BuildResponseHeaders());
+    ResponseUtilities::Respond(session, restbed::OK, "",
+                               ResponseUtilities::BuildResponseHeaders());
+  });
+
+  // Create a resource reporting the allocations of the requests served, which
+  // are only counted by instrumented builds. DELETE starts the counts over
+  std::shared_ptr<restbed::Resource> allocations =
+      std::make_shared<restbed::Resource>();
+  allocations->set_path("/metrics/allocations");
+  allocations->set_method_handler("GET", [&](const Session& session) {
+    std::string body = AllocationStats::Snapshot().dump();
+    ResponseUtilities::Respond(session, restbed::OK, body,
+                               ResponseUtilities::BuildResponseHeaders(body));
+  });
+  allocations->set_method_handler("DELETE", [&](const Session& session) {
+    AllocationStats::Reset();
+    ResponseUtilities::Respond(session, restbed::OK, "",
+                               ResponseUtilities::BuildResponseHeaders());
   });
 
   // Create the service settings
@@ -97,6 +179,11 @@ void ServerAppManager::Run() {
   // Set the address and port of the service
   settings->set_bind_address(address);
   settings->set_port(_config.port);
+  // Requests waiting on /changes hold a worker, so only half of the workers
+  // may wait, and the rest of the API is always served
+  unsigned int workers = std::max(4u, std::thread::hardware_concurrency());
+  settings->set_worker_limit(workers);
+  changeController.SetMaxWaiters(workers / 2);
 
   // Create the service
   restbed::Service service;
@@ -106,7 +193,19 @@ void ServerAppManager::Run() {
   service.publish(votesResource);
   service.publish(commentsResource);
   service.publish(issuesResource);
+  service.publish(userController.bulkResource);
+  service.publish(voteController.bulkResource);
+  service.publish(commentController.bulkResource);
+  service.publish(issueController.bulkResource);
+  service.publish(changeController.resource);
   service.publish(alive);
+  service.publish(allocations);
+
+  // Stop cleanly when interrupted or killed, so the server returns through
+  // main. Profile-guided builds only write their profile when it does
+  auto stop = [&service](const int /*signal*/) { service.stop(); };
+  service.set_signal_handler(SIGINT, stop);
+  service.set_signal_handler(SIGTERM, stop);
 
   // Create a logger, if the user requested it
   if (_config.debug) {
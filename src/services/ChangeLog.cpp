@@ -0,0 +1,108 @@
+#include "ChangeLog.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Exceptions.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+void to_json(json& j, const Change& change) {
+  j = json{{"sequence", change.sequence}, {"collection", change.collection},
+           {"op", change.op},             {"id", change.id},
+           {"entity", change.entity},     {"at", change.at}};
+}
+
+ChangeLog::ChangeLog(std::size_t capacity)
+    : _capacity(capacity > 0 ? capacity : 1) {
+  // The time the log was created, in milliseconds, is different every time
+  // the server starts
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  _epoch = std::to_string(now.count());
+}
+
+uint64_t ChangeLog::Append(const std::string& collection,
+                           const std::string& op, const std::string& id,
+                           const json& entity) {
+  Change change;
+  change.collection = collection;
+  change.op = op;
+  change.id = id;
+  change.entity = entity;
+  change.at =
+      TimeUtilities::ConvertTimeToString(TimeUtilities::CurrentTimeUTC());
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    change.sequence = ++_latest;
+    _changes.push_back(change);
+
+    // Drop the oldest changes once the log is full
+    while (_changes.size() > _capacity) {
+      _changes.pop_front();
+    }
+
+    // Subscribers are called under the lock, so they see the changes in order
+    for (auto& subscriber : _subscribers) {
+      subscriber(change);
+    }
+  }
+  _appended.notify_all();
+
+  return change.sequence;
+}
+
+void ChangeLog::Subscribe(std::function<void(const Change&)> subscriber) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _subscribers.push_back(std::move(subscriber));
+}
+
+std::vector<Change> ChangeLog::Since(uint64_t since, std::size_t limit) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  // The caller missed changes if the one after since has been dropped
+  if (!_changes.empty() && since + 1 < _changes.front().sequence) {
+    throw GoneError(
+        std::string("The changes after " + std::to_string(since) +
+                    " are no longer kept. The oldest change is " +
+                    std::to_string(_changes.front().sequence))
+            .c_str());
+  }
+
+  std::vector<Change> changes;
+  if (_changes.empty() || since >= _latest) {
+    return changes;
+  }
+
+  // Sequence numbers have no gaps, so the first change after since can be
+  // found without searching
+  std::size_t start = 0;
+  if (since >= _changes.front().sequence) {
+    start = since + 1 - _changes.front().sequence;
+  }
+  for (std::size_t i = start; i < _changes.size() && changes.size() < limit;
+       i++) {
+    changes.push_back(_changes[i]);
+  }
+  return changes;
+}
+
+bool ChangeLog::WaitForChanges(uint64_t since,
+                               std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _appended.wait_for(lock, timeout,
+                            [&]() { return _latest > since; });
+}
+
+uint64_t ChangeLog::Latest() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _latest;
+}
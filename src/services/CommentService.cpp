@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <map>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Comment.h"
@@ -13,32 +15,26 @@
 using json = nlohmann::json;
 
 std::vector<Comment> CommentService::Get(
-    const std::multimap<std::string, std::string> queryParams) {
+    const std::multimap<std::string, std::string>& queryParams) {
   std::vector<Comment> comments;
-  json jsonFile = _fileHandler->read();
-
-  json filtered = Filter(jsonFile, queryParams);
 
-  for (auto& comment : filtered) {
+  // Users are shared between all of the Comments
+  UserResolver users(*_userService);
+  ForEachMatch(queryParams, [&](const json& comment) {
     Comment temp = comment.get<Comment>();
-
-    User createdBy = _userService->Get(std::string(temp.createdBy.id));
-    temp.createdBy = createdBy;
-
-    if (!temp.updatedBy.id.empty()) {
-      temp.updatedBy = _userService->Get(std::string(temp.updatedBy.id));
-    }
-    comments.push_back(temp);
-  }
+    temp.createdBy = users.Resolve(temp.createdBy.id);
+    temp.updatedBy = users.Resolve(temp.updatedBy.id);
+    comments.push_back(std::move(temp));
+  });
 
   return comments;
 }
 
-Comment CommentService::Get(std::string id) {
-  json jsonFile = _fileHandler->read();
+Comment CommentService::Get(const std::string& id) {
+  json jsonFile = Load();
 
   // Get the comment by the id
-  json filtered = Filter(jsonFile, {{"id", id}});
+  FilterView filtered = Filter(jsonFile, {{"id", id}});
 
   // If the user was not found
   if (filtered.empty()) {
@@ -47,15 +43,14 @@ Comment CommentService::Get(std::string id) {
             .c_str());
   }
   Comment comment;
-  comment = filtered[0].get<Comment>();
-  comment.createdBy = _userService->Get(std::string(comment.createdBy.id));
-  if (!comment.updatedBy.id.empty()) {
-    comment.updatedBy = _userService->Get(std::string(comment.updatedBy.id));
-  }
+  comment = filtered.front().get<Comment>();
+  UserResolver users(*_userService);
+  comment.createdBy = users.Resolve(comment.createdBy.id);
+  comment.updatedBy = users.Resolve(comment.updatedBy.id);
   return comment;
 }
 
-Comment CommentService::Create(std::string body) {
+Comment CommentService::Create(const std::string& body) {
   json commentToCreate;
   try {
     commentToCreate = json::parse(body);
@@ -67,35 +62,88 @@ Comment CommentService::Create(std::string body) {
             .c_str());
   }
 
-  // We explicitly ignore these values when creating comments
-  commentToCreate["updatedAt"] = "";
-  commentToCreate["updatedBy"] = "";
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsonFile = _fileHandler->read();
+  Comment comment = ApplyCreate(jsonFile, std::move(commentToCreate));
+  Save(jsonFile);
 
-  // We also ignore any specified date and compute this ourselves
-  commentToCreate["createdAt"] = "";
+  return comment;
+}
+
+Comment CommentService::Update(const std::string& body) {
+  json updatedComment;
+  try {
+    updatedComment = json::parse(body);
+  }
 
+  catch (std::exception& e) {
+    throw BadRequestError(
+        std::string(
+            "The Comment could not be created because of a parsing error. "
+            "The invalid Comment information is: " +
+            body)
+            .c_str());
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsFile = _fileHandler->read();
+  Comment updated = ApplyUpdate(jsFile, std::move(updatedComment));
+  Save(jsFile);
+
+  return updated;
+}
+
+Comment CommentService::Patch(const std::string& id, const std::string& body) {
+  json patch = ParsePatch(body);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsonFile = _fileHandler->read();
+  Comment comment = ApplyPatch(jsonFile, id, std::move(patch));
+  Save(jsonFile);
+
+  return comment;
+}
+
+bool CommentService::Delete(const std::string& id) {
+  return Delete(id, AnyVersion);
+}
+
+bool CommentService::Delete(const std::string& id, int expectedVersion) {
+  std::lock_guard<std::mutex> lock(_mutex);
   json jsonFile = _fileHandler->read();
+  ApplyDelete(jsonFile, id, expectedVersion);
+  Save(jsonFile);
+  return true;
+}
+
+Comment CommentService::ApplyCreate(json& collection, json body) {
+  // We explicitly ignore these values when creating comments
+  body["updatedAt"] = "";
+  body["updatedBy"] = "";
+
+  // We also ignore any specified date and compute this ourselves
+  body["createdAt"] = "";
 
   Comment comment;
   try {
     // Attempt to deserialize the json body.
-    comment = commentToCreate.get<Comment>();
+    comment = body.get<Comment>();
   } catch (std::exception& e) {
     throw BadRequestError(
         std::string(
             "Unable to create a comment using the following information: " +
-            body)
+            body.dump())
             .c_str());
   }
   // Ignore any id value provided
   comment.id = GenerateId();
   // If the file has a comment with that id, generate a new one
-  while (!Filter(jsonFile, {{"id", comment.id}}).empty()) {
+  while (!Filter(collection, {{"id", comment.id}}).empty()) {
     comment.id = GenerateId();
   }
 
   // Get the user from the User Service
-  comment.createdBy = _userService->Get(std::string(comment.createdBy.id));
+  comment.createdBy = _userService->Get(comment.createdBy.id);
 
   // Set the created time to right now (in UTC time)
   comment.createdAt = TimeUtilities::CurrentTimeUTC();
@@ -106,74 +154,104 @@ Comment CommentService::Create(std::string body) {
   // Similarly, we set the updated time to the "null time"
   comment.updatedAt = TimeUtilities::NullTimeUTC();
 
-  jsonFile.push_back(comment);
-  _fileHandler->write(jsonFile);
+  // Newly created comments start at the first version
+  comment.version = 1;
 
+  collection.push_back(comment);
+  Record("create", comment.id, collection.back());
   return comment;
 }
 
-Comment CommentService::Update(std::string body) {
-  json updatedComment;
-  try {
-    updatedComment = json::parse(body);
-  }
+Comment CommentService::ApplyUpdate(json& collection, json body) {
+  // Ignore the updatedAt date provided, calculate it ourself to ensure
+  // consistency
+  body["updatedAt"] = "";
 
-  catch (std::exception& e) {
-    throw BadRequestError(
-        std::string(
-            "The Comment could not be created because of a parsing error. "
-            "The invalid Comment information is: " +
-            body)
+  Comment updated = body.get<Comment>();
+  int expectedVersion = ExpectedVersion(body);
+
+  auto itComment = FindById(collection, updated.id);
+  // If the Comment we want to update doesn't exist
+  if (itComment == collection.end()) {
+    throw NotFoundError(
+        std::string("The User could not be found with the following id: " +
+                    updated.id)
             .c_str());
   }
+  // Make sure nobody else has updated the Comment since the caller read it
+  CheckVersion(*itComment, expectedVersion);
 
-  // Ignore the updatedAt date provided, calculate it ourself to ensure
-  // consistency
-  updatedComment["updatedAt"] = "";
+  // Get the creator and updater users from the UserService
+  updated.createdBy = _userService->Get(updated.createdBy.id);
+  updated.updatedBy = _userService->Get(updated.updatedBy.id);
 
-  Comment updated = updatedComment.get<Comment>();
-  json jsFile = _fileHandler->read();
-  auto itComment = std::find_if(
-      jsFile.begin(), jsFile.end(),
-      [&](const json& item) { return item["id"] == updatedComment["id"]; });
-  // If the Comment we want to update exists
-  if (itComment != jsFile.end()) {
-    // Get the creator and updater users from the UserService
-    updated.createdBy = _userService->Get(std::string(updated.createdBy.id));
-    updated.updatedBy = _userService->Get(std::string(updated.updatedBy.id));
+  updated.updatedAt = TimeUtilities::CurrentTimeUTC();
+  updated.version = itComment->value("version", 0) + 1;
+
+  *itComment = updated;
+  Record("update", updated.id, *itComment);
+  return updated;
+}
 
-    updated.updatedAt = TimeUtilities::CurrentTimeUTC();
+Comment CommentService::ApplyPatch(json& collection, const std::string& id,
+                                   json patch) {
+  CheckPatch(id, patch, {"body", "updatedBy"});
+  int expectedVersion = ExpectedVersion(patch);
+  patch.erase("version");
 
-    *itComment = updated;
+  if (patch.contains("body") && !patch["body"].is_string()) {
+    throw BadRequestError("The body of a Comment must be a string");
+  }
 
-    _fileHandler->write(jsFile);
-  } else {
+  // Only look up the updater if it is being changed
+  if (patch.contains("updatedBy")) {
+    if (!patch["updatedBy"].is_string() ||
+        patch["updatedBy"].get<std::string>().empty()) {
+      throw BadRequestError("The updatedBy of a Comment must be a User id");
+    }
+    _userService->Get(patch["updatedBy"].get<std::string>());
+  }
+
+  auto itComment = FindById(collection, id);
+  if (itComment == collection.end()) {
     throw NotFoundError(
-        std::string("The User could not be found with the following id: " +
-                    updatedComment["id"].get<std::string>())
+        std::string("The comment could not be found with the following id: " +
+                    id)
             .c_str());
   }
-  return updated;
-}
+  CheckVersion(*itComment, expectedVersion);
 
-bool CommentService::Delete(std::string id) {
-  json jsonFile = _fileHandler->read();
+  itComment->merge_patch(patch);
+  (*itComment)["updatedAt"] =
+      TimeUtilities::ConvertTimeToString(TimeUtilities::CurrentTimeUTC());
+  (*itComment)["version"] = itComment->value("version", 0) + 1;
 
+  // Comments are serialized with the ids of their users, so the stored comment
+  // is all the caller needs
+  Comment patched = itComment->get<Comment>();
+  Record("patch", id, *itComment);
+  return patched;
+}
+
+void CommentService::ApplyDelete(json& collection, const std::string& id,
+                                 int expectedVersion) {
   // Find the comment with the passed in id
-  auto itcomment =
-      std::find_if(jsonFile.begin(), jsonFile.end(),
-                   [&](const json& item) { return item["id"] == id; });
-
-  // If the comment was found
-  if (itcomment != jsonFile.end()) {
-    jsonFile.erase(itcomment);
-    _fileHandler->write(jsonFile);
-    return true;
-  } else {
+  auto itcomment = FindById(collection, id);
+
+  // If the comment was not found
+  if (itcomment == collection.end()) {
     throw NotFoundError(
         std::string("The comment could not be found with the following id: " +
                     id)
             .c_str());
   }
-  return false;
+  CheckVersion(*itcomment, expectedVersion);
+  collection.erase(itcomment);
+  Record("delete", id);
+}
+
+uint64_t CommentService::Generation() {
+  uint64_t generation = _generation;
+  if (_userService) generation += _userService->Generation();
+  return generation;
 }
@@ -1,11 +1,16 @@
 #include "IssueService.h"
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "AllocationStats.h"
 #include "Comment.h"
 #include "FileHandler.h"
 #include "Issue.h"
@@ -15,116 +20,186 @@
 
 using json = nlohmann::json;
 
+namespace {
+/**
+ * @return the rows of the issues with every field of a query
+ */
+std::vector<std::size_t> MatchingRows(const IssueTable& table,
+                                      const StringMap& query) {
+  if (IssueTable::Covers(query)) return table.Select(query).Rows();
+
+  std::vector<std::size_t> rows;
+  for (std::size_t row = 0; row < table.size(); row++) {
+    if (FilterView::Matches(table.Issues()[row], query)) rows.push_back(row);
+  }
+  return rows;
+}
+}  // namespace
+
 std::vector<Issue> IssueService::Get(
-    const std::multimap<std::string, std::string> queryParams) {
+    const std::multimap<std::string, std::string>& queryParams) {
   std::vector<Issue> issues;
-  json jsonFile = _fileHandler->read();
-
-  json filteredIssues = Filter(jsonFile, queryParams);
-
-  for (auto& _issue : filteredIssues) {
-    Issue issue = _issue.get<Issue>();
-
-    // createdBy and reporter are mandotory fields, so we get them automatically
-    issue.createdBy = _userService->Get(std::string(issue.createdBy.id));
-    issue.reporter = _userService->Get(std::string(issue.reporter.id));
-
-    // updatedBy and assignedTo might not have value, so we need to check first
-    if (!issue.updatedBy.id.empty())
-      issue.updatedBy = _userService->Get(std::string(issue.updatedBy.id));
+  std::shared_ptr<const IssueTable> table = LoadTable();
 
-    if (!issue.assignedTo.id.empty())
-      issue.assignedTo = _userService->Get(std::string(issue.assignedTo.id));
-
-    issue.votes = _voteService->Get(StringMap{{"issueId", issue.id}});
-    auto comments = _commentService->Get(StringMap{{"issueId", issue.id}});
-    issue.comments = std::multiset<Comment>(comments.begin(), comments.end());
+  std::vector<std::size_t> rows;
+  if (!ListOptions::Requested(queryParams)) {
+    rows = MatchingRows(*table, queryParams);
+  } else {
+    StringMap filters;
+    ListOptions options = ListOptions::Parse(queryParams, &filters);
+    if (filters.empty()) {
+      rows = table->Times().Select(nullptr, options);
+    } else {
+      std::vector<std::size_t> matches = MatchingRows(*table, filters);
+      rows = table->Times().Select(&matches, options);
+    }
+  }
 
-    issues.push_back(issue);
+  // Building the Issues, with their users, votes and comments. Users are
+  // shared between all of the Issues
+  AllocationStats::Phase phase("hydrate");
+  UserResolver users(*_userService);
+  for (std::size_t row : rows) {
+    issues.push_back(Hydrate(table->Issues()[row], &users));
   }
 
   return issues;
 }
 
-Issue IssueService::Get(const std::string id) {
-  json jsonFile = _fileHandler->read();
-
-  json filtered = Filter(jsonFile, {{"id", id}});
+Issue IssueService::Get(const std::string& id) {
+  std::shared_ptr<const IssueTable> table = LoadTable();
 
-  if (filtered.empty()) {
+  std::vector<std::size_t> rows = table->Select({{"id", id}}).Rows();
+  if (rows.empty()) {
     throw NotFoundError(
         std::string("An issue could not be found with the following id: " + id)
             .c_str());
   }
 
-  Issue issue = filtered[0].get<Issue>();
+  AllocationStats::Phase phase("hydrate");
+  UserResolver users(*_userService);
+  return Hydrate(table->Issues()[rows.front()], &users);
+}
+
+Issue IssueService::Create(const std::string& body) {
+  json issueToCreate;
+  try {
+    issueToCreate = json::parse(body);
+  } catch (const std::exception& exp) {
+    std::cout << exp.what() << std::endl;
+    throw BadRequestError(
+        std::string(
+            "An error occured parsing the following issue information: " + body)
+            .c_str());
+  }
+
+  // The issue and its description are saved together
+  return Transact<Issue>([&](json& issues) {
+    return ApplyCreate(issues, std::move(issueToCreate));
+  });
+}
+
+Issue IssueService::Update(const std::string& body) {
+  json updatedIssue;
+  try {
+    updatedIssue = json::parse(body);
+  } catch (std::exception& e) {
+    std::cout << e.what() << std::endl;
+    throw BadRequestError(
+        std::string(
+            "The Issue could not be created because of a parsing error. "
+            "The invalid Issue information is: " +
+            body)
+            .c_str());
+  }
 
-  // createdBy and reporter are mandotory fields, so we get them automatically
-  issue.createdBy = _userService->Get(std::string(issue.createdBy.id));
-  issue.reporter = _userService->Get(std::string(issue.reporter.id));
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsFile = _fileHandler->read();
+  Issue updated = ApplyUpdate(jsFile, std::move(updatedIssue));
+  Save(jsFile);
 
-  // updatedBy and assignedTo might not have value, so we need to check first
-  if (!issue.updatedBy.id.empty())
-    issue.updatedBy = _userService->Get(std::string(issue.updatedBy.id));
+  return updated;
+}
 
-  if (!issue.assignedTo.id.empty())
-    issue.assignedTo = _userService->Get(std::string(issue.assignedTo.id));
+Issue IssueService::Patch(const std::string& id, const std::string& body) {
+  json patch = ParsePatch(body);
 
-  issue.votes = _voteService->Get(StringMap{{"issueId", issue.id}});
-  auto comments = _commentService->Get(StringMap{{"issueId", issue.id}});
-  issue.comments = std::multiset<Comment>(comments.begin(), comments.end());
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsonFile = _fileHandler->read();
+  Issue issue = ApplyPatch(jsonFile, id, std::move(patch));
+  Save(jsonFile);
 
   return issue;
 }
 
-Issue IssueService::Create(std::string body) {
-  json issueToCreate;
+bool IssueService::Delete(const std::string& id) {
+  return Delete(id, AnyVersion);
+}
+
+bool IssueService::Delete(const std::string& id, int expectedVersion) {
+  // The issue, its comments and its votes are deleted together
+  return Transact<bool>([&](json& issues) {
+    ApplyDelete(issues, id, expectedVersion);
+    return true;
+  });
+}
+
+std::vector<BulkResult<Issue>> IssueService::Bulk(const json& operations) {
+  return Transact<std::vector<BulkResult<Issue>>>([&](json& issues) {
+    bool changed = false;
+    return ApplyBulk(issues, operations, &changed);
+  });
+}
+
+void IssueService::SetJournal(const std::shared_ptr<Journal>& journal) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _journal = journal;
+}
+
+Issue IssueService::ApplyCreate(json& collection, json body) {
+  // Create the description from the the optional description field of the
+  // request json
   std::string description;
   try {
-    issueToCreate = json::parse(body);
-
-    // Create the description from the the optional description field of the
-    // request json
-    if (issueToCreate.find("description") != issueToCreate.end()) {
-      description = issueToCreate["description"].get<std::string>();
+    if (body.find("description") != body.end()) {
+      description = body["description"].get<std::string>();
     }
   } catch (const std::exception& exp) {
     std::cout << exp.what() << std::endl;
     throw BadRequestError(
-        std::string(
-            "An error occured parsing the following issue information: " + body)
+        std::string("An error occured parsing the following issue "
+                    "information: " +
+                    body.dump())
             .c_str());
   }
 
   // We explicitly ignore these values when creating issues
-  issueToCreate["updatedAt"] = "";
-  issueToCreate["updatedBy"] = "";
+  body["updatedAt"] = "";
+  body["updatedBy"] = "";
 
   // We also ignore any specified date and compute this ourselves
-  issueToCreate["createdAt"] = "";
-
-  json jsonFile = _fileHandler->read();
+  body["createdAt"] = "";
 
   Issue issue;
   try {
-    issue = issueToCreate.get<Issue>();
+    issue = body.get<Issue>();
   } catch (const std::exception& exp) {
     std::cout << exp.what() << std::endl;
     throw BadRequestError(
         std::string(
             "Unable to create an issue using the following information: " +
-            body)
+            body.dump())
             .c_str());
   }
 
   issue.id = GenerateId();
 
-  while (!Filter(jsonFile, {{"id", issue.id}}).empty()) {
+  while (!Filter(collection, {{"id", issue.id}}).empty()) {
     issue.id = GenerateId();
   }
 
   // Get the user from the User Service
-  issue.createdBy = _userService->Get(std::string(issue.createdBy.id));
+  issue.createdBy = _userService->Get(issue.createdBy.id);
 
   // Set the created time to right now (in UTC time)
   issue.createdAt = TimeUtilities::CurrentTimeUTC();
@@ -135,7 +210,7 @@ Issue IssueService::Create(std::string body) {
 
   // If we are provided assignedTo, set issue.assignedTo field to that
   if (!issue.assignedTo.id.empty()) {
-    issue.assignedTo = _userService->Get(std::string(issue.assignedTo.id));
+    issue.assignedTo = _userService->Get(issue.assignedTo.id);
   }
 
   // If we are provided a status, set issue.status field to that
@@ -146,7 +221,7 @@ Issue IssueService::Create(std::string body) {
   // If we are provided a reporter different than createdBy, set it
   // Else, reporter set to createdBy
   if (issue.reporter.id != issue.createdBy.id && !issue.reporter.id.empty()) {
-    issue.reporter = _userService->Get(std::string(issue.reporter.id));
+    issue.reporter = _userService->Get(issue.reporter.id);
   } else {
     issue.reporter = issue.createdBy;
   }
@@ -161,7 +236,7 @@ Issue IssueService::Create(std::string body) {
     temp.issueId = issue.id;
     temp.createdBy = issue.createdBy;
     temp.createdAt = issue.createdAt;
-    temp = _commentService->Create(json(temp).dump());
+    temp = _commentService->Create(_transaction, json(temp));
     // Set the comments set to have the newly created comment
     issue.comments = {};
     issue.comments.insert(temp);
@@ -170,83 +245,207 @@ Issue IssueService::Create(std::string body) {
   // Similarly, we set the updated time to the "null time"
   issue.updatedAt = TimeUtilities::NullTimeUTC();
 
-  jsonFile.push_back(issue);
-  _fileHandler->write(jsonFile);
+  // Newly created issues start at the first version
+  issue.version = 1;
 
+  collection.push_back(issue);
+  Record("create", issue.id, collection.back());
   return issue;
 }
 
-Issue IssueService::Update(std::string body) {
-  json updatedIssue;
-  try {
-    updatedIssue = json::parse(body);
-  } catch (std::exception& e) {
-    std::cout << e.what() << std::endl;
-    throw BadRequestError(
-        std::string(
-            "The Issue could not be created because of a parsing error. "
-            "The invalid Issue information is: " +
-            body)
-            .c_str());
-  }
-
+Issue IssueService::ApplyUpdate(json& collection, json body) {
   // Ignore the updatedAt date provided, calculate it ourself to ensure
   // consistency
-  updatedIssue["updatedAt"] = "";
+  body["updatedAt"] = "";
 
-  Issue updated = updatedIssue.get<Issue>();
-  json jsFile = _fileHandler->read();
-  auto itIssue = std::find_if(
-      jsFile.begin(), jsFile.end(),
-      [&](const json& item) { return item["id"] == updatedIssue["id"]; });
-  // If the issue we want to update exists
-  if (itIssue != jsFile.end()) {
-    // Get the creator, updater, assigned, and reporter users from the
-    // UserService
-    updated.createdBy = _userService->Get(std::string(updated.createdBy.id));
-    updated.updatedBy = _userService->Get(std::string(updated.updatedBy.id));
-    updated.assignedTo = _userService->Get(std::string(updated.assignedTo.id));
-    updated.reporter = _userService->Get(std::string(updated.reporter.id));
-
-    // Get the votes from our vote service
-    updated.votes = _voteService->Get({{"issueId", updated.id}});
-    // Get the comments from our comment service
-    std::vector<Comment> comments =
-        _commentService->Get({{"issueId", updated.id}});
-    std::multiset<Comment> ms(comments.begin(), comments.end());
-    updated.comments = ms;
-
-    updated.updatedAt = TimeUtilities::CurrentTimeUTC();
-
-    *itIssue = updated;
-
-    _fileHandler->write(jsFile);
-  } else {
+  Issue updated = body.get<Issue>();
+  int expectedVersion = ExpectedVersion(body);
+
+  auto itIssue = FindById(collection, updated.id);
+  // If the issue we want to update doesn't exist
+  if (itIssue == collection.end()) {
     throw NotFoundError(
         std::string("The Issue could not be found with the following id: " +
-                    updatedIssue["id"].get<std::string>())
+                    updated.id)
             .c_str());
   }
+  // Make sure nobody else has updated the issue since the caller read it
+  CheckVersion(*itIssue, expectedVersion);
+
+  // Get the creator, updater, assigned, and reporter users from the
+  // UserService
+  updated.createdBy = _userService->Get(updated.createdBy.id);
+  updated.updatedBy = _userService->Get(updated.updatedBy.id);
+  updated.assignedTo = _userService->Get(updated.assignedTo.id);
+  updated.reporter = _userService->Get(updated.reporter.id);
+
+  // Get the votes and comments of the issue
+  updated.votes = RelatedTo(_voteService.get(), updated.id);
+  std::vector<Comment> comments = RelatedTo(_commentService.get(), updated.id);
+  std::multiset<Comment> ms(comments.begin(), comments.end());
+  updated.comments = ms;
+
+  updated.updatedAt = TimeUtilities::CurrentTimeUTC();
+  updated.version = itIssue->value("version", 0) + 1;
+
+  *itIssue = updated;
+  Record("update", updated.id, *itIssue);
   return updated;
 }
 
-bool IssueService::Delete(std::string id) {
-  json jsonFile = _fileHandler->read();
+Issue IssueService::ApplyPatch(json& collection, const std::string& id,
+                               json patch) {
+  CheckPatch(id, patch,
+             {"title", "status", "reporter", "assignedTo", "updatedBy"});
+  int expectedVersion = ExpectedVersion(patch);
+  patch.erase("version");
+
+  for (const std::string field : {"title", "status"}) {
+    if (patch.contains(field) && !patch[field].is_string()) {
+      throw BadRequestError(
+          std::string("The " + field + " of an Issue must be a string")
+              .c_str());
+    }
+  }
 
+  // Only the users being changed are looked up. Removing the assignee
+  // (null) is allowed, but an issue always has a reporter
+  for (const std::string field : {"assignedTo", "reporter", "updatedBy"}) {
+    if (!patch.contains(field)) continue;
+    if (field == "assignedTo" && patch[field].is_null()) patch[field] = "";
+    if (!patch[field].is_string() ||
+        (field != "assignedTo" && patch[field].get<std::string>().empty())) {
+      throw BadRequestError(
+          std::string("The " + field + " of an Issue must be a User id")
+              .c_str());
+    }
+    if (!patch[field].get<std::string>().empty()) {
+      _userService->Get(patch[field].get<std::string>());
+    }
+  }
+
+  auto itIssue = FindById(collection, id);
+  if (itIssue == collection.end()) {
+    throw NotFoundError(
+        std::string("The Issue could not be found with the following id: " + id)
+            .c_str());
+  }
+  CheckVersion(*itIssue, expectedVersion);
+
+  itIssue->merge_patch(patch);
+  (*itIssue)["updatedAt"] =
+      TimeUtilities::ConvertTimeToString(TimeUtilities::CurrentTimeUTC());
+  (*itIssue)["version"] = itIssue->value("version", 0) + 1;
+
+  // Issues are serialized with the ids of their users, comments and votes, so
+  // the stored issue is all the caller needs
+  Issue patched = itIssue->get<Issue>();
+  Record("patch", id, *itIssue);
+  return patched;
+}
+
+void IssueService::ApplyDelete(json& collection, const std::string& id,
+                               int expectedVersion) {
   // Find the issue with the passed in id
-  auto itissue =
-      std::find_if(jsonFile.begin(), jsonFile.end(),
-                   [&](const json& item) { return item["id"] == id; });
-
-  // If the issue was found
-  if (itissue != jsonFile.end()) {
-    jsonFile.erase(itissue);
-    _fileHandler->write(jsonFile);
-    return true;
-  } else {
+  auto itissue = FindById(collection, id);
+
+  // If the issue was not found
+  if (itissue == collection.end()) {
     throw NotFoundError(
         std::string("The issue could not be found with the following id: " + id)
             .c_str());
   }
-  return false;
+  CheckVersion(*itissue, expectedVersion);
+  collection.erase(itissue);
+  Record("delete", id);
+
+  // The comments and votes of the issue go with it, in the same transaction
+  _commentService->DeleteMatching(_transaction, {{"issueId", id}});
+  _voteService->DeleteMatching(_transaction, {{"issueId", id}});
+}
+
+void IssueService::WhileIssueExists(const std::string& issueId,
+                                    const std::function<void()>& apply) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (ReadTable()->Count({{"id", issueId}}) == 0) {
+    throw NotFoundError(
+        std::string("The issue could not be found with the following id: " +
+                    issueId)
+            .c_str());
+  }
+  apply();
+}
+
+uint64_t IssueService::Generation() {
+  uint64_t generation = _generation;
+  // The generations only ever increase, so their sum does too
+  if (_userService) generation += _userService->Generation();
+  if (_commentService) generation += _commentService->Generation();
+  if (_voteService) generation += _voteService->Generation();
+  return generation;
+}
+
+template <typename Result, typename Apply>
+Result IssueService::Transact(Apply apply) {
+  Transaction transaction(_journal);
+  json& issues = transaction.Collection(this);
+  _transaction = &transaction;
+  try {
+    Result result = apply(issues);
+    transaction.Commit();
+    _transaction = nullptr;
+    return result;
+  } catch (...) {
+    _transaction = nullptr;
+    throw;
+  }
+}
+
+template <typename Related>
+std::vector<Related> IssueService::RelatedTo(EntityService<Related>* service,
+                                             const std::string& issueId) {
+  // A collection the transaction holds can't be read through its service
+  // until the transaction ends, and has the changes made so far
+  if (_transaction == nullptr || !_transaction->Holds(service)) {
+    return service->Get(StringMap{{"issueId", issueId}});
+  }
+
+  std::vector<Related> related;
+  for (const json& item :
+       Filter(_transaction->Collection(service), {{"issueId", issueId}})) {
+    related.push_back(item.get<Related>());
+  }
+  return related;
+}
+
+std::shared_ptr<const IssueTable> IssueService::LoadTable() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return ReadTable();
+}
+
+std::shared_ptr<const IssueTable> IssueService::ReadTable() {
+  uint64_t generation = _generation;
+  if (!_table || _tableGeneration != generation) {
+    _table = std::make_shared<const IssueTable>(_fileHandler->read());
+    _tableGeneration = generation;
+  }
+  return _table;
+}
+
+Issue IssueService::Hydrate(const json& stored, UserResolver* users) {
+  Issue issue = stored.get<Issue>();
+
+  // createdBy and reporter are mandotory fields, updatedBy and assignedTo
+  // resolve to no User when they are empty
+  issue.createdBy = users->Resolve(issue.createdBy.id);
+  issue.reporter = users->Resolve(issue.reporter.id);
+  issue.updatedBy = users->Resolve(issue.updatedBy.id);
+  issue.assignedTo = users->Resolve(issue.assignedTo.id);
+
+  issue.votes = _voteService->Get(StringMap{{"issueId", issue.id}});
+  auto comments = _commentService->Get(StringMap{{"issueId", issue.id}});
+  issue.comments =
+      std::multiset<Comment>(std::make_move_iterator(comments.begin()),
+                             std::make_move_iterator(comments.end()));
+  return issue;
 }
@@ -0,0 +1,237 @@
+#include "IssueTable.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "EntityId.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+const std::size_t WordBits = 64;
+
+std::size_t WordCount(std::size_t rows) {
+  return (rows + WordBits - 1) / WordBits;
+}
+
+/**
+ * Selects the rows of a column that equal a value. The inner loop has no
+ * branches, so the compiler can vectorize it
+ * @param column the column
+ * @param value the value the rows must have
+ * @param selection the selection to add the rows to
+ */
+template <typename T>
+void SelectEqual(const std::vector<T>& column, T value,
+                 IssueTable::Selection* selection) {
+  const T* data = column.data();
+  std::size_t rows = column.size();
+  for (std::size_t word = 0; word < selection->words.size(); word++) {
+    std::size_t begin = word * WordBits;
+    std::size_t end = std::min(rows, begin + WordBits);
+    uint64_t bits = 0;
+    for (std::size_t row = begin; row < end; row++) {
+      bits |= static_cast<uint64_t>(data[row] == value) << (row - begin);
+    }
+    selection->words[word] |= bits;
+  }
+}
+
+template <typename Key>
+const CompressedBitmap* Find(
+    const std::unordered_map<Key, CompressedBitmap>& index, const Key& key) {
+  auto found = index.find(key);
+  return found != index.end() ? &found->second : nullptr;
+}
+}  // namespace
+
+IssueTable::Selection::Selection(std::size_t rows, bool selected)
+    : words(WordCount(rows), selected ? ~uint64_t(0) : 0) {
+  // Rows past the end of the table are never selected
+  if (selected && rows % WordBits != 0) {
+    words.back() = (uint64_t(1) << (rows % WordBits)) - 1;
+  }
+}
+
+std::size_t IssueTable::Selection::Count() const {
+  std::size_t count = 0;
+  for (uint64_t word : words) {
+    count += __builtin_popcountll(word);
+  }
+  return count;
+}
+
+std::vector<std::size_t> IssueTable::Selection::Rows() const {
+  std::vector<std::size_t> rows;
+  rows.reserve(Count());
+  for (std::size_t word = 0; word < words.size(); word++) {
+    uint64_t bits = words[word];
+    while (bits != 0) {
+      rows.push_back(word * WordBits + __builtin_ctzll(bits));
+      bits &= bits - 1;
+    }
+  }
+  return rows;
+}
+
+void IssueTable::Selection::Clear() {
+  std::fill(words.begin(), words.end(), 0);
+}
+
+void IssueTable::Selection::And(const Selection& other) {
+  for (std::size_t word = 0; word < words.size(); word++) {
+    words[word] &= other.words[word];
+  }
+}
+
+IssueTable::IssueTable(json issues)
+    : _issues(std::move(issues)), _times(_issues) {
+  std::size_t rows = _issues.is_array() ? _issues.size() : 0;
+  _ids.reserve(rows);
+  _createdBy.reserve(rows);
+
+  // Rows are added to the bitmaps in order, which is the fastest way to
+  // build them
+  for (std::size_t row = 0; row < rows; row++) {
+    const json& issue = _issues[row];
+    _ids.push_back(IdColumnValue(issue, "id"));
+    _createdBy.push_back(IdColumnValue(issue, "createdBy"));
+
+    uint64_t assignedTo = IdColumnValue(issue, "assignedTo");
+    if (assignedTo != Missing) _assignedToRows[assignedTo].Add(row);
+    uint64_t reporter = IdColumnValue(issue, "reporter");
+    if (reporter != Missing) _reporterRows[reporter].Add(row);
+
+    auto status = issue.is_object() ? issue.find("status") : issue.end();
+    if (status != issue.end() && status->is_string()) {
+      _statusRows[status->get_ref<const std::string&>()].Add(row);
+    }
+  }
+}
+
+bool IssueTable::Covers(const Query& query) {
+  for (auto& param : query) {
+    if (param.first != "id" && param.first != "createdBy" &&
+        !Indexed(param.first)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+IssueTable::Selection IssueTable::Select(const Query& query) const {
+  Selection selection(size());
+  for (auto first = query.begin(); first != query.end();
+       first = query.upper_bound(first->first)) {
+    if (Indexed(first->first)) continue;
+
+    const std::vector<uint64_t>* column = IdColumn(first->first);
+    if (column == nullptr) {
+      selection.Clear();
+      return selection;
+    }
+
+    // The rows with any of the values of the field. An id nothing has isn't
+    // interned by the lookup, and matches no row
+    Selection matches(size(), false);
+    auto last = query.upper_bound(first->first);
+    for (auto param = first; param != last; ++param) {
+      EntityId id;
+      if (EntityId::Lookup(param->second, &id)) {
+        SelectEqual(*column, id.Value(), &matches);
+      }
+    }
+    selection.And(matches);
+  }
+
+  CompressedBitmap indexed;
+  if (IndexedRows(query, &indexed)) {
+    Selection matches(size(), false);
+    indexed.SetBits(&matches.words);
+    selection.And(matches);
+  }
+  return selection;
+}
+
+std::size_t IssueTable::Count(const Query& query) const {
+  for (auto& param : query) {
+    if (!Indexed(param.first)) return Select(query).Count();
+  }
+
+  // A row has one value for a field, so the rows of the values of a single
+  // field are counted without joining them
+  if (!query.empty() &&
+      query.upper_bound(query.begin()->first) == query.end()) {
+    std::set<std::string> values;
+    std::size_t count = 0;
+    for (auto& param : query) {
+      const CompressedBitmap* rows = IndexedRows(param.first, param.second);
+      if (rows != nullptr && values.insert(param.second).second) {
+        count += rows->Cardinality();
+      }
+    }
+    return count;
+  }
+
+  CompressedBitmap indexed;
+  return IndexedRows(query, &indexed) ? indexed.Cardinality() : size();
+}
+
+uint64_t IssueTable::IdColumnValue(const json& issue, const char* field) {
+  if (!issue.is_object()) return Missing;
+  auto value = issue.find(field);
+  if (value == issue.end() || !value->is_string()) return Missing;
+  EntityId id(value->get_ref<const std::string&>());
+  if (!id.IsPacked()) _interned.push_back(id);
+  return id.Value();
+}
+
+const std::vector<uint64_t>* IssueTable::IdColumn(
+    const std::string& field) const {
+  if (field == "id") return &_ids;
+  if (field == "createdBy") return &_createdBy;
+  return nullptr;
+}
+
+bool IssueTable::Indexed(const std::string& field) {
+  return field == "status" || field == "assignedTo" || field == "reporter";
+}
+
+const CompressedBitmap* IssueTable::IndexedRows(
+    const std::string& field, const std::string& value) const {
+  if (field == "status") return Find(_statusRows, value);
+
+  EntityId id;
+  if (!EntityId::Lookup(value, &id)) return nullptr;
+  return Find(field == "assignedTo" ? _assignedToRows : _reporterRows,
+              id.Value());
+}
+
+CompressedBitmap IssueTable::IndexedRows(Query::const_iterator first,
+                                         Query::const_iterator last) const {
+  CompressedBitmap rows;
+  for (auto param = first; param != last; ++param) {
+    const CompressedBitmap* value = IndexedRows(param->first, param->second);
+    if (value == nullptr) continue;
+    rows = rows.empty() ? *value : CompressedBitmap::Or(rows, *value);
+  }
+  return rows;
+}
+
+bool IssueTable::IndexedRows(const Query& query, CompressedBitmap* rows) const {
+  bool found = false;
+  for (auto first = query.begin(); first != query.end();
+       first = query.upper_bound(first->first)) {
+    if (!Indexed(first->first)) continue;
+
+    CompressedBitmap matches =
+        IndexedRows(first, query.upper_bound(first->first));
+    *rows = found ? CompressedBitmap::And(*rows, matches) : std::move(matches);
+    found = true;
+  }
+  return found;
+}
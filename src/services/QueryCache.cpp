@@ -0,0 +1,182 @@
+#include "QueryCache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "EntityService.hpp"
+#include "TimeIndex.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * Roughly what the containers take for each entry, on top of its contents
+ */
+const std::size_t EntryOverhead = 256;
+
+void AddId(const json& value, std::vector<EntityId>* ids) {
+  if (value.is_string() && !value.get_ref<const std::string&>().empty()) {
+    ids->push_back(EntityId(value.get_ref<const std::string&>()));
+  }
+}
+
+bool Contains(const std::vector<EntityId>& ids, const EntityId& id) {
+  return !id.empty() && std::binary_search(ids.begin(), ids.end(), id);
+}
+}  // namespace
+
+QueryCache::QueryCache(const std::string& collection, std::size_t capacity)
+    : _collection(collection), _capacity(capacity) {}
+
+void QueryCache::Depend(const std::string& collection,
+                        const std::string& field) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _dependencies[collection] = field;
+}
+
+std::shared_ptr<const std::string> QueryCache::Get(const Query& query) {
+  std::string key = Key(query);
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto found = _index.find(key);
+  if (found == _index.end()) {
+    _misses++;
+    return nullptr;
+  }
+
+  _hits++;
+  _entries.splice(_entries.begin(), _entries, found->second);
+  return found->second->body;
+}
+
+uint64_t QueryCache::Version() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _version;
+}
+
+void QueryCache::Put(const Query& query, const std::string& body,
+                     const json& response, uint64_t version) {
+  Entry entry;
+  entry.key = Key(query);
+  if (ListOptions::Requested(query)) {
+    ListOptions::Parse(query, &entry.filters);
+  } else {
+    entry.filters = query;
+  }
+
+  if (response.is_array()) {
+    for (const json& item : response) {
+      if (!item.is_object()) continue;
+      for (auto field = item.begin(); field != item.end(); ++field) {
+        if (field.key() == "id") AddId(field.value(), &entry.ids);
+        if (!field.value().is_array()) continue;
+        for (const json& id : field.value()) AddId(id, &entry.ids);
+      }
+    }
+  }
+  std::sort(entry.ids.begin(), entry.ids.end());
+  entry.ids.erase(std::unique(entry.ids.begin(), entry.ids.end()),
+                  entry.ids.end());
+
+  entry.bytes = EntryOverhead + 2 * entry.key.size() + body.size() +
+                entry.ids.size() * sizeof(EntityId);
+  for (auto& param : entry.filters) {
+    entry.bytes += param.first.size() + param.second.size();
+  }
+  if (entry.bytes > _capacity) return;
+  entry.body = std::make_shared<const std::string>(body);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  // The Entities could have changed after they were read
+  if (version != _version) return;
+
+  auto found = _index.find(entry.key);
+  if (found != _index.end()) Erase(found->second);
+  while (!_entries.empty() && _bytes + entry.bytes > _capacity) {
+    Erase(std::prev(_entries.end()));
+  }
+
+  _bytes += entry.bytes;
+  _entries.push_front(std::move(entry));
+  _index[_entries.front().key] = _entries.begin();
+}
+
+void QueryCache::Invalidate(const Change& change) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (change.collection != _collection &&
+      _dependencies.count(change.collection) == 0) {
+    return;
+  }
+
+  // An id that was never interned can't be in any response, and is left
+  // empty
+  EntityId changed;
+  EntityId::Lookup(change.id, &changed);
+  EntityId referenced;
+  if (change.collection != _collection && change.entity.is_object()) {
+    auto field = change.entity.find(_dependencies.at(change.collection));
+    if (field != change.entity.end() && field->is_string()) {
+      EntityId::Lookup(field->get_ref<const std::string&>(), &referenced);
+    }
+  }
+
+  _version++;
+  for (auto entry = _entries.begin(); entry != _entries.end();) {
+    bool affected = Contains(entry->ids, changed) ||
+                    Contains(entry->ids, referenced) ||
+                    Matches(*entry, change);
+    entry = affected ? Erase(entry) : std::next(entry);
+  }
+}
+
+QueryCache::Stats QueryCache::GetStats() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Stats stats;
+  stats.hits = _hits;
+  stats.misses = _misses;
+  stats.entries = _entries.size();
+  stats.bytes = _bytes;
+  return stats;
+}
+
+std::string QueryCache::Key(const Query& query) {
+  std::string key;
+  for (auto first = query.begin(); first != query.end();
+       first = query.upper_bound(first->first)) {
+    // The values of a parameter match any of them, so their order and
+    // repeats don't matter
+    std::vector<std::string> values;
+    for (auto param = first; param != query.upper_bound(first->first);
+         ++param) {
+      values.push_back(param->second);
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    // Lengths keep the parameters apart whatever they contain
+    for (auto& value : values) {
+      key += std::to_string(first->first.size()) + ":" + first->first +
+             std::to_string(value.size()) + ":" + value;
+    }
+  }
+  return key;
+}
+
+bool QueryCache::Matches(const Entry& entry, const Change& change) const {
+  // A deleted Entity can only alter the responses that included it
+  return change.collection == _collection && change.entity.is_object() &&
+         FilterView::Matches(change.entity, entry.filters);
+}
+
+std::list<QueryCache::Entry>::iterator QueryCache::Erase(
+    std::list<Entry>::iterator entry) {
+  _bytes -= entry->bytes;
+  _index.erase(entry->key);
+  return _entries.erase(entry);
+}
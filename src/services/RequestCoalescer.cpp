@@ -0,0 +1,66 @@
+#include "RequestCoalescer.h"
+
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+
+RequestCoalescer::Body RequestCoalescer::Do(
+    const std::string& key, const std::function<Body()>& compute) {
+  std::promise<Body> promise;
+  std::shared_future<Body> flight;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _flights.find(key);
+    if (found != _flights.end()) {
+      _shared++;
+      flight = found->second;
+    } else {
+      _computed++;
+      _flights.emplace(key, promise.get_future().share());
+    }
+  }
+  // Waits without the lock, so other requests can start or join flights
+  if (flight.valid()) return flight.get();
+
+  // The flight is ended before it is answered, so a request arriving after
+  // the response is ready computes its own rather than finding a stale one
+  Body body;
+  std::exception_ptr error;
+  try {
+    body = compute();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _flights.erase(key);
+  }
+
+  if (error) {
+    promise.set_exception(error);
+    std::rethrow_exception(error);
+  }
+  promise.set_value(body);
+  return body;
+}
+
+std::size_t RequestCoalescer::InFlight() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _flights.size();
+}
+
+RequestCoalescer::Stats RequestCoalescer::GetStats() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Stats stats;
+  stats.computed = _computed;
+  stats.shared = _shared;
+  return stats;
+}
+
+std::string RequestCoalescer::Key(const std::string& path,
+                                  const std::string& query,
+                                  uint64_t generation) {
+  return std::to_string(generation) + " " + std::to_string(path.size()) + ":" +
+         path + query;
+}
@@ -0,0 +1,204 @@
+#include "TimeIndex.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * @return the rows ordered by key, and by row for the same key
+ */
+std::vector<uint32_t> Order(const std::vector<int64_t>& keys) {
+  std::vector<uint32_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&keys](uint32_t lhs, uint32_t rhs) {
+    return keys[lhs] < keys[rhs] || (keys[lhs] == keys[rhs] && lhs < rhs);
+  });
+  return order;
+}
+
+int64_t ParseTime(const std::string& parameter, const std::string& value) {
+  int64_t seconds;
+  if (!TimeUtilities::ParseSeconds(value, &seconds)) {
+    throw BadRequestError(
+        std::string("The " + parameter + " parameter must be a time, such as "
+                    "2020-12-01T14:55:02Z, not " + value)
+            .c_str());
+  }
+  return seconds;
+}
+
+std::size_t ParseLimit(const std::string& value) {
+  if (value.empty() || value.size() > 18 ||
+      value.find_first_not_of("0123456789") != std::string::npos) {
+    throw BadRequestError(
+        std::string("The limit parameter must be a whole number, not " + value)
+            .c_str());
+  }
+  return std::stoull(value);
+}
+
+void ParseSort(const std::string& value, ListOptions* options) {
+  std::string field = value;
+  options->descending = !field.empty() && field.front() == '-';
+  if (options->descending) field.erase(0, 1);
+
+  if (field == "createdAt") {
+    options->sortField = ListOptions::CreatedAt;
+  } else if (field == "updatedAt") {
+    options->sortField = ListOptions::UpdatedAt;
+  } else {
+    throw BadRequestError(
+        std::string("Lists can only be sorted by createdAt or updatedAt, not " +
+                    value)
+            .c_str());
+  }
+  options->sorted = true;
+}
+}  // namespace
+
+const int64_t ListOptions::Never;
+
+bool ListOptions::Requested(
+    const std::multimap<std::string, std::string>& query) {
+  return query.count("createdAfter") != 0 || query.count("updatedSince") != 0 ||
+         query.count("sort") != 0 || query.count("limit") != 0;
+}
+
+ListOptions ListOptions::Parse(
+    const std::multimap<std::string, std::string>& query,
+    std::multimap<std::string, std::string>* filters) {
+  ListOptions options;
+  filters->clear();
+  for (auto& param : query) {
+    const std::string& name = param.first;
+    if (name != "createdAfter" && name != "updatedSince" && name != "sort" &&
+        name != "limit") {
+      filters->emplace_hint(filters->end(), param);
+      continue;
+    }
+
+    if (query.count(name) > 1) {
+      throw BadRequestError(
+          std::string("The " + name + " parameter can only be given once")
+              .c_str());
+    }
+    if (name == "createdAfter") {
+      // Times are compared to the second, so after one is from the next
+      options.minCreatedAt = ParseTime(name, param.second) + 1;
+    } else if (name == "updatedSince") {
+      options.minUpdatedAt = ParseTime(name, param.second);
+    } else if (name == "sort") {
+      ParseSort(param.second, &options);
+    } else {
+      options.limit = ParseLimit(param.second);
+    }
+  }
+  return options;
+}
+
+TimeIndex::TimeIndex(const json& collection) {
+  std::size_t rows = collection.is_array() ? collection.size() : 0;
+  _createdAt.reserve(rows);
+  _updatedAt.reserve(rows);
+  for (std::size_t row = 0; row < rows; row++) {
+    _createdAt.push_back(Key(collection[row], "createdAt"));
+    _updatedAt.push_back(Key(collection[row], "updatedAt"));
+  }
+  _byCreatedAt = Order(_createdAt);
+  _byUpdatedAt = Order(_updatedAt);
+}
+
+std::vector<std::size_t> TimeIndex::Select(const std::vector<std::size_t>* rows,
+                                           const ListOptions& options) const {
+  std::vector<std::size_t> selected;
+  bool ranged = options.minCreatedAt != ListOptions::Never ||
+                options.minUpdatedAt != ListOptions::Never;
+
+  if (rows != nullptr) {
+    for (std::size_t row : *rows) {
+      if (InRange(row, options)) selected.push_back(row);
+    }
+  } else if (!options.sorted && !ranged) {
+    selected.resize(std::min(size(), options.limit));
+    std::iota(selected.begin(), selected.end(), 0);
+    return selected;
+  } else {
+    // The rows in the range of one field are the end of its order. Without a
+    // sort, they are put back in the order they are stored
+    ListOptions::Field field = options.sortField;
+    if (!options.sorted) {
+      field = options.minUpdatedAt != ListOptions::Never
+                  ? ListOptions::UpdatedAt
+                  : ListOptions::CreatedAt;
+    }
+    const std::vector<int64_t>& keys = Keys(field);
+    const std::vector<uint32_t>& order =
+        field == ListOptions::CreatedAt ? _byCreatedAt : _byUpdatedAt;
+    int64_t minimum = field == ListOptions::CreatedAt ? options.minCreatedAt
+                                                      : options.minUpdatedAt;
+    auto first = std::lower_bound(
+        order.begin(), order.end(), minimum,
+        [&keys](uint32_t row, int64_t key) { return keys[row] < key; });
+
+    if (!options.sorted) {
+      for (auto row = first; row != order.end(); ++row) {
+        if (InRange(*row, options)) selected.push_back(*row);
+      }
+      std::sort(selected.begin(), selected.end());
+    } else if (!options.descending) {
+      for (auto row = first;
+           row != order.end() && selected.size() < options.limit; ++row) {
+        if (InRange(*row, options)) selected.push_back(*row);
+      }
+    } else {
+      for (auto row = order.end();
+           row != first && selected.size() < options.limit;) {
+        --row;
+        if (InRange(*row, options)) selected.push_back(*row);
+      }
+    }
+  }
+
+  if (options.sorted && rows != nullptr) {
+    // The same order as walking the index: newest first is the exact reverse
+    // of oldest first
+    const std::vector<int64_t>& keys = Keys(options.sortField);
+    bool descending = options.descending;
+    auto before = [&keys, descending](std::size_t lhs, std::size_t rhs) {
+      if (keys[lhs] != keys[rhs]) {
+        return descending ? keys[lhs] > keys[rhs] : keys[lhs] < keys[rhs];
+      }
+      return descending ? lhs > rhs : lhs < rhs;
+    };
+    if (options.limit < selected.size()) {
+      std::partial_sort(selected.begin(), selected.begin() + options.limit,
+                        selected.end(), before);
+    } else {
+      std::sort(selected.begin(), selected.end(), before);
+    }
+  }
+
+  if (selected.size() > options.limit) selected.resize(options.limit);
+  return selected;
+}
+
+int64_t TimeIndex::Key(const json& item, const char* field) {
+  if (!item.is_object()) return ListOptions::Never;
+  auto value = item.find(field);
+  int64_t seconds;
+  if (value == item.end() || !value->is_string() ||
+      !TimeUtilities::ParseSeconds(value->get_ref<const std::string&>(),
+                                   &seconds)) {
+    return ListOptions::Never;
+  }
+  return seconds;
+}
@@ -0,0 +1,158 @@
+#include "Transaction.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Exceptions.h"
+#include "FileHandler.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+Journal::Journal(std::shared_ptr<IStreamableFileHandler> fileHandler)
+    : _fileHandler(fileHandler) {}
+
+Journal::Journal(const std::string& fileName)
+    : _fileHandler(std::make_shared<FileHandler>(_os, _is, fileName)) {
+  if (!std::ifstream(fileName)) _fileHandler->write(nullptr);
+}
+
+void Journal::Write(const json& record) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _fileHandler->write(record);
+}
+
+void Journal::Clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _fileHandler->write(nullptr);
+}
+
+json Journal::Read() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    return _fileHandler->read();
+  } catch (const InternalServerError&) {
+    return nullptr;
+  }
+}
+
+std::size_t Journal::Recover(const std::vector<Transactional*>& collections) {
+  json record = Read();
+  if (!record.is_object() || !record.contains("changes") ||
+      !record["changes"].is_array()) {
+    return 0;
+  }
+  const json& changes = record["changes"];
+
+  // Nothing is applied unless all of it can be
+  for (const json& change : changes) {
+    std::string name = change.value("collection", "");
+    if (std::none_of(collections.begin(), collections.end(),
+                     [&name](Transactional* collection) {
+                       return collection->CollectionName() == name;
+                     })) {
+      throw InternalServerError(
+          std::string("The journal has changes to an unknown collection: " +
+                      name)
+              .c_str());
+    }
+  }
+
+  for (Transactional* collection : collections) {
+    const std::string& name = collection->CollectionName();
+    std::lock_guard<std::mutex> lock(collection->CollectionMutex());
+    json data;
+    bool changed = false;
+    for (const json& change : changes) {
+      if (change.value("collection", "") != name) continue;
+      if (!changed) data = collection->ReadCollection();
+      Redo(data, change);
+      changed = true;
+    }
+    if (changed) collection->SaveCollection(data);
+  }
+
+  Clear();
+  return changes.size();
+}
+
+void Journal::Redo(json& collection, const json& change) {
+  std::string id = change.value("id", "");
+  auto stored = std::find_if(
+      collection.begin(), collection.end(),
+      [&id](const json& item) { return item.value("id", "") == id; });
+
+  if (change.value("op", "") == "delete") {
+    if (stored != collection.end()) collection.erase(stored);
+  } else if (stored != collection.end()) {
+    *stored = change["entity"];
+  } else {
+    collection.push_back(change["entity"]);
+  }
+}
+
+Transaction::Transaction(std::shared_ptr<Journal> journal)
+    : _journal(std::move(journal)) {}
+
+Transaction::~Transaction() {
+  if (_committed) return;
+  for (auto& participant : _participants) {
+    participant.collection->DiscardChanges();
+  }
+}
+
+json& Transaction::Collection(Transactional* collection) {
+  for (auto& participant : _participants) {
+    if (participant.collection == collection) return participant.data;
+  }
+
+  Participant participant;
+  participant.collection = collection;
+  participant.lock =
+      std::unique_lock<std::mutex>(collection->CollectionMutex());
+  participant.data = collection->ReadCollection();
+  _participants.push_back(std::move(participant));
+  return _participants.back().data;
+}
+
+bool Transaction::Holds(const Transactional* collection) const {
+  return std::any_of(_participants.begin(), _participants.end(),
+                     [collection](const Participant& participant) {
+                       return participant.collection == collection;
+                     });
+}
+
+void Transaction::Commit() {
+  json changes = json::array();
+  std::size_t changed = 0;
+  for (auto& participant : _participants) {
+    const std::vector<Change>& pending =
+        participant.collection->PendingChanges();
+    if (pending.empty()) continue;
+    changed++;
+    for (auto& change : pending) {
+      changes.push_back(
+          {{"collection", participant.collection->CollectionName()},
+           {"op", change.op},
+           {"id", change.id},
+           {"entity", change.entity}});
+    }
+  }
+
+  // A single collection is already saved in one write
+  bool journaled = _journal && changed > 1;
+  if (journaled) _journal->Write({{"changes", changes}});
+
+  for (auto& participant : _participants) {
+    if (participant.collection->PendingChanges().empty()) continue;
+    participant.collection->SaveCollection(participant.data);
+  }
+
+  if (journaled) _journal->Clear();
+  _committed = true;
+}
@@ -4,7 +4,9 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Exceptions.h"
@@ -14,27 +16,23 @@
 using json = nlohmann::json;
 
 std::vector<User> UserService::Get(
-    const std::multimap<std::string, std::string> queryParams) {
+    const std::multimap<std::string, std::string>& queryParams) {
   std::vector<User> users;
-  json jsFile = _fileHandler->read();
-
-  json filteredUsers = Filter(jsFile, queryParams);
+  json jsFile = Load();
 
   // For each User in the filtered results
-  for (auto& person : filteredUsers) {
-    User temp = person.get<User>();
-    users.push_back(temp);
+  for (const json& person : Filter(jsFile, queryParams)) {
+    users.push_back(person.get<User>());
   }
 
   return users;
 }
 
-User UserService::Get(const std::string id) {
-  User user;
-  json jsFile = _fileHandler->read();
+User UserService::Get(const std::string& id) {
+  json jsFile = Load();
 
   // Get the user by ID - as a string
-  json filtered = Filter(jsFile, {{"id", id}});
+  FilterView filtered = Filter(jsFile, {{"id", id}});
 
   // If the user was not found
   if (filtered.empty()) {
@@ -42,11 +40,10 @@ User UserService::Get(const std::string id) {
         std::string("A User could not be found with the following id: " + id)
             .c_str());
   }
-  user = filtered[0].get<User>();
-  return user;
+  return filtered.front().get<User>();
 }
 
-User UserService::Create(std::string body) {
+User UserService::Create(const std::string& body) {
   json userToCreate;
   try {
     userToCreate = json::parse(body);
@@ -59,86 +56,160 @@ User UserService::Create(std::string body) {
                     body)
             .c_str());
   }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsFile = _fileHandler->read();
+  User user = ApplyCreate(jsFile, std::move(userToCreate));
+  Save(jsFile);
+  return user;
+}
+
+User UserService::Update(const std::string& body) {
+  json updatedUser;
+  try {
+    updatedUser = json::parse(body);
+  }
+
+  catch (std::exception& e) {
+    throw BadRequestError(
+        std::string("The User could not be created because of a parsing error. "
+                    "The invalid User information is: " +
+                    body)
+            .c_str());
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsFile = _fileHandler->read();
+  User user = ApplyUpdate(jsFile, std::move(updatedUser));
+  Save(jsFile);
+  return user;
+}
+
+User UserService::Patch(const std::string& id, const std::string& body) {
+  json patch = ParsePatch(body);
+
+  std::lock_guard<std::mutex> lock(_mutex);
   json jsFile = _fileHandler->read();
+  User user = ApplyPatch(jsFile, id, std::move(patch));
+  Save(jsFile);
+  return user;
+}
+
+// body is just the id
+bool UserService::Delete(const std::string& id) {
+  return Delete(id, AnyVersion);
+}
 
-  User temp = userToCreate.get<User>();
+bool UserService::Delete(const std::string& id, int expectedVersion) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsFile = _fileHandler->read();
+  ApplyDelete(jsFile, id, expectedVersion);
+  Save(jsFile);
+  return true;
+}
+
+User UserService::ApplyCreate(json& collection, json body) {
+  User temp = body.get<User>();
   // Ignore any value for id passed in from the request body
   temp.id = this->GenerateId();
   // If the file does not already have a user with that id
-  while (!Filter(jsFile, {{"id", temp.id}}).empty()) {
+  while (!Filter(collection, {{"id", temp.id}}).empty()) {
     temp.id = this->GenerateId();
   }
+  // Newly created users start at the first version
+  temp.version = 1;
   // Check to make sure there isn't a User with the same name
-  if (Filter(jsFile, {{"name", temp.name}}).empty()) {
-    jsFile.push_back(temp);
-    _fileHandler->write(jsFile);
-  } else {
+  if (!Filter(collection, {{"name", temp.name}}).empty()) {
     throw AlreadyExistsError(
         std::string("The User already exists with the following name: " +
-                    userToCreate["name"].get<std::string>())
+                    temp.name)
             .c_str());
   }
+  collection.push_back(temp);
+  Record("create", temp.id, collection.back());
   return temp;
 }
 
-User UserService::Update(std::string body) {
-  json updatedUser;
-  try {
-    updatedUser = json::parse(body);
+User UserService::ApplyUpdate(json& collection, json body) {
+  User temp = body.get<User>();
+  int expectedVersion = ExpectedVersion(body);
+
+  auto itUser = FindById(collection, temp.id);
+  // If the user we want to update exists
+  if (itUser == collection.end()) {
+    throw NotFoundError(
+        std::string("The User could not be found with the following id: " +
+                    temp.id)
+            .c_str());
+  }
+  // Make sure nobody else has updated the user since the caller read it
+  CheckVersion(*itUser, expectedVersion);
+  // Check if they are updating their name to something that already exists
+  FilterView filtered = Filter(collection, {{"name", temp.name}});
+  if (!filtered.empty() && filtered.front()["id"] != (*itUser)["id"]) {
+    throw AlreadyExistsError(
+        std::string("The User already exists with the following name: " +
+                    temp.name)
+            .c_str());
   }
+  temp.version = itUser->value("version", 0) + 1;
+  *itUser = temp;
+  Record("update", temp.id, *itUser);
+  return temp;
+}
 
-  catch (std::exception& e) {
-    throw BadRequestError(
-        std::string("The User could not be created because of a parsing error. "
-                    "The invalid User information is: " +
-                    body)
+User UserService::ApplyPatch(json& collection, const std::string& id,
+                             json patch) {
+  CheckPatch(id, patch, {"name", "role"});
+  int expectedVersion = ExpectedVersion(patch);
+  patch.erase("version");
+
+  for (const std::string field : {"name", "role"}) {
+    if (patch.contains(field) && !patch[field].is_string()) {
+      throw BadRequestError(
+          std::string("The " + field + " of a User must be a string").c_str());
+    }
+  }
+
+  auto itUser = FindById(collection, id);
+  if (itUser == collection.end()) {
+    throw NotFoundError(
+        std::string("The User could not be found with the following id: " + id)
             .c_str());
   }
+  CheckVersion(*itUser, expectedVersion);
 
-  User temp = updatedUser.get<User>();
-  json jsFile = _fileHandler->read();
-  auto itUser = std::find_if(
-      jsFile.begin(), jsFile.end(),
-      [&](const json& item) { return item["id"] == updatedUser["id"]; });
-  // If the user we want to update exists
-  if (itUser != jsFile.end()) {
-    // Check if they are updating their name to something that already exists
-    json filtered = Filter(jsFile, {{"name", temp.name}});
-    if (!filtered.empty() && filtered[0]["id"] != (*itUser)["id"]) {
+  // Names are only checked for duplicates if they are being changed
+  if (patch.contains("name")) {
+    std::string name = patch["name"];
+    FilterView filtered = Filter(collection, {{"name", name}});
+    if (!filtered.empty() && filtered.front()["id"] != id) {
       throw AlreadyExistsError(
           std::string("The User already exists with the following name: " +
-                      updatedUser["name"].get<std::string>())
+                      name)
               .c_str());
     }
-    *itUser = temp;
-    _fileHandler->write(jsFile);
-  } else {
-    throw NotFoundError(
-        std::string("The User could not be found with the following id: " +
-                    updatedUser["id"].get<std::string>())
-            .c_str());
   }
-  return temp;
-}
 
-// body is just the id
-bool UserService::Delete(std::string id) {
-  json jsFile = _fileHandler->read();
+  itUser->merge_patch(patch);
+  (*itUser)["version"] = itUser->value("version", 0) + 1;
+  User patched = itUser->get<User>();
+  Record("patch", id, *itUser);
+  return patched;
+}
 
+void UserService::ApplyDelete(json& collection, const std::string& id,
+                              int expectedVersion) {
   // Find the User with the passed in id
-  auto itUser =
-      std::find_if(jsFile.begin(), jsFile.end(),
-                   [&](const json& item) { return item["id"] == id; });
-
-  // If the user was found
-  if (itUser != jsFile.end()) {
-    jsFile.erase(itUser);
-    _fileHandler->write(jsFile);
-    return true;
-  } else {
+  auto itUser = FindById(collection, id);
+
+  // If the user was not found
+  if (itUser == collection.end()) {
     throw NotFoundError(
         std::string("The User could not be found with the following id: " + id)
             .c_str());
   }
-  return false;
+  CheckVersion(*itUser, expectedVersion);
+  collection.erase(itUser);
+  Record("delete", id);
 }
@@ -3,41 +3,41 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "FileHandler.h"
 #include "User.h"
-#include "Issue.h"
 #include "UserService.h"
+#include "Utilities.h"
 #include "Vote.h"
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
 
 std::vector<Vote> VoteService::Get(
-    const std::multimap<std::string, std::string> queryParams) {
+    const std::multimap<std::string, std::string>& queryParams) {
   std::vector<Vote> votes;
-  json jsonFile = _fileHandler->read();
-
-  json filtered = Filter(jsonFile, queryParams);
 
-  for (auto& vote : filtered) {
+  // Users are shared between all of the Votes
+  UserResolver users(*_userService);
+  ForEachMatch(queryParams, [&](const json& vote) {
     Vote temp = vote.get<Vote>();
-
-    // Get the user from the user service
-    User createdBy = _userService->Get(std::string(temp.createdBy.id));
-    votes.push_back(temp);
-  }
+    temp.createdBy = users.Resolve(temp.createdBy.id);
+    votes.push_back(std::move(temp));
+  });
 
   return votes;
 }
 
-Vote VoteService::Get(std::string id) {
-  json jsonFile = _fileHandler->read();
+Vote VoteService::Get(const std::string& id) {
+  json jsonFile = Load();
 
   // Get the vote by the id
-  json filtered = Filter(jsonFile, {{"id", id}});
+  FilterView filtered = Filter(jsonFile, {{"id", id}});
 
   // If the user was not found
   if (filtered.empty()) {
@@ -46,12 +46,12 @@ Vote VoteService::Get(std::string id) {
             .c_str());
   }
   Vote vote;
-  vote = filtered[0].get<Vote>();
-  vote.createdBy = _userService->Get(std::string(vote.createdBy.id));
+  vote = filtered.front().get<Vote>();
+  vote.createdBy = _userService->Get(vote.createdBy.id);
   return vote;
 }
 
-Vote VoteService::Create(std::string body) {
+Vote VoteService::Create(const std::string& body) {
   json voteToCreate;
   try {
     voteToCreate = json::parse(body);
@@ -62,77 +62,194 @@ Vote VoteService::Create(std::string body) {
             .c_str());
   }
 
-  // We explicitly ignore these values for votes
-  voteToCreate["updatedBy"] = "";
-  voteToCreate["updatedAt"] = "";
+  std::lock_guard<std::mutex> lock(_mutex);
+  json jsonFile = _fileHandler->read();
+  Vote vote = ApplyCreate(jsonFile, std::move(voteToCreate));
+  Save(jsonFile);
 
-  // We also ignore any specified date and compute this ourselves
-  voteToCreate["createdAt"] = "";
+  return vote;
+}
 
+Vote VoteService::Update(const std::string& body) {
+  throw NotImplementedError("Votes cannot be updated. Only created or deleted");
+}
+
+bool VoteService::Delete(const std::string& id) {
+  return Delete(id, AnyVersion);
+}
+
+bool VoteService::Delete(const std::string& id, int expectedVersion) {
+  std::lock_guard<std::mutex> lock(_mutex);
   json jsonFile = _fileHandler->read();
+  ApplyDelete(jsonFile, id, expectedVersion);
+  Save(jsonFile);
+  return true;
+}
+
+VoteService::Toggled VoteService::Toggle(const std::string& issueId,
+                                         const std::string& userId) {
+  if (issueId.empty() || userId.empty()) {
+    throw BadRequestError("A vote needs the id of an issue and of a user");
+  }
+
+  std::shared_ptr<IssueService> issueService = _issueService.lock();
+  if (!issueService) return ApplyToggle(issueId, userId);
+
+  // The issues are locked before the votes, as a Transaction locks them
+  Toggled toggled;
+  issueService->WhileIssueExists(
+      issueId, [&]() { toggled = ApplyToggle(issueId, userId); });
+  return toggled;
+}
+
+VoteService::Toggled VoteService::ApplyToggle(const std::string& issueId,
+                                              const std::string& userId) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Ballots& ballots = LoadBallots();
+  std::string key = BallotKey(issueId, userId);
+  auto found = ballots.slots.find(key);
+
+  Toggled toggled;
+  try {
+    if (found == ballots.slots.end()) {
+      toggled.vote = ApplyCreate(
+          ballots.votes, json({{"issueId", issueId}, {"createdBy", userId}}));
+      toggled.cast = true;
+      // Every removed slot is before the new one
+      ballots.slots.emplace(key,
+                            ballots.votes.size() - 1 + ballots.removed.size());
+      ballots.counts[issueId]++;
+    } else {
+      // The vote is erased where it is, so the votes stay in the order they
+      // were cast
+      std::size_t slot = found->second;
+      auto removedBefore = std::lower_bound(ballots.removed.begin(),
+                                            ballots.removed.end(), slot);
+      std::size_t position = slot - (removedBefore - ballots.removed.begin());
+      toggled.vote = ballots.votes[position].get<Vote>();
+      ballots.votes.erase(position);
+      ballots.removed.insert(removedBefore, slot);
+      ballots.slots.erase(found);
+      if (--ballots.counts[issueId] == 0) ballots.counts.erase(issueId);
+      if (ballots.removed.size() > MaxRemovedSlots) NumberSlots(&ballots);
+      Record("delete", toggled.vote.id);
+    }
+    Save(ballots.votes);
+  } catch (...) {
+    // The ballots may no longer match the file, so they are read again
+    _ballots.reset();
+    DiscardChanges();
+    throw;
+  }
+  ballots.generation = _generation;
+
+  auto count = ballots.counts.find(issueId);
+  toggled.count = count == ballots.counts.end() ? 0 : count->second;
+  return toggled;
+}
+
+std::size_t VoteService::Count(const std::string& issueId) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Ballots& ballots = LoadBallots();
+  auto count = ballots.counts.find(issueId);
+  return count == ballots.counts.end() ? 0 : count->second;
+}
+
+std::string VoteService::BallotKey(const std::string& issueId,
+                                   const std::string& userId) {
+  // Ids never contain a newline, so no two pairs of ids share a key
+  return issueId + "\n" + userId;
+}
+
+VoteService::Ballots& VoteService::LoadBallots() {
+  if (_ballots && _ballots->generation == _generation) return *_ballots;
+
+  std::unique_ptr<Ballots> ballots(new Ballots());
+  ballots->votes = _fileHandler->read();
+  ballots->generation = _generation;
+  NumberSlots(ballots.get());
+  for (const json& vote : ballots->votes) {
+    ballots->counts[vote.value("issueId", "")]++;
+  }
+  _ballots = std::move(ballots);
+  return *_ballots;
+}
+
+void VoteService::NumberSlots(Ballots* ballots) {
+  ballots->slots.clear();
+  ballots->removed.clear();
+  for (std::size_t position = 0; position < ballots->votes.size();
+       position++) {
+    const json& vote = ballots->votes[position];
+    ballots->slots.emplace(
+        BallotKey(vote.value("issueId", ""), vote.value("createdBy", "")),
+        position);
+  }
+}
+
+Vote VoteService::ApplyCreate(json& collection, json body) {
+  // We explicitly ignore these values for votes
+  body["updatedBy"] = "";
+  body["updatedAt"] = "";
+
+  // We also ignore any specified date and compute this ourselves
+  body["createdAt"] = "";
 
   Vote vote;
   try {
     // Attempt to deserialize the json body.
-    vote = voteToCreate.get<Vote>();
+    vote = body.get<Vote>();
   } catch (std::exception& e) {
     throw BadRequestError(
         std::string(
-            "Unable to create a Vote using the following information: " + body)
+            "Unable to create a Vote using the following information: " +
+            body.dump())
             .c_str());
   }
   // Ignore any id value provided
   vote.id = GenerateId();
   // If the file has a vote with that id, generate a new one
-  while (!Filter(jsonFile, {{"id", vote.id}}).empty()) {
+  while (!Filter(collection, {{"id", vote.id}}).empty()) {
     vote.id = GenerateId();
   }
 
   // Get the user from the User Service
-  vote.createdBy = _userService->Get(std::string(vote.createdBy.id));
-
- /*TODO(someone) : we need to initialize an issueService.
-  if (!vote.issueId.empty()) {
-      json tempIssue;
-      Issue issue = _issueService->Get(std::string(vote.issueId));
-      issue.votes.push_back(vote);
+  vote.createdBy = _userService->Get(vote.createdBy.id);
 
-      tempIssue = issue;
-      _issueService->Update(tempIssue.dump());
-  }
- */
   // Set the created time to right now (in UTC time)
-  time_t t = time(0);
-  struct tm now = *gmtime(&t);
-  vote.createdAt = now;
+  vote.createdAt = TimeUtilities::CurrentTimeUTC();
 
-  jsonFile.push_back(vote);
-  _fileHandler->write(jsonFile);
+  // Votes are never updated, so they only ever have the first version
+  vote.version = 1;
 
+  collection.push_back(vote);
+  Record("create", vote.id, collection.back());
   return vote;
 }
 
-Vote VoteService::Update(std::string body) {
-  throw NotImplementedError("Votes cannot be updated. Only created or deleted");
-}
-
-bool VoteService::Delete(std::string id) {
-  json jsonFile = _fileHandler->read();
-
+void VoteService::ApplyDelete(json& collection, const std::string& id,
+                              int expectedVersion) {
   // Find the Vote with the passed in id
-  auto itVote =
-      std::find_if(jsonFile.begin(), jsonFile.end(),
-                   [&](const json& item) { return item["id"] == id; });
-
-  // If the Vote was found
-  if (itVote != jsonFile.end()) {
-    jsonFile.erase(itVote);
-    _fileHandler->write(jsonFile);
-    return true;
-  } else {
+  auto itVote = FindById(collection, id);
+
+  // If the Vote was not found
+  if (itVote == collection.end()) {
     throw NotFoundError(
         std::string("The Vote could not be found with the following id: " + id)
             .c_str());
   }
-  return false;
+  CheckVersion(*itVote, expectedVersion);
+  collection.erase(itVote);
+  Record("delete", id);
+}
+
+void VoteService::SetIssueService(
+    const std::shared_ptr<IssueService>& issueService) {
+  _issueService = issueService;
+}
+
+uint64_t VoteService::Generation() {
+  uint64_t generation = _generation;
+  if (_userService) generation += _userService->Generation();
+  return generation;
 }
@@ -0,0 +1,226 @@
+#include "AllocationStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+#ifdef HOTTICKET_ALLOCATION_STATS
+std::atomic<bool> enabled{true};
+#else
+std::atomic<bool> enabled{false};
+#endif
+
+/**
+ * The allocations made on this thread. Plain integers, so operator new can
+ * use them without any initialization
+ */
+thread_local uint64_t threadAllocations = 0;
+thread_local uint64_t threadBytes = 0;
+
+/**
+ * The Request being accounted for on this thread, if any
+ */
+thread_local AllocationStats::Request* activeRequest = nullptr;
+
+/**
+ * The name of the phase for allocations outside of any other phase
+ */
+const char* const ControllerPhase = "controller";
+
+/**
+ * The allocations of every request to one method and endpoint
+ */
+struct Aggregate {
+  uint64_t requests = 0;
+  AllocationStats::Counts total;
+  std::map<std::string, AllocationStats::Counts> phases;
+};
+
+std::mutex aggregatesMutex;
+std::map<std::string, Aggregate> aggregates;
+
+void Add(AllocationStats::Counts* counts, uint64_t allocations,
+         uint64_t bytes) {
+  counts->allocations += allocations;
+  counts->bytes += bytes;
+}
+
+json ToJson(const AllocationStats::Counts& counts) {
+  return {{"allocations", counts.allocations}, {"bytes", counts.bytes}};
+}
+}  // namespace
+
+#ifdef HOTTICKET_ALLOCATION_STATS
+namespace {
+void* Allocate(std::size_t size) {
+  AllocationStats::Count(size);
+  void* memory = std::malloc(size > 0 ? size : 1);
+  if (memory == nullptr) throw std::bad_alloc();
+  return memory;
+}
+}  // namespace
+
+// Every allocation in the server goes through these, so each request can
+// report how much it allocated
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return Allocate(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return Allocate(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+#endif
+
+namespace AllocationStats {
+bool Enabled() { return enabled.load(std::memory_order_relaxed); }
+
+void SetEnabled(bool value) { enabled.store(value); }
+
+void Count(std::size_t bytes) {
+  threadAllocations++;
+  threadBytes += bytes;
+}
+
+Counts Current() {
+  Counts counts;
+  counts.allocations = threadAllocations;
+  counts.bytes = threadBytes;
+  return counts;
+}
+
+std::string Header() {
+  if (activeRequest == nullptr) return "";
+
+  // The header itself is built after the counts are taken
+  activeRequest->Flush();
+  Counts total = activeRequest->Total();
+  return "allocations=" + std::to_string(total.allocations) +
+         "; bytes=" + std::to_string(total.bytes);
+}
+
+json Snapshot() {
+  json requests = json::object();
+  {
+    std::lock_guard<std::mutex> lock(aggregatesMutex);
+    for (auto& aggregate : aggregates) {
+      const Aggregate& counts = aggregate.second;
+      json phases = json::object();
+      for (auto& phase : counts.phases) {
+        phases[phase.first] = ToJson(phase.second);
+      }
+      requests[aggregate.first] = {
+          {"requests", counts.requests},
+          {"allocations", counts.total.allocations},
+          {"bytes", counts.total.bytes},
+          {"allocationsPerRequest",
+           static_cast<double>(counts.total.allocations) / counts.requests},
+          {"bytesPerRequest",
+           static_cast<double>(counts.total.bytes) / counts.requests},
+          {"phases", phases}};
+    }
+  }
+  return {{"enabled", Enabled()}, {"requests", requests}};
+}
+
+void Reset() {
+  std::lock_guard<std::mutex> lock(aggregatesMutex);
+  aggregates.clear();
+}
+
+Request::Request(const std::string& endpoint, const char* method) {
+  if (!Enabled() || activeRequest != nullptr) return;
+
+  _active = true;
+  _key = std::string(method) + " " + endpoint;
+  _phase = ControllerPhase;
+  _phases[0] = {ControllerPhase, Counts()};
+  _phaseCount = 1;
+  activeRequest = this;
+
+  // Taken last, so building the key isn't counted against the request
+  _mark = Current();
+}
+
+Request::~Request() {
+  if (!_active) return;
+
+  Flush();
+  activeRequest = nullptr;
+
+  std::lock_guard<std::mutex> lock(aggregatesMutex);
+  Aggregate& aggregate = aggregates[_key];
+  aggregate.requests++;
+  for (std::size_t i = 0; i < _phaseCount; i++) {
+    const Counts& counts = _phases[i].counts;
+    Add(&aggregate.phases[_phases[i].name], counts.allocations, counts.bytes);
+    Add(&aggregate.total, counts.allocations, counts.bytes);
+  }
+}
+
+void Request::Flush() {
+  Counts now = Current();
+  uint64_t allocations = now.allocations - _mark.allocations;
+  uint64_t bytes = now.bytes - _mark.bytes;
+  _mark = now;
+
+  // Phases are few, so a linear search is cheaper than anything that
+  // allocates
+  std::size_t i = 0;
+  while (i < _phaseCount && std::strcmp(_phases[i].name, _phase) != 0) i++;
+  if (i == _phaseCount) {
+    if (_phaseCount == MaxPhases) {
+      i = 0;
+    } else {
+      _phases[_phaseCount++] = {_phase, Counts()};
+    }
+  }
+  Add(&_phases[i].counts, allocations, bytes);
+}
+
+const char* Request::Enter(const char* name) {
+  Flush();
+  const char* previous = _phase;
+  _phase = name;
+  return previous;
+}
+
+Counts Request::Total() const {
+  Counts total;
+  for (std::size_t i = 0; i < _phaseCount; i++) {
+    Add(&total, _phases[i].counts.allocations, _phases[i].counts.bytes);
+  }
+  return total;
+}
+
+Phase::Phase(const char* name) : _request(activeRequest) {
+  if (_request != nullptr) _previous = _request->Enter(name);
+}
+
+Phase::~Phase() {
+  if (_request != nullptr) _request->Enter(_previous);
+}
+}  // namespace AllocationStats
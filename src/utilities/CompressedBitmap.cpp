@@ -0,0 +1,244 @@
+#include "CompressedBitmap.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace {
+uint16_t High(uint32_t value) { return static_cast<uint16_t>(value >> 16); }
+
+uint16_t Low(uint32_t value) { return static_cast<uint16_t>(value & 0xFFFF); }
+
+uint32_t PopCount(const std::vector<uint64_t>& words) {
+  uint32_t count = 0;
+  for (uint64_t word : words) count += __builtin_popcountll(word);
+  return count;
+}
+}  // namespace
+
+const std::size_t CompressedBitmap::MaxArrayValues;
+const std::size_t CompressedBitmap::ChunkWords;
+
+void CompressedBitmap::Add(uint32_t value) {
+  uint16_t key = High(value);
+  auto chunk = _chunks.end();
+  if (_chunks.empty() || _chunks.back().key < key) {
+    _chunks.emplace_back();
+    _chunks.back().key = key;
+    chunk = _chunks.end() - 1;
+  } else {
+    chunk = std::lower_bound(
+        _chunks.begin(), _chunks.end(), key,
+        [](const Chunk& chunk, uint16_t key) { return chunk.key < key; });
+    if (chunk->key != key) {
+      chunk = _chunks.insert(chunk, Chunk());
+      chunk->key = key;
+    }
+  }
+
+  uint16_t low = Low(value);
+  if (chunk->IsBitmap()) {
+    uint64_t& word = chunk->bits[low / 64];
+    uint64_t bit = uint64_t(1) << (low % 64);
+    if ((word & bit) == 0) {
+      word |= bit;
+      chunk->cardinality++;
+    }
+    return;
+  }
+
+  std::vector<uint16_t>& array = chunk->array;
+  if (array.empty() || array.back() < low) {
+    array.push_back(low);
+  } else {
+    auto position = std::lower_bound(array.begin(), array.end(), low);
+    if (*position == low) return;
+    array.insert(position, low);
+  }
+  chunk->cardinality++;
+  if (array.size() > MaxArrayValues) ToBitmap(&*chunk);
+}
+
+bool CompressedBitmap::Contains(uint32_t value) const {
+  uint16_t key = High(value);
+  auto chunk = std::lower_bound(
+      _chunks.begin(), _chunks.end(), key,
+      [](const Chunk& chunk, uint16_t key) { return chunk.key < key; });
+  if (chunk == _chunks.end() || chunk->key != key) return false;
+
+  uint16_t low = Low(value);
+  if (chunk->IsBitmap()) {
+    return (chunk->bits[low / 64] >> (low % 64)) & 1;
+  }
+  return std::binary_search(chunk->array.begin(), chunk->array.end(), low);
+}
+
+std::size_t CompressedBitmap::Cardinality() const {
+  std::size_t cardinality = 0;
+  for (auto& chunk : _chunks) cardinality += chunk.cardinality;
+  return cardinality;
+}
+
+std::vector<uint32_t> CompressedBitmap::Values() const {
+  std::vector<uint32_t> values;
+  values.reserve(Cardinality());
+  for (auto& chunk : _chunks) {
+    uint32_t high = static_cast<uint32_t>(chunk.key) << 16;
+    if (!chunk.IsBitmap()) {
+      for (uint16_t low : chunk.array) values.push_back(high | low);
+      continue;
+    }
+    for (std::size_t i = 0; i < ChunkWords; i++) {
+      uint64_t word = chunk.bits[i];
+      while (word != 0) {
+        values.push_back(high | (i * 64 + __builtin_ctzll(word)));
+        word &= word - 1;
+      }
+    }
+  }
+  return values;
+}
+
+void CompressedBitmap::SetBits(std::vector<uint64_t>* words) const {
+  for (auto& chunk : _chunks) {
+    std::size_t first = static_cast<std::size_t>(chunk.key) * ChunkWords;
+    if (first >= words->size()) break;
+
+    if (chunk.IsBitmap()) {
+      std::size_t count = std::min(ChunkWords, words->size() - first);
+      for (std::size_t i = 0; i < count; i++) {
+        (*words)[first + i] |= chunk.bits[i];
+      }
+      continue;
+    }
+    for (uint16_t low : chunk.array) {
+      std::size_t word = first + low / 64;
+      if (word >= words->size()) break;
+      (*words)[word] |= uint64_t(1) << (low % 64);
+    }
+  }
+}
+
+CompressedBitmap CompressedBitmap::And(const CompressedBitmap& lhs,
+                                       const CompressedBitmap& rhs) {
+  CompressedBitmap result;
+  auto left = lhs._chunks.begin();
+  auto right = rhs._chunks.begin();
+  while (left != lhs._chunks.end() && right != rhs._chunks.end()) {
+    if (left->key < right->key) {
+      ++left;
+    } else if (right->key < left->key) {
+      ++right;
+    } else {
+      Chunk chunk = AndChunks(*left, *right);
+      if (chunk.cardinality > 0) result._chunks.push_back(std::move(chunk));
+      ++left;
+      ++right;
+    }
+  }
+  return result;
+}
+
+CompressedBitmap CompressedBitmap::Or(const CompressedBitmap& lhs,
+                                      const CompressedBitmap& rhs) {
+  CompressedBitmap result;
+  auto left = lhs._chunks.begin();
+  auto right = rhs._chunks.begin();
+  while (left != lhs._chunks.end() || right != rhs._chunks.end()) {
+    if (right == rhs._chunks.end() ||
+        (left != lhs._chunks.end() && left->key < right->key)) {
+      result._chunks.push_back(*left++);
+    } else if (left == lhs._chunks.end() || right->key < left->key) {
+      result._chunks.push_back(*right++);
+    } else {
+      result._chunks.push_back(OrChunks(*left++, *right++));
+    }
+  }
+  return result;
+}
+
+void CompressedBitmap::ToBitmap(Chunk* chunk) {
+  chunk->bits.assign(ChunkWords, 0);
+  for (uint16_t low : chunk->array) {
+    chunk->bits[low / 64] |= uint64_t(1) << (low % 64);
+  }
+  std::vector<uint16_t>().swap(chunk->array);
+}
+
+void CompressedBitmap::Shrink(Chunk* chunk) {
+  if (!chunk->IsBitmap() || chunk->cardinality > MaxArrayValues) return;
+
+  chunk->array.reserve(chunk->cardinality);
+  for (std::size_t i = 0; i < ChunkWords; i++) {
+    uint64_t word = chunk->bits[i];
+    while (word != 0) {
+      chunk->array.push_back(
+          static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+      word &= word - 1;
+    }
+  }
+  std::vector<uint64_t>().swap(chunk->bits);
+}
+
+CompressedBitmap::Chunk CompressedBitmap::AndChunks(const Chunk& lhs,
+                                                    const Chunk& rhs) {
+  Chunk result;
+  result.key = lhs.key;
+
+  if (lhs.IsBitmap() && rhs.IsBitmap()) {
+    result.bits.resize(ChunkWords);
+    for (std::size_t i = 0; i < ChunkWords; i++) {
+      result.bits[i] = lhs.bits[i] & rhs.bits[i];
+    }
+    result.cardinality = PopCount(result.bits);
+    Shrink(&result);
+  } else if (lhs.IsBitmap() || rhs.IsBitmap()) {
+    // Keep the values of the array that are set in the bitmap
+    const Chunk& array = lhs.IsBitmap() ? rhs : lhs;
+    const Chunk& bitmap = lhs.IsBitmap() ? lhs : rhs;
+    for (uint16_t low : array.array) {
+      if ((bitmap.bits[low / 64] >> (low % 64)) & 1) {
+        result.array.push_back(low);
+      }
+    }
+    result.cardinality = result.array.size();
+  } else {
+    std::set_intersection(lhs.array.begin(), lhs.array.end(),
+                          rhs.array.begin(), rhs.array.end(),
+                          std::back_inserter(result.array));
+    result.cardinality = result.array.size();
+  }
+  return result;
+}
+
+CompressedBitmap::Chunk CompressedBitmap::OrChunks(const Chunk& lhs,
+                                                   const Chunk& rhs) {
+  Chunk result;
+  result.key = lhs.key;
+
+  if (!lhs.IsBitmap() && !rhs.IsBitmap() &&
+      lhs.cardinality + rhs.cardinality <= MaxArrayValues) {
+    std::set_union(lhs.array.begin(), lhs.array.end(), rhs.array.begin(),
+                   rhs.array.end(), std::back_inserter(result.array));
+    result.cardinality = result.array.size();
+    return result;
+  }
+
+  result.bits.assign(ChunkWords, 0);
+  for (const Chunk* chunk : {&lhs, &rhs}) {
+    if (chunk->IsBitmap()) {
+      for (std::size_t i = 0; i < ChunkWords; i++) {
+        result.bits[i] |= chunk->bits[i];
+      }
+    } else {
+      for (uint16_t low : chunk->array) {
+        result.bits[low / 64] |= uint64_t(1) << (low % 64);
+      }
+    }
+  }
+  result.cardinality = PopCount(result.bits);
+  Shrink(&result);
+  return result;
+}
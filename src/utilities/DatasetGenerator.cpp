@@ -0,0 +1,333 @@
+#include "DatasetGenerator.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "FileHandler.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+const char* const Roles[] = {"Developer", "Developer", "Tester", "Manager"};
+const char* const Statuses[] = {"New", "Assigned", "Fixed", "Won't Fix",
+                                "Closed"};
+// How likely an issue is to be in each status, out of 100
+const int StatusWeights[] = {25, 30, 25, 5, 15};
+
+const char* const FirstNames[] = {
+    "Ada",   "Alan",   "Barbara", "Blake", "Dennis", "Donald", "Edsger",
+    "Everett", "Frances", "Grace", "Jean",  "John",  "Ken",     "Linus",
+    "Margaret", "Niklaus", "Radia", "Steven", "Tim",  "Tony"};
+const char* const LastNames[] = {
+    "Allen",  "Backus", "Dijkstra", "Hamilton", "Hopper",   "Kernighan",
+    "Knuth",  "Liskov", "Lovelace", "McCarthy", "Perlman",  "Ritchie",
+    "Stroustrup", "Thompson", "Torvalds", "Turing", "Wirth", "Wozniak"};
+
+const char* const Components[] = {
+    "Login page", "Search", "Settings", "The dashboard", "Checkout",
+    "The REST API", "Notifications", "The file uploader", "Reports",
+    "The mobile app", "Sign up", "The user profile"};
+const char* const Problems[] = {
+    "crashes on startup",
+    "is slow with a lot of data",
+    "shows the wrong time zone",
+    "loses changes after saving",
+    "doesn't work offline",
+    "throws an error for long names",
+    "renders off screen on small windows",
+    "ignores the sort order",
+    "leaks memory when left open",
+    "sends duplicate emails"};
+const char* const Remarks[] = {
+    "I can reproduce this every time.",
+    "This started after the last release.",
+    "Have we tried turning it off and on again?",
+    "Same here, it's blocking our whole team.",
+    "Can you attach the logs?",
+    "I think this is a duplicate of another issue.",
+    "A fix is up for review.",
+    "Works for me on the latest build.",
+    "This only happens when the cache is cold.",
+    "Bumping this, it still happens."};
+
+const int SecondsPerDay = 24 * 60 * 60;
+
+/**
+ * A random number generator that gives the same numbers for the same seed on
+ * every platform. std::mt19937_64 is fully specified by the standard, but the
+ * distributions in <random> are not, so numbers are taken from it directly
+ */
+class Random {
+ public:
+  explicit Random(uint64_t seed) : _engine(seed) {}
+
+  /**
+   * @return a number in [0, count)
+   */
+  std::size_t Below(std::size_t count) {
+    return count == 0 ? 0 : static_cast<std::size_t>(_engine() % count);
+  }
+
+  /**
+   * @return a number in [0, 1)
+   */
+  double Real() { return (_engine() >> 11) * (1.0 / 9007199254740992.0); }
+
+  /**
+   * Shuffles a vector in place
+   */
+  template <typename T>
+  void Shuffle(std::vector<T>* items) {
+    for (std::size_t i = items->size(); i > 1; i--) {
+      std::swap((*items)[i - 1], (*items)[Below(i)]);
+    }
+  }
+
+  /**
+   * @return 10 lowercase characters and numbers, like the ids the services
+   * generate
+   */
+  std::string Id() {
+    std::string id(10, ' ');
+    for (auto& character : id) {
+      int num = static_cast<int>(Below(36));
+      character = num < 26 ? 'a' + num : '0' + num - 26;
+    }
+    return id;
+  }
+
+ private:
+  std::mt19937_64 _engine;
+};
+
+/**
+ * Picks items with a Zipf distribution: the item at rank k is picked in
+ * proportion to 1 / (k + 1)^skew. Ranks are shuffled over the items, so the
+ * popular ones aren't all at the start of the collection
+ */
+class Zipf {
+ public:
+  Zipf(std::size_t count, double skew, Random* random) : _ranks(count) {
+    _cumulative.reserve(count);
+    double total = 0;
+    for (std::size_t rank = 0; rank < count; rank++) {
+      total += 1.0 / std::pow(static_cast<double>(rank + 1), skew);
+      _cumulative.push_back(total);
+    }
+    for (auto& weight : _cumulative) weight /= total;
+
+    for (std::size_t i = 0; i < count; i++) _ranks[i] = i;
+    random->Shuffle(&_ranks);
+  }
+
+  /**
+   * @return the index of the picked item
+   */
+  std::size_t Next(Random* random) const {
+    auto it = std::upper_bound(_cumulative.begin(), _cumulative.end(),
+                               random->Real());
+    std::size_t rank = std::min<std::size_t>(it - _cumulative.begin(),
+                                             _ranks.size() - 1);
+    return _ranks[rank];
+  }
+
+ private:
+  std::vector<double> _cumulative;
+  std::vector<std::size_t> _ranks;
+};
+
+/**
+ * Generates ids that haven't been used before in the dataset
+ */
+class Ids {
+ public:
+  explicit Ids(Random* random) : _random(random) {}
+
+  std::string Next() {
+    std::string id = _random->Id();
+    while (!_used.insert(id).second) id = _random->Id();
+    return id;
+  }
+
+ private:
+  Random* _random;
+  std::unordered_set<std::string> _used;
+};
+
+std::string FormatTime(time_t time) {
+  return TimeUtilities::ConvertTimeToString(TimeUtilities::ToUTC(time));
+}
+
+/**
+ * @return a time between from and end, or from if it is already past end
+ */
+time_t Between(time_t from, time_t end, Random* random) {
+  if (end <= from) return from;
+  return from + static_cast<time_t>(random->Below(end - from));
+}
+
+std::string Status(Random* random) {
+  int pick = static_cast<int>(random->Below(100));
+  for (int i = 0; i < 5; i++) {
+    if (pick < StatusWeights[i]) return Statuses[i];
+    pick -= StatusWeights[i];
+  }
+  return Statuses[0];
+}
+
+/**
+ * @return a unique name for the index-th user
+ */
+std::string Name(std::size_t index) {
+  const std::size_t first = sizeof(FirstNames) / sizeof(FirstNames[0]);
+  const std::size_t last = sizeof(LastNames) / sizeof(LastNames[0]);
+  std::string name = std::string(FirstNames[index % first]) + " " +
+                     LastNames[(index / first) % last];
+  if (index >= first * last) {
+    name += " " + std::to_string(index / (first * last));
+  }
+  return name;
+}
+}  // namespace
+
+Dataset DatasetGenerator::Generate() const {
+  Random random(_options.seed);
+  Ids ids(&random);
+  Dataset dataset;
+  const time_t end =
+      _options.start + static_cast<time_t>(_options.days) * SecondsPerDay;
+
+  // Users. Everyone but the managers can be assigned issues
+  std::vector<std::string> userIds;
+  std::vector<std::string> assignees;
+  for (std::size_t i = 0; i < _options.users; i++) {
+    std::string id = ids.Next();
+    std::string role = Roles[random.Below(4)];
+    dataset.users.push_back({{"id", id}, {"name", Name(i)}, {"role", role}});
+    userIds.push_back(id);
+    if (role != "Manager") assignees.push_back(id);
+  }
+  if (assignees.empty()) assignees = userIds;
+  if (userIds.empty()) return dataset;
+
+  // A few users report a large share of the issues
+  std::vector<std::string> heavyReporters = userIds;
+  random.Shuffle(&heavyReporters);
+  std::size_t heavyCount = static_cast<std::size_t>(
+      std::llround(_options.heavyReporters * userIds.size()));
+  heavyReporters.resize(std::min(heavyCount, userIds.size()));
+
+  // Issues, created in order over the time span
+  std::vector<time_t> issueTimes;
+  for (std::size_t i = 0; i < _options.issues; i++) {
+    time_t createdAt =
+        _options.start +
+        static_cast<time_t>((end - _options.start) * (i + random.Real()) /
+                            _options.issues);
+    bool heavy = !heavyReporters.empty() && random.Real() < _options.heavyShare;
+    std::string reporter =
+        heavy ? heavyReporters[random.Below(heavyReporters.size())]
+              : userIds[random.Below(userIds.size())];
+    std::string status = Status(&random);
+
+    json issue = {{"id", ids.Next()},
+                  {"title", std::string(Components[random.Below(12)]) + " " +
+                                Problems[random.Below(10)]},
+                  {"status", status},
+                  {"createdAt", FormatTime(createdAt)},
+                  {"createdBy", reporter},
+                  {"reporter", reporter},
+                  {"assignedTo", ""},
+                  {"updatedAt", ""},
+                  {"updatedBy", ""},
+                  {"comments", json::array()},
+                  {"votes", json::array()},
+                  {"version", 1}};
+
+    // Issues that have moved on from New have been assigned and updated
+    if (status != "New") {
+      std::string assignee = assignees[random.Below(assignees.size())];
+      issue["assignedTo"] = assignee;
+      issue["updatedAt"] = FormatTime(Between(createdAt, end, &random));
+      issue["updatedBy"] = assignee;
+      issue["version"] = 2;
+    }
+
+    dataset.issues.push_back(issue);
+    issueTimes.push_back(createdAt);
+  }
+  if (dataset.issues.empty()) return dataset;
+
+  // Comments, mostly on the popular issues
+  Zipf commentedIssues(_options.issues, _options.skew, &random);
+  for (std::size_t i = 0; i < _options.comments; i++) {
+    std::size_t issue = commentedIssues.Next(&random);
+    std::string id = ids.Next();
+    dataset.comments.push_back(
+        {{"id", id},
+         {"issueId", dataset.issues[issue]["id"]},
+         {"body", Remarks[random.Below(10)]},
+         {"createdAt", FormatTime(Between(issueTimes[issue], end, &random))},
+         {"createdBy", userIds[random.Below(userIds.size())]},
+         {"updatedAt", ""},
+         {"updatedBy", ""},
+         {"version", 1}});
+    dataset.issues[issue]["comments"].push_back(id);
+  }
+
+  // Votes, also mostly on the popular issues. Users vote for an issue at most
+  // once, unless there aren't enough of them left to choose from
+  Zipf votedIssues(_options.issues, _options.skew, &random);
+  std::unordered_set<std::string> voted;
+  for (std::size_t i = 0; i < _options.votes; i++) {
+    std::size_t issue = votedIssues.Next(&random);
+    std::string issueId = dataset.issues[issue]["id"];
+    std::string voter;
+    for (int attempt = 0; attempt < 8; attempt++) {
+      voter = userIds[random.Below(userIds.size())];
+      if (voted.insert(issueId + voter).second) break;
+    }
+
+    std::string id = ids.Next();
+    dataset.votes.push_back(
+        {{"id", id},
+         {"issueId", issueId},
+         {"createdAt", FormatTime(Between(issueTimes[issue], end, &random))},
+         {"createdBy", voter},
+         {"updatedAt", ""},
+         {"updatedBy", ""},
+         {"version", 1}});
+    dataset.issues[issue]["votes"].push_back(id);
+  }
+
+  return dataset;
+}
+
+void DatasetGenerator::Write(const Dataset& dataset,
+                             const std::string& directory) {
+  mkdir(directory.c_str(), 0755);
+
+  const std::pair<const char*, const json*> files[] = {
+      {"users.json", &dataset.users},
+      {"issues.json", &dataset.issues},
+      {"comments.json", &dataset.comments},
+      {"votes.json", &dataset.votes}};
+  for (auto& file : files) {
+    std::ofstream os;
+    std::ifstream is;
+    FileHandler fileHandler(os, is, directory + "/" + file.first);
+    fileHandler.write(*file.second);
+  }
+}
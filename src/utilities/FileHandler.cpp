@@ -1,47 +1,89 @@
 #include "FileHandler.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <string>
+#include "AllocationStats.h"
 #include "Exceptions.h"
 
 using json = nlohmann::json;
 
-void FileHandler::write(nlohmann::json updatedJson) {
-  // Clear the iostream
-  _os.open(fileName);
+namespace {
+/**
+ * Flushes a file, or a directory, from the system's cache to the disk
+ * @param path the path of the file or directory
+ * @return whether it was flushed
+ */
+bool SyncToDisk(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  return synced;
+}
+
+/**
+ * @param path the path of a file
+ * @return the directory the file is in
+ */
+std::string DirectoryOf(const std::string& path) {
+  std::size_t slash = path.rfind('/');
+  if (slash == std::string::npos) return ".";
+  return slash == 0 ? "/" : path.substr(0, slash);
+}
+}  // namespace
+
+void FileHandler::write(const nlohmann::json& updatedJson) {
+  AllocationStats::Phase phase("write");
+  // The data is written next to the file, and then replaces it, so the file
+  // is never left part way through a write
+  std::string temporary = fileName + ".tmp";
+  _os.open(temporary);
   // If the ostream is open
   if (_os) {
-    _os << std::setw(4) << updatedJson << std::endl;;
+    _os << std::setw(4) << updatedJson << std::endl;
   } else {
     throw InternalServerError(
         "The file stream was not able to be opened for reading. Check if your "
         "file path is correct");
   }
 
+  // The data is on the disk before it replaces the file, and the directory is
+  // flushed after, so the rename is kept too
   _os.close();
+  if (!_os || !SyncToDisk(temporary) ||
+      std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+    _os.clear();
+    throw InternalServerError("The file could not be saved");
+  }
+  SyncToDisk(DirectoryOf(fileName));
 }
 
 nlohmann::json FileHandler::read() {
-  // Clear the iostream
-  _is.open(fileName);
+  AllocationStats::Phase phase("read");
+  // The file is opened for each read, since a write replaces it with a new one
   _is.clear();
-  _is.seekg(0, _is.beg);
+  _is.open(fileName);
   // If the istream is open
-  if (_is) {
-    try {
-      return json::parse(_is);
-    }
-
-    catch (std::exception& e) {
-      throw InternalServerError(
-          "The file could not be read. Check if your JSON file has valid "
-          "syntax.");
-    }
-  } else {
+  if (!_is) {
+    _is.clear();
     throw InternalServerError(
         "The file stream was not able to be opened for reading. Check if your "
         "file path is correct");
   }
 
+  json data;
+  try {
+    data = json::parse(_is);
+  } catch (std::exception& e) {
+    _is.close();
+    throw InternalServerError(
+        "The file could not be read. Check if your JSON file has valid "
+        "syntax.");
+  }
   _is.close();
+  return data;
 }
@@ -0,0 +1,92 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+/**
+ * Values below this are counted exactly, one per bucket
+ */
+const uint64_t LinearBuckets = 128;
+
+/**
+ * The number of buckets for each power of two above LinearBuckets
+ */
+const uint64_t SubBuckets = 64;
+
+/**
+ * The largest value that can be recorded. Larger values are counted as this
+ */
+const uint64_t HighestTrackable = (uint64_t(1) << 40) - 1;
+
+/**
+ * @return the position of the highest set bit of a non-zero value
+ */
+int HighestBit(uint64_t value) {
+  int bit = 0;
+  while (value >>= 1) bit++;
+  return bit;
+}
+}  // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : _buckets(BucketOf(HighestTrackable) + 1, 0) {}
+
+std::size_t LatencyHistogram::BucketOf(uint64_t value) {
+  if (value < LinearBuckets) return static_cast<std::size_t>(value);
+
+  // Keep the top 7 bits of the value, the first of which is always set
+  int shift = HighestBit(value) - 6;
+  uint64_t sub = value >> shift;
+  return static_cast<std::size_t>(LinearBuckets + (shift - 1) * SubBuckets +
+                                  (sub - SubBuckets));
+}
+
+uint64_t LatencyHistogram::HighestIn(std::size_t bucket) {
+  if (bucket < LinearBuckets) return bucket;
+
+  int shift = static_cast<int>((bucket - LinearBuckets) / SubBuckets) + 1;
+  uint64_t sub = (bucket - LinearBuckets) % SubBuckets + SubBuckets;
+  return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+  value = std::min(value, HighestTrackable);
+  _buckets[BucketOf(value)]++;
+  _count++;
+  _sum += static_cast<double>(value);
+  _min = std::min(_min, value);
+  _max = std::max(_max, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (std::size_t i = 0; i < _buckets.size(); i++) {
+    _buckets[i] += other._buckets[i];
+  }
+  _count += other._count;
+  _sum += other._sum;
+  _min = std::min(_min, other._min);
+  _max = std::max(_max, other._max);
+}
+
+double LatencyHistogram::Mean() const {
+  return _count > 0 ? _sum / static_cast<double>(_count) : 0;
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+  if (_count == 0) return 0;
+
+  // The rank of the value at the percentile, counting from 1
+  percentile = std::max(0.0, std::min(100.0, percentile));
+  uint64_t rank = static_cast<uint64_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(_count)));
+  rank = std::max<uint64_t>(rank, 1);
+
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < _buckets.size(); i++) {
+    seen += _buckets[i];
+    if (seen >= rank) return std::min(HighestIn(i), _max);
+  }
+  return _max;
+}
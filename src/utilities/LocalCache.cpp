@@ -0,0 +1,311 @@
+#include "LocalCache.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+/**
+ * The name of the file the cache is saved in, inside its directory
+ */
+const char* const CacheFile = "cache.json";
+
+/**
+ * Creates a directory and any missing parents
+ * @param directory the directory to create
+ * @return whether the directory exists
+ */
+bool MakeDirectories(const std::string& directory) {
+  for (std::size_t slash = directory.find('/', 1);
+       slash != std::string::npos; slash = directory.find('/', slash + 1)) {
+    mkdir(directory.substr(0, slash).c_str(), 0755);
+  }
+  mkdir(directory.c_str(), 0755);
+
+  struct stat info;
+  return stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+}  // namespace
+
+std::string LocalCache::DefaultDirectory(const std::string& serverUri) {
+  const char* home = std::getenv("HOME");
+  std::string directory = std::string(home ? home : ".") + "/.hotTicket/";
+
+  // Keep the caches of different servers apart, using a name that is safe to
+  // use as a directory (i.e. http://localhost:8080 becomes localhost_8080)
+  std::string server = serverUri;
+  std::size_t scheme = server.find("://");
+  if (scheme != std::string::npos) server = server.substr(scheme + 3);
+  for (auto& c : server) {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') {
+      c = '_';
+    }
+  }
+  return directory + server;
+}
+
+void LocalCache::Load() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _collections.clear();
+  _fetched.clear();
+  _sequence = 0;
+  _epoch = "";
+  _dirty = false;
+
+  std::ifstream file(_directory + "/" + CacheFile);
+  if (!file) return;
+
+  try {
+    json cache = json::parse(file);
+    _sequence = cache.value("sequence", static_cast<uint64_t>(0));
+    _epoch = cache.value("epoch", "");
+    for (auto& key : cache.value("fetched", json::array())) {
+      _fetched.insert(key.get<std::string>());
+    }
+    json collections = cache.value("collections", json::object());
+    for (auto& collection : collections.items()) {
+      for (auto& entity : collection.value()) {
+        PutLocked(collection.key(), entity);
+      }
+    }
+    _dirty = false;
+  } catch (const std::exception& e) {
+    // A damaged cache is thrown away and fetched again
+    _collections.clear();
+    _fetched.clear();
+    _sequence = 0;
+    _epoch = "";
+  }
+}
+
+void LocalCache::Save() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_dirty) return;
+
+  json cache = {{"sequence", _sequence},
+                {"epoch", _epoch},
+                {"fetched", _fetched},
+                {"collections", json::object()}};
+  for (auto& collection : _collections) {
+    cache["collections"][collection.first] = collection.second.entities;
+  }
+
+  if (!MakeDirectories(_directory)) {
+    throw InternalServerError(
+        std::string("Unable to create the cache directory " + _directory)
+            .c_str());
+  }
+
+  // Write to a temporary file first, so a crash part way through never leaves
+  // a damaged cache behind
+  std::string path = _directory + "/" + CacheFile;
+  std::string temporaryPath = path + ".tmp";
+  {
+    std::ofstream file(temporaryPath);
+    if (!file) {
+      throw InternalServerError(
+          std::string("Unable to write the cache to " + temporaryPath)
+              .c_str());
+    }
+    file << cache.dump();
+  }
+  if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    throw InternalServerError(
+        std::string("Unable to write the cache to " + path).c_str());
+  }
+  _dirty = false;
+}
+
+void LocalCache::Clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _collections.clear();
+  _fetched.clear();
+  _sequence = 0;
+  _epoch = "";
+  _dirty = true;
+}
+
+bool LocalCache::Fetched(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _fetched.count(key) > 0;
+}
+
+void LocalCache::Fetch(const std::string& collection, const std::string& key,
+                       const json& entities) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto& entity : entities) {
+    PutLocked(collection, entity);
+  }
+  _fetched.insert(key);
+  _dirty = true;
+}
+
+void LocalCache::Put(const std::string& collection, const json& entity) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  PutLocked(collection, entity);
+}
+
+void LocalCache::Remove(const std::string& collection, const std::string& id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  RemoveLocked(collection, id);
+}
+
+json LocalCache::Find(const std::string& collection, const std::string& id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto itCollection = _collections.find(collection);
+  if (itCollection == _collections.end()) return nullptr;
+
+  auto itIndex = itCollection->second.index.find(id);
+  if (itIndex == itCollection->second.index.end()) return nullptr;
+  return itCollection->second.entities[itIndex->second];
+}
+
+std::vector<json> LocalCache::Get(const std::string& collection,
+                                  const StringMap& query) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<json> matched;
+  auto itCollection = _collections.find(collection);
+  if (itCollection == _collections.end()) return matched;
+
+  for (auto& entity : itCollection->second.entities) {
+    bool found = true;
+    // Each field has to match one of the values given for it
+    for (auto it = query.begin(); found && it != query.end();
+         it = query.upper_bound(it->first)) {
+      auto values = query.equal_range(it->first);
+      found = entity.contains(it->first) &&
+              std::any_of(values.first, values.second,
+                          [&](const std::pair<const std::string, std::string>&
+                                  value) {
+                            return entity[it->first] == value.second;
+                          });
+    }
+    if (found) matched.push_back(entity);
+  }
+  return matched;
+}
+
+void LocalCache::Apply(const json& change) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::string collection = change.value("collection", "");
+  std::string op = change.value("op", "");
+  std::string id = change.value("id", "");
+
+  if (op == "delete") {
+    RemoveLocked(collection, id);
+    LinkToIssue(collection, id, "");
+  } else if (change.contains("entity") && change["entity"].is_object()) {
+    json entity = change["entity"];
+
+    // The comments and votes of an issue are kept current by their own
+    // changes, so they are kept when the issue itself changes
+    auto itCollection = _collections.find(collection);
+    if (collection == "issues" && itCollection != _collections.end()) {
+      auto itIndex = itCollection->second.index.find(id);
+      if (itIndex != itCollection->second.index.end()) {
+        json& cached = itCollection->second.entities[itIndex->second];
+        if (cached.contains("comments")) entity["comments"] = cached["comments"];
+        if (cached.contains("votes")) entity["votes"] = cached["votes"];
+      }
+    }
+    PutLocked(collection, entity);
+
+    std::string issueId = entity.value("issueId", "");
+    if (op == "create" && !issueId.empty()) {
+      LinkToIssue(collection, id, issueId);
+    }
+  }
+
+  _sequence = std::max(_sequence,
+                       change.value("sequence", static_cast<uint64_t>(0)));
+  _dirty = true;
+}
+
+uint64_t LocalCache::Sequence() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _sequence;
+}
+
+void LocalCache::SetSequence(uint64_t sequence) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_sequence != sequence) _dirty = true;
+  _sequence = sequence;
+}
+
+std::string LocalCache::Epoch() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _epoch;
+}
+
+void LocalCache::SetEpoch(const std::string& epoch) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_epoch != epoch) _dirty = true;
+  _epoch = epoch;
+}
+
+void LocalCache::PutLocked(const std::string& collection, const json& entity) {
+  std::string id = entity.value("id", "");
+  if (id.empty()) return;
+
+  Collection& cached = _collections[collection];
+  auto itIndex = cached.index.find(id);
+  if (itIndex != cached.index.end()) {
+    cached.entities[itIndex->second] = entity;
+  } else {
+    cached.index[id] = cached.entities.size();
+    cached.entities.push_back(entity);
+  }
+  _dirty = true;
+}
+
+void LocalCache::RemoveLocked(const std::string& collection,
+                              const std::string& id) {
+  auto itCollection = _collections.find(collection);
+  if (itCollection == _collections.end()) return;
+
+  Collection& cached = itCollection->second;
+  auto itIndex = cached.index.find(id);
+  if (itIndex == cached.index.end()) return;
+
+  // Keep the entities in order, and move the positions after it back by one
+  std::size_t position = itIndex->second;
+  cached.entities.erase(cached.entities.begin() + position);
+  cached.index.erase(itIndex);
+  for (auto& index : cached.index) {
+    if (index.second > position) index.second--;
+  }
+  _dirty = true;
+}
+
+void LocalCache::LinkToIssue(const std::string& collection,
+                             const std::string& id,
+                             const std::string& issueId) {
+  if (collection != "comments" && collection != "votes") return;
+  auto itIssues = _collections.find("issues");
+  if (itIssues == _collections.end()) return;
+
+  for (auto& issue : itIssues->second.entities) {
+    if (!issueId.empty() && issue.value("id", "") != issueId) continue;
+
+    json& ids = issue[collection];
+    if (!ids.is_array()) ids = json::array();
+    auto itId = std::find(ids.begin(), ids.end(), id);
+    if (issueId.empty() && itId != ids.end()) {
+      ids.erase(itId);
+    } else if (!issueId.empty() && itId == ids.end()) {
+      ids.push_back(id);
+    }
+  }
+}
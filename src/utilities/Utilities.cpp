@@ -11,6 +11,7 @@
 #include <sstream>
 #include <string>
 
+#include "AllocationStats.h"
 #include "Exceptions.h"
 #include "ServerErrorResponse.h"
 #include "User.h"
@@ -48,6 +49,61 @@ int DigitCount(int i) {
   }
   return count;
 }
+
+int ParseVersionTag(const std::string& header) {
+  std::string tag = header;
+  tag.erase(0, tag.find_first_not_of(" \t"));
+  tag.erase(tag.find_last_not_of(" \t") + 1);
+  if (tag.empty() || tag == "*") return -1;
+
+  // Versions are handed out as entity tags, so accept them in that form too
+  if (tag.compare(0, 2, "W/") == 0) tag.erase(0, 2);
+  if (tag.size() >= 2 && tag.front() == '"' && tag.back() == '"') {
+    tag = tag.substr(1, tag.size() - 2);
+  }
+
+  // The tag of an Entity (see BuildEntityETag) starts with its version
+  std::size_t dot = tag.find('.');
+  std::string rest = dot == std::string::npos ? "" : tag.substr(dot + 1);
+  if (dot != std::string::npos) tag.erase(dot);
+
+  if (tag.empty() || tag.size() > 9 ||
+      tag.find_first_not_of("0123456789") != std::string::npos ||
+      (dot != std::string::npos &&
+       (rest.empty() ||
+        rest.find_first_not_of("0123456789-") != std::string::npos))) {
+    throw BadRequestError(
+        std::string("The If-Match header must be a version or the ETag of "
+                    "an Entity, not " +
+                    header)
+            .c_str());
+  }
+  return std::stoi(tag);
+}
+
+json ParseBulkBody(const std::string& body) {
+  std::size_t start = body.find_first_not_of(" \t\r\n");
+  try {
+    if (start != std::string::npos && body[start] == '[') {
+      return json::parse(body);
+    }
+
+    // Otherwise there is one value per line
+    json values = json::array();
+    std::stringstream stream(body);
+    std::string line;
+    while (std::getline(stream, line)) {
+      if (line.find_first_not_of(" \t\r") != std::string::npos) {
+        values.push_back(json::parse(line));
+      }
+    }
+    return values;
+  } catch (const json::exception& e) {
+    throw BadRequestError(
+        std::string("Unable to parse the bulk request: " + std::string(e.what()))
+            .c_str());
+  }
+}
 }  // namespace Utilities
 
 namespace TimeUtilities {
@@ -74,14 +130,127 @@ std::string ConvertTimeToString(struct tm time) {
 }
 
 bool DateComparator(struct tm tm1, struct tm tm2) {
-  return difftime(mktime(&tm1), mktime(&tm2)) < 0.0;
+  return ToSeconds(tm1) < ToSeconds(tm2);
+}
+
+namespace {
+/**
+ * @return the number of days from Jan 01 1970 to a date of the proleptic
+ * Gregorian calendar, from Howard Hinnant's days_from_civil
+ */
+int64_t DaysFromCivil(int64_t year, int64_t month, int64_t day) {
+  year -= month <= 2;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const int64_t yearOfEra = year - era * 400;
+  const int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 +
+                            day - 1;
+  const int64_t dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * Reads a fixed number of digits
+ * @return whether there were that many digits at the position
+ */
+bool ReadDigits(const std::string& text, std::size_t position,
+                std::size_t count, int* value) {
+  if (position + count > text.size()) return false;
+  *value = 0;
+  for (std::size_t i = position; i < position + count; i++) {
+    if (text[i] < '0' || text[i] > '9') return false;
+    *value = *value * 10 + (text[i] - '0');
+  }
+  return true;
+}
+
+bool ValidTime(const struct tm& time) {
+  return time.tm_mon >= 0 && time.tm_mon < 12 && time.tm_mday >= 1 &&
+         time.tm_mday <= 31 && time.tm_hour < 24 && time.tm_min < 60 &&
+         time.tm_sec <= 60;
+}
+
+/**
+ * Reads Www Mmm dd hh:mm:ss yyyy, the format of our JSON file
+ */
+bool ParseStoredTime(const std::string& text, struct tm* time) {
+  static const char* const Months[] = {"Jan", "Feb", "Mar", "Apr",
+                                       "May", "Jun", "Jul", "Aug",
+                                       "Sep", "Oct", "Nov", "Dec"};
+  if (text.size() != 24 || text[3] != ' ' || text[7] != ' ' ||
+      text[10] != ' ' || text[13] != ':' || text[16] != ':' ||
+      text[19] != ' ') {
+    return false;
+  }
+
+  time->tm_mon = -1;
+  for (int month = 0; month < 12; month++) {
+    if (text.compare(4, 3, Months[month]) == 0) time->tm_mon = month;
+  }
+
+  int year;
+  if (!ReadDigits(text, 8, 2, &time->tm_mday) ||
+      !ReadDigits(text, 11, 2, &time->tm_hour) ||
+      !ReadDigits(text, 14, 2, &time->tm_min) ||
+      !ReadDigits(text, 17, 2, &time->tm_sec) ||
+      !ReadDigits(text, 20, 4, &year)) {
+    return false;
+  }
+  time->tm_year = year - 1900;
+  return ValidTime(*time);
+}
+
+/**
+ * Reads yyyy-mm-dd, optionally followed by Thh:mm:ss and Z
+ */
+bool ParseIsoTime(std::string text, struct tm* time) {
+  if (!text.empty() && text.back() == 'Z') text.pop_back();
+  if (text.size() != 10 && text.size() != 19) return false;
+  if (text[4] != '-' || text[7] != '-') return false;
+
+  int year, month;
+  if (!ReadDigits(text, 0, 4, &year) || !ReadDigits(text, 5, 2, &month) ||
+      !ReadDigits(text, 8, 2, &time->tm_mday)) {
+    return false;
+  }
+  time->tm_year = year - 1900;
+  time->tm_mon = month - 1;
+
+  time->tm_hour = time->tm_min = time->tm_sec = 0;
+  if (text.size() == 19 &&
+      (text[10] != 'T' || text[13] != ':' || text[16] != ':' ||
+       !ReadDigits(text, 11, 2, &time->tm_hour) ||
+       !ReadDigits(text, 14, 2, &time->tm_min) ||
+       !ReadDigits(text, 17, 2, &time->tm_sec))) {
+    return false;
+  }
+  return ValidTime(*time);
+}
+}  // namespace
+
+int64_t ToSeconds(const struct tm& time) {
+  return DaysFromCivil(time.tm_year + 1900LL, time.tm_mon + 1, time.tm_mday) *
+             86400 +
+         time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec;
+}
+
+bool ParseSeconds(const std::string& stringTime, int64_t* seconds) {
+  struct tm time = {};
+  if (!ParseStoredTime(stringTime, &time) && !ParseIsoTime(stringTime, &time)) {
+    return false;
+  }
+  *seconds = ToSeconds(time);
+  return true;
 }
 
-struct tm CurrentTimeUTC() {
-  time_t t = time(0);
-  return *gmtime(&t);
+struct tm ToUTC(time_t time) {
+  struct tm utc = {};
+  gmtime_r(&time, &utc);
+  return utc;
 }
 
+struct tm CurrentTimeUTC() { return ToUTC(time(0)); }
+
 struct tm NullTimeUTC() {
   struct tm nullTime;
   nullTime.tm_hour = 0;
@@ -99,10 +268,14 @@ struct tm NullTimeUTC() {
 
 namespace ResponseUtilities {
 StringMap BuildResponseHeader(const StringMap& parameters) {
-  StringMap headers = {ALLOW_ALL, CLOSE_CONNECTION};
+  StringMap headers = {ALLOW_ALL};
   for (auto param : parameters) {
     headers.insert(param);
   }
+
+  // Instrumented servers report what the request has allocated so far
+  std::string allocations = AllocationStats::Header();
+  if (!allocations.empty()) headers.insert({"X-Allocations", allocations});
   return headers;
 }
 
@@ -123,7 +296,10 @@ json HandleResponse(std::shared_ptr<restbed::Response> response) {
   if (status_code >= 100 && status_code < 200) {
     // Informational codes. Do nothing?
   } else if (status_code >= 200 && status_code < 300) {
-    restbed::Http::fetch(length, response);
+    // Responses sent through a ConnectionPool already have their body
+    if (response->get_body().size() < static_cast<std::size_t>(length)) {
+      restbed::Http::fetch(length, response);
+    }
     std::string responseStr(
         reinterpret_cast<char*>(response->get_body().data()), length);
 
@@ -132,7 +308,9 @@ json HandleResponse(std::shared_ptr<restbed::Response> response) {
   } else if (status_code >= 300 && status_code < 400) {
     // Redirects. Do nothing?
   } else if (status_code >= 400 && status_code < 600) {
-    restbed::Http::fetch(length, response);
+    if (response->get_body().size() < static_cast<std::size_t>(length)) {
+      restbed::Http::fetch(length, response);
+    }
     std::string responseStr(
         reinterpret_cast<char*>(response->get_body().data()), length);
 
@@ -161,9 +339,46 @@ json HandleResponse(std::shared_ptr<restbed::Response> response) {
 }
 
 StringMap BuildResponseHeaders(const std::string& body) {
-  StringMap headers = {ALLOW_ALL, CLOSE_CONNECTION, CONTENT_LENGTH(body)};
+  StringMap headers = {ALLOW_ALL, CONTENT_LENGTH(body)};
   return headers;
 }
+
+std::string BuildETag(const uint64_t& generation) {
+  // Initialized once, the first time a tag is built
+  static const time_t startTime = time(0);
+  return "W/\"" + std::to_string(startTime) + "-" +
+         std::to_string(generation) + "\"";
+}
+
+std::string BuildEntityETag(int version, const uint64_t& generation) {
+  // W/"<start>-<generation>" becomes W/"<version>.<start>-<generation>"
+  std::string tag = BuildETag(generation);
+  return "W/\"" + std::to_string(version) + "." + tag.substr(3);
+}
+
+bool ETagMatches(const std::string& header, const std::string& etag) {
+  // Weak comparison ignores the W/ prefix
+  auto opaqueTag = [](std::string tag) {
+    std::size_t start = tag.find_first_not_of(" \t");
+    std::size_t end = tag.find_last_not_of(" \t");
+    if (start == std::string::npos) return std::string();
+    tag = tag.substr(start, end - start + 1);
+    if (tag.compare(0, 2, "W/") == 0) tag.erase(0, 2);
+    return tag;
+  };
+
+  std::string current = opaqueTag(etag);
+  std::stringstream stream(header);
+  std::string tag;
+  // The header is a comma separated list of tags, or *
+  while (std::getline(stream, tag, ',')) {
+    tag = opaqueTag(tag);
+    if (tag == "*" || (!tag.empty() && tag == current)) {
+      return true;
+    }
+  }
+  return false;
+}
 }  // namespace ResponseUtilities
 
 namespace RequestUtilities {
@@ -228,4 +443,107 @@ std::shared_ptr<restbed::Request> CreateDeleteRequest(
   // Build and return request
   return CreateGenericRequest(baseUri, endpoint, "DELETE");
 }
+
+std::shared_ptr<restbed::Response> ConnectionPool::Send(
+    const std::shared_ptr<restbed::Request>& request) {
+  auto connection = Acquire();
+
+  // Point the pooled connection at the new request
+  connection->set_protocol(request->get_protocol());
+  connection->set_host(request->get_host());
+  connection->set_port(request->get_port());
+  connection->set_version(request->get_version());
+  connection->set_method(request->get_method());
+  connection->set_path(request->get_path());
+  connection->set_headers(request->get_headers());
+  connection->set_query_parameters(request->get_query_parameters());
+  connection->set_body(request->get_body());
+
+  std::shared_ptr<restbed::Response> response;
+  try {
+    auto pooledResponse = restbed::Http::sync(connection);
+
+    // Read the whole body, so nothing is left on the connection for the next
+    // request
+    std::size_t length = pooledResponse->get_header("Content-Length", 0);
+    if (length > 0) {
+      restbed::Http::fetch(length, pooledResponse);
+    }
+
+    // Copy the response, so it can outlive the connection being reused
+    response = std::make_shared<restbed::Response>();
+    response->set_status_code(pooledResponse->get_status_code());
+    response->set_headers(pooledResponse->get_headers());
+    response->set_body(pooledResponse->get_body());
+
+    if (pooledResponse->get_header("Connection") == "close") {
+      restbed::Http::close(connection);
+    }
+  } catch (...) {
+    // The connection is in an unknown state, so start over with it
+    restbed::Http::close(connection);
+    Release(connection);
+    throw;
+  }
+
+  Release(connection);
+  return response;
+}
+
+std::shared_ptr<restbed::Request> ConnectionPool::Acquire() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _released.wait(lock,
+                 [&]() { return !_idle.empty() || _opened < _maxConnections; });
+
+  if (!_idle.empty()) {
+    auto connection = _idle.back();
+    _idle.pop_back();
+    return connection;
+  }
+  _opened++;
+  return std::make_shared<restbed::Request>();
+}
+
+void ConnectionPool::Release(
+    const std::shared_ptr<restbed::Request>& connection) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _idle.push_back(connection);
+  }
+  _released.notify_one();
+}
+
+namespace {
+/**
+ * The most connections each new ConnectionPool opens
+ */
+std::size_t connectionsPerServer = ConnectionPool::DefaultConnections;
+}  // namespace
+
+void SetConnectionsPerServer(std::size_t maxConnections) {
+  connectionsPerServer = maxConnections;
+}
+
+std::shared_ptr<restbed::Response> Send(
+    const std::shared_ptr<restbed::Request>& request) {
+  static std::mutex poolsMutex;
+  static std::map<std::string, std::shared_ptr<ConnectionPool>> pools;
+
+  // Requests to the same server share a pool
+  std::string server = request->get_protocol() + "://" + request->get_host() +
+                       ":" + std::to_string(request->get_port());
+  std::shared_ptr<ConnectionPool> pool;
+  {
+    std::lock_guard<std::mutex> lock(poolsMutex);
+    auto& entry = pools[server];
+    if (!entry) entry = std::make_shared<ConnectionPool>(connectionsPerServer);
+    pool = entry;
+  }
+  return pool->Send(request);
+}
+
+std::future<std::shared_ptr<restbed::Response>> SendAsync(
+    const std::shared_ptr<restbed::Request>& request) {
+  return std::async(std::launch::async, [request]() { return Send(request); });
+}
 }  // namespace RequestUtilities
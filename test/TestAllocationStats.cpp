@@ -0,0 +1,107 @@
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "AllocationStats.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * The test program doesn't replace operator new, so the only allocations
+ * counted are the ones the tests count themselves
+ */
+class TestAllocationStats : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    AllocationStats::SetEnabled(true);
+    AllocationStats::Reset();
+  }
+
+  void TearDown() override {
+    AllocationStats::SetEnabled(false);
+    AllocationStats::Reset();
+  }
+};
+
+TEST_F(TestAllocationStats, Request_CountsPhases) {
+  {
+    AllocationStats::Request request("/issues", "GET");
+    AllocationStats::Count(10);
+    {
+      AllocationStats::Phase service("service");
+      AllocationStats::Count(100);
+      {
+        AllocationStats::Phase read("read");
+        AllocationStats::Count(1000);
+      }
+      AllocationStats::Count(100);
+    }
+    AllocationStats::Count(10);
+  }
+
+  json report = AllocationStats::Snapshot();
+  EXPECT_TRUE(report["enabled"].get<bool>());
+
+  json issues = report["requests"]["GET /issues"];
+  EXPECT_EQ(1, issues["requests"]);
+  EXPECT_EQ(5, issues["allocations"]);
+  EXPECT_EQ(1220, issues["bytes"]);
+  EXPECT_EQ(2, issues["phases"]["controller"]["allocations"]);
+  EXPECT_EQ(20, issues["phases"]["controller"]["bytes"]);
+  EXPECT_EQ(2, issues["phases"]["service"]["allocations"]);
+  EXPECT_EQ(200, issues["phases"]["service"]["bytes"]);
+  EXPECT_EQ(1, issues["phases"]["read"]["allocations"]);
+  EXPECT_EQ(1000, issues["phases"]["read"]["bytes"]);
+}
+
+TEST_F(TestAllocationStats, Snapshot_AveragesRequests) {
+  for (int i = 1; i <= 2; i++) {
+    AllocationStats::Request request("/users", "POST");
+    for (int j = 0; j < i; j++) AllocationStats::Count(64);
+  }
+
+  json users = AllocationStats::Snapshot()["requests"]["POST /users"];
+  EXPECT_EQ(2, users["requests"]);
+  EXPECT_EQ(3, users["allocations"]);
+  EXPECT_DOUBLE_EQ(1.5, users["allocationsPerRequest"].get<double>());
+  EXPECT_DOUBLE_EQ(96, users["bytesPerRequest"].get<double>());
+
+  AllocationStats::Reset();
+  EXPECT_TRUE(AllocationStats::Snapshot()["requests"].empty());
+}
+
+TEST_F(TestAllocationStats, Header_ReportsRequestSoFar) {
+  EXPECT_EQ("", AllocationStats::Header());
+
+  AllocationStats::Request request("/votes", "GET");
+  AllocationStats::Count(8);
+  {
+    AllocationStats::Phase phase("service");
+    AllocationStats::Count(24);
+  }
+  EXPECT_EQ("allocations=2; bytes=32", AllocationStats::Header());
+}
+
+TEST_F(TestAllocationStats, Request_DoesNothingWhenDisabledOrNested) {
+  AllocationStats::SetEnabled(false);
+  {
+    AllocationStats::Request request("/issues", "GET");
+    AllocationStats::Phase phase("service");
+    AllocationStats::Count(10);
+    EXPECT_EQ("", AllocationStats::Header());
+  }
+  EXPECT_TRUE(AllocationStats::Snapshot()["requests"].empty());
+
+  // Only the outer request is accounted for
+  AllocationStats::SetEnabled(true);
+  {
+    AllocationStats::Request outer("/issues", "GET");
+    AllocationStats::Request inner("/users", "GET");
+    AllocationStats::Count(10);
+  }
+  json requests = AllocationStats::Snapshot()["requests"];
+  EXPECT_EQ(1, requests.size());
+  EXPECT_EQ(1, requests["GET /issues"]["allocations"]);
+}
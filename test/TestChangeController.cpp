@@ -0,0 +1,164 @@
+#include <restbed>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "ChangeController.hpp"
+#include "ChangeLog.h"
+#include "MockSession.h"
+#include "Utilities.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+
+using ::testing::_;
+using ::testing::AllOf;
+using ::testing::Contains;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::Pair;
+using ::testing::Return;
+
+using json = nlohmann::json;
+
+/**
+ * Fixture class for bootstrapping the test process
+ */
+class TestChangeController : public ::testing::Test {
+ protected:
+  std::shared_ptr<ChangeLog> changeLog = std::make_shared<ChangeLog>(2);
+  ChangeController<MockSession> controller;
+  std::shared_ptr<MockSession> mockSession;
+  std::shared_ptr<restbed::Request> request;
+
+  void SetUp() override {
+    mockSession = std::make_shared<MockSession>();
+    request = std::make_shared<restbed::Request>();
+    request->set_path("/changes");
+    controller.SetChangeLog(changeLog);
+
+    changeLog->Append("issues", "create", "a1", {{"id", "a1"}});
+    changeLog->Append("users", "delete", "b2", nullptr);
+  }
+};
+
+TEST_F(TestChangeController, Get_Since) {
+  request->set_query_parameter("since", "1");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Only the change after the first one is sent, along with the next sequence
+  EXPECT_CALL(*mockSession,
+              yield(restbed::OK,
+                    AllOf(HasSubstr("\"id\":\"b2\""),
+                          Not(HasSubstr("\"id\":\"a1\"")),
+                          HasSubstr("\"next\":2")),
+                    _))
+      .Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestChangeController, Get_SinceLatest) {
+  request->set_query_parameter("since", "latest");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Clients starting from the latest change get no changes, and the epoch to
+  // check on their next request
+  EXPECT_CALL(*mockSession,
+              yield(restbed::OK,
+                    AllOf(HasSubstr("\"changes\":[]"),
+                          HasSubstr("\"next\":2"),
+                          HasSubstr("\"epoch\":\"" + changeLog->Epoch())),
+                    _))
+      .Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestChangeController, Get_EventStream) {
+  request->add_header("Accept", "text/event-stream");
+  request->add_header("Last-Event-ID", "1");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Each change is an event, whose id is its sequence. The stream ends with
+  // the connection
+  EXPECT_CALL(*mockSession,
+              close(restbed::OK,
+                    AllOf(HasSubstr("id: 2\nevent: change\ndata: "),
+                          Not(HasSubstr("id: 1\n"))),
+                    Contains(Pair("Connection", "close"))))
+      .Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestChangeController, Get_DroppedChanges) {
+  // The log only keeps two changes, so the first one is dropped
+  changeLog->Append("issues", "patch", "a1", {{"id", "a1"}});
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  EXPECT_CALL(*mockSession, yield(restbed::GONE, _, _)).Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestChangeController, Get_InvalidSince) {
+  request->set_query_parameter("since", "-4");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, _, _)).Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestChangeController, Get_Wait_TooManyWaiters) {
+  controller.SetMaxWaiters(0);
+  request->set_query_parameter("since", "latest");
+  request->set_query_parameter("wait", "30");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Nothing has changed, and the request can't wait, so it is told to retry
+  EXPECT_CALL(*mockSession, yield(restbed::SERVICE_UNAVAILABLE, _,
+                                  Contains(Pair("Retry-After", "1"))))
+      .Times(1);
+
+  controller.Get(mockSession);
+  EXPECT_EQ(0, controller.Waiting());
+}
+
+TEST_F(TestChangeController, Get_Wait_ChangesAlreadyMade) {
+  // A request that has changes to get doesn't wait, so it isn't limited
+  controller.SetMaxWaiters(0);
+  request->set_query_parameter("since", "1");
+  request->set_query_parameter("wait", "30");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  EXPECT_CALL(*mockSession, yield(restbed::OK, HasSubstr("\"next\":2"), _))
+      .Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestChangeController, Get_Wait_WokenByChange) {
+  controller.SetMaxWaiters(1);
+  request->set_query_parameter("since", "2");
+  request->set_query_parameter("wait", "30");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+  EXPECT_CALL(*mockSession, yield(restbed::OK, HasSubstr("\"next\":3"), _))
+      .Times(1);
+
+  std::thread waiting([this]() { controller.Get(mockSession); });
+  while (controller.Waiting() == 0) std::this_thread::yield();
+
+  // The only place to wait is taken
+  auto otherSession = std::make_shared<MockSession>();
+  EXPECT_CALL(*otherSession, get_request()).WillOnce(Return(request));
+  EXPECT_CALL(*otherSession, yield(restbed::SERVICE_UNAVAILABLE, _, _))
+      .Times(1);
+  controller.Get(otherSession);
+
+  changeLog->Append("issues", "patch", "a1", {{"id", "a1"}});
+  waiting.join();
+  EXPECT_EQ(0, controller.Waiting());
+}
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "ChangeLog.h"
+#include "Exceptions.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+TEST(TestChangeLog, Append_AssignsSequence) {
+  ChangeLog changeLog;
+  EXPECT_EQ(0, changeLog.Latest());
+
+  EXPECT_EQ(1, changeLog.Append("issues", "create", "a1", {{"id", "a1"}}));
+  EXPECT_EQ(2, changeLog.Append("users", "delete", "b2", nullptr));
+  EXPECT_EQ(2, changeLog.Latest());
+}
+
+TEST(TestChangeLog, Subscribe) {
+  ChangeLog changeLog;
+  std::vector<uint64_t> sequences;
+  changeLog.Append("issues", "create", "a1", {{"id", "a1"}});
+  changeLog.Subscribe(
+      [&sequences](const Change& change) {
+        sequences.push_back(change.sequence);
+      });
+
+  // Only the changes after subscribing are given to the subscriber
+  changeLog.Append("issues", "delete", "a1", nullptr);
+  changeLog.Append("votes", "create", "b2", {{"id", "b2"}});
+  EXPECT_EQ(std::vector<uint64_t>({2, 3}), sequences);
+}
+
+TEST(TestChangeLog, Since) {
+  ChangeLog changeLog;
+  changeLog.Append("issues", "create", "a1", {{"id", "a1"}});
+  changeLog.Append("issues", "patch", "a1", {{"id", "a1"}});
+  changeLog.Append("votes", "delete", "c3", nullptr);
+
+  std::vector<Change> changes = changeLog.Since(0, 10);
+  ASSERT_EQ(3, changes.size());
+  EXPECT_EQ("create", changes[0].op);
+
+  changes = changeLog.Since(1, 10);
+  ASSERT_EQ(2, changes.size());
+  EXPECT_EQ(2, changes[0].sequence);
+  EXPECT_EQ("votes", changes[1].collection);
+  EXPECT_TRUE(changes[1].entity.is_null());
+
+  // The limit caps the number of changes
+  EXPECT_EQ(1, changeLog.Since(0, 1).size());
+  EXPECT_TRUE(changeLog.Since(3, 10).empty());
+}
+
+TEST(TestChangeLog, Since_DroppedChanges) {
+  ChangeLog changeLog(2);
+  changeLog.Append("issues", "create", "a1", {{"id", "a1"}});
+  changeLog.Append("issues", "create", "a2", {{"id", "a2"}});
+  changeLog.Append("issues", "create", "a3", {{"id", "a3"}});
+
+  // The first change was dropped, so a client that never saw it is behind
+  EXPECT_THROW(changeLog.Since(0, 10), GoneError);
+  EXPECT_EQ(2, changeLog.Since(1, 10).size());
+}
+
+TEST(TestChangeLog, WaitForChanges) {
+  ChangeLog changeLog;
+  EXPECT_FALSE(changeLog.WaitForChanges(0, std::chrono::milliseconds(1)));
+
+  std::thread writer([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    changeLog.Append("issues", "create", "a1", {{"id", "a1"}});
+  });
+  EXPECT_TRUE(changeLog.WaitForChanges(0, std::chrono::seconds(5)));
+  writer.join();
+}
@@ -24,7 +24,7 @@ class MockUserService : public UserService {
   MockUserService() {}
   virtual ~MockUserService() {}
 
-  MOCK_METHOD1(Get, User(std::string));
+  MOCK_METHOD1(Get, User(const std::string&));
 };
 
 class TestCommentService : public ::testing::Test {
@@ -78,14 +78,14 @@ class TestCommentService : public ::testing::Test {
 };
 
 TEST_F(TestCommentService, GetComments_NoQuery) {
-  // The user service should be called twice (getting the users for : 1x
-  // createdBy, 1x updatedBy) * 2 JSON comments
-  EXPECT_CALL(*userService, Get(fakeUser.id))
-      .Times(2)
+  // Each comment has one user as both createdBy and updatedBy, and each user
+  // is only fetched once
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser));
 
-  EXPECT_CALL(*userService, Get(fakeUser2.id))
-      .Times(2)
+  EXPECT_CALL(*userService, Get(fakeUser2.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser2));
 
   // We should read the json data once
@@ -96,10 +96,10 @@ TEST_F(TestCommentService, GetComments_NoQuery) {
 }
 
 TEST_F(TestCommentService, GetComments_WithQuery_ExpectOneResult) {
-  // The user service should be called once. (1x createdBy 1x updatedBy) * 1
-  // (issueID query = 1 JSON comment)
-  EXPECT_CALL(*userService, Get(fakeUser.id))
-      .Times(2)
+  // The user service should be called once, for the createdBy and updatedBy
+  // of the 1 JSON comment matching the issueId query
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser));
 
   // We should read the json data once
@@ -122,10 +122,10 @@ TEST_F(TestCommentService, GetComments_WithQuery_ExpectNoResults) {
 }
 
 TEST_F(TestCommentService, GetComment_ValidId) {
-  // The user service should be called once. (1x createdBy, 1x updatedBy) * 1 (1
-  // JSON comment with id 2222)
-  EXPECT_CALL(*userService, Get(fakeUser.id))
-      .Times(2)
+  // The user service should be called once, for the createdBy and updatedBy
+  // of the JSON comment with id 2222
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser));
 
   // We should read the json data once
@@ -135,10 +135,10 @@ TEST_F(TestCommentService, GetComment_ValidId) {
   EXPECT_EQ("2222", comment.id);
   EXPECT_EQ("123456", comment.issueId);
   EXPECT_EQ(fakeUser.id, comment.createdBy.id);
-  EXPECT_EQ(fakeUser.name, comment.createdBy.name);
+  EXPECT_EQ(fakeUser.name, comment.createdBy.Name());
 
   EXPECT_EQ(fakeUser.id, comment.updatedBy.id);
-  EXPECT_EQ(fakeUser.name, comment.updatedBy.name);
+  EXPECT_EQ(fakeUser.name, comment.updatedBy.Name());
 
   EXPECT_EQ("Example body content1", comment.body);
 }
@@ -188,7 +188,7 @@ TEST_F(TestCommentService, CreateComment_ValidComment) {
   // TODO(someone): Add check from Issue Service that this is a valid Issue ID
   EXPECT_THAT(result.issueId, StrEq("123456"));
   EXPECT_EQ(result.createdBy.id, fakeUser.id);
-  EXPECT_EQ(result.createdBy.name, fakeUser.name);
+  EXPECT_EQ(result.createdBy.Name(), fakeUser.name);
 
   EXPECT_EQ(result.body, "Example body content");
 
@@ -206,7 +206,7 @@ TEST_F(TestCommentService, CreateComment_ValidComment) {
   EXPECT_EQ(result.updatedAt.tm_hour, nullTime.tm_hour);
   // The updated user should also be uninitialized
   EXPECT_EQ(result.updatedBy.id, "");
-  EXPECT_EQ(result.updatedBy.name, "");
+  EXPECT_EQ(result.updatedBy.Name(), "");
 }
 
 TEST_F(TestCommentService, CreateComment_ValidComment_ExtraFieldsIgnored) {
@@ -234,7 +234,7 @@ TEST_F(TestCommentService, CreateComment_ValidComment_ExtraFieldsIgnored) {
   // TODO(someone): Add check from Issue Service that this is a valid Issue ID
   EXPECT_THAT(result.issueId, StrEq("1234567"));
   EXPECT_EQ(result.createdBy.id, fakeUser2.id);
-  EXPECT_EQ(result.createdBy.name, fakeUser2.name);
+  EXPECT_EQ(result.createdBy.Name(), fakeUser2.name);
 
   EXPECT_EQ(result.body, "Example body content");
 
@@ -252,7 +252,7 @@ TEST_F(TestCommentService, CreateComment_ValidComment_ExtraFieldsIgnored) {
   EXPECT_EQ(result.updatedAt.tm_hour, nullTime.tm_hour);
   // The updated user should also be uninitialized
   EXPECT_EQ(result.updatedBy.id, "");
-  EXPECT_EQ(result.updatedBy.name, "");
+  EXPECT_EQ(result.updatedBy.Name(), "");
 }
 
 TEST_F(TestCommentService, CreateComment_InvalidComment_UserDoesntExist) {
@@ -359,3 +359,42 @@ TEST_F(TestCommentService, UpdateUser_ExpectEntityCreationError) {
   std::string body = "testfake";
   EXPECT_THROW(commentService->Update(body), BadRequestError);
 }
+
+TEST_F(TestCommentService, GetComments_SortedAndLimited) {
+  fakeJsonData[0]["createdAt"] = "Tue May 26 09:00:00 2000";
+  fakeJsonData.push_back({{"id", "2224"},
+                          {"createdAt", "Wed May 24 15:30:11 2000"},
+                          {"createdBy", "1234"},
+                          {"updatedAt", ""},
+                          {"updatedBy", ""},
+                          {"issueId", "123456"},
+                          {"body", "Example body content3"}});
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
+      .WillRepeatedly(Return(fakeUser));
+  EXPECT_CALL(*userService, Get(fakeUser2.id.str()))
+      .WillRepeatedly(Return(fakeUser2));
+
+  // The collection is read and indexed once, for every query with a sort,
+  // range or limit
+  EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
+
+  std::vector<Comment> newest =
+      commentService->Get({{"sort", "-createdAt"}, {"limit", "2"}});
+  ASSERT_EQ(2, newest.size());
+  EXPECT_EQ("2222", newest[0].id);
+  EXPECT_EQ("2223", newest[1].id);
+
+  std::vector<Comment> oldest =
+      commentService->Get({{"issueId", "123456"}, {"sort", "createdAt"}});
+  ASSERT_EQ(2, oldest.size());
+  EXPECT_EQ("2224", oldest[0].id);
+  EXPECT_EQ("2222", oldest[1].id);
+
+  std::vector<Comment> created =
+      commentService->Get({{"createdAfter", "2000-05-25T15:30:11Z"}});
+  ASSERT_EQ(1, created.size());
+  EXPECT_EQ("2222", created[0].id);
+
+  EXPECT_EQ(2, commentService->Get({{"updatedSince", "2000-05-25"}}).size());
+  EXPECT_THROW(commentService->Get({{"sort", "body"}}), BadRequestError);
+}
@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "CompressedBitmap.h"
+
+namespace {
+/**
+ * @return a set of every step-th value below end
+ */
+CompressedBitmap Every(uint32_t step, uint32_t end) {
+  CompressedBitmap bitmap;
+  for (uint32_t value = 0; value < end; value += step) bitmap.Add(value);
+  return bitmap;
+}
+}  // namespace
+
+TEST(TestCompressedBitmap, AddAndContains) {
+  CompressedBitmap bitmap;
+  EXPECT_TRUE(bitmap.empty());
+  EXPECT_FALSE(bitmap.Contains(0));
+
+  // Out of order, across chunks, and twice
+  for (uint32_t value : {70000u, 5u, 3u, 5u, 65535u, 65536u}) {
+    bitmap.Add(value);
+  }
+  EXPECT_FALSE(bitmap.empty());
+  EXPECT_EQ(5, bitmap.Cardinality());
+  EXPECT_EQ(std::vector<uint32_t>({3, 5, 65535, 65536, 70000}),
+            bitmap.Values());
+  EXPECT_TRUE(bitmap.Contains(65536));
+  EXPECT_FALSE(bitmap.Contains(4));
+  EXPECT_FALSE(bitmap.Contains(131072));
+}
+
+TEST(TestCompressedBitmap, LargeChunks_BecomeBitmaps) {
+  // 10000 values in the first chunk, more than an array keeps
+  CompressedBitmap bitmap = Every(2, 20000);
+  EXPECT_EQ(10000, bitmap.Cardinality());
+  EXPECT_TRUE(bitmap.Contains(19998));
+  EXPECT_FALSE(bitmap.Contains(19999));
+
+  bitmap.Add(19998);
+  bitmap.Add(19999);
+  EXPECT_EQ(10001, bitmap.Cardinality());
+  std::vector<uint32_t> values = bitmap.Values();
+  ASSERT_EQ(10001, values.size());
+  EXPECT_EQ(19999, values.back());
+}
+
+TEST(TestCompressedBitmap, AndOr_AcrossChunkKinds) {
+  // A bitmap chunk, an array chunk, and a chunk only one side has
+  CompressedBitmap evens = Every(2, 20000);
+  evens.Add(65536 + 6);
+  CompressedBitmap threes = Every(3, 3000);
+  threes.Add(65536 + 6);
+  threes.Add(65536 + 7);
+  threes.Add(200000);
+
+  CompressedBitmap both = CompressedBitmap::And(evens, threes);
+  EXPECT_EQ(501, both.Cardinality());
+  EXPECT_TRUE(both.Contains(2994));
+  EXPECT_TRUE(both.Contains(65536 + 6));
+  EXPECT_FALSE(both.Contains(65536 + 7));
+  EXPECT_FALSE(both.Contains(200000));
+
+  CompressedBitmap either = CompressedBitmap::Or(evens, threes);
+  EXPECT_EQ(10000 + 500 + 2 + 1, either.Cardinality());
+  EXPECT_TRUE(either.Contains(2997));
+  EXPECT_TRUE(either.Contains(65536 + 7));
+  EXPECT_TRUE(either.Contains(200000));
+  EXPECT_EQ(either.Values().size(), either.Cardinality());
+
+  // Two large arrays join into a bitmap, and a sparse intersection of two
+  // bitmaps shrinks back into an array
+  CompressedBitmap odds;
+  for (uint32_t value = 1; value < 6000; value += 2) odds.Add(value);
+  EXPECT_EQ(6000, CompressedBitmap::Or(Every(2, 6000), odds).Cardinality());
+  EXPECT_EQ(0, CompressedBitmap::And(Every(2, 20000), odds).Cardinality());
+  EXPECT_TRUE(CompressedBitmap::And(CompressedBitmap(), evens).empty());
+}
+
+TEST(TestCompressedBitmap, SetBits_FillsAPlainBitmap) {
+  CompressedBitmap bitmap = Every(5, 20000);
+  bitmap.Add(65536 + 1);
+
+  // Only the first 256 values fit, and the bits already set are kept
+  std::vector<uint64_t> words(4, 0);
+  words[0] = 2;
+  bitmap.SetBits(&words);
+  for (uint32_t value = 0; value < words.size() * 64; value++) {
+    bool set = (words[value / 64] >> (value % 64)) & 1;
+    EXPECT_EQ(value % 5 == 0 || value == 1, set) << value;
+  }
+}
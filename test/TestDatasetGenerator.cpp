@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "DatasetGenerator.h"
+#include "Issue.h"
+#include "User.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+DatasetOptions SmallOptions() {
+  DatasetOptions options;
+  options.users = 50;
+  options.issues = 200;
+  options.comments = 1000;
+  options.votes = 1000;
+  return options;
+}
+}  // namespace
+
+TEST(TestDatasetGenerator, Generate_Cardinalities) {
+  Dataset dataset = DatasetGenerator(SmallOptions()).Generate();
+
+  EXPECT_EQ(50, dataset.users.size());
+  EXPECT_EQ(200, dataset.issues.size());
+  EXPECT_EQ(1000, dataset.comments.size());
+  EXPECT_EQ(1000, dataset.votes.size());
+
+  // Entities read back like the ones the services store
+  User user = dataset.users[0].get<User>();
+  EXPECT_EQ(10, user.id.str().size());
+  Issue issue = dataset.issues[0].get<Issue>();
+  EXPECT_EQ(2020, issue.createdAt.tm_year + 1900);
+}
+
+TEST(TestDatasetGenerator, Generate_SameSeedSameDataset) {
+  DatasetOptions options = SmallOptions();
+  Dataset first = DatasetGenerator(options).Generate();
+  Dataset second = DatasetGenerator(options).Generate();
+  EXPECT_EQ(first.issues, second.issues);
+  EXPECT_EQ(first.votes, second.votes);
+
+  options.seed++;
+  Dataset third = DatasetGenerator(options).Generate();
+  EXPECT_NE(first.issues, third.issues);
+}
+
+TEST(TestDatasetGenerator, Generate_ReferencesExist) {
+  Dataset dataset = DatasetGenerator(SmallOptions()).Generate();
+
+  std::set<std::string> users;
+  std::set<std::string> names;
+  for (auto& user : dataset.users) {
+    users.insert(user["id"].get<std::string>());
+    names.insert(user["name"].get<std::string>());
+  }
+  EXPECT_EQ(dataset.users.size(), users.size());
+  EXPECT_EQ(dataset.users.size(), names.size());
+
+  std::map<std::string, json> issues;
+  for (auto& issue : dataset.issues) {
+    EXPECT_EQ(1, users.count(issue["reporter"]));
+    issues[issue["id"]] = issue;
+  }
+
+  for (auto& comment : dataset.comments) {
+    ASSERT_EQ(1, issues.count(comment["issueId"]));
+    EXPECT_EQ(1, users.count(comment["createdBy"]));
+    auto& ids = issues[comment["issueId"]]["comments"];
+    EXPECT_NE(ids.end(), std::find(ids.begin(), ids.end(), comment["id"]));
+  }
+  for (auto& vote : dataset.votes) {
+    ASSERT_EQ(1, issues.count(vote["issueId"]));
+    EXPECT_EQ(1, users.count(vote["createdBy"]));
+  }
+}
+
+TEST(TestDatasetGenerator, Generate_Skew) {
+  DatasetOptions options = SmallOptions();
+  Dataset dataset = DatasetGenerator(options).Generate();
+
+  // The most commented issue has far more than its share of the comments
+  std::size_t mostComments = 0;
+  for (auto& issue : dataset.issues) {
+    mostComments = std::max(mostComments, issue["comments"].size());
+  }
+  EXPECT_GT(mostComments, 10 * options.comments / options.issues);
+
+  // About half of the issues come from the few heavy reporters
+  std::map<std::string, int> reported;
+  for (auto& issue : dataset.issues) reported[issue["reporter"]]++;
+  std::vector<int> counts;
+  for (auto& reporter : reported) counts.push_back(reporter.second);
+  std::sort(counts.rbegin(), counts.rend());
+  int heavyReported = 0;
+  for (std::size_t i = 0; i < 3 && i < counts.size(); i++) {
+    heavyReported += counts[i];
+  }
+  EXPECT_GT(heavyReported, options.issues * 0.4);
+
+  // Without skew, no issue stands out as much
+  options.skew = 0;
+  options.heavyShare = 0;
+  dataset = DatasetGenerator(options).Generate();
+  mostComments = 0;
+  for (auto& issue : dataset.issues) {
+    mostComments = std::max(mostComments, issue["comments"].size());
+  }
+  EXPECT_LT(mostComments, 4 * options.comments / options.issues);
+}
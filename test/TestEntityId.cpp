@@ -0,0 +1,118 @@
+#include <string>
+#include <unordered_set>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "Comment.h"
+#include "EntityId.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+TEST(TestEntityId, PackedIds_KeepTheirString) {
+  EntityId id("a1b2c3d4e5");
+  EXPECT_TRUE(id.IsPacked());
+  EXPECT_EQ("a1b2c3d4e5", id.str());
+  EXPECT_EQ(EntityId("a1b2c3d4e5"), id);
+  EXPECT_NE(EntityId("a1b2c3d4e6"), id);
+
+  EntityId longest("zzzzzzzzzzzz");
+  EXPECT_TRUE(longest.IsPacked());
+  EXPECT_EQ("zzzzzzzzzzzz", longest.str());
+
+  // Leading zeros are kept
+  EXPECT_EQ("00001", EntityId("00001").str());
+  EXPECT_NE(EntityId("0001"), EntityId("00001"));
+}
+
+TEST(TestEntityId, OtherIds_AreInterned) {
+  EntityId id("Assigned Example User ID");
+  EXPECT_FALSE(id.IsPacked());
+  EXPECT_EQ("Assigned Example User ID", id.str());
+  EXPECT_EQ(id.Value(), EntityId("Assigned Example User ID").Value());
+
+  EXPECT_FALSE(EntityId("abcdefghijklm").IsPacked());
+  EXPECT_FALSE(EntityId("Steven8thPlace").IsPacked());
+  EXPECT_NE(EntityId("Steven8thPlace"), EntityId("steven8thplace"));
+}
+
+TEST(TestEntityId, InternedIds_DroppedWithTheLastCopy) {
+  std::size_t interned = EntityId::InternedCount();
+  {
+    EntityId id("A Hand Written Id");
+    EntityId copy = id;
+    EntityId moved = std::move(copy);
+    EXPECT_EQ(interned + 1, EntityId::InternedCount());
+
+    EntityId found;
+    EXPECT_TRUE(EntityId::Lookup("A Hand Written Id", &found));
+    EXPECT_EQ(id, found);
+    id = EntityId("abc");
+    EXPECT_EQ("A Hand Written Id", moved.str());
+  }
+  EXPECT_EQ(interned, EntityId::InternedCount());
+  EntityId found;
+  EXPECT_FALSE(EntityId::Lookup("A Hand Written Id", &found));
+
+  // The index is reused by the next string, which keeps its own
+  EntityId next("Another Hand Written Id");
+  EXPECT_EQ("Another Hand Written Id", next.str());
+  EXPECT_NE(EntityId("Yet Another Id!"), next);
+}
+
+TEST(TestEntityId, IdsFromRequests_NotKept) {
+  // Ids parsed from a request body are dropped with the request
+  std::size_t interned = EntityId::InternedCount();
+  for (int request = 0; request < 100; request++) {
+    Comment comment =
+        json({{"id", "c0mment001"},
+              {"issueId", "Random Issue " + std::to_string(request)},
+              {"createdBy", "Random User " + std::to_string(request)}})
+            .get<Comment>();
+    EXPECT_FALSE(comment.issueId.IsPacked());
+  }
+  EXPECT_EQ(interned, EntityId::InternedCount());
+}
+
+TEST(TestEntityId, EmptyId) {
+  EntityId id;
+  EXPECT_TRUE(id.empty());
+  EXPECT_EQ("", id.str());
+  EXPECT_EQ(EntityId(""), id);
+  EXPECT_FALSE(EntityId("0").empty());
+}
+
+TEST(TestEntityId, PackedIds_SortLikeTheirStrings) {
+  EXPECT_LT(EntityId("a"), EntityId("aa"));
+  EXPECT_LT(EntityId("aa"), EntityId("b"));
+  EXPECT_LT(EntityId("9zz"), EntityId("a"));
+  EXPECT_LT(EntityId("zzzzzzzzzzzz"), EntityId("Interned"));
+}
+
+TEST(TestEntityId, ConvertsToAndFromJson) {
+  EntityId id("q2w3e4r5t6");
+  json j = id;
+  EXPECT_EQ(json("q2w3e4r5t6"), j);
+  EXPECT_EQ(id, j.get<EntityId>());
+  EXPECT_TRUE(json(nullptr).get<EntityId>().empty());
+
+  Comment comment = json({{"id", "c0mment001"},
+                          {"issueId", "issue00001"},
+                          {"createdBy", "user000001"}})
+                        .get<Comment>();
+  EXPECT_EQ("c0mment001", comment.id);
+  EXPECT_EQ("issue00001", comment.issueId);
+  EXPECT_EQ("user000001", comment.createdBy.id);
+  EXPECT_EQ("issue00001", json(comment)["issueId"]);
+}
+
+TEST(TestEntityId, WorksWithStrings) {
+  EntityId id("abc123");
+  EXPECT_EQ("/issues/abc123/votes", "/issues/" + id + "/votes");
+  std::string copy = id;
+  EXPECT_EQ("abc123", copy);
+
+  std::unordered_set<EntityId> ids = {id, EntityId("abc123"), "def456"};
+  EXPECT_EQ(2, ids.size());
+}
@@ -1,3 +1,5 @@
+#include <cstdio>
+#include <fstream>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -49,3 +51,23 @@ TEST(TestFileHandler,
   FileHandler* fileHandler = new FileHandler(os, is, fileName);
   EXPECT_THROW(fileHandler->read(), InternalServerError);
 }
+
+TEST(TestFileHandler, ReadAfterWrite_RealFile_ReturnsEveryWrite) {
+  std::ifstream is;
+  std::ofstream os;
+  std::string fileName = ::testing::TempDir() + "TestFileHandler.json";
+  FileHandler fileHandler(os, is, fileName);
+  fileHandler.write(json::array());
+
+  // Each write replaces the file, so each read must see the one before it
+  json users = fileHandler.read();
+  users.push_back("x1");
+  fileHandler.write(users);
+  users = fileHandler.read();
+  users.push_back("x2");
+  fileHandler.write(users);
+
+  EXPECT_EQ(json({"x1", "x2"}), fileHandler.read());
+  EXPECT_EQ(json({"x1", "x2"}), fileHandler.read());
+  std::remove(fileName.c_str());
+}
@@ -1,10 +1,12 @@
 #include <restbed>
 
 #include <exception>
+#include <future>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "Exceptions.h"
@@ -19,9 +21,16 @@
 #include "nlohmann/json.hpp"
 
 using ::testing::_;
+using ::testing::AllOf;
+using ::testing::Contains;
 using ::testing::HasSubstr;
+using ::testing::Invoke;
 using ::testing::InvokeArgument;
+using ::testing::Key;
+using ::testing::Not;
+using ::testing::Pair;
 using ::testing::Return;
+using ::testing::SaveArg;
 using ::testing::StrEq;
 using ::testing::StrNe;
 using ::testing::Throw;
@@ -65,11 +74,11 @@ TEST_F(TestIssueController, Get_OneIssue_ProperRequest) {
   request->set_path("/issues/" + issue.id);
 
   // Controller should call the IssueService once with the passed in issue id
-  EXPECT_CALL(*mockService, Get(issue.id)).WillOnce(Return(issue));
+  EXPECT_CALL(*mockService, Get(issue.id.str())).WillOnce(Return(issue));
 
   // Controller should send back the issue as a JSON string, with a status of OK
   // if the request is valid
-  EXPECT_CALL(*mockSession, close(restbed::OK, StrEq(body), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(body), _)).Times(1);
 
   // Controller should get the request from the session
   EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
@@ -77,9 +86,26 @@ TEST_F(TestIssueController, Get_OneIssue_ProperRequest) {
   controller.Get(mockSession);
 }
 
+TEST_F(TestIssueController, Get_OneIssue_KeepsTheConnection) {
+  request->set_path("/issues/" + issue.id);
+  EXPECT_CALL(*mockService, Get(issue.id.str()))
+      .Times(2)
+      .WillRepeatedly(Return(issue));
+  EXPECT_CALL(*mockSession, get_request()).WillRepeatedly(Return(request));
+
+  // Both requests are answered on the same session, which is never closed
+  EXPECT_CALL(*mockSession,
+              yield(restbed::OK, _, Not(Contains(Key("Connection")))))
+      .Times(2);
+  EXPECT_CALL(*mockSession, close(_, _, _)).Times(0);
+
+  controller.Get(mockSession);
+  controller.Get(mockSession);
+}
+
 TEST_F(TestIssueController, Get_OneIssue_NotFound) {
   // Fake the issue service throwing a not found error
-  EXPECT_CALL(*mockService, Get(issue.id))
+  EXPECT_CALL(*mockService, Get(issue.id.str()))
       .WillOnce(Throw(NotFoundError("fake not found exception")));
 
   // Add the issue id to the request path
@@ -90,14 +116,14 @@ TEST_F(TestIssueController, Get_OneIssue_NotFound) {
 
   // Controller should send back a NOT FOUND response if the issue specified
   // doesn't exist, with a non-empty error message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
 
   controller.Get(mockSession);
 }
 
 TEST_F(TestIssueController, Get_OneIssue_ServerError) {
   // Fake the issue service throwing an error while performing the request
-  EXPECT_CALL(*mockService, Get(issue.id))
+  EXPECT_CALL(*mockService, Get(issue.id.str()))
       .WillOnce(Throw(InternalServerError("fake server error")));
 
   // Add the issue id to the request path
@@ -109,7 +135,7 @@ TEST_F(TestIssueController, Get_OneIssue_ServerError) {
   // Controller should send back an INTERNAL_SERVER_ERROR if the issue service
   // encountered an error while getting the issues, with a non-empty error
   // message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Get(mockSession);
@@ -123,7 +149,7 @@ TEST_F(TestIssueController, Get_AllIssues_NoQuery) {
 
   // Fake the issue service sending back a vector of issues
   std::vector<Issue> issues = {issue};
-  EXPECT_CALL(*mockService, Get(::testing::A<StringMap>()))
+  EXPECT_CALL(*mockService, Get(::testing::A<const StringMap&>()))
       .WillOnce(Return(issues));
 
   // Controller should get the request from the session
@@ -131,7 +157,7 @@ TEST_F(TestIssueController, Get_AllIssues_NoQuery) {
 
   // Controller should send back an OK for any get request to /issues/, with the
   // serialized issue in the response body
-  EXPECT_CALL(*mockSession, close(restbed::OK, HasSubstr(jsonIssue.dump()), _))
+  EXPECT_CALL(*mockSession, yield(restbed::OK, HasSubstr(jsonIssue.dump()), _))
       .Times(1);
 
   controller.Get(mockSession);
@@ -147,7 +173,7 @@ TEST_F(TestIssueController, Get_AllIssues_WithValidQuery) {
   // Fake the issue service sending back a vector of issues
   std::vector<Issue> issues = {issue};
 
-  EXPECT_CALL(*mockService, Get(::testing::An<StringMap>()))
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>()))
       .WillOnce(Return(issues));
 
   // Controller should get the request from the session
@@ -155,12 +181,51 @@ TEST_F(TestIssueController, Get_AllIssues_WithValidQuery) {
 
   // Controller should send back an OK for any get request to /issues/, with the
   // serialized issue in the response body
-  EXPECT_CALL(*mockSession, close(restbed::OK, HasSubstr(jsonIssue.dump()), _))
+  EXPECT_CALL(*mockSession, yield(restbed::OK, HasSubstr(jsonIssue.dump()), _))
       .Times(1);
 
   controller.Get(mockSession);
 }
 
+TEST_F(TestIssueController, Get_AllIssues_FromTheQueryCache) {
+  auto cache = std::make_shared<QueryCache>("issues");
+  controller.SetQueryCache(cache);
+  request->set_path("/issues/");
+  request->set_query_parameter("status", issue.status);
+  jsonIssue = json::array({issue});
+
+  // The service is only asked once, and both responses are the same
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>()))
+      .WillOnce(Return(std::vector<Issue>{issue}));
+  EXPECT_CALL(*mockSession, get_request()).WillRepeatedly(Return(request));
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(jsonIssue.dump()), _))
+      .Times(2);
+
+  controller.Get(mockSession);
+  controller.Get(mockSession);
+  EXPECT_EQ(1, cache->GetStats().hits);
+}
+
+TEST_F(TestIssueController, Get_AllIssues_Coalesced) {
+  auto coalescer = std::make_shared<RequestCoalescer>();
+  controller.SetCoalescer(coalescer);
+  request->set_path("/issues/");
+  jsonIssue = json::array({issue});
+
+  // Requests that don't overlap each compute their response
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>()))
+      .Times(2)
+      .WillRepeatedly(Return(std::vector<Issue>{issue}));
+  EXPECT_CALL(*mockSession, get_request()).WillRepeatedly(Return(request));
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(jsonIssue.dump()), _))
+      .Times(2);
+
+  controller.Get(mockSession);
+  controller.Get(mockSession);
+  EXPECT_EQ(2, coalescer->GetStats().computed);
+  EXPECT_EQ(0, coalescer->InFlight());
+}
+
 TEST_F(TestIssueController, Get_AllIssues_ServerError) {
   // Add the issues endpoint to the path
   request->set_path("/issues/");
@@ -169,7 +234,7 @@ TEST_F(TestIssueController, Get_AllIssues_ServerError) {
   StringMap queryParams = request->get_query_parameters();
 
   // Fake the issue service throwing an error while retrieving the issues
-  EXPECT_CALL(*mockService, Get(::testing::An<StringMap>()))
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>()))
       .WillOnce(Throw(InternalServerError("fake error")));
 
   // Controller should get the request from the session
@@ -177,19 +242,148 @@ TEST_F(TestIssueController, Get_AllIssues_ServerError) {
 
   // Controller should send back an INTERNAL_SERVER_ERROR if an error occurs,
   // with a nonempty error message in the body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+      .Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestIssueController, Get_AllIssues_SendsETag) {
+  request->set_path("/issues/");
+
+  std::vector<Issue> issues = {issue};
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>()))
+      .WillOnce(Return(issues));
+
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Controller should tag the response so the client can revalidate it
+  EXPECT_CALL(*mockSession, yield(restbed::OK, _, Contains(Key("ETag"))))
       .Times(1);
 
   controller.Get(mockSession);
 }
 
+TEST_F(TestIssueController, Get_AllIssues_NotModified) {
+  request->set_path("/issues/");
+  request->set_header(
+      "If-None-Match",
+      ResponseUtilities::BuildETag(mockService->Generation()));
+
+  // The client has the current issues, so the service shouldn't be queried
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>())).Times(0);
+
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Controller should send back NOT MODIFIED with an empty body
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_MODIFIED, StrEq(""),
+                                  Contains(Key("ETag"))))
+      .Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestIssueController, Get_OneIssue_NotModified) {
+  request->set_path("/issues/" + issue.id);
+  issue.version = 4;
+  request->set_header("If-None-Match",
+                      ResponseUtilities::BuildEntityETag(
+                          issue.version, mockService->Generation()));
+
+  // The issue is read to make sure it still exists
+  EXPECT_CALL(*mockService, Get(issue.id.str())).WillOnce(Return(issue));
+
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_MODIFIED, StrEq(""),
+                                  Contains(Key("ETag"))))
+      .Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestIssueController, Get_OneIssue_SharedNotModified_ReadAgain) {
+  auto coalescer = std::make_shared<RequestCoalescer>();
+  controller.SetCoalescer(coalescer);
+  issue.version = 4;
+  jsonIssue = issue;
+
+  // The first request has the issue already, so it reads it without
+  // serializing it. The second joins it while it reads
+  request->set_path("/issues/" + issue.id);
+  request->set_header("If-None-Match",
+                      ResponseUtilities::BuildEntityETag(
+                          issue.version, mockService->Generation()));
+  auto other = std::make_shared<restbed::Request>();
+  other->set_path("/issues/" + issue.id);
+  auto otherSession = std::make_shared<MockSession>();
+
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  EXPECT_CALL(*mockService, Get(issue.id.str()))
+      .WillOnce(Invoke([&](const std::string&) {
+        released.wait();
+        return issue;
+      }))
+      .WillOnce(Return(issue));
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+  EXPECT_CALL(*otherSession, get_request()).WillOnce(Return(other));
+
+  // The second request gets no body from the first, so it reads the issue
+  // again for its own
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_MODIFIED, StrEq(""), _))
+      .Times(1);
+  EXPECT_CALL(*otherSession, yield(restbed::OK, StrEq(jsonIssue.dump()), _))
+      .Times(1);
+
+  std::thread first([&]() { controller.Get(mockSession); });
+  while (coalescer->InFlight() == 0) std::this_thread::yield();
+  std::thread second([&]() { controller.Get(otherSession); });
+  while (coalescer->GetStats().shared == 0) std::this_thread::yield();
+  release.set_value();
+  first.join();
+  second.join();
+}
+
+TEST_F(TestIssueController, Get_MissingIssue_NotFoundDespiteETag) {
+  request->set_path("/issues/missing");
+  request->set_header("If-None-Match", "*");
+
+  // An issue that doesn't exist was never modified, so it is not found
+  EXPECT_CALL(*mockService, Get(std::string("missing")))
+      .WillOnce(Throw(NotFoundError("fake not found error")));
+
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+
+  controller.Get(mockSession);
+}
+
+TEST_F(TestIssueController, Get_OneIssue_StaleETag) {
+  jsonIssue = issue;
+  body = jsonIssue.dump();
+
+  request->set_path("/issues/" + issue.id);
+  request->set_header("If-None-Match", "W/\"0-0\"");
+
+  // The client's tag is out of date, so the issue should be sent again
+  EXPECT_CALL(*mockService, Get(issue.id.str())).WillOnce(Return(issue));
+
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(body), _)).Times(1);
+
+  controller.Get(mockSession);
+}
+
 TEST_F(TestIssueController, Get_NoRequest) {
   // Fake the session not having a request
   EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(nullptr));
 
   // Controller should send back a BAD REQUEST response if there is no request
   // passed in
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, _, _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, _, _)).Times(1);
 
   controller.Get(mockSession);
 }
@@ -219,7 +413,7 @@ TEST_F(TestIssueController, Create_ProperRequest) {
 
   // Controller should send back a CREATED for a valid post to /issues/, with the
   // serialized issue in the body of the response
-  EXPECT_CALL(*mockSession, close(restbed::CREATED, StrEq(body), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::CREATED, StrEq(body), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -252,7 +446,7 @@ TEST_F(TestIssueController, Create_NoName) {
 
   // Controller should send back a BAD REQUEST if the issue service throws an
   // exception, with a non-empty error message in the body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -273,7 +467,7 @@ TEST_F(TestIssueController, Create_EmptyBody) {
 
   // Controller should send back a BAD_REQUEST for an empty request body, with a
   // non-empty error message in the reponse body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -302,7 +496,7 @@ TEST_F(TestIssueController, Create_ServerError) {
 
   // Controller should send back an INTERNAL_SERVER_ERROR if something else went
   // wrong with the request, with a non-empty error message in the body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Create(mockSession);
@@ -315,7 +509,7 @@ TEST_F(TestIssueController, Create_NoRequest) {
 
   // Controller should send back a BAD REQUEST response if there is no request
   // passed in, with a non-empty error message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -341,7 +535,7 @@ TEST_F(TestIssueController, Update_ProperRequest) {
   EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
 
   // Controller should send back an OK if the update is valid
-  EXPECT_CALL(*mockSession, close(restbed::OK, StrEq(body), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(body), _)).Times(1);
 
   // The controller should fetch the request body and invoke the callback to
   // process the body
@@ -367,7 +561,7 @@ TEST_F(TestIssueController, Update_EmptyBody) {
 
   // The controller should send back a BAD_REQUEST if the request is empty, with
   // a non-empty error message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   // The controller shouldn't call the fetch method
   EXPECT_CALL(*mockSession, fetch(_, _)).Times(0);
@@ -396,7 +590,7 @@ TEST_F(TestIssueController, Update_IssueNotFound) {
 
   // Controller should return a NOT FOUND if the issue in the request body could
   // not be found
-  EXPECT_CALL(*mockSession, close(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
 
   // The controller should fetch the request body and invoke the callback to
   // process the body
@@ -430,7 +624,42 @@ TEST_F(TestIssueController, Update_ServerError) {
   // Controller should return an INTERNAL_SERVER_ERROR if the issue service
   // encounters an error while updating the issue, with a non-empty error message
   // in the response body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+      .Times(1);
+
+  // The controller should fetch the request body and invoke the callback to
+  // process the body
+  EXPECT_CALL(*mockSession, fetch(_, _))
+      .Times(1)
+      .WillOnce(
+          InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
+
+  controller.Update(mockSession);
+}
+
+TEST_F(TestIssueController, Update_StaleVersion) {
+  // Create the test issue
+  issue.title = "Testy McTestface";
+  jsonIssue = issue;
+  body = jsonIssue.dump();
+  restbed::Bytes bodyAsBytes = restbed::String::to_bytes(body);
+
+  // The version in the If-Match header should be passed on to the service,
+  // which fakes the issue having been changed since that version
+  EXPECT_CALL(*mockService, Update(HasSubstr("\"version\":2")))
+      .Times(1)
+      .WillOnce(Throw(PreconditionFailedError("fake version conflict")));
+
+  // Set the request body and headers
+  request->add_header("Content-Length", std::to_string(body.size()));
+  request->add_header("If-Match", "\"2\"");
+  request->set_body(body);
+
+  // The controller should get the request from the session once
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Controller should return a PRECONDITION_FAILED if the issue has changed
+  EXPECT_CALL(*mockSession, yield(restbed::PRECONDITION_FAILED, StrNe(""), _))
       .Times(1);
 
   // The controller should fetch the request body and invoke the callback to
@@ -443,6 +672,98 @@ TEST_F(TestIssueController, Update_ServerError) {
   controller.Update(mockSession);
 }
 
+TEST_F(TestIssueController, Update_IfMatchWithETagFromGet) {
+  // Get the issue, and keep the ETag it was sent with
+  issue.version = 3;
+  request->set_path("/issues/" + issue.id);
+  EXPECT_CALL(*mockService, Get(issue.id.str())).WillOnce(Return(issue));
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  StringMap getHeaders;
+  EXPECT_CALL(*mockSession, yield(restbed::OK, _, _))
+      .WillOnce(SaveArg<2>(&getHeaders));
+  controller.Get(mockSession);
+  ASSERT_EQ(1, getHeaders.count("ETag"));
+
+  // Sending the ETag back in an If-Match header updates the issue only if it
+  // is still at the version that was sent
+  issue.title = "Testy McTestface";
+  jsonIssue = issue;
+  jsonIssue.erase("version");
+  body = jsonIssue.dump();
+  restbed::Bytes bodyAsBytes = restbed::String::to_bytes(body);
+
+  auto updateRequest = std::make_shared<restbed::Request>();
+  updateRequest->add_header("Content-Length", std::to_string(body.size()));
+  updateRequest->add_header("If-Match", getHeaders.find("ETag")->second);
+  updateRequest->set_body(body);
+
+  EXPECT_CALL(*mockService, Update(HasSubstr("\"version\":3")))
+      .WillOnce(Return(issue));
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(updateRequest));
+  EXPECT_CALL(*mockSession, fetch(_, _))
+      .WillOnce(
+          InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrNe(""), _)).Times(1);
+
+  controller.Update(mockSession);
+}
+
+TEST_F(TestIssueController, Patch_ProperRequest) {
+  body = "{\"status\":\"Closed\"}";
+  restbed::Bytes bodyAsBytes = restbed::String::to_bytes(body);
+  issue.status = "Closed";
+  jsonIssue = issue;
+
+  // The controller should pass the id in the path and the patch to the service
+  EXPECT_CALL(*mockService, Patch(StrEq(issue.id), StrEq(body)))
+      .Times(1)
+      .WillOnce(Return(issue));
+
+  // Set up the path, body and header for the request
+  request->set_path("/issues/" + issue.id);
+  request->add_header("Content-Length", std::to_string(body.size()));
+  request->set_body(body);
+
+  // The controller should get the request from the session
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Controller should send back an OK with the patched issue
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(jsonIssue.dump()), _))
+      .Times(1);
+
+  // The controller should fetch the request body and invoke the callback to
+  // process the body
+  EXPECT_CALL(*mockSession, fetch(_, _))
+      .Times(1)
+      .WillOnce(
+          InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
+
+  controller.Patch(mockSession);
+}
+
+TEST_F(TestIssueController, Patch_NoId) {
+  body = "{\"status\":\"Closed\"}";
+
+  // The issue service shouldn't be called if there is no id provided
+  EXPECT_CALL(*mockService, Patch(_, _)).Times(0);
+
+  request->set_path("/issues");
+  request->add_header("Content-Length", std::to_string(body.size()));
+
+  // The controller should get the request from the session once
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Controller should send back a BAD_REQUEST without fetching the body, and
+  // close the connection, since the body is still on it
+  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""),
+                                  Contains(Pair("Connection", "close"))))
+      .Times(1);
+  EXPECT_CALL(*mockSession, fetch(_, _)).Times(0);
+
+  controller.Patch(mockSession);
+}
+
 TEST_F(TestIssueController, Delete_ProperRequest) {
   // The controller should call the issue service once
   EXPECT_CALL(*mockService, Delete(StrEq(issue.id)))
@@ -457,7 +778,7 @@ TEST_F(TestIssueController, Delete_ProperRequest) {
 
   // Controller should send back an OK if the delete was successful, with an
   // empty resposne body
-  EXPECT_CALL(*mockSession, close(restbed::OK, StrEq(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(""), _)).Times(1);
 
   controller.Delete(mockSession);
 }
@@ -475,7 +796,7 @@ TEST_F(TestIssueController, Delete_NoId) {
   // Controller should send back a BAD_REQUEST if the request path does not
   // contain an id parameter, with a non-empty error message on the response
   // body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Delete(mockSession);
 }
@@ -494,7 +815,7 @@ TEST_F(TestIssueController, Delete_NotFound) {
 
   // Controller should send back a NOT_FOUND if the requested issue could not be
   // found
-  EXPECT_CALL(*mockSession, close(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
 
   controller.Delete(mockSession);
 }
@@ -514,8 +835,72 @@ TEST_F(TestIssueController, Delete_ServerError) {
   // Controller should send back a INTERNAL_SERVER_ERROR if the server
   // encountered an error while processing the delete, with a non-empty error
   // message on the response body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Delete(mockSession);
 }
+
+TEST_F(TestIssueController, Delete_StaleVersion) {
+  // The controller should pass the version in the If-Match header to the
+  // service, which fakes the issue having been changed since that version
+  EXPECT_CALL(*mockService, Delete(StrEq(issue.id), 2))
+      .Times(1)
+      .WillOnce(Throw(PreconditionFailedError("fake version conflict")));
+  EXPECT_CALL(*mockService, Delete(_)).Times(0);
+
+  // Set the request path to the issue id, and the version to match
+  request->set_path("/issues/" + issue.id);
+  request->add_header("If-Match", "2");
+
+  // The controller should get the request from the session once
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Controller should return a PRECONDITION_FAILED if the issue has changed
+  EXPECT_CALL(*mockSession, yield(restbed::PRECONDITION_FAILED, StrNe(""), _))
+      .Times(1);
+
+  controller.Delete(mockSession);
+}
+
+TEST_F(TestIssueController, Bulk_ProperRequest) {
+  body =
+      "{\"op\":\"patch\",\"id\":\"" + issue.id +
+      "\",\"body\":{\"status\":\"Closed\"}}\n"
+      "{\"op\":\"delete\",\"id\":\"missing\"}\n";
+  restbed::Bytes bodyAsBytes = restbed::String::to_bytes(body);
+
+  // Fake the service patching the issue, but not finding the other one
+  BulkResult<Issue> patched;
+  patched.op = "patch";
+  patched.id = issue.id;
+  patched.entity = issue;
+  BulkResult<Issue> missing;
+  missing.op = "delete";
+  missing.id = "missing";
+  missing.error = std::make_exception_ptr(NotFoundError("fake not found"));
+
+  // Both operations should be passed to the service at once
+  EXPECT_CALL(*mockService, Bulk(_))
+      .Times(1)
+      .WillOnce(Return(std::vector<BulkResult<Issue>>{patched, missing}));
+
+  request->add_header("Content-Length", std::to_string(body.size()));
+
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // The response should be OK, with the status of each operation
+  EXPECT_CALL(*mockSession,
+              yield(restbed::OK,
+                    AllOf(HasSubstr("\"status\":200"),
+                          HasSubstr("\"status\":404")),
+                    _))
+      .Times(1);
+
+  EXPECT_CALL(*mockSession, fetch(_, _))
+      .Times(1)
+      .WillOnce(
+          InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
+
+  controller.Bulk(mockSession);
+}
@@ -31,7 +31,7 @@ class MockUserService : public UserService {
   MockUserService() {}
   virtual ~MockUserService() {}
 
-  MOCK_METHOD1(Get, User(std::string));
+  MOCK_METHOD1(Get, User(const std::string&));
 };
 
 class MockCommentService : public CommentService {
@@ -39,17 +39,24 @@ class MockCommentService : public CommentService {
   MockCommentService() : CommentService(nullptr) {}
   virtual ~MockCommentService() {}
 
-  MOCK_METHOD1(
-      Get, std::vector<Comment>(const std::multimap<std::string, std::string>));
-  MOCK_METHOD1(Create, Comment(std::string));
+  MOCK_METHOD1(Get, std::vector<Comment>(
+                        const std::multimap<std::string, std::string>&));
+  MOCK_METHOD1(Create, Comment(const std::string&));
+  MOCK_METHOD2(Create, Comment(Transaction*, json));
+  MOCK_METHOD2(DeleteMatching,
+               std::size_t(Transaction*,
+                           const std::multimap<std::string, std::string>&));
 };
 
 class MockVoteService : public VoteService {
  public:
   MockVoteService() : VoteService(nullptr) {}
   virtual ~MockVoteService() {}
-  MOCK_METHOD1(
-      Get, std::vector<Vote>(const std::multimap<std::string, std::string>));
+  MOCK_METHOD1(Get, std::vector<Vote>(
+                        const std::multimap<std::string, std::string>&));
+  MOCK_METHOD2(DeleteMatching,
+               std::size_t(Transaction*,
+                           const std::multimap<std::string, std::string>&));
 };
 
 class TestIssueService : public ::testing::Test {
@@ -136,12 +143,13 @@ class TestIssueService : public ::testing::Test {
 };
 
 TEST_F(TestIssueService, GetIssues_NoQuery) {
-  EXPECT_CALL(*userService, Get(fakeUser.id))
-      .Times(AtLeast(3))
+  // Each user is fetched once, however many issues refer to them
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser));
 
-  EXPECT_CALL(*userService, Get(fakeUser2.id))
-      .Times(AtLeast(3))
+  EXPECT_CALL(*userService, Get(fakeUser2.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser2));
 
   StringMap issue1IdMap = {{"issueId", "2222"}};
@@ -170,14 +178,18 @@ TEST_F(TestIssueService, GetIssues_NoQuery) {
   EXPECT_EQ("2223", issues[1].id);
   EXPECT_EQ(fakeUser.id, issues[0].createdBy.id);
   EXPECT_EQ(fakeUser2.id, issues[1].createdBy.id);
+
+  // Both issues refer to the same copy of fakeUser2
+  EXPECT_TRUE(issues[0].reporter.Resolved());
+  EXPECT_EQ(issues[0].reporter.Get(), issues[1].createdBy.Get());
 }
 
 TEST_F(TestIssueService, GetIssues_WithQuery_ExpectOneResult) {
-  EXPECT_CALL(*userService, Get(fakeUser.id))
-      .Times(AtLeast(3))
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser));
 
-  EXPECT_CALL(*userService, Get(fakeUser2.id)).WillOnce(Return(fakeUser2));
+  EXPECT_CALL(*userService, Get(fakeUser2.id.str())).WillOnce(Return(fakeUser2));
 
   StringMap issue1IdMap = {{"issueId", "2222"}};
   EXPECT_CALL(*commentService, Get(issue1IdMap))
@@ -208,6 +220,24 @@ TEST_F(TestIssueService, GetIssues_WithQuery_ExpectNoResults) {
   EXPECT_TRUE(issues.empty());
 }
 
+TEST_F(TestIssueService, GetIssues_ReadsAgainOnlyAfterAWrite) {
+  EXPECT_CALL(*userService, Get).Times(0);
+  EXPECT_CALL(*fileHandler, read())
+      .Times(3)
+      .WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(1);
+  EXPECT_CALL(*commentService, DeleteMatching(_, _)).WillOnce(Return(0));
+  EXPECT_CALL(*voteService, DeleteMatching(_, _)).WillOnce(Return(0));
+
+  // The second query is answered from the issues read for the first
+  EXPECT_TRUE(issueService->Get({{"status", "Closed"}}).empty());
+  EXPECT_TRUE(issueService->Get({{"status", "Closed"}}).empty());
+
+  // Deleting reads and writes the file, and the next query reads it again
+  EXPECT_TRUE(issueService->Delete("2223"));
+  EXPECT_TRUE(issueService->Get({{"status", "Closed"}}).empty());
+}
+
 TEST_F(TestIssueService, CreateIssue_ValidIssue_WithDescription) {
   std::string body =
       R"(
@@ -227,8 +257,10 @@ TEST_F(TestIssueService, CreateIssue_ValidIssue_WithDescription) {
 
   EXPECT_CALL(*fileHandler, write(_)).Times(1);
 
-  // We should create a comment with the "description" comment provided
-  EXPECT_CALL(*commentService, Create(_)).WillOnce(Return(fakeComment1));
+  // We should create a comment with the "description" comment provided, in
+  // the same transaction as the issue
+  EXPECT_CALL(*commentService, Create(::testing::NotNull(), _))
+      .WillOnce(Return(fakeComment1));
 
   Issue result = issueService->Create(body);
 
@@ -253,15 +285,15 @@ TEST_F(TestIssueService, CreateIssue_ValidIssue_WithDescription) {
 
   // The updated user should also be uninitialized
   EXPECT_EQ(result.updatedBy.id, "");
-  EXPECT_EQ(result.updatedBy.name, "");
+  EXPECT_EQ(result.updatedBy.Name(), "");
 
   // The assigned user should also be uninitialized
   EXPECT_EQ(result.assignedTo.id, "");
-  EXPECT_EQ(result.assignedTo.name, "");
+  EXPECT_EQ(result.assignedTo.Name(), "");
 
   // The reporter should also be uninitialized
   EXPECT_EQ(result.reporter.id, result.createdBy.id);
-  EXPECT_EQ(result.reporter.name, result.createdBy.name);
+  EXPECT_EQ(result.reporter.Name(), result.createdBy.Name());
 
   // There should be one comment, with the body of the description that we
   // provided
@@ -299,14 +331,14 @@ TEST_F(TestIssueService, CreateIssue_HandleOptionalAndIgnoredFields) {
       .WillRepeatedly(Return(fakeUser));
 
   // No "description" was provided, so we shouldn't call the comment service
-  EXPECT_CALL(*commentService, Create).Times(0);
+  EXPECT_CALL(*commentService, Create(_, _)).Times(0);
 
   Issue result = issueService->Create(body);
 
   EXPECT_THAT(result.id, StrNe("abcdefgh23"));
 
   EXPECT_EQ(result.createdBy.id, fakeUser.id);
-  EXPECT_EQ(result.createdBy.name, fakeUser.name);
+  EXPECT_EQ(result.createdBy.Name(), fakeUser.name);
 
   // The created date should be ignored and the current UTC time should be used
   struct tm now = TimeUtilities::CurrentTimeUTC();
@@ -324,15 +356,15 @@ TEST_F(TestIssueService, CreateIssue_HandleOptionalAndIgnoredFields) {
 
   // The updated user should also be uninitialized
   EXPECT_EQ(result.updatedBy.id, "");
-  EXPECT_EQ(result.updatedBy.name, "");
+  EXPECT_EQ(result.updatedBy.Name(), "");
 
   // The assigned user should also be uninitialized
   EXPECT_EQ(result.assignedTo.id, "1234");
-  EXPECT_EQ(result.assignedTo.name, "HussJess");
+  EXPECT_EQ(result.assignedTo.Name(), "HussJess");
 
   // The reporter should also be uninitialized
   EXPECT_EQ(result.reporter.id, fakeUser.id);
-  EXPECT_EQ(result.reporter.name, fakeUser.name);
+  EXPECT_EQ(result.reporter.Name(), fakeUser.name);
 
   EXPECT_EQ(0, result.votes.size());
   EXPECT_EQ(0, result.comments.size());
@@ -346,6 +378,13 @@ TEST_F(TestIssueService, DeleteIssue_ValidDelete) {
 
   // We should write to the json file once
   EXPECT_CALL(*fileHandler, write(_)).Times(1);
+
+  // The comments and votes of the issue are deleted with it
+  StringMap ofIssue = {{"issueId", id}};
+  EXPECT_CALL(*commentService, DeleteMatching(::testing::NotNull(), ofIssue))
+      .WillOnce(Return(2));
+  EXPECT_CALL(*voteService, DeleteMatching(::testing::NotNull(), ofIssue))
+      .WillOnce(Return(1));
   EXPECT_TRUE(issueService->Delete(id));
 }
 
@@ -411,3 +450,47 @@ TEST_F(TestIssueService, Update_ExpectValidUserUpdated) {
   EXPECT_EQ(testIssue.comments.size(), 2);
   EXPECT_EQ(testIssue.votes.size(), 3);
 }
+
+TEST_F(TestIssueService, Patch_OnlyStatus) {
+  std::string body = "{\"status\":\"Closed\"}";
+
+  // Nothing but the status changes, so no users, comments or votes should be
+  // looked up
+  EXPECT_CALL(*userService, Get(_)).Times(0);
+  EXPECT_CALL(*commentService, Get(_)).Times(0);
+  EXPECT_CALL(*voteService, Get(_)).Times(0);
+
+  // We should read and write the json file once
+  EXPECT_CALL(*fileHandler, read).Times(1).WillOnce(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(1);
+
+  Issue testIssue = issueService->Patch("2223", body);
+
+  EXPECT_EQ("2223", testIssue.id);
+  EXPECT_EQ("Closed", testIssue.status);
+  // The rest of the issue is left as it is
+  EXPECT_EQ("Fake Title 2", testIssue.title);
+  EXPECT_EQ("1234", testIssue.assignedTo.id);
+  EXPECT_EQ(5, testIssue.comments.size());
+  EXPECT_EQ(1, testIssue.version);
+}
+
+TEST_F(TestIssueService, Patch_ReadOnlyField) {
+  std::string body = "{\"createdBy\":\"4567\"}";
+
+  // The patch should be rejected without writing the json file
+  EXPECT_CALL(*fileHandler, read).WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(0);
+
+  EXPECT_THROW(issueService->Patch("2223", body), BadRequestError);
+}
+
+TEST_F(TestIssueService, Patch_UnknownField) {
+  // A PUT would drop the field, so a PATCH can't store it either
+  std::string body = "{\"status\":\"Closed\",\"foo\":1}";
+
+  EXPECT_CALL(*fileHandler, read).WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(0);
+
+  EXPECT_THROW(issueService->Patch("2223", body), BadRequestError);
+}
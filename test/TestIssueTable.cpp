@@ -0,0 +1,133 @@
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "EntityId.h"
+#include "EntityService.hpp"
+#include "IssueTable.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+const char* const Statuses[] = {"New", "Assigned", "Fixed", "Won't fix"};
+const char* const Users[] = {"us3r000001", "us3r000002", "Assigned User"};
+
+/**
+ * Builds 150 issues, so the table spans several words of a Selection
+ */
+json MakeIssues() {
+  json issues = json::array();
+  for (int i = 0; i < 150; i++) {
+    json issue = {{"id", "issue" + std::to_string(10000 + i)},
+                  {"title", "Issue " + std::to_string(i)},
+                  {"status", Statuses[i % 4]},
+                  {"createdBy", Users[i % 3]},
+                  {"reporter", Users[i % 2]}};
+    // Some issues aren't assigned, and one has an assignee that isn't a
+    // string
+    if (i % 5 != 0) issue["assignedTo"] = Users[i % 3];
+    if (i == 7) issue["assignedTo"] = nullptr;
+    issues.push_back(issue);
+  }
+  return issues;
+}
+
+std::vector<std::size_t> Expected(const json& issues,
+                                  const IssueTable::Query& query) {
+  std::vector<std::size_t> rows;
+  for (std::size_t row = 0; row < issues.size(); row++) {
+    if (FilterView::Matches(issues[row], query)) rows.push_back(row);
+  }
+  return rows;
+}
+}  // namespace
+
+TEST(TestIssueTable, Select_MatchesFilterView) {
+  IssueTable table(MakeIssues());
+  ASSERT_EQ(150, table.size());
+
+  std::vector<IssueTable::Query> queries = {
+      {},
+      {{"status", "Fixed"}},
+      {{"status", "Closed"}},
+      {{"assignedTo", "us3r000002"}},
+      {{"assignedTo", "Assigned User"}},
+      {{"assignedTo", ""}},
+      {{"reporter", "us3r000001"}, {"status", "New"}},
+      {{"createdBy", "us3r000001"}, {"assignedTo", "us3r000001"}},
+      {{"status", "New"}, {"status", "Fixed"}},
+      {{"status", "New"}, {"status", "Closed"}, {"assignedTo", "us3r000002"}},
+      {{"reporter", "us3r000002"}, {"reporter", "Nobody"}},
+      {{"createdBy", "us3r000001"}, {"createdBy", "Assigned User"}},
+      {{"id", "issue10003"}, {"id", "issue10140"}, {"status", "Won't fix"}},
+      {{"id", "issue10149"}},
+      {{"id", "issue20000"}}};
+  for (std::size_t i = 0; i < queries.size(); i++) {
+    SCOPED_TRACE("query " + std::to_string(i));
+    const IssueTable::Query& query = queries[i];
+    ASSERT_TRUE(IssueTable::Covers(query));
+    IssueTable::Selection selection = table.Select(query);
+    std::vector<std::size_t> expected = Expected(table.Issues(), query);
+    EXPECT_EQ(expected, selection.Rows());
+    EXPECT_EQ(expected.size(), selection.Count());
+  }
+}
+
+TEST(TestIssueTable, Count_MatchesSelect) {
+  IssueTable table(MakeIssues());
+  std::vector<IssueTable::Query> queries = {
+      {},
+      {{"status", "Assigned"}},
+      {{"status", "New"}, {"status", "Fixed"}, {"reporter", "us3r000001"}},
+      {{"assignedTo", "Assigned User"}, {"assignedTo", "us3r000001"}},
+      {{"assignedTo", "Nobody"}},
+      {{"status", "Fixed"}, {"status", "New"}, {"status", "Fixed"}},
+      {{"createdBy", "us3r000002"}, {"status", "New"}}};
+  for (std::size_t i = 0; i < queries.size(); i++) {
+    SCOPED_TRACE("query " + std::to_string(i));
+    EXPECT_EQ(Expected(table.Issues(), queries[i]).size(),
+              table.Count(queries[i]));
+  }
+  EXPECT_EQ(150, table.Count({}));
+}
+
+TEST(TestIssueTable, Covers_OnlyTheColumns) {
+  EXPECT_TRUE(IssueTable::Covers({{"status", "New"}, {"reporter", "a"}}));
+  EXPECT_FALSE(IssueTable::Covers({{"title", "Issue 1"}}));
+  EXPECT_FALSE(IssueTable::Covers({{"status", "New"}, {"body", "a"}}));
+}
+
+TEST(TestIssueTable, Select_DoesNotInternUnknownIds) {
+  IssueTable table(MakeIssues());
+  EXPECT_EQ(0, table.Select({{"reporter", "Nobody At All"}}).Count());
+
+  EntityId id;
+  EXPECT_FALSE(EntityId::Lookup("Nobody At All", &id));
+  EXPECT_TRUE(EntityId::Lookup("Assigned User", &id));
+  EXPECT_EQ(EntityId("Assigned User"), id);
+}
+
+TEST(TestIssueTable, KeepsItsInternedIds) {
+  // The table is the only holder of the interned id, and still matches it
+  json issues = json::array({{{"id", "issue00001"},
+                              {"status", "New"},
+                              {"createdBy", "Only In The Table"},
+                              {"reporter", "Only In The Table"}}});
+  IssueTable table(issues);
+  issues = nullptr;
+
+  EntityId other("Another Hand Written Id");
+  EXPECT_EQ(1, table.Select({{"createdBy", "Only In The Table"}}).Count());
+  EXPECT_EQ(1, table.Count({{"reporter", "Only In The Table"}}));
+  EXPECT_EQ(0, table.Select({{"createdBy", other.str()}}).Count());
+}
+
+TEST(TestIssueTable, EmptyTable) {
+  IssueTable table(json::array());
+  EXPECT_EQ(0, table.size());
+  EXPECT_TRUE(table.Select({{"status", "New"}}).Rows().empty());
+  EXPECT_TRUE(table.Select({}).Rows().empty());
+}
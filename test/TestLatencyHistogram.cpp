@@ -0,0 +1,57 @@
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "LatencyHistogram.h"
+
+TEST(TestLatencyHistogram, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.Count());
+  EXPECT_EQ(0, histogram.Min());
+  EXPECT_EQ(0, histogram.Max());
+  EXPECT_EQ(0, histogram.Percentile(99));
+}
+
+TEST(TestLatencyHistogram, Percentile_ExactForSmallValues) {
+  LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 100; value++) histogram.Record(value);
+
+  EXPECT_EQ(100, histogram.Count());
+  EXPECT_EQ(1, histogram.Min());
+  EXPECT_EQ(100, histogram.Max());
+  EXPECT_DOUBLE_EQ(50.5, histogram.Mean());
+  EXPECT_EQ(50, histogram.Percentile(50));
+  EXPECT_EQ(99, histogram.Percentile(99));
+  EXPECT_EQ(100, histogram.Percentile(100));
+}
+
+TEST(TestLatencyHistogram, Percentile_WithinPrecisionForLargeValues) {
+  LatencyHistogram histogram;
+  // 990 fast requests and 10 slow ones
+  for (int i = 0; i < 990; i++) histogram.Record(1000);
+  for (int i = 0; i < 10; i++) histogram.Record(2500000);
+
+  uint64_t median = histogram.Percentile(50);
+  EXPECT_GE(median, 1000);
+  EXPECT_LE(median, 1000 + 1000 / 64);
+
+  uint64_t tail = histogram.Percentile(99.9);
+  EXPECT_GE(tail, 2500000 - 2500000 / 64);
+  EXPECT_LE(tail, 2500000);
+  EXPECT_EQ(2500000, histogram.Max());
+}
+
+TEST(TestLatencyHistogram, Merge) {
+  LatencyHistogram first;
+  LatencyHistogram second;
+  first.Record(10);
+  second.Record(5);
+  second.Record(20);
+
+  first.Merge(second);
+  EXPECT_EQ(3, first.Count());
+  EXPECT_EQ(5, first.Min());
+  EXPECT_EQ(20, first.Max());
+  EXPECT_EQ(10, first.Percentile(50));
+}
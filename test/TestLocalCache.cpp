@@ -0,0 +1,114 @@
+#include <stdlib.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "LocalCache.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+TEST(TestLocalCache, DefaultDirectory) {
+  std::string directory =
+      LocalCache::DefaultDirectory("http://localhost:8080");
+  EXPECT_NE(std::string::npos,
+            directory.find("/.hotTicket/localhost_8080"));
+}
+
+TEST(TestLocalCache, PutFindRemove) {
+  LocalCache cache("");
+  cache.Put("issues", {{"id", "a1"}, {"title", "First"}});
+  cache.Put("issues", {{"id", "b2"}, {"title", "Second"}});
+  cache.Put("issues", {{"id", "a1"}, {"title", "Renamed"}});
+
+  EXPECT_EQ("Renamed", cache.Find("issues", "a1")["title"]);
+  EXPECT_TRUE(cache.Find("users", "a1").is_null());
+
+  cache.Remove("issues", "a1");
+  EXPECT_TRUE(cache.Find("issues", "a1").is_null());
+  EXPECT_EQ("Second", cache.Find("issues", "b2")["title"]);
+}
+
+TEST(TestLocalCache, Get_MatchesAnyValueForAField) {
+  LocalCache cache("");
+  cache.Fetch("issues", "/issues",
+              {{{"id", "a1"}, {"status", "New"}, {"assignedTo", "u1"}},
+               {{"id", "b2"}, {"status", "Fixed"}, {"assignedTo", "u2"}},
+               {{"id", "c3"}, {"status", "Closed"}, {"assignedTo", "u1"}}});
+  EXPECT_TRUE(cache.Fetched("/issues"));
+  EXPECT_EQ(3, cache.Get("issues").size());
+
+  std::vector<json> open =
+      cache.Get("issues", {{"status", "New"}, {"status", "Fixed"}});
+  ASSERT_EQ(2, open.size());
+  EXPECT_EQ("a1", open[0]["id"]);
+  EXPECT_EQ("b2", open[1]["id"]);
+
+  std::vector<json> mine =
+      cache.Get("issues", {{"status", "New"}, {"assignedTo", "u2"}});
+  EXPECT_TRUE(mine.empty());
+}
+
+TEST(TestLocalCache, Apply) {
+  LocalCache cache("");
+  cache.Put("issues", {{"id", "a1"}, {"comments", json::array()}});
+
+  // New comments are added to the issue they belong to
+  cache.Apply({{"sequence", 4},
+               {"collection", "comments"},
+               {"op", "create"},
+               {"id", "c1"},
+               {"entity", {{"id", "c1"}, {"issueId", "a1"}}}});
+  EXPECT_EQ(json::array({"c1"}), cache.Find("issues", "a1")["comments"]);
+  EXPECT_EQ(4, cache.Sequence());
+
+  // Changes to the issue keep its comments
+  cache.Apply({{"sequence", 5},
+               {"collection", "issues"},
+               {"op", "patch"},
+               {"id", "a1"},
+               {"entity",
+                {{"id", "a1"}, {"title", "New"}, {"comments", json::array()}}}});
+  EXPECT_EQ("New", cache.Find("issues", "a1")["title"]);
+  EXPECT_EQ(json::array({"c1"}), cache.Find("issues", "a1")["comments"]);
+
+  cache.Apply({{"sequence", 6},
+               {"collection", "comments"},
+               {"op", "delete"},
+               {"id", "c1"},
+               {"entity", nullptr}});
+  EXPECT_TRUE(cache.Find("comments", "c1").is_null());
+  EXPECT_TRUE(cache.Find("issues", "a1")["comments"].empty());
+  EXPECT_EQ(6, cache.Sequence());
+}
+
+TEST(TestLocalCache, SaveAndLoad) {
+  char directory[] = "/tmp/hotTicketCacheXXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(directory));
+
+  LocalCache cache(directory);
+  cache.Fetch("users", "/users", {{{"id", "u1"}, {"name", "Ada"}}});
+  cache.SetSequence(12);
+  cache.SetEpoch("1600000000000");
+  cache.Save();
+
+  LocalCache loaded(directory);
+  loaded.Load();
+  EXPECT_EQ("Ada", loaded.Find("users", "u1")["name"]);
+  EXPECT_TRUE(loaded.Fetched("/users"));
+  EXPECT_EQ(12, loaded.Sequence());
+  EXPECT_EQ("1600000000000", loaded.Epoch());
+
+  // Clearing the cache forgets everything, including where it synced to
+  loaded.Clear();
+  EXPECT_TRUE(loaded.Find("users", "u1").is_null());
+  EXPECT_FALSE(loaded.Fetched("/users"));
+  EXPECT_TRUE(loaded.Epoch().empty());
+
+  std::remove((std::string(directory) + "/cache.json").c_str());
+  std::remove(directory);
+}
@@ -0,0 +1,147 @@
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "ChangeLog.h"
+#include "QueryCache.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+Change MakeChange(const std::string& collection, const std::string& op,
+                  const std::string& id, const json& entity) {
+  Change change;
+  change.collection = collection;
+  change.op = op;
+  change.id = id;
+  change.entity = entity;
+  return change;
+}
+
+/**
+ * Caches a response of issues with the given ids, with one comment each
+ */
+void PutIssues(QueryCache* cache, const QueryCache::Query& query,
+               std::initializer_list<const char*> ids) {
+  json response = json::array();
+  for (const char* id : ids) {
+    response.push_back({{"id", id},
+                        {"status", "New"},
+                        {"comments", {std::string("c0") + id}},
+                        {"votes", json::array()}});
+  }
+  cache->Put(query, response.dump(), response, cache->Version());
+}
+}  // namespace
+
+TEST(TestQueryCache, Key_IgnoresOrderAndRepeats) {
+  EXPECT_EQ(QueryCache::Key({{"status", "New"}, {"status", "Fixed"}}),
+            QueryCache::Key({{"status", "Fixed"},
+                             {"status", "New"},
+                             {"status", "Fixed"}}));
+  EXPECT_NE(QueryCache::Key({{"status", "New"}}),
+            QueryCache::Key({{"status", "New"}, {"status", "Fixed"}}));
+  EXPECT_NE(QueryCache::Key({{"a", "b=c"}}), QueryCache::Key({{"a=b", "c"}}));
+  EXPECT_EQ("", QueryCache::Key({}));
+}
+
+TEST(TestQueryCache, GetPut) {
+  QueryCache cache("issues");
+  EXPECT_EQ(nullptr, cache.Get({{"status", "New"}}));
+
+  PutIssues(&cache, {{"status", "New"}}, {"issue00001"});
+  auto body = cache.Get({{"status", "New"}});
+  ASSERT_NE(nullptr, body);
+  EXPECT_THAT(*body, ::testing::HasSubstr("issue00001"));
+
+  QueryCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(1, stats.entries);
+  EXPECT_GT(stats.bytes, body->size());
+}
+
+TEST(TestQueryCache, Put_AfterAChange_IsDropped) {
+  QueryCache cache("issues");
+  uint64_t version = cache.Version();
+  cache.Invalidate(MakeChange("issues", "delete", "issue00009", nullptr));
+  cache.Put({}, "[]", json::array(), version);
+  EXPECT_EQ(nullptr, cache.Get({}));
+
+  // Changes to other collections don't change the version
+  version = cache.Version();
+  cache.Invalidate(MakeChange("users", "delete", "us3r000001", nullptr));
+  cache.Put({}, "[]", json::array(), version);
+  EXPECT_NE(nullptr, cache.Get({}));
+}
+
+TEST(TestQueryCache, EvictsTheLeastRecentlyUsed) {
+  // Room for two of the responses
+  QueryCache cache("issues", 1100);
+  PutIssues(&cache, {{"status", "A"}}, {"issue00001"});
+  PutIssues(&cache, {{"status", "B"}}, {"issue00002"});
+  EXPECT_NE(nullptr, cache.Get({{"status", "A"}}));
+  PutIssues(&cache, {{"status", "C"}}, {"issue00003"});
+
+  EXPECT_NE(nullptr, cache.Get({{"status", "A"}}));
+  EXPECT_EQ(nullptr, cache.Get({{"status", "B"}}));
+  EXPECT_NE(nullptr, cache.Get({{"status", "C"}}));
+  EXPECT_LE(cache.GetStats().bytes, 1100);
+
+  // Responses bigger than the cache aren't kept
+  json big = json::array({{{"id", std::string(2000, 'a')}}});
+  cache.Put({{"big", "1"}}, big.dump(), big, cache.Version());
+  EXPECT_EQ(nullptr, cache.Get({{"big", "1"}}));
+  EXPECT_EQ(2, cache.GetStats().entries);
+}
+
+TEST(TestQueryCache, Invalidate_OnlyTheAlteredResponses) {
+  QueryCache cache("issues");
+  cache.Depend("comments", "issueId");
+  PutIssues(&cache, {{"status", "New"}}, {"issue00001", "issue00002"});
+  PutIssues(&cache, {{"status", "Fixed"}}, {"issue00003"});
+  PutIssues(&cache, {{"reporter", "us3r000001"}}, {"issue00004"});
+  PutIssues(&cache, {{"status", "Fixed"}, {"sort", "-updatedAt"}},
+            {"issue00003"});
+
+  // An issue leaving New drops the responses that had it, and the ones it
+  // now matches, ignoring their sort
+  cache.Invalidate(MakeChange("issues", "patch", "issue00002",
+                              {{"id", "issue00002"}, {"status", "Fixed"}}));
+  EXPECT_EQ(nullptr, cache.Get({{"status", "New"}}));
+  EXPECT_EQ(nullptr, cache.Get({{"status", "Fixed"}}));
+  EXPECT_EQ(nullptr, cache.Get({{"status", "Fixed"}, {"sort", "-updatedAt"}}));
+  EXPECT_NE(nullptr, cache.Get({{"reporter", "us3r000001"}}));
+
+  // A new comment drops the responses with its issue, and a deleted one the
+  // responses that listed it
+  PutIssues(&cache, {{"status", "New"}}, {"issue00001"});
+  json comment = {{"id", "c0mment999"}, {"issueId", "issue00004"}};
+  cache.Invalidate(MakeChange("comments", "create", "c0mment999", comment));
+  EXPECT_EQ(nullptr, cache.Get({{"reporter", "us3r000001"}}));
+  EXPECT_NE(nullptr, cache.Get({{"status", "New"}}));
+  cache.Invalidate(MakeChange("comments", "delete", "c0issue00001", nullptr));
+  EXPECT_EQ(nullptr, cache.Get({{"status", "New"}}));
+
+  // Deleting an issue no response has changes nothing
+  PutIssues(&cache, {{"status", "New"}}, {"issue00001"});
+  cache.Invalidate(MakeChange("issues", "delete", "issue00077", nullptr));
+  cache.Invalidate(MakeChange("users", "patch", "us3r000001",
+                              {{"id", "us3r000001"}, {"name", "A"}}));
+  EXPECT_NE(nullptr, cache.Get({{"status", "New"}}));
+}
+
+TEST(TestQueryCache, FollowsAChangeLog) {
+  auto cache = std::make_shared<QueryCache>("issues");
+  ChangeLog changeLog;
+  changeLog.Subscribe(
+      [cache](const Change& change) { cache->Invalidate(change); });
+
+  PutIssues(cache.get(), {}, {"issue00001"});
+  changeLog.Append("issues", "create", "issue00002",
+                   {{"id", "issue00002"}, {"status", "New"}});
+  EXPECT_EQ(nullptr, cache->Get({}));
+}
@@ -0,0 +1,109 @@
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "Exceptions.h"
+#include "RequestCoalescer.h"
+
+namespace {
+/**
+ * Waits until a number of requests are waiting for a flight
+ */
+void AwaitShared(RequestCoalescer* coalescer, uint64_t requests) {
+  while (coalescer->GetStats().shared < requests) {
+    std::this_thread::yield();
+  }
+}
+}  // namespace
+
+TEST(TestRequestCoalescer, Key) {
+  EXPECT_EQ(RequestCoalescer::Key("/issues", "6:status3:New", 4),
+            RequestCoalescer::Key("/issues", "6:status3:New", 4));
+  EXPECT_NE(RequestCoalescer::Key("/issues", "6:status3:New", 4),
+            RequestCoalescer::Key("/issues", "6:status3:New", 5));
+  EXPECT_NE(RequestCoalescer::Key("/issues", "", 4),
+            RequestCoalescer::Key("/comments", "", 4));
+  EXPECT_NE(RequestCoalescer::Key("/a", "1:b", 0),
+            RequestCoalescer::Key("/a1:b", "", 0));
+}
+
+TEST(TestRequestCoalescer, Do_SharesAFlight) {
+  RequestCoalescer coalescer;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::atomic<int> computed(0);
+  auto compute = [&]() {
+    computed++;
+    released.wait();
+    return std::make_shared<const RequestCoalescer::Response>("[]");
+  };
+
+  const int requests = 8;
+  std::vector<std::future<RequestCoalescer::Body>> responses;
+  responses.push_back(std::async(std::launch::async, [&]() {
+    return coalescer.Do("k", compute);
+  }));
+  while (computed == 0) std::this_thread::yield();
+  for (int request = 1; request < requests; request++) {
+    responses.push_back(std::async(std::launch::async, [&]() {
+      return coalescer.Do("k", compute);
+    }));
+  }
+  AwaitShared(&coalescer, requests - 1);
+  EXPECT_EQ(1, coalescer.InFlight());
+  release.set_value();
+
+  RequestCoalescer::Body first = responses.front().get();
+  for (std::size_t request = 1; request < responses.size(); request++) {
+    EXPECT_EQ(first, responses[request].get());
+  }
+  EXPECT_EQ(1, computed);
+  EXPECT_EQ(0, coalescer.InFlight());
+  EXPECT_EQ(1, coalescer.GetStats().computed);
+}
+
+TEST(TestRequestCoalescer, Do_SharesErrors) {
+  RequestCoalescer coalescer;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::atomic<bool> started(false);
+  auto compute = [&]() -> RequestCoalescer::Body {
+    started = true;
+    released.wait();
+    throw NotFoundError("gone");
+  };
+
+  auto first = std::async(std::launch::async,
+                          [&]() { return coalescer.Do("k", compute); });
+  while (!started) std::this_thread::yield();
+  auto second = std::async(std::launch::async,
+                           [&]() { return coalescer.Do("k", compute); });
+  AwaitShared(&coalescer, 1);
+  release.set_value();
+
+  EXPECT_THROW(first.get(), NotFoundError);
+  EXPECT_THROW(second.get(), NotFoundError);
+  EXPECT_EQ(0, coalescer.InFlight());
+}
+
+TEST(TestRequestCoalescer, Do_ComputesAfterAFlightEnds) {
+  RequestCoalescer coalescer;
+  int computed = 0;
+  auto compute = [&]() {
+    computed++;
+    return std::make_shared<const RequestCoalescer::Response>(
+        std::to_string(computed));
+  };
+
+  // A response is never kept once it has been given out
+  EXPECT_EQ("1", coalescer.Do("k", compute)->body);
+  EXPECT_EQ("2", coalescer.Do("k", compute)->body);
+  EXPECT_EQ(2, coalescer.GetStats().computed);
+  EXPECT_EQ(0, coalescer.GetStats().shared);
+}
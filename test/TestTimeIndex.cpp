@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "EntityService.hpp"
+#include "Exceptions.h"
+#include "TimeIndex.h"
+#include "Utilities.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+std::string Time(int64_t minutes) {
+  time_t seconds = 1600000000 + minutes * 60;
+  return TimeUtilities::ConvertTimeToString(*gmtime(&seconds));
+}
+
+/**
+ * Builds 200 entities created out of order, many at the same time, and some
+ * never updated
+ */
+json MakeEntities() {
+  json entities = json::array();
+  for (int i = 0; i < 200; i++) {
+    json entity = {{"id", "entity" + std::to_string(i)},
+                   {"createdAt", Time((i * 37) % 50)},
+                   {"updatedAt", i % 3 == 0 ? "" : Time((i * 11) % 70)},
+                   {"kind", i % 4 == 0 ? "even" : "odd"}};
+    entities.push_back(entity);
+  }
+  return entities;
+}
+
+/**
+ * Lists the rows of a query the slow way, for Select to be compared with
+ */
+std::vector<std::size_t> Expected(const json& entities,
+                                  const std::vector<std::size_t>& matches,
+                                  const ListOptions& options) {
+  std::vector<std::size_t> rows;
+  for (std::size_t row : matches) {
+    if (TimeIndex::Key(entities[row], "createdAt") >= options.minCreatedAt &&
+        TimeIndex::Key(entities[row], "updatedAt") >= options.minUpdatedAt) {
+      rows.push_back(row);
+    }
+  }
+  if (options.sorted) {
+    const char* field =
+        options.sortField == ListOptions::CreatedAt ? "createdAt" : "updatedAt";
+    std::stable_sort(rows.begin(), rows.end(),
+                     [&](std::size_t lhs, std::size_t rhs) {
+                       return TimeIndex::Key(entities[lhs], field) <
+                              TimeIndex::Key(entities[rhs], field);
+                     });
+    if (options.descending) std::reverse(rows.begin(), rows.end());
+  }
+  if (rows.size() > options.limit) rows.resize(options.limit);
+  return rows;
+}
+}  // namespace
+
+TEST(TestTimeIndex, Parse_SplitsOptionsFromFilters) {
+  StringMap filters;
+  ListOptions options = ListOptions::Parse({{"status", "New"},
+                                            {"sort", "-updatedAt"},
+                                            {"limit", "10"},
+                                            {"status", "Fixed"},
+                                            {"createdAfter", "2020-12-01"}},
+                                           &filters);
+  EXPECT_EQ(StringMap({{"status", "New"}, {"status", "Fixed"}}), filters);
+  EXPECT_TRUE(options.sorted);
+  EXPECT_EQ(ListOptions::UpdatedAt, options.sortField);
+  EXPECT_TRUE(options.descending);
+  EXPECT_EQ(10, options.limit);
+  EXPECT_EQ(1606780800 + 1, options.minCreatedAt);
+  EXPECT_EQ(ListOptions::Never, options.minUpdatedAt);
+
+  EXPECT_TRUE(ListOptions::Requested({{"limit", "1"}}));
+  EXPECT_FALSE(ListOptions::Requested({{"status", "New"}}));
+}
+
+TEST(TestTimeIndex, Parse_InvalidOptions) {
+  StringMap filters;
+  for (StringMap query :
+       {StringMap{{"sort", "title"}}, StringMap{{"sort", "-"}},
+        StringMap{{"limit", "-1"}}, StringMap{{"limit", "ten"}},
+        StringMap{{"limit", ""}}, StringMap{{"updatedSince", "yesterday"}},
+        StringMap{{"createdAfter", "2020-13-01"}},
+        StringMap{{"sort", "createdAt"}, {"sort", "updatedAt"}}}) {
+    EXPECT_THROW(ListOptions::Parse(query, &filters), BadRequestError);
+  }
+}
+
+TEST(TestTimeIndex, Select_MatchesSorting) {
+  json entities = MakeEntities();
+  TimeIndex index(entities);
+  ASSERT_EQ(200, index.size());
+
+  std::vector<std::size_t> all(entities.size());
+  std::vector<std::size_t> even;
+  for (std::size_t row = 0; row < all.size(); row++) {
+    all[row] = row;
+    if (entities[row]["kind"] == "even") even.push_back(row);
+  }
+
+  std::vector<StringMap> queries = {
+      {},
+      {{"limit", "5"}},
+      {{"sort", "createdAt"}},
+      {{"sort", "-createdAt"}, {"limit", "7"}},
+      {{"sort", "-updatedAt"}, {"limit", "10"}},
+      {{"sort", "updatedAt"}, {"limit", "300"}},
+      {{"createdAfter", Time(30)}},
+      {{"updatedSince", Time(20)}, {"limit", "4"}},
+      {{"createdAfter", Time(10)}, {"updatedSince", Time(40)}},
+      {{"createdAfter", Time(10)}, {"sort", "-updatedAt"}, {"limit", "6"}},
+      {{"updatedSince", Time(60)}, {"sort", "createdAt"}},
+      {{"limit", "0"}, {"sort", "createdAt"}}};
+  for (std::size_t i = 0; i < queries.size(); i++) {
+    SCOPED_TRACE("query " + std::to_string(i));
+    StringMap filters;
+    ListOptions options = ListOptions::Parse(queries[i], &filters);
+    EXPECT_EQ(Expected(entities, all, options), index.Select(nullptr, options));
+    EXPECT_EQ(Expected(entities, even, options), index.Select(&even, options));
+  }
+}
+
+TEST(TestTimeIndex, MissingTimes_AreNever) {
+  json entities = {{{"createdAt", "not a time"}},
+                   {{"createdAt", Time(1)}, {"updatedAt", Time(2)}},
+                   json::object(),
+                   nullptr};
+  TimeIndex index(entities);
+  EXPECT_EQ(4, index.size());
+  EXPECT_EQ(ListOptions::Never, TimeIndex::Key(entities[0], "createdAt"));
+
+  StringMap filters;
+  ListOptions newest = ListOptions::Parse({{"sort", "-updatedAt"}}, &filters);
+  EXPECT_EQ(std::vector<std::size_t>({1, 3, 2, 0}),
+            index.Select(nullptr, newest));
+
+  ListOptions updated =
+      ListOptions::Parse({{"updatedSince", Time(0)}}, &filters);
+  EXPECT_EQ(std::vector<std::size_t>({1}), index.Select(nullptr, updated));
+}
@@ -0,0 +1,217 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "ChangeLog.h"
+#include "CommentService.h"
+#include "Exceptions.h"
+#include "IStreamableFileHandler.h"
+#include "IssueService.h"
+#include "Transaction.h"
+#include "UserService.h"
+#include "VoteService.h"
+#include "nlohmann/json.hpp"
+
+using ::testing::ElementsAre;
+using json = nlohmann::json;
+
+namespace {
+/**
+ * Keeps a file in memory, and can be made to fail its writes as a full disk
+ * would, or its reads as a file torn by a crash would
+ */
+class MemoryFile : public IStreamableFileHandler {
+ public:
+  explicit MemoryFile(const json& data) : data(data) {}
+
+  json read() override {
+    if (failReads) throw InternalServerError("The file could not be read");
+    return data;
+  }
+
+  void write(const json& updatedJson) override {
+    if (failWrites) throw InternalServerError("The disk is full");
+    data = updatedJson;
+    writes.push_back(updatedJson);
+  }
+
+  json data;
+  std::vector<json> writes;
+  bool failWrites = false;
+  bool failReads = false;
+};
+
+std::vector<std::string> Ids(const json& collection) {
+  std::vector<std::string> ids;
+  for (auto& item : collection) ids.push_back(item["id"]);
+  return ids;
+}
+
+json MakeComment(const std::string& id, const std::string& issueId) {
+  return {{"id", id},
+          {"issueId", issueId},
+          {"body", "A comment"},
+          {"createdAt", "Thu Dec 10 06:56:05 2020"},
+          {"createdBy", "us3r000001"},
+          {"updatedAt", ""},
+          {"updatedBy", ""}};
+}
+}  // namespace
+
+class TestTransaction : public ::testing::Test {
+ protected:
+  std::shared_ptr<MemoryFile> usersFile;
+  std::shared_ptr<MemoryFile> commentsFile;
+  std::shared_ptr<MemoryFile> votesFile;
+  std::shared_ptr<MemoryFile> issuesFile;
+  std::shared_ptr<MemoryFile> journalFile;
+
+  std::shared_ptr<UserService> userService;
+  std::shared_ptr<CommentService> commentService;
+  std::shared_ptr<VoteService> voteService;
+  std::shared_ptr<IssueService> issueService;
+  std::shared_ptr<ChangeLog> changeLog;
+  std::shared_ptr<Journal> journal;
+
+  void SetUp() override {
+    usersFile = std::make_shared<MemoryFile>(json::array(
+        {{{"id", "us3r000001"}, {"name", "Ada"}, {"role", "Developer"}}}));
+    commentsFile = std::make_shared<MemoryFile>(json::array());
+    votesFile = std::make_shared<MemoryFile>(json::array());
+    issuesFile = std::make_shared<MemoryFile>(json::array());
+    journalFile = std::make_shared<MemoryFile>(nullptr);
+
+    userService = std::make_shared<UserService>(usersFile);
+    commentService =
+        std::make_shared<CommentService>(commentsFile, userService);
+    voteService = std::make_shared<VoteService>(votesFile, userService);
+    issueService = std::make_shared<IssueService>(issuesFile, userService,
+                                                  commentService, voteService);
+
+    changeLog = std::make_shared<ChangeLog>();
+    userService->SetChangeLog(changeLog, "users");
+    commentService->SetChangeLog(changeLog, "comments");
+    voteService->SetChangeLog(changeLog, "votes");
+    issueService->SetChangeLog(changeLog, "issues");
+
+    journal = std::make_shared<Journal>(journalFile);
+    issueService->SetJournal(journal);
+  }
+
+  std::vector<Transactional*> Collections() {
+    return {issueService.get(), commentService.get(), voteService.get(),
+            userService.get()};
+  }
+};
+
+TEST_F(TestTransaction, CreateIssue_SavesTheDescriptionInOneCommit) {
+  Issue issue = issueService->Create(
+      R"({"title": "Crash", "createdBy": "us3r000001",
+          "description": "It crashes on start"})");
+
+  ASSERT_EQ(1, commentsFile->data.size());
+  EXPECT_EQ(issue.id.str(), commentsFile->data[0]["issueId"]);
+  EXPECT_THAT(Ids(issuesFile->data), ElementsAre(issue.id.str()));
+  EXPECT_THAT(issuesFile->data[0]["comments"],
+              ElementsAre(commentsFile->data[0]["id"]));
+
+  // One commit record with both changes, cleared once both were saved
+  ASSERT_EQ(2, journalFile->writes.size());
+  json changes = journalFile->writes[0]["changes"];
+  ASSERT_EQ(2, changes.size());
+  EXPECT_EQ("issues", changes[0]["collection"]);
+  EXPECT_EQ("comments", changes[1]["collection"]);
+  EXPECT_TRUE(journalFile->data.is_null());
+  EXPECT_EQ(2, changeLog->Latest());
+}
+
+TEST_F(TestTransaction, CreateIssue_WithoutDescription_NotJournaled) {
+  issueService->Create(R"({"title": "Crash", "createdBy": "us3r000001"})");
+  EXPECT_EQ(1, issuesFile->data.size());
+  EXPECT_TRUE(commentsFile->writes.empty());
+  EXPECT_TRUE(journalFile->writes.empty());
+}
+
+TEST_F(TestTransaction, CreateIssue_FailedWrite_FinishedByRecovery) {
+  issuesFile->failWrites = true;
+  EXPECT_THROW(
+      issueService->Create(R"({"title": "Crash", "createdBy": "us3r000001",
+                               "description": "It crashes on start"})"),
+      InternalServerError);
+
+  // Nothing was saved, and the commit record is kept
+  EXPECT_TRUE(issuesFile->data.empty());
+  EXPECT_TRUE(commentsFile->data.empty());
+  ASSERT_TRUE(journalFile->data.is_object());
+
+  // Recovering saves the issue and its description together
+  issuesFile->failWrites = false;
+  EXPECT_EQ(2, journal->Recover(Collections()));
+  EXPECT_EQ(1, issuesFile->data.size());
+  EXPECT_EQ(1, commentsFile->data.size());
+  EXPECT_TRUE(journalFile->data.is_null());
+
+  // Recovering again has nothing to do
+  EXPECT_EQ(0, journal->Recover(Collections()));
+}
+
+TEST_F(TestTransaction, DeleteIssue_DeletesItsCommentsAndVotes) {
+  issuesFile->data = json::array(
+      {{{"id", "issue00001"}, {"title", "Crash"}, {"createdBy", "us3r000001"},
+        {"reporter", "us3r000001"}, {"status", "New"}},
+       {{"id", "issue00002"}, {"title", "Hang"}, {"createdBy", "us3r000001"},
+        {"reporter", "us3r000001"}, {"status", "New"}}});
+  commentsFile->data = json::array({MakeComment("c0mment001", "issue00001"),
+                                    MakeComment("c0mment002", "issue00002"),
+                                    MakeComment("c0mment003", "issue00001")});
+  votesFile->data = json::array({MakeComment("v0te000001", "issue00001")});
+
+  EXPECT_TRUE(issueService->Delete("issue00001"));
+
+  EXPECT_THAT(Ids(issuesFile->data), ElementsAre("issue00002"));
+  EXPECT_THAT(Ids(commentsFile->data), ElementsAre("c0mment002"));
+  EXPECT_TRUE(votesFile->data.empty());
+  ASSERT_EQ(2, journalFile->writes.size());
+  EXPECT_EQ(4, journalFile->writes[0]["changes"].size());
+  EXPECT_EQ(4, changeLog->Latest());
+}
+
+TEST_F(TestTransaction, Uncommitted_ChangesAreDiscarded) {
+  {
+    Transaction transaction(journal);
+    commentService->Create(&transaction, MakeComment("", "issue00001"));
+    EXPECT_TRUE(transaction.Holds(commentService.get()));
+    EXPECT_FALSE(transaction.Holds(voteService.get()));
+  }
+  EXPECT_TRUE(commentsFile->writes.empty());
+
+  // Only the next change is published
+  commentService->Create(MakeComment("", "issue00002").dump());
+  EXPECT_EQ(1, changeLog->Latest());
+  EXPECT_EQ(1, commentsFile->data.size());
+}
+
+TEST_F(TestTransaction, Journal_TornRecord_IsIgnored) {
+  // A record torn while it was written was never committed
+  journalFile->failReads = true;
+  EXPECT_TRUE(journal->Read().is_null());
+  EXPECT_EQ(0, journal->Recover(Collections()));
+  EXPECT_TRUE(issuesFile->writes.empty());
+}
+
+TEST_F(TestTransaction, Journal_Redo_ByIdAndRepeatable) {
+  json collection = json::array({MakeComment("c0mment001", "issue00001")});
+  json created = {{"op", "create"},
+                  {"id", "c0mment002"},
+                  {"entity", MakeComment("c0mment002", "issue00001")}};
+  json deleted = {{"op", "delete"}, {"id", "c0mment001"}, {"entity", nullptr}};
+
+  for (int repeat = 0; repeat < 2; repeat++) {
+    Journal::Redo(collection, created);
+    Journal::Redo(collection, deleted);
+  }
+  EXPECT_THAT(Ids(collection), ElementsAre("c0mment002"));
+}
@@ -38,3 +38,12 @@ TEST(TestUser, Deserializer) {
       "{\"id\":\"abcdefgh23\",\"name\":\"BoDiddly\",\"role\":\"Developer\"}";
   EXPECT_EQ(expected_val, jsonText);
 }
+
+TEST(TestUser, Serializer_Versioned) {
+  User user;
+  user.id = "abcdefgh23";
+  user.version = 3;
+  json j = user;
+  EXPECT_EQ(3, j.value("version", 0));
+  EXPECT_EQ(3, j.get<User>().version);
+}
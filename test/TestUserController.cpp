@@ -66,11 +66,11 @@ TEST_F(TestUserController, Get_OneUser_ProperRequest) {
   request->set_path("/users/" + user.id);
 
   // Controller should call the UserService once with the passed in user id
-  EXPECT_CALL(*mockService, Get(user.id)).WillOnce(Return(user));
+  EXPECT_CALL(*mockService, Get(user.id.str())).WillOnce(Return(user));
 
   // Controller should send back the user as a JSON string, with a status of OK
   // if the request is valid
-  EXPECT_CALL(*mockSession, close(restbed::OK, StrEq(body), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(body), _)).Times(1);
 
   // Controller should get the request from the session
   EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
@@ -80,7 +80,7 @@ TEST_F(TestUserController, Get_OneUser_ProperRequest) {
 
 TEST_F(TestUserController, Get_OneUser_NotFound) {
   // Fake the user service throwing a not found error
-  EXPECT_CALL(*mockService, Get(user.id))
+  EXPECT_CALL(*mockService, Get(user.id.str()))
       .WillOnce(Throw(NotFoundError("fake not found exception")));
 
   // Add the user id to the request path
@@ -91,14 +91,14 @@ TEST_F(TestUserController, Get_OneUser_NotFound) {
 
   // Controller should send back a NOT FOUND response if the user specified
   // doesn't exist, with a non-empty error message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
 
   controller.Get(mockSession);
 }
 
 TEST_F(TestUserController, Get_OneUser_ServerError) {
   // Fake the user service throwing an error while performing the request
-  EXPECT_CALL(*mockService, Get(user.id))
+  EXPECT_CALL(*mockService, Get(user.id.str()))
       .WillOnce(Throw(InternalServerError("fake server error")));
 
   // Add the user id to the request path
@@ -110,7 +110,7 @@ TEST_F(TestUserController, Get_OneUser_ServerError) {
   // Controller should send back an INTERNAL_SERVER_ERROR if the user service
   // encountered an error while getting the users, with a non-empty error
   // message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Get(mockSession);
@@ -124,7 +124,7 @@ TEST_F(TestUserController, Get_AllUsers_NoQuery) {
 
   // Fake the user service sending back a vector of users
   std::vector<User> users = {user};
-  EXPECT_CALL(*mockService, Get(::testing::A<StringMap>()))
+  EXPECT_CALL(*mockService, Get(::testing::A<const StringMap&>()))
       .WillOnce(Return(users));
 
   // Controller should get the request from the session
@@ -132,7 +132,7 @@ TEST_F(TestUserController, Get_AllUsers_NoQuery) {
 
   // Controller should send back an OK for any get request to /users/, with the
   // serialized user in the response body
-  EXPECT_CALL(*mockSession, close(restbed::OK, HasSubstr(jsonUser.dump()), _))
+  EXPECT_CALL(*mockSession, yield(restbed::OK, HasSubstr(jsonUser.dump()), _))
       .Times(1);
 
   controller.Get(mockSession);
@@ -148,7 +148,7 @@ TEST_F(TestUserController, Get_AllUsers_WithValidQuery) {
   // Fake the user service sending back a vector of users
   std::vector<User> users = {user};
 
-  EXPECT_CALL(*mockService, Get(::testing::An<StringMap>()))
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>()))
       .WillOnce(Return(users));
 
   // Controller should get the request from the session
@@ -156,7 +156,7 @@ TEST_F(TestUserController, Get_AllUsers_WithValidQuery) {
 
   // Controller should send back an OK for any get request to /users/, with the
   // serialized user in the response body
-  EXPECT_CALL(*mockSession, close(restbed::OK, HasSubstr(jsonUser.dump()), _))
+  EXPECT_CALL(*mockSession, yield(restbed::OK, HasSubstr(jsonUser.dump()), _))
       .Times(1);
 
   controller.Get(mockSession);
@@ -170,7 +170,7 @@ TEST_F(TestUserController, Get_AllUsers_ServerError) {
   StringMap queryParams = request->get_query_parameters();
 
   // Fake the user service throwing an error while retrieving the users
-  EXPECT_CALL(*mockService, Get(::testing::An<StringMap>()))
+  EXPECT_CALL(*mockService, Get(::testing::An<const StringMap&>()))
       .WillOnce(Throw(InternalServerError("fake error")));
 
   // Controller should get the request from the session
@@ -178,7 +178,7 @@ TEST_F(TestUserController, Get_AllUsers_ServerError) {
 
   // Controller should send back an INTERNAL_SERVER_ERROR if an error occurs,
   // with a nonempty error message in the body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Get(mockSession);
@@ -190,7 +190,7 @@ TEST_F(TestUserController, Get_NoRequest) {
 
   // Controller should send back a BAD REQUEST response if there is no request
   // passed in
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, _, _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, _, _)).Times(1);
 
   controller.Get(mockSession);
 }
@@ -220,7 +220,7 @@ TEST_F(TestUserController, Create_ProperRequest) {
 
   // Controller should send back a CREATED for a valid post to /users/, with the
   // serialized user in the body of the response
-  EXPECT_CALL(*mockSession, close(restbed::CREATED, StrEq(body), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::CREATED, StrEq(body), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -253,7 +253,7 @@ TEST_F(TestUserController, Create_NoName) {
 
   // Controller should send back a BAD REQUEST if the user service throws an
   // exception, with a non-empty error message in the body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -274,7 +274,7 @@ TEST_F(TestUserController, Create_EmptyBody) {
 
   // Controller should send back a BAD_REQUEST for an empty request body, with a
   // non-empty error message in the reponse body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -303,7 +303,7 @@ TEST_F(TestUserController, Create_ServerError) {
 
   // Controller should send back an INTERNAL_SERVER_ERROR if something else went
   // wrong with the request, with a non-empty error message in the body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Create(mockSession);
@@ -316,7 +316,7 @@ TEST_F(TestUserController, Create_NoRequest) {
 
   // Controller should send back a BAD REQUEST response if there is no request
   // passed in, with a non-empty error message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -342,7 +342,7 @@ TEST_F(TestUserController, Update_ProperRequest) {
   EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
 
   // Controller should send back an OK if the update is valid
-  EXPECT_CALL(*mockSession, close(restbed::OK, StrEq(body), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(body), _)).Times(1);
 
   // The controller should fetch the request body and invoke the callback to
   // process the body
@@ -368,7 +368,7 @@ TEST_F(TestUserController, Update_EmptyBody) {
 
   // The controller should send back a BAD_REQUEST if the request is empty, with
   // a non-empty error message in the response body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   // The controller shouldn't call the fetch method
   EXPECT_CALL(*mockSession, fetch(_, _)).Times(0);
@@ -397,7 +397,7 @@ TEST_F(TestUserController, Update_UserNotFound) {
 
   // Controller should return a NOT FOUND if the user in the request body could
   // not be found
-  EXPECT_CALL(*mockSession, close(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
 
   // The controller should fetch the request body and invoke the callback to
   // process the body
@@ -431,7 +431,7 @@ TEST_F(TestUserController, Update_ServerError) {
   // Controller should return an INTERNAL_SERVER_ERROR if the user service
   // encounters an error while updating the user, with a non-empty error message
   // in the response body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   // The controller should fetch the request body and invoke the callback to
@@ -458,7 +458,7 @@ TEST_F(TestUserController, Delete_ProperRequest) {
 
   // Controller should send back an OK if the delete was successful, with an
   // empty resposne body
-  EXPECT_CALL(*mockSession, close(restbed::OK, StrEq(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(""), _)).Times(1);
 
   controller.Delete(mockSession);
 }
@@ -476,7 +476,7 @@ TEST_F(TestUserController, Delete_NoId) {
   // Controller should send back a BAD_REQUEST if the request path does not
   // contain an id parameter, with a non-empty error message on the response
   // body
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Delete(mockSession);
 }
@@ -495,7 +495,7 @@ TEST_F(TestUserController, Delete_NotFound) {
 
   // Controller should send back a NOT_FOUND if the requested user could not be
   // found
-  EXPECT_CALL(*mockSession, close(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
 
   controller.Delete(mockSession);
 }
@@ -515,7 +515,7 @@ TEST_F(TestUserController, Delete_ServerError) {
   // Controller should send back a INTERNAL_SERVER_ERROR if the server
   // encountered an error while processing the delete, with a non-empty error
   // message on the response body
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Delete(mockSession);
@@ -0,0 +1,50 @@
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "User.h"
+#include "UserRef.h"
+
+namespace {
+User MakeUser() {
+  User user;
+  user.id = "u5er000001";
+  user.name = "Example User";
+  user.role = "Tester";
+  return user;
+}
+}  // namespace
+
+TEST(TestUserRef, Unresolved) {
+  UserRef ref;
+  ref.id = "u5er000001";
+  EXPECT_FALSE(ref.Resolved());
+  EXPECT_EQ(nullptr, ref.Get());
+  EXPECT_EQ("", ref.Name());
+  EXPECT_EQ("", ref.Role());
+}
+
+TEST(TestUserRef, ResolvedToUser) {
+  UserRef ref = MakeUser();
+  EXPECT_TRUE(ref.Resolved());
+  EXPECT_EQ("u5er000001", ref.id);
+  EXPECT_EQ("Example User", ref.Name());
+  EXPECT_EQ("Tester", ref.Role());
+}
+
+TEST(TestUserRef, CopiesShareTheUser) {
+  auto user = std::make_shared<const User>(MakeUser());
+  UserRef createdBy(user);
+  UserRef reporter = createdBy;
+  EXPECT_EQ(user, createdBy.Get());
+  EXPECT_EQ(user, reporter.Get());
+}
+
+TEST(TestUserRef, ChangingTheIdUnresolves) {
+  UserRef ref = MakeUser();
+  ref.id = "0ther00001";
+  EXPECT_FALSE(ref.Resolved());
+  EXPECT_EQ("", ref.Name());
+}
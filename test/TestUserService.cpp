@@ -1,3 +1,4 @@
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -6,6 +7,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include "ChangeLog.h"
 #include "Exceptions.h"
 #include "FileHandler.h"
 #include "IStreamableFileHandler.h"
@@ -49,37 +51,46 @@ class TestUserService : public ::testing::Test {
 };
 
 TEST_F(TestUserService, TestFilter_Expect_SingleParamIdIs2222) {
-  json filtered = userService->Filter(fakeJsonData, {{"role", "Developer"}});
+  FilterView filtered =
+      userService->Filter(fakeJsonData, {{"role", "Developer"}});
   EXPECT_EQ(filtered.size(), 2);
 }
 
 TEST_F(TestUserService, TestFilter_Expect_MultipleParamRoleDeveloperId2222) {
-  json filtered = userService->Filter(
+  FilterView filtered = userService->Filter(
       fakeJsonData, {{"id", "2222"}, {"name", "Steven Trinh"}});
   EXPECT_EQ(filtered.size(), 1);
 }
 
 TEST_F(TestUserService, TestFilter_Expect_NoResults_KeyDoesntExist) {
-  json filtered = userService->Filter(fakeJsonData, {{"place", "8"}});
+  FilterView filtered = userService->Filter(fakeJsonData, {{"place", "8"}});
   EXPECT_EQ(filtered.size(), 0);
 }
 
 TEST_F(TestUserService, TestFilter_Expect_NoResults_EmptyValues) {
-  json filtered = userService->Filter(fakeJsonData, {{"name", ""}});
+  FilterView filtered = userService->Filter(fakeJsonData, {{"name", ""}});
   EXPECT_EQ(filtered.size(), 0);
 }
 
 TEST_F(TestUserService, TestFilter_Expect_NoResults) {
-  json filtered =
+  FilterView filtered =
       userService->Filter(fakeJsonData, {{"role", "SupremeMemLeak"}});
   EXPECT_EQ(filtered.size(), 0);
 }
 
 TEST_F(TestUserService, TestFilter_EmptyFilterProvided) {
-  json filtered = userService->Filter(fakeJsonData, {});
+  FilterView filtered = userService->Filter(fakeJsonData, {});
   EXPECT_EQ(filtered.size(), 2);
 }
 
+TEST_F(TestUserService, TestFilter_RefersToTheData) {
+  std::multimap<std::string, std::string> query = {{"id", "3333"}};
+  FilterView filtered = userService->Filter(fakeJsonData, query);
+  ASSERT_FALSE(filtered.empty());
+  // The matches are the items of the data, not copies of them
+  EXPECT_EQ(&fakeJsonData[1], &filtered.front());
+}
+
 TEST_F(TestUserService, GetUsers_Expect_TwoValidUsers) {
   // We should read the json data once
   EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
@@ -254,3 +265,104 @@ TEST_F(TestUserService, UpdateUser_ExpectEntityCreationError) {
   std::string body = "testfake";
   EXPECT_THROW(userService->Update(body), BadRequestError);
 }
+
+TEST_F(TestUserService, Update_AdvancesVersionAndGeneration) {
+  EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(1);
+
+  uint64_t generation = userService->Generation();
+  std::string body =
+      "{\"id\": \"2222\", \"name\": \"UpdatedName\", \"role\": "
+      "\"UpdatedRole\"}";
+  User testUser = userService->Update(body);
+
+  // The stored user had no version, so the update is its first version
+  EXPECT_EQ(1, testUser.version);
+  EXPECT_EQ(generation + 1, userService->Generation());
+}
+
+TEST_F(TestUserService, Update_StaleVersion) {
+  EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
+  // Nothing should be written if the user has changed since it was read
+  EXPECT_CALL(*fileHandler, write(_)).Times(0);
+
+  std::string body =
+      "{\"id\": \"2222\", \"name\": \"UpdatedName\", \"role\": "
+      "\"UpdatedRole\", \"version\": 3}";
+  EXPECT_THROW(userService->Update(body), PreconditionFailedError);
+}
+
+TEST_F(TestUserService, Patch_OnlyUserFields) {
+  json stored;
+  EXPECT_CALL(*fileHandler, read())
+      .Times(2)
+      .WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_))
+      .Times(1)
+      .WillOnce(::testing::SaveArg<0>(&stored));
+
+  // Fields a User doesn't have are rejected rather than stored
+  EXPECT_THROW(userService->Patch("2222", "{\"foo\": 1}"), BadRequestError);
+
+  User patched = userService->Patch("2222", "{\"role\": \"Tester\"}");
+  EXPECT_EQ("Tester", patched.role);
+  EXPECT_FALSE(stored[0].contains("foo"));
+}
+
+TEST_F(TestUserService, Delete_ExpectedVersion) {
+  EXPECT_CALL(*fileHandler, read())
+      .Times(2)
+      .WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(1);
+
+  // The stored user is unversioned, so only version 0 matches it
+  EXPECT_THROW(userService->Delete("2222", 2), PreconditionFailedError);
+  EXPECT_TRUE(userService->Delete("2222", 0));
+}
+
+TEST_F(TestUserService, Bulk_OneReadAndWrite) {
+  // All of the operations should share one read and one write
+  EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(1);
+
+  json operations = json::parse(R"([
+    {"op": "create", "body": {"name": "NewUser", "role": "Tester"}},
+    {"op": "patch", "id": "2222", "body": {"role": "Manager"}},
+    {"op": "delete", "id": "doesnotexist"},
+    {"op": "explode"}
+  ])");
+  std::vector<BulkResult<User>> results = userService->Bulk(operations);
+
+  ASSERT_EQ(4, results.size());
+  EXPECT_FALSE(results[0].error);
+  EXPECT_EQ("NewUser", results[0].entity.name);
+  EXPECT_EQ(results[0].id, results[0].entity.id);
+  EXPECT_FALSE(results[1].error);
+  EXPECT_EQ("Manager", results[1].entity.role);
+  // Failed operations are reported without stopping the others
+  EXPECT_THROW(std::rethrow_exception(results[2].error), NotFoundError);
+  EXPECT_THROW(std::rethrow_exception(results[3].error), BadRequestError);
+}
+
+TEST_F(TestUserService, ChangeLog_RecordsSavedChanges) {
+  auto changeLog = std::make_shared<ChangeLog>();
+  userService->SetChangeLog(changeLog, "users");
+
+  EXPECT_CALL(*fileHandler, read()).WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(2);
+
+  User created = userService->Create("{\"name\":\"New\",\"role\":\"Tester\"}");
+  userService->Delete("2222");
+
+  // Failed changes are not recorded
+  EXPECT_THROW(userService->Delete("doesnotexist"), NotFoundError);
+
+  std::vector<Change> changes = changeLog->Since(0, 10);
+  ASSERT_EQ(2, changes.size());
+  EXPECT_EQ("users", changes[0].collection);
+  EXPECT_EQ("create", changes[0].op);
+  EXPECT_EQ(created.id, changes[0].id);
+  EXPECT_EQ("New", changes[0].entity["name"]);
+  EXPECT_EQ("delete", changes[1].op);
+  EXPECT_EQ("2222", changes[1].id);
+}
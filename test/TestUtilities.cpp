@@ -15,13 +15,14 @@ TEST(TestUtilities, TestBuildHeaders) {
   EXPECT_NE(headers.find("SomeKey"), headers.end());
   EXPECT_NE(headers.find("SomeOtherKey"), headers.end());
 
-  // Create a pair from the ALLOW_ALL and CLOSE_CONNECTION definitions
+  // Create a pair from the ALLOW_ALL definition
   std::pair<std::string, std::string> allowAll = ALLOW_ALL;
-  std::pair<std::string, std::string> close = CLOSE_CONNECTION;
 
-  // Expect that these headers are also included
+  // Expect that this header is also included
   EXPECT_NE(headers.find(allowAll.first), headers.end());
-  EXPECT_NE(headers.find(close.first), headers.end());
+
+  // Connections are kept open for the client's next request
+  EXPECT_EQ(headers.find("Connection"), headers.end());
 
   // Expect there to be no other keys
   EXPECT_EQ(headers.find("SomeFakeKey"), headers.end());
@@ -43,3 +44,93 @@ TEST(TestUtilities, TestGetIdFromPath) {
   EXPECT_EQ(Utilities::GetEntityIdFromRequestPath("/user/123/entity/456/", endpoint), "123");
   // clang-format on
 }
+
+TEST(TestUtilities, TestETagMatches) {
+  std::string etag = ResponseUtilities::BuildETag(12);
+
+  // clang-format off
+  EXPECT_TRUE(ResponseUtilities::ETagMatches(etag, etag));
+  EXPECT_TRUE(ResponseUtilities::ETagMatches("*", etag));
+  EXPECT_TRUE(ResponseUtilities::ETagMatches("\"abc\", " + etag, etag));
+  // Weak comparison ignores the W/ prefix
+  EXPECT_TRUE(ResponseUtilities::ETagMatches(etag.substr(2), etag));
+  EXPECT_FALSE(ResponseUtilities::ETagMatches("", etag));
+  EXPECT_FALSE(ResponseUtilities::ETagMatches("\"abc\"", etag));
+  EXPECT_FALSE(ResponseUtilities::ETagMatches(ResponseUtilities::BuildETag(13), etag));
+  // clang-format on
+}
+
+TEST(TestUtilities, TestParseVersionTag) {
+  EXPECT_EQ(3, Utilities::ParseVersionTag("3"));
+  EXPECT_EQ(3, Utilities::ParseVersionTag("\"3\""));
+  EXPECT_EQ(12, Utilities::ParseVersionTag(" W/\"12\" "));
+  // Empty headers and * match any version
+  EXPECT_EQ(-1, Utilities::ParseVersionTag(""));
+  EXPECT_EQ(-1, Utilities::ParseVersionTag("*"));
+  EXPECT_THROW(Utilities::ParseVersionTag("abc"), BadRequestError);
+  EXPECT_THROW(Utilities::ParseVersionTag("\"-1\""), BadRequestError);
+
+  // The ETag an Entity was sent with holds its version
+  EXPECT_EQ(7, Utilities::ParseVersionTag(
+                   ResponseUtilities::BuildEntityETag(7, 12)));
+  EXPECT_THROW(Utilities::ParseVersionTag(ResponseUtilities::BuildETag(12)),
+               BadRequestError);
+  EXPECT_THROW(Utilities::ParseVersionTag("\"7.\""), BadRequestError);
+}
+
+TEST(TestUtilities, TestToUTC) {
+  struct tm utc = TimeUtilities::ToUTC(998578502);
+  EXPECT_EQ("Thu Aug 23 14:55:02 2001",
+            TimeUtilities::ConvertTimeToString(utc));
+  EXPECT_EQ(998578502, TimeUtilities::ToSeconds(utc));
+}
+
+TEST(TestUtilities, TestParseSeconds) {
+  using TimeUtilities::ParseSeconds;
+  int64_t seconds = 0;
+  EXPECT_TRUE(ParseSeconds("Thu Jan 01 00:00:00 1970", &seconds));
+  EXPECT_EQ(0, seconds);
+  EXPECT_TRUE(ParseSeconds("Thu Aug 23 14:55:02 2001", &seconds));
+  EXPECT_EQ(998578502, seconds);
+  EXPECT_TRUE(ParseSeconds("2001-08-23T14:55:02Z", &seconds));
+  EXPECT_EQ(998578502, seconds);
+  EXPECT_TRUE(ParseSeconds("2001-08-23", &seconds));
+  EXPECT_EQ(998524800, seconds);
+
+  // The null time is long before the epoch
+  EXPECT_TRUE(ParseSeconds("Mon Jan 01 00:00:00 1900", &seconds));
+  EXPECT_EQ(-2208988800LL, seconds);
+  EXPECT_EQ(seconds, TimeUtilities::ToSeconds(TimeUtilities::NullTimeUTC()));
+
+  for (std::string invalid :
+       {"", "yesterday", "2001-8-23", "2001-08-23T14:55",
+        "Thu Abc 23 14:55:02 2001", "2001-08-23T25:00:00"}) {
+    EXPECT_FALSE(ParseSeconds(invalid, &seconds)) << invalid;
+  }
+}
+
+TEST(TestUtilities, TestParseBulkBody) {
+  json array =
+      Utilities::ParseBulkBody("[{\"op\":\"create\"},{\"op\":\"delete\"}]");
+  EXPECT_EQ(2, array.size());
+
+  // One operation per line, ignoring blank lines
+  json lines = Utilities::ParseBulkBody(
+      "{\"op\":\"create\"}\n\n{\"op\":\"delete\",\"id\":\"a1\"}\n");
+  EXPECT_EQ(2, lines.size());
+  EXPECT_EQ("a1", lines[1]["id"]);
+
+  EXPECT_THROW(Utilities::ParseBulkBody("{\"op\":"), BadRequestError);
+}
+
+TEST(TestUtilities, TestHandleResponseWithBody) {
+  // Responses from a ConnectionPool have already been read from the socket
+  std::string body = "{\"id\":\"a1\"}";
+  auto response = std::make_shared<restbed::Response>();
+  response->set_status_code(restbed::OK);
+  response->set_header("Content-Length", std::to_string(body.size()));
+  response->set_body(body);
+
+  json responseJson = ResponseUtilities::HandleResponse(response);
+  EXPECT_EQ("a1", responseJson["id"]);
+}
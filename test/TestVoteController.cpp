@@ -67,9 +67,10 @@ TEST_F(TestVoteController, Create_ValidVote) {
   requestBody = requestJson.dump();
   restbed::Bytes bodyAsBytes = restbed::String::to_bytes(requestBody);
 
-  // Set up the response body to be the created Vote
+  // Set up the response body to hold the created Vote and the new count
   jsonVote = vote;
-  responseBody = jsonVote.dump();
+  responseBody =
+      json({{"voted", true}, {"count", 3}, {"vote", jsonVote}}).dump();
 
   // Set the necessary request parameters
   request->set_path("/issues/" + fakeIssueId + "/votes");
@@ -86,25 +87,53 @@ TEST_F(TestVoteController, Create_ValidVote) {
       .WillOnce(
           InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
 
-  // We should call the service to get any votes by the user for the issue. We
-  // fake there being none, thus we will try to create a new vote
-  StringMap queryParams = {{"issueId", fakeIssueId},
-                           {"createdBy", fakeUser.id}};
-  EXPECT_CALL(*mockService, Get(queryParams))
-      .Times(1)
-      .WillOnce(Return(std::vector<Vote>{}));
-
-  // The service should successfully create the vote
-  EXPECT_CALL(*mockService, Create(requestBody)).WillOnce(Return(vote));
+  // The service should toggle the vote for the issue in the path, and we fake
+  // it being cast
+  VoteService::Toggled toggled;
+  toggled.vote = vote;
+  toggled.cast = true;
+  toggled.count = 3;
+  EXPECT_CALL(*mockService, Toggle(fakeIssueId, fakeUser.id.str()))
+      .WillOnce(Return(toggled));
 
-  // The controller should close the session with a status of CREATED and the
+  // The controller should respond with a status of CREATED and the
   // vote in the body of the response
-  EXPECT_CALL(*mockSession, close(restbed::CREATED, StrEq(responseBody), _))
+  EXPECT_CALL(*mockSession, yield(restbed::CREATED, StrEq(responseBody), _))
       .Times(1);
 
   controller.Create(mockSession);
 }
 
+TEST_F(TestVoteController, Create_IssueIdFromBody) {
+  // Votes posted to /votes name their issue in the body
+  json requestJson;
+  requestJson["issueId"] = fakeIssueId;
+  requestJson["createdBy"] = fakeUser.id;
+  requestBody = requestJson.dump();
+  restbed::Bytes bodyAsBytes = restbed::String::to_bytes(requestBody);
+
+  request->set_path("/votes");
+  request->set_body(requestBody);
+  request->set_header("Content-Length", std::to_string(requestBody.size()));
+
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+  EXPECT_CALL(*mockSession, fetch(_, _))
+      .Times(1)
+      .WillOnce(
+          InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
+
+  VoteService::Toggled toggled;
+  toggled.vote = vote;
+  toggled.cast = true;
+  toggled.count = 1;
+  EXPECT_CALL(*mockService, Toggle(fakeIssueId, fakeUser.id.str()))
+      .WillOnce(Return(toggled));
+
+  EXPECT_CALL(*mockSession, yield(restbed::CREATED, StrNe(""), _)).Times(1);
+
+  controller.Create(mockSession);
+}
+
 TEST_F(TestVoteController, Create_UserNotFound) {
   // Set up the request body to contain a user id
   json requestJson;
@@ -127,20 +156,12 @@ TEST_F(TestVoteController, Create_UserNotFound) {
       .WillOnce(
           InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
 
-  // We should call the service to get any votes by the user for the issue. We
-  // fake there being none, thus we will try to create a new vote
-  StringMap queryParams = {{"issueId", fakeIssueId},
-                           {"createdBy", fakeUser.id}};
-  EXPECT_CALL(*mockService, Get(queryParams))
-      .Times(1)
-      .WillOnce(Return(std::vector<Vote>{}));
-
   // Fake the UserService within the VoteService not finding the user
-  EXPECT_CALL(*mockService, Create(requestBody))
+  EXPECT_CALL(*mockService, Toggle(fakeIssueId, fakeUser.id.str()))
       .WillOnce(Throw(NotFoundError("fake user not found error")));
 
-  // The controller should close the session with a NOT_FOUND error response
-  EXPECT_CALL(*mockSession, close(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
+  // The controller should respond with a NOT_FOUND error response
+  EXPECT_CALL(*mockSession, yield(restbed::NOT_FOUND, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -168,13 +189,11 @@ TEST_F(TestVoteController, Create_ServerError) {
           InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
 
   // we fake the service throwing a server error
-  StringMap queryParams = {{"issueId", fakeIssueId},
-                           {"createdBy", fakeUser.id}};
-  EXPECT_CALL(*mockService, Get(queryParams))
+  EXPECT_CALL(*mockService, Toggle(fakeIssueId, fakeUser.id.str()))
       .WillOnce(Throw(InternalServerError("fake server error")));
 
-  // We should close the session with an INTERNAL_SERVER_ERROR status
-  EXPECT_CALL(*mockSession, close(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
+  // We should respond with an INTERNAL_SERVER_ERROR status
+  EXPECT_CALL(*mockSession, yield(restbed::INTERNAL_SERVER_ERROR, StrNe(""), _))
       .Times(1);
 
   controller.Create(mockSession);
@@ -203,13 +222,11 @@ TEST_F(TestVoteController, Create_BadRequest) {
           InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
 
   // we fake the service throwing a server error
-  StringMap queryParams = {{"issueId", fakeIssueId},
-                           {"createdBy", fakeUser.id}};
-  EXPECT_CALL(*mockService, Get(queryParams))
+  EXPECT_CALL(*mockService, Toggle(fakeIssueId, fakeUser.id.str()))
       .WillOnce(Throw(BadRequestError("fake bad request error")));
 
-  // We should close the session with an BAD_REQUEST status
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  // We should respond with an BAD_REQUEST status
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -220,9 +237,9 @@ TEST_F(TestVoteController, Create_InvalidPath) {
 
   EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
 
-  // The controller should close the session with a BAD_REQUEST and some kind of
+  // The controller should respond with a BAD_REQUEST and some kind of
   // error message
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -230,9 +247,9 @@ TEST_F(TestVoteController, Create_InvalidPath) {
 TEST_F(TestVoteController, Create_NoRequest) {
   EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(nullptr));
 
-  // The controller should close the session with a BAD_REQUEST and some kind of
+  // The controller should respond with a BAD_REQUEST and some kind of
   // error message
-  EXPECT_CALL(*mockSession, close(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
+  EXPECT_CALL(*mockSession, yield(restbed::BAD_REQUEST, StrNe(""), _)).Times(1);
 
   controller.Create(mockSession);
 }
@@ -259,21 +276,22 @@ TEST_F(TestVoteController, Delete_ValidDelete) {
       .WillOnce(
           InvokeArgument<1>(std::ref(mockSession), std::ref(bodyAsBytes)));
 
-  // We should call the service to get any votes by the user for the issue. We
-  // fake there being one, thus we will delete it
-  StringMap queryParams = {{"issueId", fakeIssueId},
-                           {"createdBy", fakeUser.id}};
-  std::vector<Vote> fakeVotes = {vote};
-  EXPECT_CALL(*mockService, Get(queryParams))
-      .Times(1)
-      .WillOnce(Return(fakeVotes));
-
-  // The service should successfully delete the vote
-  EXPECT_CALL(*mockService, Delete(vote.id)).WillOnce(Return(true));
-
-  // The controller should close the session with a status of NO_CONTENT to
-  // notify the caller it was deleted successfully
-  EXPECT_CALL(*mockSession, close(restbed::NO_CONTENT, StrEq(""), _)).Times(1);
+  // The service should toggle the vote, and we fake the user having voted
+  // already, thus it is removed
+  VoteService::Toggled toggled;
+  toggled.vote = vote;
+  toggled.cast = false;
+  toggled.count = 0;
+  EXPECT_CALL(*mockService, Toggle(fakeIssueId, fakeUser.id.str()))
+      .WillOnce(Return(toggled));
+
+  // The controller should respond with a status of OK and the new
+  // count, to notify the caller it was removed successfully
+  jsonVote = vote;
+  responseBody =
+      json({{"voted", false}, {"count", 0}, {"vote", jsonVote}}).dump();
+  EXPECT_CALL(*mockSession, yield(restbed::OK, StrEq(responseBody), _))
+      .Times(1);
 
   controller.Create(mockSession);
 }
@@ -282,9 +300,25 @@ TEST_F(TestVoteController, UnusedMethods) {
   // This test just makes sure the unused methods don't do anything
   EXPECT_CALL(*mockSession, get_request).Times(0);
   EXPECT_CALL(*mockSession, get_path_parameter).Times(0);
+  EXPECT_CALL(*mockSession, yield).Times(0);
   EXPECT_CALL(*mockSession, close).Times(0);
   EXPECT_CALL(*mockSession, fetch).Times(0);
 
   controller.Update(mockSession);
   controller.Delete(mockSession);
 }
+
+TEST_F(TestVoteController, Get_VotesForIssue) {
+  request->set_path("/issues/" + fakeIssueId + "/votes");
+  EXPECT_CALL(*mockSession, get_request()).WillOnce(Return(request));
+
+  // Only the votes for the issue in the path should be requested
+  StringMap queryParams = {{"issueId", fakeIssueId}};
+  EXPECT_CALL(*mockService, Get(queryParams))
+      .Times(1)
+      .WillOnce(Return(std::vector<Vote>{vote}));
+
+  EXPECT_CALL(*mockSession, yield(restbed::OK, _, _)).Times(1);
+
+  controller.Get(mockSession);
+}
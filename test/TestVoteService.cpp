@@ -1,9 +1,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "FileHandler.h"
+#include "IssueService.h"
 #include "MockIStreamFileHandler.h"
 #include "MockUserService.h"
 #include "User.h"
@@ -15,6 +17,7 @@
 #include "gtest/gtest.h"
 
 using ::testing::_;
+using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::StrEq;
 using ::testing::StrNe;
@@ -64,9 +67,9 @@ class TestVoteService : public ::testing::Test {
 };
 
 TEST_F(TestVoteService, GetVotes_NoQuery) {
-  // The user service should be called twice. We fake it returning the fake user
-  EXPECT_CALL(*userService, Get(fakeUser.id))
-      .Times(2)
+  // Both votes were made by the fake user, who should only be fetched once
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
+      .Times(1)
       .WillRepeatedly(Return(fakeUser));
 
   // We should read the json data once
@@ -78,7 +81,7 @@ TEST_F(TestVoteService, GetVotes_NoQuery) {
 
 TEST_F(TestVoteService, GetVotes_WithQuery_ExpectOneResult) {
   // The user service should be called once. We fake it returning the fake user
-  EXPECT_CALL(*userService, Get(fakeUser.id))
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
       .Times(1)
       .WillOnce(Return(fakeUser));
 
@@ -91,7 +94,8 @@ TEST_F(TestVoteService, GetVotes_WithQuery_ExpectOneResult) {
 
 TEST_F(TestVoteService, GetVotes_WithQuery_ExpectNoResults) {
   // The user service should not be called
-  EXPECT_CALL(*userService, Get(::testing::A<std::string>())).Times(0);
+  EXPECT_CALL(*userService, Get(::testing::A<const std::string&>()))
+      .Times(0);
 
   // We should read the json data once
   EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
@@ -102,7 +106,7 @@ TEST_F(TestVoteService, GetVotes_WithQuery_ExpectNoResults) {
 
 TEST_F(TestVoteService, GetVote_ValidId) {
   // The user service should be called once. We fake it returning the fake user
-  EXPECT_CALL(*userService, Get(fakeUser.id))
+  EXPECT_CALL(*userService, Get(fakeUser.id.str()))
       .Times(1)
       .WillOnce(Return(fakeUser));
 
@@ -113,13 +117,14 @@ TEST_F(TestVoteService, GetVote_ValidId) {
   EXPECT_EQ("2222", vote.id);
   EXPECT_EQ("123456", vote.issueId);
   EXPECT_EQ(fakeUser.id, vote.createdBy.id);
-  EXPECT_EQ(fakeUser.name, vote.createdBy.name);
+  EXPECT_EQ(fakeUser.name, vote.createdBy.Name());
   EXPECT_EQ("", vote.updatedBy.id);
 }
 
 TEST_F(TestVoteService, GetVote_InvalidId) {
   // The user service should not get called
-  EXPECT_CALL(*userService, Get(::testing::A<std::string>())).Times(0);
+  EXPECT_CALL(*userService, Get(::testing::A<const std::string&>()))
+      .Times(0);
 
   // We should read the json data once
   EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
@@ -130,7 +135,8 @@ TEST_F(TestVoteService, GetVote_InvalidId) {
 
 TEST_F(TestVoteService, GetVote_NoId) {
   // The user service should not get called
-  EXPECT_CALL(*userService, Get(::testing::A<std::string>())).Times(0);
+  EXPECT_CALL(*userService, Get(::testing::A<const std::string&>()))
+      .Times(0);
 
   // We should read the json data once
   EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
@@ -160,7 +166,7 @@ TEST_F(TestVoteService, CreateVote_ValidVote) {
   // TODO(anyone): Add check from Issue Service that this is a valid Issue ID
   EXPECT_THAT(result.issueId, StrEq("123456"));
   EXPECT_EQ(result.createdBy.id, fakeUser.id);
-  EXPECT_EQ(result.createdBy.name, fakeUser.name);
+  EXPECT_EQ(result.createdBy.Name(), fakeUser.name);
 
   // The created date should be ignored and the current UTC time should be used
   time_t t = time(0);
@@ -199,7 +205,7 @@ TEST_F(TestVoteService, CreateVote_ValidVote_ExtraFieldsIgnored) {
   // TODO(anyone): Add check from Issue Service that this is a valid Issue ID
   EXPECT_THAT(result.issueId, StrEq("123456"));
   EXPECT_EQ(result.createdBy.id, fakeUser.id);
-  EXPECT_EQ(result.createdBy.name, fakeUser.name);
+  EXPECT_EQ(result.createdBy.Name(), fakeUser.name);
 
   // The created date should be ignored and the current UTC time should be used
   time_t t = time(0);
@@ -237,7 +243,8 @@ TEST_F(TestVoteService, CreateVote_InvalidVote_NoIssueId) {
   std::string body = "{\"createdBy\": \"9999\"}";
 
   // The user service shouldn't be called at all
-  EXPECT_CALL(*userService, Get(::testing::A<std::string>())).Times(0);
+  EXPECT_CALL(*userService, Get(::testing::A<const std::string&>()))
+      .Times(0);
 
   // We should read the json file once
   EXPECT_CALL(*fileHandler, read()).Times(1).WillOnce(Return(fakeJsonData));
@@ -276,3 +283,141 @@ TEST_F(TestVoteService, DeleteVote_InvalidId) {
 
   EXPECT_THROW(voteService->Delete(id), NotFoundError);
 }
+
+TEST_F(TestVoteService, Toggle_RemovesExistingVote) {
+  // The file is read once for the ballots, and written for each toggle
+  json saved;
+  EXPECT_CALL(*fileHandler, read).Times(1).WillOnce(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&saved](const json& data) { saved = data; }));
+  EXPECT_CALL(*userService, Get(std::string("1234")))
+      .WillOnce(Return(fakeUser));
+
+  // The user has voted for the issue, so the vote is removed
+  VoteService::Toggled toggled = voteService->Toggle("123456", "1234");
+  EXPECT_FALSE(toggled.cast);
+  EXPECT_EQ("2222", toggled.vote.id.str());
+  EXPECT_EQ(0, toggled.count);
+  ASSERT_EQ(1, saved.size());
+  EXPECT_EQ("2223", saved[0]["id"]);
+
+  // Toggling again casts a new one
+  toggled = voteService->Toggle("123456", "1234");
+  EXPECT_TRUE(toggled.cast);
+  EXPECT_EQ("123456", toggled.vote.issueId.str());
+  EXPECT_EQ(1, toggled.count);
+  EXPECT_EQ(2, saved.size());
+  EXPECT_EQ(1, voteService->Count("1234567"));
+}
+
+TEST_F(TestVoteService, Toggle_KeepsVotesInOrder) {
+  json votes = fakeJsonData;
+  votes.push_back(votes[1]);
+  votes[2]["id"] = "2224";
+  votes[2]["issueId"] = "12345678";
+  json saved;
+  EXPECT_CALL(*fileHandler, read).Times(1).WillOnce(Return(votes));
+  EXPECT_CALL(*fileHandler, write(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&saved](const json& data) { saved = data; }));
+  EXPECT_CALL(*userService, Get(std::string("1234")))
+      .WillOnce(Return(fakeUser));
+
+  // Removing a vote leaves the others in the order they were cast
+  voteService->Toggle("1234567", "1234");
+  ASSERT_EQ(2, saved.size());
+  EXPECT_EQ("2222", saved[0]["id"]);
+  EXPECT_EQ("2224", saved[1]["id"]);
+
+  // A vote cast again goes last, and the votes after a removed one are
+  // still found
+  VoteService::Toggled cast = voteService->Toggle("1234567", "1234");
+  voteService->Toggle("12345678", "1234");
+  ASSERT_EQ(2, saved.size());
+  EXPECT_EQ("2222", saved[0]["id"]);
+  EXPECT_EQ(cast.vote.id.str(), saved[1]["id"]);
+}
+
+TEST_F(TestVoteService, Toggle_ReadsAgainAfterOtherWrites) {
+  // The ballots are read, then the file is read by the delete, which makes
+  // the ballots read again
+  json stored = fakeJsonData;
+  EXPECT_CALL(*fileHandler, read)
+      .Times(3)
+      .WillRepeatedly(Invoke([&stored]() { return stored; }));
+  EXPECT_CALL(*fileHandler, write(_))
+      .WillRepeatedly(Invoke([&stored](const json& data) { stored = data; }));
+
+  EXPECT_EQ(1, voteService->Count("1234567"));
+  EXPECT_TRUE(voteService->Delete(std::string("2223")));
+  EXPECT_EQ(0, voteService->Count("1234567"));
+}
+
+TEST_F(TestVoteService, Toggle_InvalidIds_ShouldThrow) {
+  EXPECT_CALL(*fileHandler, read).Times(0);
+  EXPECT_THROW(voteService->Toggle("", "1234"), BadRequestError);
+  EXPECT_THROW(voteService->Toggle("123456", ""), BadRequestError);
+}
+
+TEST_F(TestVoteService, Toggle_UserDoesntExist_NothingSaved) {
+  EXPECT_CALL(*fileHandler, read).WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(0);
+  EXPECT_CALL(*userService, Get(std::string("9999")))
+      .WillOnce(Throw(NotFoundError("fake user not found error")));
+
+  EXPECT_THROW(voteService->Toggle("123456", "9999"), NotFoundError);
+  EXPECT_EQ(1, voteService->Count("123456"));
+}
+
+TEST_F(TestVoteService, Toggle_Concurrent_NeverVotesTwice) {
+  json stored = json::array();
+  EXPECT_CALL(*fileHandler, read)
+      .WillRepeatedly(Invoke([&stored]() { return stored; }));
+  EXPECT_CALL(*fileHandler, write(_))
+      .WillRepeatedly(Invoke([&stored](const json& data) { stored = data; }));
+  EXPECT_CALL(*userService, Get(::testing::An<const std::string&>()))
+      .WillRepeatedly(Invoke([](const std::string& id) {
+        User user;
+        user.id = id;
+        return user;
+      }));
+
+  // Every user toggles an even number of times, but the first, who toggles
+  // once more, so only the first user's vote is left
+  const int users = 4;
+  std::vector<std::thread> threads;
+  for (int user = 0; user < users; user++) {
+    threads.emplace_back([this, user]() {
+      std::string userId = "user" + std::to_string(user);
+      for (int toggle = 0; toggle < 20 + (user == 0); toggle++) {
+        voteService->Toggle("123456", userId);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  ASSERT_EQ(1, stored.size());
+  EXPECT_EQ("user0", stored[0]["createdBy"]);
+  EXPECT_EQ(1, voteService->Count("123456"));
+}
+
+TEST_F(TestVoteService, Toggle_IssueDoesntExist_NothingSaved) {
+  auto issueFileHandler = std::make_shared<MockIStreamFileHandler>();
+  EXPECT_CALL(*issueFileHandler, read)
+      .WillRepeatedly(Return(json::parse(R"([{"id": "123456"}])")));
+  auto issueService = std::make_shared<IssueService>(
+      issueFileHandler, userService, nullptr, nullptr);
+  voteService->SetIssueService(issueService);
+
+  EXPECT_CALL(*fileHandler, read).WillRepeatedly(Return(fakeJsonData));
+  EXPECT_CALL(*fileHandler, write(_)).Times(1);
+
+  // The votes of a deleted issue are never cast again
+  EXPECT_THROW(voteService->Toggle("1234567", "1234"), NotFoundError);
+  EXPECT_EQ(1, voteService->Count("1234567"));
+
+  // The issue that exists is voted on
+  VoteService::Toggled toggled = voteService->Toggle("123456", "1234");
+  EXPECT_FALSE(toggled.cast);
+}
@@ -26,7 +26,7 @@ class MockIStreamFileHandler : public IStreamableFileHandler {
    */
   virtual ~MockIStreamFileHandler() {}
 
-  MOCK_METHOD1(write, void(json));
+  MOCK_METHOD1(write, void(const json&));
   MOCK_METHOD0(read, json());
 };
 
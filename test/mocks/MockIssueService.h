@@ -23,12 +23,15 @@ class MockIssueService : public IssueService {
   : IssueService(nullptr, nullptr, nullptr) {}
   virtual ~MockIssueService() {}
 
-  MOCK_METHOD1(Get, Issue(const std::string));
+  MOCK_METHOD1(Get, Issue(const std::string&));
   MOCK_METHOD1(
-      Get, std::vector<Issue>(const std::multimap<std::string, std::string>));
-  MOCK_METHOD1(Create, Issue(std::string));
-  MOCK_METHOD1(Update, Issue(std::string));
-  MOCK_METHOD1(Delete, bool(std::string));
+      Get, std::vector<Issue>(const std::multimap<std::string, std::string>&));
+  MOCK_METHOD1(Create, Issue(const std::string&));
+  MOCK_METHOD1(Update, Issue(const std::string&));
+  MOCK_METHOD2(Patch, Issue(const std::string&, const std::string&));
+  MOCK_METHOD1(Delete, bool(const std::string&));
+  MOCK_METHOD2(Delete, bool(const std::string&, int));
+  MOCK_METHOD1(Bulk, std::vector<BulkResult<Issue>>(const json&));
 };
 
 #endif  // MOCK_ISSUE_SERVICE_H
\ No newline at end of file
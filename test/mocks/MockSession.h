@@ -20,6 +20,8 @@ class MockSession {
   ~MockSession() {}
   MOCK_METHOD0(get_request, const std::shared_ptr<restbed::Request>());
   MOCK_METHOD1(get_path_parameter, std::string(std::string));
+  MOCK_METHOD3(yield, void(const int status, const std::string&,
+                           const std::multimap<std::string, std::string>&));
   MOCK_METHOD3(close, void(const int status, const std::string&,
                            const std::multimap<std::string, std::string>&));
   MOCK_METHOD2(
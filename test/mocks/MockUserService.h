@@ -17,12 +17,14 @@ class MockUserService : public UserService {
   MockUserService() {}
   ~MockUserService() {}
 
-  MOCK_METHOD1(Get, User(const std::string));
+  MOCK_METHOD1(Get, User(const std::string&));
   MOCK_METHOD1(
-      Get, std::vector<User>(const std::multimap<std::string, std::string>));
-  MOCK_METHOD1(Create, User(std::string));
-  MOCK_METHOD1(Update, User(std::string));
-  MOCK_METHOD1(Delete, bool(std::string));
+      Get, std::vector<User>(const std::multimap<std::string, std::string>&));
+  MOCK_METHOD1(Create, User(const std::string&));
+  MOCK_METHOD1(Update, User(const std::string&));
+  MOCK_METHOD2(Patch, User(const std::string&, const std::string&));
+  MOCK_METHOD1(Delete, bool(const std::string&));
+  MOCK_METHOD2(Delete, bool(const std::string&, int));
 };
 
 #endif  // MOCK_USER_SERVICE_H
\ No newline at end of file
@@ -21,10 +21,13 @@ class MockVoteService : public VoteService {
   MockVoteService() : VoteService(nullptr) {}
   virtual ~MockVoteService() {}
 
-  MOCK_METHOD1(Get, std::vector<Vote>(std::multimap<std::string, std::string>));
-  MOCK_METHOD1(Get, Vote(std::string));
-  MOCK_METHOD1(Create, Vote(std::string));
-  MOCK_METHOD1(Delete, bool(std::string));
+  MOCK_METHOD1(Get, std::vector<Vote>(
+                        const std::multimap<std::string, std::string>&));
+  MOCK_METHOD1(Get, Vote(const std::string&));
+  MOCK_METHOD1(Create, Vote(const std::string&));
+  MOCK_METHOD1(Delete, bool(const std::string&));
+  MOCK_METHOD2(Delete, bool(const std::string&, int));
+  MOCK_METHOD2(Toggle, Toggled(const std::string&, const std::string&));
 };
 
 #endif  // MOCK_VOTE_SERVICE_H
\ No newline at end of file